@@ -0,0 +1,208 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#define BENCH_SAMPLES_MAX 65536
+#define BENCH_BATCH 64
+/* Fewer samples than this make p999 just the maximum, so it is left out */
+#define BENCH_SAMPLES_P999 1000
+
+/**
+ * @brief Options of a benchmark run, set from the command line.
+ *
+ */
+typedef struct bench_config_t {
+  const char* filter;
+  unsigned int scale;
+  unsigned int threads;
+  int first;
+} bench_config_t;
+
+/**
+ * @brief Times one benchmark. Operations are timed in batches of about
+ * BENCH_BATCH, as a single operation is too short for the clock, and every
+ * batch gives one latency sample in nanoseconds per operation. Allocations are
+ * only counted while a batch is timed.
+ *
+ */
+typedef struct bench_timer_t {
+  const char* name;
+  char params[256];
+  double* samples;
+  unsigned int sample_amount;
+  unsigned long operations;
+  unsigned long allocations;
+  double total_ns;
+  double bytes_per_op;
+  double sample_start;
+  unsigned long sample_allocations;
+} bench_timer_t;
+
+static bench_config_t bench_config = {NULL, 10, 0, 1};
+
+/* Benchmarks run one at a time and share the sample storage */
+static double bench_samples[BENCH_SAMPLES_MAX];
+
+/* Counted by the allocator wrappers of rsv_bench.c when they are linked in */
+static unsigned long bench_allocations = 0;
+static int bench_counting_allocations = 0;
+
+#if !defined(__GNUC__)
+/* Stored to by bench_clobber, so the compiler must assume it is read */
+static const void* volatile bench_clobbered = NULL;
+#endif
+
+static inline double bench_now(void) {
+#if defined(_WIN32)
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER now;
+
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&now);
+
+  return (double)now.QuadPart * 1e9 / (double)frequency.QuadPart;
+#else
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (double)now.tv_sec * 1e9 + (double)now.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Makes the compiler assume that the memory behind a pointer is read, so
+ * that the work which wrote it is neither hoisted out of a loop nor removed.
+ *
+ */
+static inline void bench_clobber(const void* pointer) {
+#if defined(__GNUC__)
+  __asm__ __volatile__("" : : "r"(pointer) : "memory");
+#else
+  bench_clobbered = pointer;
+#endif
+}
+
+static inline uint64_t bench_random(uint64_t* state) {
+  /* xorshift64*, fixed seeds keep runs reproducible */
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+
+  return *state * UINT64_C(2685821657736338717);
+}
+
+static inline int bench_compare_samples(const void* a, const void* b) {
+  double sample_a = *(const double*)a;
+  double sample_b = *(const double*)b;
+
+  return (sample_a > sample_b) - (sample_a < sample_b);
+}
+
+/**
+ * @brief Starts timing a benchmark, unless it is filtered out.
+ *
+ * @return 1 if the benchmark should run, 0 otherwise.
+ */
+static inline int bench_start(bench_timer_t* timer, const char* name,
+                              const char* params) {
+  if (bench_config.filter && !strstr(name, bench_config.filter)) {
+    return 0;
+  }
+
+  timer->name = name;
+  timer->samples = bench_samples;
+  strncpy(timer->params, params, sizeof(timer->params) - 1);
+  timer->params[sizeof(timer->params) - 1] = '\0';
+  timer->sample_amount = 0;
+  timer->operations = 0;
+  timer->total_ns = 0;
+  timer->bytes_per_op = 0;
+  timer->allocations = 0;
+
+  return 1;
+}
+
+static inline void bench_sample_begin(bench_timer_t* timer) {
+  timer->sample_allocations = bench_allocations;
+  timer->sample_start = bench_now();
+}
+
+static inline void bench_sample_add(bench_timer_t* timer, double ns,
+                                    unsigned long operations) {
+  if (timer->sample_amount < BENCH_SAMPLES_MAX && operations > 0) {
+    timer->samples[timer->sample_amount++] = ns / (double)operations;
+  }
+
+  timer->operations += operations;
+  timer->total_ns += ns;
+}
+
+static inline void bench_sample_end(bench_timer_t* timer,
+                                    unsigned long operations) {
+  double end = bench_now();
+
+  timer->allocations += bench_allocations - timer->sample_allocations;
+  bench_sample_add(timer, end - timer->sample_start, operations);
+}
+
+static inline double bench_percentile(const bench_timer_t* timer,
+                                      double percentile) {
+  unsigned int index =
+      (unsigned int)(percentile * (double)(timer->sample_amount - 1) + 0.5);
+
+  return timer->samples[index];
+}
+
+/**
+ * @brief Finishes a benchmark and prints its result as a JSON object.
+ *
+ */
+static inline void bench_finish(bench_timer_t* timer) {
+  if (timer->sample_amount == 0) {
+    return;
+  }
+
+  qsort(timer->samples, timer->sample_amount, sizeof(double),
+        bench_compare_samples);
+
+  printf("%s\n    {\"name\": \"%s\", \"params\": {%s}, \"operations\": %lu, "
+         "\"ns_per_op\": %.3f, \"p50_ns\": %.3f, \"p99_ns\": %.3f",
+         bench_config.first ? "" : ",", timer->name, timer->params,
+         timer->operations, timer->total_ns / (double)timer->operations,
+         bench_percentile(timer, 0.5), bench_percentile(timer, 0.99));
+
+  if (timer->sample_amount >= BENCH_SAMPLES_P999) {
+    printf(", \"p999_ns\": %.3f", bench_percentile(timer, 0.999));
+  } else {
+    printf(", \"p999_ns\": null");
+  }
+
+  if (bench_counting_allocations) {
+    printf(", \"allocations_per_op\": %.4f",
+           (double)timer->allocations /
+               (double)timer->operations);
+  } else {
+    printf(", \"allocations_per_op\": null");
+  }
+
+  if (timer->bytes_per_op > 0) {
+    printf(", \"gb_per_s\": %.3f",
+           timer->bytes_per_op * (double)timer->operations / timer->total_ns);
+  }
+
+  printf("}");
+  fflush(stdout);
+  bench_config.first = 0;
+}
+
+#endif /* BENCH_H */
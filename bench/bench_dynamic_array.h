@@ -0,0 +1,105 @@
+#ifndef BENCH_DYNAMIC_ARRAY_H
+#define BENCH_DYNAMIC_ARRAY_H
+
+#include "bench.h"
+#include <rsv/containers/dynamic_array.h>
+
+#define BENCH_DYNAMIC_ARRAY_AMOUNT 4096
+
+/* Indices read in one round, picked before timing */
+static unsigned int bench_dynamic_array_indices[BENCH_DYNAMIC_ARRAY_AMOUNT];
+
+static inline void bench_dynamic_array(void) {
+  const unsigned long amount = BENCH_DYNAMIC_ARRAY_AMOUNT;
+  unsigned int rounds = 20 * bench_config.scale;
+  uint64_t state = 1;
+  rsv_dynamic_array_t array;
+  bench_timer_t timer;
+  unsigned long sink = 0;
+  unsigned long batch, i;
+  unsigned int round;
+
+  /* Push into a fresh array, including every reallocation */
+  if (bench_start(&timer, "dynamic_array.push", "\"element_size\": 8")) {
+    for (round = 0; round < rounds; ++round) {
+      array = rsv_dynamic_array_create(1, sizeof(unsigned long));
+
+      for (batch = 0; batch < amount; batch += BENCH_BATCH) {
+        bench_sample_begin(&timer);
+
+        for (i = batch; i < batch + BENCH_BATCH; ++i) {
+          rsv_dynamic_array_push(&array, &i);
+        }
+
+        bench_sample_end(&timer, BENCH_BATCH);
+      }
+
+      rsv_dynamic_array_destroy(&array);
+    }
+
+    bench_finish(&timer);
+  }
+
+  /* Pop everything, including every shrink */
+  if (bench_start(&timer, "dynamic_array.pop", "\"element_size\": 8")) {
+    for (round = 0; round < rounds; ++round) {
+      array = rsv_dynamic_array_create((unsigned int)amount,
+                                       sizeof(unsigned long));
+
+      for (i = 0; i < amount; ++i) {
+        rsv_dynamic_array_push(&array, &i);
+      }
+
+      for (batch = 0; batch < amount; batch += BENCH_BATCH) {
+        bench_sample_begin(&timer);
+
+        for (i = batch; i < batch + BENCH_BATCH; ++i) {
+          rsv_dynamic_array_pop(&array);
+        }
+
+        bench_sample_end(&timer, BENCH_BATCH);
+      }
+
+      rsv_dynamic_array_destroy(&array);
+    }
+
+    bench_finish(&timer);
+  }
+
+  /* Random reads */
+  if (bench_start(&timer, "dynamic_array.get", "\"element_size\": 8")) {
+    array =
+        rsv_dynamic_array_create((unsigned int)amount, sizeof(unsigned long));
+
+    for (i = 0; i < amount; ++i) {
+      rsv_dynamic_array_push(&array, &i);
+    }
+
+    for (round = 0; round < rounds; ++round) {
+      for (i = 0; i < amount; ++i) {
+        bench_dynamic_array_indices[i] =
+            (unsigned int)(bench_random(&state) % amount);
+      }
+
+      for (batch = 0; batch < amount; batch += BENCH_BATCH) {
+        bench_sample_begin(&timer);
+
+        for (i = batch; i < batch + BENCH_BATCH; ++i) {
+          sink += *(unsigned long*)rsv_dynamic_array_get(
+              &array, bench_dynamic_array_indices[i]);
+        }
+
+        bench_sample_end(&timer, BENCH_BATCH);
+      }
+    }
+
+    rsv_dynamic_array_destroy(&array);
+    bench_finish(&timer);
+  }
+
+  if (sink == 1) {
+    printf(" ");
+  }
+}
+
+#endif /* BENCH_DYNAMIC_ARRAY_H */
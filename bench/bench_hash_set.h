@@ -0,0 +1,132 @@
+#ifndef BENCH_HASH_SET_H
+#define BENCH_HASH_SET_H
+
+#include "bench.h"
+#include "bench_hash_table.h"
+#include <rsv/containers/hash_set.h>
+
+static inline void bench_hash_set(void) {
+  static const unsigned int key_sizes[] = {4, 16, 64};
+  static const double load_factors[] = {0.25, 0.5, 0.75};
+  static const double hit_ratios[] = {1.0, 0.5, 0.0};
+  const unsigned int capacity = BENCH_HASH_CAPACITY;
+  unsigned int rounds = 10 * bench_config.scale;
+  const unsigned char* key;
+  uint64_t state = 1;
+  bench_timer_t timer;
+  char params[256];
+  unsigned long sink = 0;
+  unsigned int k, l, h, round, batch, end, i;
+
+  for (k = 0; k < sizeof(key_sizes) / sizeof(key_sizes[0]); ++k) {
+    unsigned int key_size = key_sizes[k];
+
+    bench_hash_keys_fill(key_size);
+
+    for (l = 0; l < sizeof(load_factors) / sizeof(load_factors[0]); ++l) {
+      unsigned int amount = (unsigned int)(capacity * load_factors[l]);
+      rsv_hash_set_t set;
+
+      /* Push into a set which does not need to grow */
+      snprintf(params, sizeof(params),
+               "\"key_size\": %u, \"load_factor\": %.2f", key_size,
+               load_factors[l]);
+
+      if (bench_start(&timer, "hash_set.push", params)) {
+        for (round = 0; round < rounds; ++round) {
+          set = rsv_hash_set_create(capacity, key_size, NULL, NULL);
+          for (batch = 0; batch < amount; batch += BENCH_BATCH) {
+            end = batch + BENCH_BATCH < amount ? batch + BENCH_BATCH : amount;
+            bench_sample_begin(&timer);
+
+            for (i = batch; i < end; ++i) {
+              key = bench_hash_key_at(key_size, i * 2);
+              rsv_hash_set_push(&set, key);
+            }
+
+            bench_sample_end(&timer, end - batch);
+          }
+
+          rsv_hash_set_destroy(&set);
+        }
+
+        bench_finish(&timer);
+      }
+
+      set = rsv_hash_set_create(capacity, key_size, NULL, NULL);
+
+      for (i = 0; i < amount; ++i) {
+        key = bench_hash_key_at(key_size, i * 2);
+        rsv_hash_set_push(&set, key);
+      }
+
+      /* Lookups with a share of hits */
+      for (h = 0; h < sizeof(hit_ratios) / sizeof(hit_ratios[0]); ++h) {
+        snprintf(params, sizeof(params),
+                 "\"key_size\": %u, \"load_factor\": %.2f, "
+                 "\"hit_ratio\": %.2f",
+                 key_size, load_factors[l], hit_ratios[h]);
+
+        if (bench_start(&timer, "hash_set.get", params)) {
+          for (round = 0; round < rounds; ++round) {
+            bench_hash_lookups_fill(amount, hit_ratios[h], &state);
+
+            for (batch = 0; batch < amount; batch += BENCH_BATCH) {
+              end = batch + BENCH_BATCH < amount ? batch + BENCH_BATCH : amount;
+              bench_sample_begin(&timer);
+
+              for (i = batch; i < end; ++i) {
+                key = bench_hash_key_at(key_size, bench_hash_lookups[i]);
+                sink += (unsigned long)rsv_hash_set_contains(&set, key);
+              }
+
+              bench_sample_end(&timer, end - batch);
+            }
+          }
+
+          bench_finish(&timer);
+        }
+      }
+
+      rsv_hash_set_destroy(&set);
+
+      /* Pop every key */
+      snprintf(params, sizeof(params),
+               "\"key_size\": %u, \"load_factor\": %.2f", key_size,
+               load_factors[l]);
+
+      if (bench_start(&timer, "hash_set.pop", params)) {
+        for (round = 0; round < rounds; ++round) {
+          set = rsv_hash_set_create(capacity, key_size, NULL, NULL);
+
+          for (i = 0; i < amount; ++i) {
+            key = bench_hash_key_at(key_size, i * 2);
+            rsv_hash_set_push(&set, key);
+          }
+
+          for (batch = 0; batch < amount; batch += BENCH_BATCH) {
+            end = batch + BENCH_BATCH < amount ? batch + BENCH_BATCH : amount;
+            bench_sample_begin(&timer);
+
+            for (i = batch; i < end; ++i) {
+              key = bench_hash_key_at(key_size, i * 2);
+              rsv_hash_set_pop(&set, key);
+            }
+
+            bench_sample_end(&timer, end - batch);
+          }
+
+          rsv_hash_set_destroy(&set);
+        }
+
+        bench_finish(&timer);
+      }
+    }
+  }
+
+  if (sink == 1) {
+    printf(" ");
+  }
+}
+
+#endif /* BENCH_HASH_SET_H */
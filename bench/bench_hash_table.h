@@ -0,0 +1,205 @@
+#ifndef BENCH_HASH_TABLE_H
+#define BENCH_HASH_TABLE_H
+
+#include "bench.h"
+#include <rsv/containers/hash_table.h>
+
+#define BENCH_HASH_KEY_SIZE_MAX 64
+#define BENCH_HASH_CAPACITY 8192
+
+/* Keys of every seed, written before timing so that only the container is
+ * measured */
+static unsigned char
+    bench_hash_keys[BENCH_HASH_CAPACITY * 2 * BENCH_HASH_KEY_SIZE_MAX];
+
+/* Seeds of the keys looked up in one round */
+static unsigned int bench_hash_lookups[BENCH_HASH_CAPACITY];
+
+/**
+ * @brief Writes the key of an index. Keys of even seeds are the ones pushed,
+ * odd seeds give keys which miss.
+ *
+ */
+static inline void bench_hash_key(unsigned char* key, unsigned int key_size,
+                                  uint64_t seed) {
+  uint64_t state = seed * 2 + 1;
+  unsigned int i;
+
+  memset(key, 0, key_size);
+  memcpy(key, &seed, key_size < sizeof(seed) ? key_size : sizeof(seed));
+
+  for (i = sizeof(seed); i + sizeof(state) <= key_size; i += sizeof(state)) {
+    uint64_t word = bench_random(&state);
+    memcpy(key + i, &word, sizeof(word));
+  }
+}
+
+/**
+ * @brief Writes the keys of every seed below BENCH_HASH_CAPACITY * 2 into
+ * bench_hash_keys.
+ *
+ */
+static inline void bench_hash_keys_fill(unsigned int key_size) {
+  unsigned int seed;
+
+  for (seed = 0; seed < BENCH_HASH_CAPACITY * 2; ++seed) {
+    bench_hash_key(bench_hash_keys + (size_t)seed * key_size, key_size, seed);
+  }
+}
+
+/**
+ * @brief Gets the key of a seed from bench_hash_keys.
+ *
+ */
+static inline const unsigned char* bench_hash_key_at(unsigned int key_size,
+                                                     unsigned int seed) {
+  return bench_hash_keys + (size_t)seed * key_size;
+}
+
+/**
+ * @brief Picks the seeds of a round of random lookups into bench_hash_lookups,
+ * hitting one of the amount pushed keys with the given ratio.
+ *
+ */
+static inline void bench_hash_lookups_fill(unsigned int amount,
+                                           double hit_ratio, uint64_t* state) {
+  unsigned int i;
+
+  for (i = 0; i < amount; ++i) {
+    uint64_t random = bench_random(state);
+    unsigned int index = (unsigned int)(random % amount);
+    int hit = (double)(random >> 40) / (double)(1 << 24) < hit_ratio;
+
+    bench_hash_lookups[i] = index * 2 + !hit;
+  }
+}
+
+static inline void bench_hash_table(void) {
+  static const unsigned int key_sizes[] = {4, 16, 64};
+  static const double load_factors[] = {0.25, 0.5, 0.75};
+  static const double hit_ratios[] = {1.0, 0.5, 0.0};
+  const unsigned int capacity = BENCH_HASH_CAPACITY;
+  unsigned int rounds = 10 * bench_config.scale;
+  const unsigned char* key;
+  uint64_t value = 0;
+  uint64_t state = 1;
+  bench_timer_t timer;
+  char params[256];
+  unsigned long sink = 0;
+  unsigned int k, l, h, round, batch, end, i;
+
+  for (k = 0; k < sizeof(key_sizes) / sizeof(key_sizes[0]); ++k) {
+    unsigned int key_size = key_sizes[k];
+
+    bench_hash_keys_fill(key_size);
+
+    for (l = 0; l < sizeof(load_factors) / sizeof(load_factors[0]); ++l) {
+      unsigned int amount = (unsigned int)(capacity * load_factors[l]);
+      rsv_hash_table_t table;
+
+      /* Push into a table which does not need to grow */
+      snprintf(params, sizeof(params),
+               "\"key_size\": %u, \"load_factor\": %.2f", key_size,
+               load_factors[l]);
+
+      if (bench_start(&timer, "hash_table.push", params)) {
+        for (round = 0; round < rounds; ++round) {
+          table = rsv_hash_table_create(capacity, key_size, sizeof(value),
+                                        NULL, NULL);
+          for (batch = 0; batch < amount; batch += BENCH_BATCH) {
+            end = batch + BENCH_BATCH < amount ? batch + BENCH_BATCH : amount;
+            bench_sample_begin(&timer);
+
+            for (i = batch; i < end; ++i) {
+              key = bench_hash_key_at(key_size, i * 2);
+              rsv_hash_table_push(&table, key, &value);
+            }
+
+            bench_sample_end(&timer, end - batch);
+          }
+
+          rsv_hash_table_destroy(&table);
+        }
+
+        bench_finish(&timer);
+      }
+
+      table = rsv_hash_table_create(capacity, key_size, sizeof(value), NULL,
+                                    NULL);
+
+      for (i = 0; i < amount; ++i) {
+        key = bench_hash_key_at(key_size, i * 2);
+        rsv_hash_table_push(&table, key, &value);
+      }
+
+      /* Lookups with a share of hits */
+      for (h = 0; h < sizeof(hit_ratios) / sizeof(hit_ratios[0]); ++h) {
+        snprintf(params, sizeof(params),
+                 "\"key_size\": %u, \"load_factor\": %.2f, "
+                 "\"hit_ratio\": %.2f",
+                 key_size, load_factors[l], hit_ratios[h]);
+
+        if (bench_start(&timer, "hash_table.get", params)) {
+          for (round = 0; round < rounds; ++round) {
+            bench_hash_lookups_fill(amount, hit_ratios[h], &state);
+
+            for (batch = 0; batch < amount; batch += BENCH_BATCH) {
+              end = batch + BENCH_BATCH < amount ? batch + BENCH_BATCH : amount;
+              bench_sample_begin(&timer);
+
+              for (i = batch; i < end; ++i) {
+                key = bench_hash_key_at(key_size, bench_hash_lookups[i]);
+                sink += rsv_hash_table_get(&table, key) != NULL;
+              }
+
+              bench_sample_end(&timer, end - batch);
+            }
+          }
+
+          bench_finish(&timer);
+        }
+      }
+
+      rsv_hash_table_destroy(&table);
+
+      /* Pop every key */
+      snprintf(params, sizeof(params),
+               "\"key_size\": %u, \"load_factor\": %.2f", key_size,
+               load_factors[l]);
+
+      if (bench_start(&timer, "hash_table.pop", params)) {
+        for (round = 0; round < rounds; ++round) {
+          table = rsv_hash_table_create(capacity, key_size, sizeof(value),
+                                        NULL, NULL);
+
+          for (i = 0; i < amount; ++i) {
+            key = bench_hash_key_at(key_size, i * 2);
+            rsv_hash_table_push(&table, key, &value);
+          }
+
+          for (batch = 0; batch < amount; batch += BENCH_BATCH) {
+            end = batch + BENCH_BATCH < amount ? batch + BENCH_BATCH : amount;
+            bench_sample_begin(&timer);
+
+            for (i = batch; i < end; ++i) {
+              key = bench_hash_key_at(key_size, i * 2);
+              rsv_hash_table_pop(&table, key);
+            }
+
+            bench_sample_end(&timer, end - batch);
+          }
+
+          rsv_hash_table_destroy(&table);
+        }
+
+        bench_finish(&timer);
+      }
+    }
+  }
+
+  if (sink == 1) {
+    printf(" ");
+  }
+}
+
+#endif /* BENCH_HASH_TABLE_H */
@@ -0,0 +1,40 @@
+#ifndef BENCH_STRING_H
+#define BENCH_STRING_H
+
+#include "bench.h"
+#include <rsv/safe/string.h>
+
+static inline void bench_string(void) {
+  static const unsigned int lengths[] = {15, 255, 4095};
+  unsigned int samples = 1000 * bench_config.scale;
+  char source[4096];
+  char destination[4096];
+  bench_timer_t timer;
+  char params[256];
+  unsigned int l, s, i;
+
+  for (l = 0; l < sizeof(lengths) / sizeof(lengths[0]); ++l) {
+    memset(source, 'a', sizeof(source));
+    source[lengths[l]] = '\0';
+    snprintf(params, sizeof(params), "\"length\": %u", lengths[l]);
+
+    if (bench_start(&timer, "string.strcpy", params)) {
+      timer.bytes_per_op = lengths[l] + 1;
+
+      for (s = 0; s < samples; ++s) {
+        bench_sample_begin(&timer);
+
+        for (i = 0; i < BENCH_BATCH; ++i) {
+          rsv_strcpy(destination, source, sizeof(destination));
+          bench_clobber(destination);
+        }
+
+        bench_sample_end(&timer, BENCH_BATCH);
+      }
+
+      bench_finish(&timer);
+    }
+  }
+}
+
+#endif /* BENCH_STRING_H */
@@ -0,0 +1,127 @@
+#if defined(__unix__)
+
+#ifndef BENCH_THREADS_H
+#define BENCH_THREADS_H
+
+#include "bench.h"
+#include <rsv/threads/atomic.h>
+#include <rsv/threads/threads_pthreads.h>
+#include <unistd.h>
+
+#define BENCH_THREADS_BATCH 64
+
+typedef struct bench_threads_context_t {
+  bench_timer_t* timer;
+  rsv_mutex_t mutex;
+  rsv_adaptive_mutex_t adaptive_mutex;
+  rsv_barrier_t barrier;
+  unsigned long counter;
+  unsigned int samples;
+  unsigned int thread_amount;
+  unsigned int next_index;
+  int adaptive;
+} bench_threads_context_t;
+
+static inline void* bench_threads_contend(void* arg) {
+  bench_threads_context_t* context = (bench_threads_context_t*)arg;
+  unsigned int index = rsv_atomic_fetch_add(&context->next_index, 1,
+                                            RSV_MEMORY_ORDER_RELAXED);
+  unsigned int samples = context->samples / context->thread_amount;
+  double* slots = context->timer->samples + index * samples;
+  unsigned int s, i;
+
+  rsv_barrier_wait(&context->barrier);
+
+  for (s = 0; s < samples; ++s) {
+    double start = bench_now();
+
+    for (i = 0; i < BENCH_THREADS_BATCH; ++i) {
+      if (context->adaptive) {
+        rsv_adaptive_mutex_lock(&context->adaptive_mutex);
+        context->counter++;
+        rsv_adaptive_mutex_unlock(&context->adaptive_mutex);
+      } else {
+        rsv_mutex_lock(&context->mutex);
+        context->counter++;
+        rsv_mutex_unlock(&context->mutex);
+      }
+    }
+
+    slots[s] = (bench_now() - start) / BENCH_THREADS_BATCH;
+  }
+
+  return NULL;
+}
+
+static inline void bench_threads(void) {
+  static const char* names[] = {"mutex.lock_unlock",
+                                "adaptive_mutex.lock_unlock"};
+  unsigned int max_threads = bench_config.threads;
+  unsigned int samples = BENCH_SAMPLES_MAX / 4;
+  bench_threads_context_t context;
+  rsv_thread_t threads[64];
+  bench_timer_t timer;
+  char params[256];
+  unsigned int kind, amount, i;
+
+  if (max_threads == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    max_threads = cpus > 0 ? (unsigned int)cpus : 1;
+  }
+
+  max_threads = max_threads < 64 ? max_threads : 64;
+
+  if (bench_config.scale < 10) {
+    samples = BENCH_SAMPLES_MAX / 32;
+  }
+
+  for (kind = 0; kind < 2; ++kind) {
+    for (amount = 1; amount <= max_threads;
+         amount = amount * 2 > max_threads && amount < max_threads
+                      ? max_threads
+                      : amount * 2) {
+      unsigned long allocations;
+      double start;
+
+      snprintf(params, sizeof(params), "\"threads\": %u", amount);
+
+      if (!bench_start(&timer, names[kind], params)) {
+        continue;
+      }
+
+      context.timer = &timer;
+      context.counter = 0;
+      context.samples = samples;
+      context.thread_amount = amount;
+      context.next_index = 0;
+      context.adaptive = kind == 1;
+      rsv_mutex_create(&context.mutex);
+      rsv_adaptive_mutex_create(&context.adaptive_mutex);
+      rsv_barrier_create(&context.barrier, amount);
+      allocations = bench_allocations;
+      start = bench_now();
+
+      for (i = 0; i < amount; ++i) {
+        rsv_thread_create(&threads[i], bench_threads_contend, &context);
+      }
+
+      for (i = 0; i < amount; ++i) {
+        rsv_thread_join(threads[i], NULL);
+      }
+
+      /* Throughput over all threads, latency from the samples of each */
+      timer.sample_amount = samples / amount * amount;
+      timer.operations = context.counter;
+      timer.total_ns = bench_now() - start;
+      timer.allocations = bench_allocations - allocations;
+      rsv_barrier_destroy(&context.barrier);
+      rsv_adaptive_mutex_destroy(&context.adaptive_mutex);
+      rsv_mutex_destroy(&context.mutex);
+      bench_finish(&timer);
+    }
+  }
+}
+
+#endif /* BENCH_THREADS_H */
+
+#endif
@@ -0,0 +1,71 @@
+#include "rsv_bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(RSV_BENCH_WRAP_ALLOCATIONS)
+/* Linked with --wrap, so every allocation made by the library is counted */
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t amount, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+int __real_posix_memalign(void** pointer, size_t alignment, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  __atomic_fetch_add(&bench_allocations, 1, __ATOMIC_RELAXED);
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t amount, size_t size) {
+  __atomic_fetch_add(&bench_allocations, 1, __ATOMIC_RELAXED);
+  return __real_calloc(amount, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size) {
+  __atomic_fetch_add(&bench_allocations, 1, __ATOMIC_RELAXED);
+  return __real_realloc(pointer, size);
+}
+
+int __wrap_posix_memalign(void** pointer, size_t alignment, size_t size) {
+  __atomic_fetch_add(&bench_allocations, 1, __ATOMIC_RELAXED);
+  return __real_posix_memalign(pointer, alignment, size);
+}
+#endif
+
+static void usage(const char* program) {
+  printf("Usage: %s [--filter NAME] [--quick] [--scale N] [--threads N]\n"
+         "Prints the results as JSON.\n",
+         program);
+}
+
+int main(int argc, char** argv) {
+  int i;
+
+  for (i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      bench_config.filter = argv[++i];
+    } else if (strcmp(argv[i], "--quick") == 0) {
+      bench_config.scale = 1;
+    } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+      bench_config.scale = (unsigned int)strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      bench_config.threads = (unsigned int)strtoul(argv[++i], NULL, 10);
+    } else {
+      usage(argv[0]);
+      exit(strcmp(argv[i], "--help") == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+
+  if (bench_config.scale == 0) {
+    bench_config.scale = 1;
+  }
+
+#if defined(RSV_BENCH_WRAP_ALLOCATIONS)
+  bench_counting_allocations = 1;
+#endif
+
+  printf("{\n  \"scale\": %u,\n  \"benchmarks\": [", bench_config.scale);
+  rsv_bench_all();
+  printf("\n  ]\n}\n");
+
+  exit(EXIT_SUCCESS);
+}
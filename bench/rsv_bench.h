@@ -0,0 +1,21 @@
+#ifndef RSV_BENCH_H
+#define RSV_BENCH_H
+
+#include "bench_dynamic_array.h"
+#include "bench_hash_set.h"
+#include "bench_hash_table.h"
+#include "bench_string.h"
+#include "bench_threads.h"
+
+static inline void rsv_bench_all(void) {
+  bench_dynamic_array();
+  bench_hash_table();
+  bench_hash_set();
+  bench_string();
+
+#if defined(__unix__)
+  bench_threads();
+#endif
+}
+
+#endif /* RSV_BENCH_H */
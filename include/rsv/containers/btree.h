@@ -0,0 +1,1332 @@
+/*
+  btree.h
+  Implementation of an ordered map as a B+ tree
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#ifndef RSV_BTREE_H
+#define RSV_BTREE_H
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define RSV_BTREE_NODE_SIZE 512
+#define RSV_BTREE_MIN_CAPACITY 4
+#define RSV_BTREE_MAX_HEIGHT 32
+#define RSV_BTREE_LINEAR_SEARCH 32
+
+#define RSV_BTREE_KEY_BYTES 0
+#define RSV_BTREE_KEY_INT32 1
+#define RSV_BTREE_KEY_UINT32 2
+#define RSV_BTREE_KEY_INT64 3
+#define RSV_BTREE_KEY_UINT64 4
+
+/**
+ * @brief A B+ tree node. Leaves hold keys and values and are linked in key
+ * order, inner nodes hold separator keys and children. Should not be directly
+ * used unless necessary.
+ *
+ */
+typedef struct rsv_btree_node_t {
+  unsigned int amount;
+  unsigned int leaf;
+  struct rsv_btree_node_t* next;
+  union {
+    void* pointer;
+    double floating;
+    long long integer;
+  } data[];
+} rsv_btree_node_t;
+
+/**
+ * @brief An ordered map stored as a B+ tree of fixed size nodes. Keys and
+ * values are stored inline in the nodes, so a lookup touches one node per
+ * level and in-order iteration walks the linked leaves. Make sure to cast your
+ * type from the void pointer.
+ *
+ */
+typedef struct rsv_btree_t {
+  /**
+   * @brief The root node, or NULL if the tree is empty.
+   *
+   */
+  rsv_btree_node_t* root;
+  /**
+   * @brief The amount of key-value pairs in the tree.
+   *
+   */
+  unsigned int amount;
+  /**
+   * @brief The amount of levels in the tree.
+   *
+   */
+  unsigned int height;
+  /**
+   * @brief The size of the key in memory.
+   *
+   */
+  unsigned int key_size;
+  /**
+   * @brief The size of the value in memory.
+   *
+   */
+  unsigned int value_size;
+  /**
+   * @brief The most keys held by a leaf.
+   *
+   */
+  unsigned int leaf_capacity;
+  /**
+   * @brief The most keys held by an inner node, which has one more child.
+   *
+   */
+  unsigned int inner_capacity;
+  /**
+   * @brief Offset of the values of a leaf after its keys.
+   *
+   */
+  unsigned int leaf_values_offset;
+  /**
+   * @brief Offset of the children of an inner node after its keys.
+   *
+   */
+  unsigned int inner_children_offset;
+  /**
+   * @brief The size in memory of the data of a node.
+   *
+   */
+  unsigned int node_data_size;
+  /**
+   * @brief The key type searched with SIMD, found from the compare function.
+   *
+   */
+  unsigned int key_type;
+  /**
+   * @brief Space for two keys, used while splitting nodes.
+   *
+   */
+  unsigned char* scratch;
+  /**
+   * @brief Use if the tree would need a custom compare function for ordering
+   * keys, returning a negative value, 0 or a positive value like memcmp. Set
+   * to NULL for default comparing, which orders keys as bytes.
+   *
+   */
+  int (*custom_compare_func)(const void*, const void*, unsigned int);
+} rsv_btree_t;
+
+/**
+ * @brief Iterates the key-value pairs of a tree in key order.
+ *
+ */
+typedef struct rsv_btree_iterator_t {
+  const rsv_btree_t* tree;
+  rsv_btree_node_t* node;
+  unsigned int index;
+  /**
+   * @brief Iteration stops before this key, unless NULL.
+   *
+   */
+  const void* upper;
+  /**
+   * @brief Iteration stops at the first key not starting with this prefix,
+   * unless prefix_length is 0.
+   *
+   */
+  const void* prefix;
+  unsigned int prefix_length;
+} rsv_btree_iterator_t;
+
+/**
+ * @brief Compares two keys as bytes.
+ *
+ * @param key_a Pointer to the first key.
+ * @param key_b Pointer to the second key.
+ * @param key_size Size of the keys in memory.
+ * @return A negative value, 0 or a positive value if the first key is lower,
+ * equal or higher.
+ */
+static inline int rsv_btree_compare(const void* key_a, const void* key_b,
+                                    unsigned int key_size) {
+  return memcmp(key_a, key_b, key_size);
+}
+
+/**
+ * @brief Compares two int32_t keys. Trees using it search nodes with SIMD.
+ *
+ * @param key_a Pointer to the first key.
+ * @param key_b Pointer to the second key.
+ * @param key_size Size of the keys in memory.
+ * @return A negative value, 0 or a positive value if the first key is lower,
+ * equal or higher.
+ */
+static inline int rsv_btree_compare_int32(const void* key_a, const void* key_b,
+                                          unsigned int key_size) {
+  int32_t a;
+  int32_t b;
+
+  (void)key_size;
+  memcpy(&a, key_a, sizeof(a));
+  memcpy(&b, key_b, sizeof(b));
+
+  return (a > b) - (a < b);
+}
+
+/**
+ * @brief Compares two uint32_t keys. Trees using it search nodes with SIMD.
+ *
+ * @param key_a Pointer to the first key.
+ * @param key_b Pointer to the second key.
+ * @param key_size Size of the keys in memory.
+ * @return A negative value, 0 or a positive value if the first key is lower,
+ * equal or higher.
+ */
+static inline int rsv_btree_compare_uint32(const void* key_a,
+                                           const void* key_b,
+                                           unsigned int key_size) {
+  uint32_t a;
+  uint32_t b;
+
+  (void)key_size;
+  memcpy(&a, key_a, sizeof(a));
+  memcpy(&b, key_b, sizeof(b));
+
+  return (a > b) - (a < b);
+}
+
+/**
+ * @brief Compares two int64_t keys. Trees using it search nodes with SIMD
+ * where SSE4.2 or AVX2 is available.
+ *
+ * @param key_a Pointer to the first key.
+ * @param key_b Pointer to the second key.
+ * @param key_size Size of the keys in memory.
+ * @return A negative value, 0 or a positive value if the first key is lower,
+ * equal or higher.
+ */
+static inline int rsv_btree_compare_int64(const void* key_a, const void* key_b,
+                                          unsigned int key_size) {
+  int64_t a;
+  int64_t b;
+
+  (void)key_size;
+  memcpy(&a, key_a, sizeof(a));
+  memcpy(&b, key_b, sizeof(b));
+
+  return (a > b) - (a < b);
+}
+
+/**
+ * @brief Compares two uint64_t keys. Trees using it search nodes with SIMD
+ * where SSE4.2 or AVX2 is available.
+ *
+ * @param key_a Pointer to the first key.
+ * @param key_b Pointer to the second key.
+ * @param key_size Size of the keys in memory.
+ * @return A negative value, 0 or a positive value if the first key is lower,
+ * equal or higher.
+ */
+static inline int rsv_btree_compare_uint64(const void* key_a,
+                                           const void* key_b,
+                                           unsigned int key_size) {
+  uint64_t a;
+  uint64_t b;
+
+  (void)key_size;
+  memcpy(&a, key_a, sizeof(a));
+  memcpy(&b, key_b, sizeof(b));
+
+  return (a > b) - (a < b);
+}
+
+/**
+ * @brief Gets a key of a node. Should not be directly used unless necessary.
+ *
+ * @param tree Pointer to the tree.
+ * @param node Pointer to the node.
+ * @param index Index of the key.
+ * @return Pointer to the key.
+ */
+static inline unsigned char* rsv_btree_key(const rsv_btree_t* tree,
+                                           rsv_btree_node_t* node,
+                                           unsigned int index) {
+  return (unsigned char*)node->data + index * tree->key_size;
+}
+
+/**
+ * @brief Gets a value of a leaf. Should not be directly used unless necessary.
+ *
+ * @param tree Pointer to the tree.
+ * @param node Pointer to the leaf.
+ * @param index Index of the value.
+ * @return Pointer to the value.
+ */
+static inline unsigned char* rsv_btree_value(const rsv_btree_t* tree,
+                                             rsv_btree_node_t* node,
+                                             unsigned int index) {
+  return (unsigned char*)node->data + tree->leaf_values_offset +
+         index * tree->value_size;
+}
+
+/**
+ * @brief Gets the children of an inner node. Should not be directly used
+ * unless necessary.
+ *
+ * @param tree Pointer to the tree.
+ * @param node Pointer to the inner node.
+ * @return Pointer to the array of children.
+ */
+static inline rsv_btree_node_t** rsv_btree_children(const rsv_btree_t* tree,
+                                                    rsv_btree_node_t* node) {
+  return (rsv_btree_node_t**)((unsigned char*)node->data +
+                              tree->inner_children_offset);
+}
+
+/**
+ * @brief Counts the 32 bit keys lower than (or equal to) a key. Should not be
+ * directly used unless necessary.
+ *
+ * @param keys Pointer to the keys.
+ * @param amount The amount of keys.
+ * @param key Pointer to the key.
+ * @param is_signed 1 if the keys are int32_t, 0 if they are uint32_t.
+ * @param or_equal 1 to also count equal keys.
+ * @return The amount of keys counted.
+ */
+static inline unsigned int rsv_btree_count_32(const unsigned char* keys,
+                                              unsigned int amount,
+                                              const void* key, int is_signed,
+                                              int or_equal) {
+  unsigned int count = 0;
+  unsigned int i = 0;
+  uint32_t target;
+
+  memcpy(&target, key, sizeof(target));
+
+#if defined(__AVX2__)
+  {
+    /* Flip the sign bit of unsigned keys to compare them signed */
+    __m256i bias = _mm256_set1_epi32(is_signed ? 0 : INT_MIN);
+    __m256i wide = _mm256_xor_si256(_mm256_set1_epi32((int)target), bias);
+
+    for (; i + 8 <= amount; i += 8) {
+      __m256i block = _mm256_xor_si256(
+          _mm256_loadu_si256((const __m256i*)(keys + i * 4)), bias);
+      __m256i mask = or_equal ? _mm256_cmpgt_epi32(block, wide)
+                              : _mm256_cmpgt_epi32(wide, block);
+      unsigned int hits = (unsigned int)__builtin_popcount(
+          (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+
+      count += or_equal ? 8 - hits : hits;
+    }
+  }
+#endif
+
+#if defined(__SSE2__)
+  {
+    __m128i bias = _mm_set1_epi32(is_signed ? 0 : INT_MIN);
+    __m128i wide = _mm_xor_si128(_mm_set1_epi32((int)target), bias);
+
+    for (; i + 4 <= amount; i += 4) {
+      __m128i block = _mm_xor_si128(
+          _mm_loadu_si128((const __m128i*)(keys + i * 4)), bias);
+      __m128i mask = or_equal ? _mm_cmpgt_epi32(block, wide)
+                              : _mm_cmpgt_epi32(wide, block);
+      unsigned int hits = (unsigned int)__builtin_popcount(
+          (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(mask)));
+
+      count += or_equal ? 4 - hits : hits;
+    }
+  }
+#endif
+
+  {
+    /* Flip the sign bit of signed keys to compare them unsigned */
+    uint32_t bias = is_signed ? 0x80000000u : 0;
+
+    target ^= bias;
+
+    for (; i < amount; ++i) {
+      uint32_t current;
+
+      memcpy(&current, keys + i * 4, sizeof(current));
+      current ^= bias;
+      count += or_equal ? current <= target : current < target;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * @brief Counts the 64 bit keys lower than (or equal to) a key. Should not be
+ * directly used unless necessary.
+ *
+ * @param keys Pointer to the keys.
+ * @param amount The amount of keys.
+ * @param key Pointer to the key.
+ * @param is_signed 1 if the keys are int64_t, 0 if they are uint64_t.
+ * @param or_equal 1 to also count equal keys.
+ * @return The amount of keys counted.
+ */
+static inline unsigned int rsv_btree_count_64(const unsigned char* keys,
+                                              unsigned int amount,
+                                              const void* key, int is_signed,
+                                              int or_equal) {
+  unsigned int count = 0;
+  unsigned int i = 0;
+  uint64_t target;
+
+  memcpy(&target, key, sizeof(target));
+
+#if defined(__AVX2__)
+  {
+    __m256i bias = _mm256_set1_epi64x(is_signed ? 0 : LLONG_MIN);
+    __m256i wide =
+        _mm256_xor_si256(_mm256_set1_epi64x((long long)target), bias);
+
+    for (; i + 4 <= amount; i += 4) {
+      __m256i block = _mm256_xor_si256(
+          _mm256_loadu_si256((const __m256i*)(keys + i * 8)), bias);
+      __m256i mask = or_equal ? _mm256_cmpgt_epi64(block, wide)
+                              : _mm256_cmpgt_epi64(wide, block);
+      unsigned int hits = (unsigned int)__builtin_popcount(
+          (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+
+      count += or_equal ? 4 - hits : hits;
+    }
+  }
+#endif
+
+#if defined(__SSE4_2__)
+  {
+    __m128i bias = _mm_set1_epi64x(is_signed ? 0 : LLONG_MIN);
+    __m128i wide = _mm_xor_si128(_mm_set1_epi64x((long long)target), bias);
+
+    for (; i + 2 <= amount; i += 2) {
+      __m128i block = _mm_xor_si128(
+          _mm_loadu_si128((const __m128i*)(keys + i * 8)), bias);
+      __m128i mask = or_equal ? _mm_cmpgt_epi64(block, wide)
+                              : _mm_cmpgt_epi64(wide, block);
+      unsigned int hits = (unsigned int)__builtin_popcount(
+          (unsigned int)_mm_movemask_pd(_mm_castsi128_pd(mask)));
+
+      count += or_equal ? 2 - hits : hits;
+    }
+  }
+#endif
+
+  {
+    uint64_t bias = is_signed ? 0x8000000000000000ull : 0;
+
+    target ^= bias;
+
+    for (; i < amount; ++i) {
+      uint64_t current;
+
+      memcpy(&current, keys + i * 8, sizeof(current));
+      current ^= bias;
+      count += or_equal ? current <= target : current < target;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * @brief Searches a node for a key. Should not be directly used unless
+ * necessary.
+ *
+ * Binary searches down to a window of RSV_BTREE_LINEAR_SEARCH keys, then
+ * counts the window with SIMD compares for integer keys.
+ *
+ * @param tree Pointer to the tree.
+ * @param node Pointer to the node.
+ * @param key Pointer to the key.
+ * @param or_equal 0 to get the index of the first key not lower than the key,
+ * 1 to get the index of the first key higher than the key.
+ * @return The index.
+ */
+static inline unsigned int rsv_btree_search(const rsv_btree_t* tree,
+                                            rsv_btree_node_t* node,
+                                            const void* key, int or_equal) {
+  unsigned int low = 0;
+  unsigned int high = node->amount;
+  unsigned int window =
+      tree->key_type == RSV_BTREE_KEY_BYTES ? 0 : RSV_BTREE_LINEAR_SEARCH;
+
+  while (high - low > window) {
+    unsigned int middle = low + (high - low) / 2;
+    int order = tree->custom_compare_func(rsv_btree_key(tree, node, middle),
+                                          key, tree->key_size);
+
+    if (order < 0 || (or_equal && order == 0)) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  if (high > low) {
+    const unsigned char* keys = rsv_btree_key(tree, node, low);
+
+    switch (tree->key_type) {
+    case RSV_BTREE_KEY_INT32:
+    case RSV_BTREE_KEY_UINT32:
+      low += rsv_btree_count_32(keys, high - low, key,
+                                tree->key_type == RSV_BTREE_KEY_INT32,
+                                or_equal);
+      break;
+    default:
+      low += rsv_btree_count_64(keys, high - low, key,
+                                tree->key_type == RSV_BTREE_KEY_INT64,
+                                or_equal);
+      break;
+    }
+  }
+
+  return low;
+}
+
+/**
+ * @brief Allocates an empty node. Should not be directly used unless
+ * necessary.
+ *
+ * @param tree Pointer to the tree.
+ * @param leaf 1 for a leaf, 0 for an inner node.
+ * @return Pointer to the node.
+ */
+static inline rsv_btree_node_t* rsv_btree_node_create(rsv_btree_t* tree,
+                                                      unsigned int leaf) {
+  rsv_btree_node_t* node = (rsv_btree_node_t*)malloc(
+      sizeof(rsv_btree_node_t) + tree->node_data_size);
+
+  node->amount = 0;
+  node->leaf = leaf;
+  node->next = NULL;
+
+  return node;
+}
+
+/**
+ * @brief Frees a node and everything below it. Should not be directly used
+ * unless necessary.
+ *
+ * @param tree Pointer to the tree.
+ * @param node Pointer to the node.
+ */
+static inline void rsv_btree_node_destroy(rsv_btree_t* tree,
+                                          rsv_btree_node_t* node) {
+  if (!node->leaf) {
+    unsigned int i;
+
+    for (i = 0; i <= node->amount; ++i) {
+      rsv_btree_node_destroy(tree, rsv_btree_children(tree, node)[i]);
+    }
+  }
+
+  free(node);
+}
+
+/**
+ * @brief Inserts a key and value into a leaf with room. Should not be directly
+ * used unless necessary.
+ *
+ * @param tree Pointer to the tree.
+ * @param node Pointer to the leaf.
+ * @param index Index to insert at.
+ * @param key Pointer to the key.
+ * @param value Pointer to the value.
+ */
+static inline void rsv_btree_leaf_insert(rsv_btree_t* tree,
+                                         rsv_btree_node_t* node,
+                                         unsigned int index, const void* key,
+                                         const void* value) {
+  unsigned int after = node->amount - index;
+
+  memmove(rsv_btree_key(tree, node, index + 1),
+          rsv_btree_key(tree, node, index),
+          after * tree->key_size);
+  memmove(rsv_btree_value(tree, node, index + 1),
+          rsv_btree_value(tree, node, index), after * tree->value_size);
+  memcpy(rsv_btree_key(tree, node, index), key, tree->key_size);
+  memcpy(rsv_btree_value(tree, node, index), value, tree->value_size);
+  node->amount++;
+}
+
+/**
+ * @brief Removes a key and value from a leaf. Should not be directly used
+ * unless necessary.
+ *
+ * @param tree Pointer to the tree.
+ * @param node Pointer to the leaf.
+ * @param index Index to remove.
+ */
+static inline void rsv_btree_leaf_remove(rsv_btree_t* tree,
+                                         rsv_btree_node_t* node,
+                                         unsigned int index) {
+  unsigned int after = node->amount - index - 1;
+
+  memmove(rsv_btree_key(tree, node, index),
+          rsv_btree_key(tree, node, index + 1),
+          after * tree->key_size);
+  memmove(rsv_btree_value(tree, node, index),
+          rsv_btree_value(tree, node, index + 1), after * tree->value_size);
+  node->amount--;
+}
+
+/**
+ * @brief Inserts a key and the child after it into an inner node with room.
+ * Should not be directly used unless necessary.
+ *
+ * @param tree Pointer to the tree.
+ * @param node Pointer to the inner node.
+ * @param index Index of the key to insert.
+ * @param key Pointer to the key.
+ * @param child Pointer to the child, inserted at index + 1.
+ */
+static inline void rsv_btree_inner_insert(rsv_btree_t* tree,
+                                          rsv_btree_node_t* node,
+                                          unsigned int index, const void* key,
+                                          rsv_btree_node_t* child) {
+  rsv_btree_node_t** children = rsv_btree_children(tree, node);
+  unsigned int after = node->amount - index;
+
+  memmove(rsv_btree_key(tree, node, index + 1),
+          rsv_btree_key(tree, node, index),
+          after * tree->key_size);
+  memmove(children + index + 2, children + index + 1,
+          after * sizeof(rsv_btree_node_t*));
+  memcpy(rsv_btree_key(tree, node, index), key, tree->key_size);
+  children[index + 1] = child;
+  node->amount++;
+}
+
+/**
+ * @brief Removes a key and the child after it from an inner node. Should not
+ * be directly used unless necessary.
+ *
+ * @param tree Pointer to the tree.
+ * @param node Pointer to the inner node.
+ * @param index Index of the key to remove.
+ */
+static inline void rsv_btree_inner_remove(rsv_btree_t* tree,
+                                          rsv_btree_node_t* node,
+                                          unsigned int index) {
+  rsv_btree_node_t** children = rsv_btree_children(tree, node);
+  unsigned int after = node->amount - index - 1;
+
+  memmove(rsv_btree_key(tree, node, index),
+          rsv_btree_key(tree, node, index + 1),
+          after * tree->key_size);
+  memmove(children + index + 1, children + index + 2,
+          after * sizeof(rsv_btree_node_t*));
+  node->amount--;
+}
+
+/**
+ * @brief Creates a tree.
+ *
+ * @param node_size Size of each node in memory, or 0 to use
+ * RSV_BTREE_NODE_SIZE. A few cache lines suit lookups, a page suits scans.
+ * @param key_size Size of each key in memory.
+ * @param value_size Size of each value in memory.
+ * @param custom_compare_func Pointer to a custom compare function, or NULL to
+ * order keys as bytes. Pass one of the rsv_btree_compare_int32, uint32, int64
+ * or uint64 functions to search integer keys with SIMD.
+ * @return A rsv_btree_t struct representing the created tree.
+ */
+static inline rsv_btree_t
+rsv_btree_create(unsigned int node_size, unsigned int key_size,
+                 unsigned int value_size,
+                 int (*custom_compare_func)(const void*, const void*,
+                                            unsigned int)) {
+  rsv_btree_t tree;
+  unsigned int data_size;
+  unsigned int leaf_size;
+  unsigned int inner_size;
+
+  if (node_size == 0) {
+    node_size = RSV_BTREE_NODE_SIZE;
+  }
+
+  data_size = node_size > sizeof(rsv_btree_node_t)
+                  ? node_size - (unsigned int)sizeof(rsv_btree_node_t)
+                  : 0;
+
+  tree.root = NULL;
+  tree.amount = 0;
+  tree.height = 0;
+  tree.key_size = key_size;
+  tree.value_size = value_size;
+  tree.leaf_capacity = data_size / (key_size + value_size);
+  tree.inner_capacity = (data_size - (unsigned int)sizeof(rsv_btree_node_t*)) /
+                        (key_size + (unsigned int)sizeof(rsv_btree_node_t*));
+
+  if (data_size < sizeof(rsv_btree_node_t*) ||
+      tree.inner_capacity < RSV_BTREE_MIN_CAPACITY) {
+    tree.inner_capacity = RSV_BTREE_MIN_CAPACITY;
+  }
+
+  if (tree.leaf_capacity < RSV_BTREE_MIN_CAPACITY) {
+    tree.leaf_capacity = RSV_BTREE_MIN_CAPACITY;
+  }
+
+  /* Align the values and children after the keys */
+  tree.leaf_values_offset =
+      (tree.leaf_capacity * key_size + sizeof(rsv_btree_node_t*) - 1) &
+      ~(unsigned int)(sizeof(rsv_btree_node_t*) - 1);
+  tree.inner_children_offset =
+      (tree.inner_capacity * key_size + sizeof(rsv_btree_node_t*) - 1) &
+      ~(unsigned int)(sizeof(rsv_btree_node_t*) - 1);
+  leaf_size = tree.leaf_values_offset + tree.leaf_capacity * value_size;
+  inner_size = tree.inner_children_offset +
+               (tree.inner_capacity + 1) * sizeof(rsv_btree_node_t*);
+  tree.node_data_size = leaf_size > inner_size ? leaf_size : inner_size;
+  tree.scratch = (unsigned char*)malloc(2 * key_size);
+
+  if (custom_compare_func == NULL) {
+    custom_compare_func = rsv_btree_compare;
+  }
+
+  tree.key_type = RSV_BTREE_KEY_BYTES;
+
+  if (key_size == 4 && custom_compare_func == rsv_btree_compare_int32) {
+    tree.key_type = RSV_BTREE_KEY_INT32;
+  } else if (key_size == 4 && custom_compare_func == rsv_btree_compare_uint32) {
+    tree.key_type = RSV_BTREE_KEY_UINT32;
+  } else if (key_size == 8 && custom_compare_func == rsv_btree_compare_int64) {
+    tree.key_type = RSV_BTREE_KEY_INT64;
+  } else if (key_size == 8 && custom_compare_func == rsv_btree_compare_uint64) {
+    tree.key_type = RSV_BTREE_KEY_UINT64;
+  }
+
+  tree.custom_compare_func = custom_compare_func;
+
+  return tree;
+}
+
+/**
+ * @brief Destroys a tree, freeing all associated memory.
+ *
+ * @param tree Pointer to the tree to destroy.
+ */
+static inline void rsv_btree_destroy(rsv_btree_t* tree) {
+  if (tree->root) {
+    rsv_btree_node_destroy(tree, tree->root);
+  }
+
+  free(tree->scratch);
+  tree->scratch = NULL;
+  tree->root = NULL;
+  tree->amount = 0;
+  tree->height = 0;
+}
+
+/**
+ * @brief Retrieves the value associated with the specified key in the tree.
+ *
+ * @param tree Pointer to the tree.
+ * @param key Pointer to the key.
+ * @return Pointer to the value associated with the key, or NULL if the key is
+ * not found.
+ */
+static inline void* rsv_btree_get(rsv_btree_t* tree, const void* key) {
+  rsv_btree_node_t* node = tree->root;
+  unsigned int index;
+
+  if (node == NULL) {
+    return NULL;
+  }
+
+  while (!node->leaf) {
+    node = rsv_btree_children(tree, node)[rsv_btree_search(tree, node, key, 1)];
+  }
+
+  index = rsv_btree_search(tree, node, key, 0);
+
+  if (index < node->amount &&
+      tree->custom_compare_func(rsv_btree_key(tree, node, index), key,
+                                tree->key_size) == 0) {
+    return rsv_btree_value(tree, node, index);
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Adds a key-value pair to the tree, replacing the value if the key is
+ * already in the tree.
+ *
+ * @param tree Pointer to the tree.
+ * @param key Pointer to the key.
+ * @param value Pointer to the value.
+ */
+static inline void rsv_btree_push(rsv_btree_t* tree, const void* key,
+                                  const void* value) {
+  rsv_btree_node_t* path[RSV_BTREE_MAX_HEIGHT];
+  unsigned int indices[RSV_BTREE_MAX_HEIGHT];
+  unsigned int depth = 0;
+  unsigned int scratch = 0;
+  rsv_btree_node_t* node;
+  rsv_btree_node_t* right;
+  const void* separator;
+  unsigned int index;
+  unsigned int half;
+
+  if (tree->root == NULL) {
+    tree->root = rsv_btree_node_create(tree, 1);
+    tree->height = 1;
+  }
+
+  node = tree->root;
+
+  while (!node->leaf) {
+    index = rsv_btree_search(tree, node, key, 1);
+    path[depth] = node;
+    indices[depth] = index;
+    depth++;
+    node = rsv_btree_children(tree, node)[index];
+  }
+
+  index = rsv_btree_search(tree, node, key, 0);
+
+  if (index < node->amount &&
+      tree->custom_compare_func(rsv_btree_key(tree, node, index), key,
+                                tree->key_size) == 0) {
+    memcpy(rsv_btree_value(tree, node, index), value, tree->value_size);
+    return;
+  }
+
+  tree->amount++;
+
+  if (node->amount < tree->leaf_capacity) {
+    rsv_btree_leaf_insert(tree, node, index, key, value);
+    return;
+  }
+
+  /* Split the full leaf in half, then insert into the matching half */
+  right = rsv_btree_node_create(tree, 1);
+  half = node->amount / 2;
+  right->amount = node->amount - half;
+  memcpy(rsv_btree_key(tree, right, 0), rsv_btree_key(tree, node, half),
+         right->amount * tree->key_size);
+  memcpy(rsv_btree_value(tree, right, 0), rsv_btree_value(tree, node, half),
+         right->amount * tree->value_size);
+  node->amount = half;
+  right->next = node->next;
+  node->next = right;
+
+  if (index <= half) {
+    rsv_btree_leaf_insert(tree, node, index, key, value);
+  } else {
+    rsv_btree_leaf_insert(tree, right, index - half, key, value);
+  }
+
+  separator = rsv_btree_key(tree, right, 0);
+
+  while (depth > 0) {
+    rsv_btree_node_t* parent = path[--depth];
+    rsv_btree_node_t** children;
+    unsigned char* middle_key;
+    unsigned int middle;
+
+    index = indices[depth];
+
+    if (parent->amount < tree->inner_capacity) {
+      rsv_btree_inner_insert(tree, parent, index, separator, right);
+      return;
+    }
+
+    /*
+     * Split the full inner node so both halves end up at least half full
+     * once the separator is in. The key in the middle of the keys including
+     * the separator moves up, which may be the separator itself.
+     */
+    node = rsv_btree_node_create(tree, 0);
+    children = rsv_btree_children(tree, parent);
+    middle = parent->amount / 2;
+
+    /* Alternate buffers, the separator may still point at the other one */
+    middle_key = tree->scratch + scratch * tree->key_size;
+    scratch ^= 1;
+
+    if (index == middle) {
+      memcpy(middle_key, separator, tree->key_size);
+      node->amount = parent->amount - middle;
+      memcpy(rsv_btree_key(tree, node, 0), rsv_btree_key(tree, parent, middle),
+             node->amount * tree->key_size);
+      rsv_btree_children(tree, node)[0] = right;
+      memcpy(rsv_btree_children(tree, node) + 1, children + middle + 1,
+             node->amount * sizeof(rsv_btree_node_t*));
+      parent->amount = middle;
+    } else {
+      if (index < middle) {
+        middle--;
+      }
+
+      memcpy(middle_key, rsv_btree_key(tree, parent, middle), tree->key_size);
+      node->amount = parent->amount - middle - 1;
+      memcpy(rsv_btree_key(tree, node, 0),
+             rsv_btree_key(tree, parent, middle + 1),
+             node->amount * tree->key_size);
+      memcpy(rsv_btree_children(tree, node), children + middle + 1,
+             (node->amount + 1) * sizeof(rsv_btree_node_t*));
+      parent->amount = middle;
+
+      if (index <= middle) {
+        rsv_btree_inner_insert(tree, parent, index, separator, right);
+      } else {
+        rsv_btree_inner_insert(tree, node, index - middle - 1, separator,
+                               right);
+      }
+    }
+
+    separator = middle_key;
+    right = node;
+  }
+
+  /* The root was split, so grow a new root above it */
+  node = rsv_btree_node_create(tree, 0);
+  memcpy(rsv_btree_key(tree, node, 0), separator, tree->key_size);
+  rsv_btree_children(tree, node)[0] = tree->root;
+  rsv_btree_children(tree, node)[1] = right;
+  node->amount = 1;
+  tree->root = node;
+  tree->height++;
+}
+
+/**
+ * @brief Refills a node which fell below half full from its siblings. Should
+ * not be directly used unless necessary.
+ *
+ * @param tree Pointer to the tree.
+ * @param parent Pointer to the parent of the node.
+ * @param index Index of the node among the children of the parent.
+ * @return 1 if a sibling was merged into the node, or the node into a sibling,
+ * taking a key from the parent. 0 if a key was borrowed instead.
+ */
+static inline int rsv_btree_rebalance(rsv_btree_t* tree,
+                                      rsv_btree_node_t* parent,
+                                      unsigned int index) {
+  rsv_btree_node_t** siblings = rsv_btree_children(tree, parent);
+  rsv_btree_node_t* node = siblings[index];
+  rsv_btree_node_t* left = index > 0 ? siblings[index - 1] : NULL;
+  rsv_btree_node_t* right = index < parent->amount ? siblings[index + 1] : NULL;
+  unsigned int minimum =
+      (node->leaf ? tree->leaf_capacity : tree->inner_capacity) / 2;
+  rsv_btree_node_t** children;
+
+  if (left && left->amount > minimum) {
+    if (node->leaf) {
+      rsv_btree_leaf_insert(tree, node, 0,
+                            rsv_btree_key(tree, left, left->amount - 1),
+                            rsv_btree_value(tree, left, left->amount - 1));
+      left->amount--;
+      memcpy(rsv_btree_key(tree, parent, index - 1),
+             rsv_btree_key(tree, node, 0), tree->key_size);
+    } else {
+      /* Rotate the last child of the left sibling through the parent */
+      children = rsv_btree_children(tree, node);
+      memmove(rsv_btree_key(tree, node, 1), rsv_btree_key(tree, node, 0),
+              node->amount * tree->key_size);
+      memmove(children + 1, children,
+              (node->amount + 1) * sizeof(rsv_btree_node_t*));
+      memcpy(rsv_btree_key(tree, node, 0),
+             rsv_btree_key(tree, parent, index - 1), tree->key_size);
+      children[0] = rsv_btree_children(tree, left)[left->amount];
+      memcpy(rsv_btree_key(tree, parent, index - 1),
+             rsv_btree_key(tree, left, left->amount - 1), tree->key_size);
+      left->amount--;
+      node->amount++;
+    }
+
+    return 0;
+  }
+
+  if (right && right->amount > minimum) {
+    if (node->leaf) {
+      rsv_btree_leaf_insert(tree, node, node->amount,
+                            rsv_btree_key(tree, right, 0),
+                            rsv_btree_value(tree, right, 0));
+      rsv_btree_leaf_remove(tree, right, 0);
+    } else {
+      /* Rotate the first child of the right sibling through the parent */
+      children = rsv_btree_children(tree, right);
+      memcpy(rsv_btree_key(tree, node, node->amount),
+             rsv_btree_key(tree, parent, index), tree->key_size);
+      rsv_btree_children(tree, node)[node->amount + 1] = children[0];
+      node->amount++;
+      memcpy(rsv_btree_key(tree, parent, index), rsv_btree_key(tree, right, 0),
+             tree->key_size);
+      memmove(rsv_btree_key(tree, right, 0), rsv_btree_key(tree, right, 1),
+              (right->amount - 1) * tree->key_size);
+      memmove(children, children + 1,
+              right->amount * sizeof(rsv_btree_node_t*));
+      right->amount--;
+      return 0;
+    }
+
+    memcpy(rsv_btree_key(tree, parent, index), rsv_btree_key(tree, right, 0),
+           tree->key_size);
+
+    return 0;
+  }
+
+  /* Neither sibling can spare a key, so merge the right one of the pair */
+  if (left) {
+    right = node;
+    index--;
+  } else {
+    left = node;
+  }
+
+  if (left->leaf) {
+    memcpy(rsv_btree_key(tree, left, left->amount),
+           rsv_btree_key(tree, right, 0),
+           right->amount * tree->key_size);
+    memcpy(rsv_btree_value(tree, left, left->amount),
+           rsv_btree_value(tree, right, 0), right->amount * tree->value_size);
+    left->amount += right->amount;
+    left->next = right->next;
+  } else {
+    memcpy(rsv_btree_key(tree, left, left->amount),
+           rsv_btree_key(tree, parent, index), tree->key_size);
+    memcpy(rsv_btree_key(tree, left, left->amount + 1),
+           rsv_btree_key(tree, right, 0), right->amount * tree->key_size);
+    memcpy(rsv_btree_children(tree, left) + left->amount + 1,
+           rsv_btree_children(tree, right),
+           (right->amount + 1) * sizeof(rsv_btree_node_t*));
+    left->amount += right->amount + 1;
+  }
+
+  rsv_btree_inner_remove(tree, parent, index);
+  free(right);
+
+  return 1;
+}
+
+/**
+ * @brief Removes a key-value pair from the tree.
+ *
+ * @param tree Pointer to the tree.
+ * @param key Pointer to the key of the pair to remove.
+ */
+static inline void rsv_btree_pop(rsv_btree_t* tree, const void* key) {
+  rsv_btree_node_t* path[RSV_BTREE_MAX_HEIGHT];
+  unsigned int indices[RSV_BTREE_MAX_HEIGHT];
+  unsigned int depth = 0;
+  rsv_btree_node_t* node = tree->root;
+  unsigned int index;
+
+  if (node == NULL) {
+    return;
+  }
+
+  while (!node->leaf) {
+    index = rsv_btree_search(tree, node, key, 1);
+    path[depth] = node;
+    indices[depth] = index;
+    depth++;
+    node = rsv_btree_children(tree, node)[index];
+  }
+
+  index = rsv_btree_search(tree, node, key, 0);
+
+  if (index >= node->amount ||
+      tree->custom_compare_func(rsv_btree_key(tree, node, index), key,
+                                tree->key_size) != 0) {
+    return;
+  }
+
+  /* Separators equal to the removed key still route correctly, so they stay */
+  rsv_btree_leaf_remove(tree, node, index);
+  tree->amount--;
+
+  while (depth > 0) {
+    unsigned int minimum =
+        (node->leaf ? tree->leaf_capacity : tree->inner_capacity) / 2;
+
+    if (node->amount >= minimum) {
+      return;
+    }
+
+    depth--;
+
+    if (!rsv_btree_rebalance(tree, path[depth], indices[depth])) {
+      return;
+    }
+
+    node = path[depth];
+  }
+
+  /* Shrink the tree once the root runs out of keys */
+  if (node->amount == 0) {
+    tree->root = node->leaf ? NULL : rsv_btree_children(tree, node)[0];
+    tree->height--;
+    free(node);
+  }
+}
+
+/**
+ * @brief Fills an empty tree from key-value pairs sorted by key, building
+ * every node once instead of inserting the pairs one at a time.
+ *
+ * @param tree Pointer to the empty tree.
+ * @param keys Pointer to the keys, in strictly increasing order.
+ * @param values Pointer to the values, in the same order as the keys.
+ * @param amount The amount of key-value pairs.
+ * @return 1 if the tree was filled, 0 if the tree was not empty or the keys
+ * were not strictly increasing.
+ */
+static inline int rsv_btree_bulk_load(rsv_btree_t* tree, const void* keys,
+                                      const void* values,
+                                      unsigned int amount) {
+  const unsigned char* key_bytes = (const unsigned char*)keys;
+  const unsigned char* value_bytes = (const unsigned char*)values;
+  rsv_btree_node_t** level;
+  const unsigned char** firsts;
+  rsv_btree_node_t* previous = NULL;
+  unsigned int nodes;
+  unsigned int offset = 0;
+  unsigned int i;
+
+  if (tree->root != NULL) {
+    return 0;
+  }
+
+  for (i = 1; i < amount; ++i) {
+    if (tree->custom_compare_func(key_bytes + (i - 1) * tree->key_size,
+                                  key_bytes + i * tree->key_size,
+                                  tree->key_size) >= 0) {
+      return 0;
+    }
+  }
+
+  if (amount == 0) {
+    return 1;
+  }
+
+  /* Spread the pairs evenly so that every leaf is at least half full */
+  nodes = (amount + tree->leaf_capacity - 1) / tree->leaf_capacity;
+  level = (rsv_btree_node_t**)malloc(nodes * sizeof(rsv_btree_node_t*));
+  firsts = (const unsigned char**)malloc(nodes * sizeof(unsigned char*));
+
+  for (i = 0; i < nodes; ++i) {
+    rsv_btree_node_t* leaf = rsv_btree_node_create(tree, 1);
+
+    leaf->amount = amount / nodes + (i < amount % nodes);
+    memcpy(rsv_btree_key(tree, leaf, 0), key_bytes + offset * tree->key_size,
+           leaf->amount * tree->key_size);
+    memcpy(rsv_btree_value(tree, leaf, 0),
+           value_bytes + offset * tree->value_size,
+           leaf->amount * tree->value_size);
+    offset += leaf->amount;
+
+    if (previous) {
+      previous->next = leaf;
+    }
+
+    previous = leaf;
+    level[i] = leaf;
+    firsts[i] = rsv_btree_key(tree, leaf, 0);
+  }
+
+  tree->height = 1;
+
+  /* Build each inner level over the one below, writing it in place */
+  while (nodes > 1) {
+    unsigned int parents =
+        (nodes + tree->inner_capacity) / (tree->inner_capacity + 1);
+    unsigned int child = 0;
+
+    for (i = 0; i < parents; ++i) {
+      rsv_btree_node_t* parent = rsv_btree_node_create(tree, 0);
+      unsigned int amount_children = nodes / parents + (i < nodes % parents);
+      const unsigned char* first = firsts[child];
+      unsigned int j;
+
+      for (j = 0; j < amount_children; ++j, ++child) {
+        rsv_btree_children(tree, parent)[j] = level[child];
+
+        if (j > 0) {
+          memcpy(rsv_btree_key(tree, parent, j - 1), firsts[child],
+                 tree->key_size);
+        }
+      }
+
+      parent->amount = amount_children - 1;
+      level[i] = parent;
+      firsts[i] = first;
+    }
+
+    nodes = parents;
+    tree->height++;
+  }
+
+  tree->root = level[0];
+  tree->amount = amount;
+  free(level);
+  free((void*)firsts);
+
+  return 1;
+}
+
+/**
+ * @brief Finds the first leaf position at or after a key. Should not be
+ * directly used unless necessary.
+ *
+ * @param tree Pointer to the tree.
+ * @param key Pointer to the key, or NULL for the first position.
+ * @param prefix_length 0 to compare whole keys, otherwise the amount of leading
+ * bytes compared with memcmp.
+ * @param iterator Pointer to the iterator to position.
+ */
+static inline void rsv_btree_seek(const rsv_btree_t* tree, const void* key,
+                                  unsigned int prefix_length,
+                                  rsv_btree_iterator_t* iterator) {
+  rsv_btree_node_t* node = tree->root;
+  unsigned int index = 0;
+
+  while (node) {
+    if (key == NULL) {
+      index = 0;
+    } else if (prefix_length == 0) {
+      index = rsv_btree_search(tree, node, key, !node->leaf);
+    } else {
+      /* Go to the leftmost child which may hold the prefix */
+      unsigned int low = 0;
+      unsigned int high = node->amount;
+
+      while (low < high) {
+        unsigned int middle = low + (high - low) / 2;
+
+        if (memcmp(rsv_btree_key(tree, node, middle), key, prefix_length) < 0) {
+          low = middle + 1;
+        } else {
+          high = middle;
+        }
+      }
+
+      index = low;
+    }
+
+    if (node->leaf) {
+      break;
+    }
+
+    node = rsv_btree_children(tree, node)[index];
+  }
+
+  iterator->tree = tree;
+  iterator->node = node;
+  iterator->index = index;
+  iterator->upper = NULL;
+  iterator->prefix = NULL;
+  iterator->prefix_length = 0;
+}
+
+/**
+ * @brief Creates an iterator over the keys from lower, inclusive, to upper,
+ * exclusive, in key order.
+ *
+ * @param tree Pointer to the tree.
+ * @param lower Pointer to the lowest key, or NULL to start at the first key.
+ * @param upper Pointer to the key to stop before, or NULL to run to the end.
+ * @return The iterator. Invalid once the tree is changed.
+ */
+static inline rsv_btree_iterator_t
+rsv_btree_range(const rsv_btree_t* tree, const void* lower, const void* upper) {
+  rsv_btree_iterator_t iterator;
+
+  rsv_btree_seek(tree, lower, 0, &iterator);
+  iterator.upper = upper;
+
+  return iterator;
+}
+
+/**
+ * @brief Creates an iterator over the keys starting with a prefix, in key
+ * order. Only meaningful for trees ordering keys as bytes, where those keys
+ * are next to each other.
+ *
+ * @param tree Pointer to the tree.
+ * @param prefix Pointer to the prefix.
+ * @param prefix_length Size of the prefix in memory, at most the key size.
+ * @return The iterator. Invalid once the tree is changed.
+ */
+static inline rsv_btree_iterator_t
+rsv_btree_prefix(const rsv_btree_t* tree, const void* prefix,
+                 unsigned int prefix_length) {
+  rsv_btree_iterator_t iterator;
+
+  if (prefix_length == 0) {
+    return rsv_btree_range(tree, NULL, NULL);
+  }
+
+  rsv_btree_seek(tree, prefix, prefix_length, &iterator);
+  iterator.prefix = prefix;
+  iterator.prefix_length = prefix_length;
+
+  return iterator;
+}
+
+/**
+ * @brief Gets the next key-value pair of an iterator.
+ *
+ * @param iterator Pointer to the iterator.
+ * @param key Pointer to store a pointer to the key in, or NULL.
+ * @param value Pointer to store a pointer to the value in, or NULL.
+ * @return 1 if a pair was found, 0 if the iteration is done.
+ */
+static inline int rsv_btree_iterator_next(rsv_btree_iterator_t* iterator,
+                                          void** key, void** value) {
+  const rsv_btree_t* tree = iterator->tree;
+  unsigned char* found;
+
+  while (iterator->node && iterator->index >= iterator->node->amount) {
+    iterator->node = iterator->node->next;
+    iterator->index = 0;
+  }
+
+  if (iterator->node == NULL) {
+    return 0;
+  }
+
+  found = rsv_btree_key(tree, iterator->node, iterator->index);
+
+  if ((iterator->upper &&
+       tree->custom_compare_func(found, iterator->upper, tree->key_size) >=
+           0) ||
+      (iterator->prefix_length &&
+       memcmp(found, iterator->prefix, iterator->prefix_length) != 0)) {
+    iterator->node = NULL;
+    return 0;
+  }
+
+  if (key) {
+    *key = found;
+  }
+
+  if (value) {
+    *value = rsv_btree_value(tree, iterator->node, iterator->index);
+  }
+
+  iterator->index++;
+
+  return 1;
+}
+
+#endif /* RSV_BTREE_H */
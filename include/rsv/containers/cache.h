@@ -0,0 +1,1015 @@
+/*
+  cache.h
+  Implementation of a bounded cache with LRU or CLOCK eviction
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#ifndef RSV_CACHE_H
+#define RSV_CACHE_H
+
+#include "hash_table.h"
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RSV_CACHE_LRU 0
+#define RSV_CACHE_CLOCK 1
+#define RSV_CACHE_NONE 0xFFFFFFFFu
+#define RSV_CACHE_MIN_SLOTS 8
+#define RSV_CACHE_MAX_INITIAL_SLOTS 1024
+#define RSV_CACHE_MAX_SLOTS 0x80000000u
+
+/**
+ * @brief The header of a cache slot, followed by the key and the value.
+ * Should not be directly used unless necessary.
+ *
+ */
+typedef struct rsv_cache_slot_t {
+  /**
+   * @brief The next slot in the same bucket, or in the free list.
+   *
+   */
+  unsigned int next;
+  /**
+   * @brief The neighbours in recency order, only used by LRU.
+   *
+   */
+  unsigned int older;
+  unsigned int newer;
+  unsigned int hash;
+  size_t weight;
+  unsigned char used;
+  /**
+   * @brief Set by reads, cleared as the CLOCK hand passes.
+   *
+   */
+  unsigned char referenced;
+} rsv_cache_slot_t;
+
+/**
+ * @brief A cache holding up to a capacity of key-value pairs, evicting the
+ * least recently used pair (LRU) or a pair not read since the clock hand last
+ * passed it (CLOCK) to make room. Pairs live inline in one slot array indexed
+ * by intrusive hash chains, so pushes do not allocate once the slots are
+ * warm. The slots grow with the amount of pairs rather than the capacity, as
+ * a weighted capacity may be far larger than the amount of pairs it holds.
+ * Make sure to cast your type from the void pointer.
+ *
+ */
+typedef struct rsv_cache_t {
+  /**
+   * @brief The slots, each slot_size bytes.
+   *
+   */
+  unsigned char* slots;
+  /**
+   * @brief The first slot of each bucket chain.
+   *
+   */
+  unsigned int* buckets;
+  /**
+   * @brief The amount of buckets, a power of two, or 0 if none could be
+   * allocated yet.
+   *
+   */
+  unsigned int bucket_amount;
+  /**
+   * @brief The amount of allocated slots.
+   *
+   */
+  unsigned int slot_amount;
+  /**
+   * @brief The amount of slots ever used, the CLOCK hand sweeps below it.
+   *
+   */
+  unsigned int slots_touched;
+  /**
+   * @brief The first free slot.
+   *
+   */
+  unsigned int free_slot;
+  /**
+   * @brief The most and least recently used slots, only used by LRU.
+   *
+   */
+  unsigned int newest;
+  unsigned int oldest;
+  /**
+   * @brief The next slot the CLOCK hand looks at.
+   *
+   */
+  unsigned int hand;
+  /**
+   * @brief The amount of key-value pairs in the cache.
+   *
+   */
+  unsigned int amount;
+  /**
+   * @brief The amount of pairs evicted to make room.
+   *
+   */
+  unsigned long evictions;
+  /**
+   * @brief The most weight the cache holds before evicting.
+   *
+   */
+  size_t capacity;
+  /**
+   * @brief The weight of the pairs in the cache.
+   *
+   */
+  size_t weight;
+  /**
+   * @brief The size of the key in memory.
+   *
+   */
+  unsigned int key_size;
+  /**
+   * @brief The size of the value in memory.
+   *
+   */
+  unsigned int value_size;
+  /**
+   * @brief The offset of the value in a slot and the size of a slot.
+   *
+   */
+  unsigned int value_offset;
+  unsigned int slot_size;
+  /**
+   * @brief RSV_CACHE_LRU or RSV_CACHE_CLOCK.
+   *
+   */
+  unsigned int policy;
+  /**
+   * @brief Use if the cache would need a custom hash function. Set to NULL for
+   * default hashing.
+   *
+   */
+  unsigned int (*custom_hash_func)(const void*, unsigned int);
+  /**
+   * @brief Use if the cache would need a custom comparing function for
+   * comparing keys. Set to NULL for default comparing.
+   *
+   */
+  int (*custom_compare_func)(const void*, const void*, unsigned int);
+  /**
+   * @brief Gets the weight of a pair, called with the key and the value, such
+   * as the bytes a value points to for a byte capacity. NULL weighs every
+   * pair as 1, for a count capacity. Set after creating the cache.
+   *
+   */
+  size_t (*weight_func)(const void*, const void*);
+  /**
+   * @brief Called with the context, the key and the value of every pair
+   * leaving the cache, whether evicted, popped, replaced by a push or
+   * destroyed, so that values owning memory can release it. Set after
+   * creating the cache, or leave NULL.
+   *
+   */
+  void (*evict_func)(void*, const void*, void*);
+  /**
+   * @brief Pointer passed to evict_func.
+   *
+   */
+  void* context;
+} rsv_cache_t;
+
+/**
+ * @brief Gets a slot. Should not be directly used unless necessary.
+ *
+ * @param cache Pointer to the cache.
+ * @param index Index of the slot.
+ * @return Pointer to the slot.
+ */
+static inline rsv_cache_slot_t* rsv_cache_slot(const rsv_cache_t* cache,
+                                               unsigned int index) {
+  return (rsv_cache_slot_t*)(cache->slots + (size_t)index * cache->slot_size);
+}
+
+/**
+ * @brief Gets the key of a slot. Should not be directly used unless necessary.
+ *
+ * @param cache Pointer to the cache.
+ * @param index Index of the slot.
+ * @return Pointer to the key.
+ */
+static inline void* rsv_cache_key(const rsv_cache_t* cache,
+                                  unsigned int index) {
+  return rsv_cache_slot(cache, index) + 1;
+}
+
+/**
+ * @brief Gets the value of a slot. Should not be directly used unless
+ * necessary.
+ *
+ * @param cache Pointer to the cache.
+ * @param index Index of the slot.
+ * @return Pointer to the value.
+ */
+static inline void* rsv_cache_value(const rsv_cache_t* cache,
+                                    unsigned int index) {
+  return (unsigned char*)rsv_cache_slot(cache, index) + cache->value_offset;
+}
+
+/**
+ * @brief Gets the bucket of a hash. Should not be directly used unless
+ * necessary.
+ *
+ * @param cache Pointer to the cache.
+ * @param hash The hash.
+ * @return Index of the bucket.
+ */
+static inline unsigned int rsv_cache_bucket(const rsv_cache_t* cache,
+                                            unsigned int hash) {
+  return (hash ^ (hash >> 15)) & (cache->bucket_amount - 1);
+}
+
+/**
+ * @brief Gets the slot holding a key. Should not be directly used unless
+ * necessary.
+ *
+ * @param cache Pointer to the cache.
+ * @param key Pointer to the key.
+ * @param hash The hash of the key.
+ * @return Index of the slot, or RSV_CACHE_NONE if the key is not cached.
+ */
+static inline unsigned int rsv_cache_find(const rsv_cache_t* cache,
+                                          const void* key, unsigned int hash) {
+  unsigned int index;
+
+  if (cache->bucket_amount == 0) {
+    return RSV_CACHE_NONE;
+  }
+
+  index = cache->buckets[rsv_cache_bucket(cache, hash)];
+
+  while (index != RSV_CACHE_NONE) {
+    rsv_cache_slot_t* slot = rsv_cache_slot(cache, index);
+
+    if (slot->hash == hash &&
+        cache->custom_compare_func(slot + 1, key, cache->key_size)) {
+      return index;
+    }
+
+    index = slot->next;
+  }
+
+  return RSV_CACHE_NONE;
+}
+
+/**
+ * @brief Unlinks a slot from the recency list. Should not be directly used
+ * unless necessary.
+ *
+ * @param cache Pointer to the cache.
+ * @param index Index of the slot.
+ */
+static inline void rsv_cache_unlink(rsv_cache_t* cache, unsigned int index) {
+  rsv_cache_slot_t* slot = rsv_cache_slot(cache, index);
+
+  if (slot->older != RSV_CACHE_NONE) {
+    rsv_cache_slot(cache, slot->older)->newer = slot->newer;
+  } else {
+    cache->oldest = slot->newer;
+  }
+
+  if (slot->newer != RSV_CACHE_NONE) {
+    rsv_cache_slot(cache, slot->newer)->older = slot->older;
+  } else {
+    cache->newest = slot->older;
+  }
+}
+
+/**
+ * @brief Links a slot as the most recently used. Should not be directly used
+ * unless necessary.
+ *
+ * @param cache Pointer to the cache.
+ * @param index Index of the slot.
+ */
+static inline void rsv_cache_link(rsv_cache_t* cache, unsigned int index) {
+  rsv_cache_slot_t* slot = rsv_cache_slot(cache, index);
+
+  slot->older = cache->newest;
+  slot->newer = RSV_CACHE_NONE;
+
+  if (cache->newest != RSV_CACHE_NONE) {
+    rsv_cache_slot(cache, cache->newest)->newer = index;
+  } else {
+    cache->oldest = index;
+  }
+
+  cache->newest = index;
+}
+
+/**
+ * @brief Doubles the buckets and relinks every used slot. Should not be
+ * directly used unless necessary.
+ *
+ * @param cache Pointer to the cache.
+ * @return 0 on success, or ENOMEM if out of memory, in which case the cache
+ * is unchanged.
+ */
+static inline int rsv_cache_rehash(rsv_cache_t* cache) {
+  unsigned int amount =
+      cache->bucket_amount ? cache->bucket_amount * 2 : RSV_CACHE_MIN_SLOTS;
+  unsigned int* buckets;
+  unsigned int i;
+
+  if (amount > RSV_CACHE_MAX_SLOTS ||
+      (buckets = (unsigned int*)malloc(amount * sizeof(unsigned int))) ==
+          NULL) {
+    return ENOMEM;
+  }
+
+  free(cache->buckets);
+  memset(buckets, 0xFF, amount * sizeof(unsigned int));
+  cache->buckets = buckets;
+  cache->bucket_amount = amount;
+
+  for (i = 0; i < cache->slots_touched; ++i) {
+    rsv_cache_slot_t* slot = rsv_cache_slot(cache, i);
+
+    if (slot->used) {
+      unsigned int bucket = rsv_cache_bucket(cache, slot->hash);
+
+      slot->next = cache->buckets[bucket];
+      cache->buckets[bucket] = i;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Grows the slots to an amount, adding the new ones to the free list.
+ * Should not be directly used unless necessary.
+ *
+ * @param cache Pointer to the cache.
+ * @param amount The new amount of slots.
+ * @return 0 on success, or ENOMEM if out of memory, in which case the cache
+ * is unchanged.
+ */
+static inline int rsv_cache_grow(rsv_cache_t* cache, unsigned int amount) {
+  unsigned char* slots =
+      (unsigned char*)realloc(cache->slots, (size_t)amount * cache->slot_size);
+  unsigned int i;
+
+  if (slots == NULL) {
+    return ENOMEM;
+  }
+
+  cache->slots = slots;
+
+  /* Free the new slots lowest first, so the CLOCK sweep stays short */
+  for (i = amount; i-- > cache->slot_amount;) {
+    rsv_cache_slot(cache, i)->used = 0;
+    rsv_cache_slot(cache, i)->next = cache->free_slot;
+    cache->free_slot = i;
+  }
+
+  cache->slot_amount = amount;
+
+  return 0;
+}
+
+/**
+ * @brief Takes a free slot, growing the slots if there is none. Should not be
+ * directly used unless necessary.
+ *
+ * @param cache Pointer to the cache.
+ * @return Index of the slot, or RSV_CACHE_NONE if out of memory.
+ */
+static inline unsigned int rsv_cache_take_slot(rsv_cache_t* cache) {
+  unsigned int index;
+
+  if (cache->free_slot == RSV_CACHE_NONE &&
+      (cache->slot_amount >= RSV_CACHE_MAX_SLOTS ||
+       rsv_cache_grow(cache, cache->slot_amount ? cache->slot_amount * 2
+                                                : RSV_CACHE_MIN_SLOTS) != 0)) {
+    return RSV_CACHE_NONE;
+  }
+
+  index = cache->free_slot;
+  cache->free_slot = rsv_cache_slot(cache, index)->next;
+
+  if (index >= cache->slots_touched) {
+    cache->slots_touched = index + 1;
+  }
+
+  return index;
+}
+
+/**
+ * @brief Removes the pair of a slot, calling the evict function. Should not be
+ * directly used unless necessary.
+ *
+ * @param cache Pointer to the cache.
+ * @param index Index of the slot.
+ */
+static inline void rsv_cache_remove(rsv_cache_t* cache, unsigned int index) {
+  rsv_cache_slot_t* slot = rsv_cache_slot(cache, index);
+  unsigned int* link = &cache->buckets[rsv_cache_bucket(cache, slot->hash)];
+
+  while (*link != index) {
+    link = &rsv_cache_slot(cache, *link)->next;
+  }
+
+  *link = slot->next;
+
+  if (cache->policy == RSV_CACHE_LRU) {
+    rsv_cache_unlink(cache, index);
+  }
+
+  if (cache->evict_func) {
+    cache->evict_func(cache->context, slot + 1,
+                      rsv_cache_value(cache, index));
+  }
+
+  cache->weight -= slot->weight;
+  cache->amount--;
+  slot->used = 0;
+  slot->next = cache->free_slot;
+  cache->free_slot = index;
+}
+
+/**
+ * @brief Picks the pair to evict. Should not be directly used unless
+ * necessary.
+ *
+ * @param cache Pointer to the cache, holding at least two pairs.
+ * @param keep Index of a slot which must not be picked.
+ * @return Index of the slot to evict.
+ */
+static inline unsigned int rsv_cache_victim(rsv_cache_t* cache,
+                                            unsigned int keep) {
+  if (cache->policy == RSV_CACHE_LRU) {
+    return cache->oldest != keep ? cache->oldest
+                                 : rsv_cache_slot(cache, keep)->newer;
+  }
+
+  /* Give every referenced pair a second chance, ends within two sweeps */
+  for (;;) {
+    unsigned int index = cache->hand;
+    rsv_cache_slot_t* slot = rsv_cache_slot(cache, index);
+
+    cache->hand = index + 1 < cache->slots_touched ? index + 1 : 0;
+
+    if (!slot->used || index == keep) {
+      continue;
+    }
+
+    if (slot->referenced) {
+      slot->referenced = 0;
+      continue;
+    }
+
+    return index;
+  }
+}
+
+/**
+ * @brief Creates a cache.
+ *
+ * @param capacity The most weight held before evicting. Pairs weigh 1 each
+ * unless a weight function is set, so this is a count of pairs by default.
+ * Up to RSV_CACHE_MAX_INITIAL_SLOTS slots are allocated up front, more as
+ * pairs are pushed.
+ * @param key_size Size of each key in memory.
+ * @param value_size Size of each value in memory.
+ * @param policy RSV_CACHE_LRU or RSV_CACHE_CLOCK. CLOCK reads only set a bit
+ * instead of reordering a list.
+ * @param custom_hash_func Pointer to a custom hash function, or NULL to use the
+ * default.
+ * @param custom_compare_func Pointer to a custom compare function, or NULL to
+ * use the default.
+ * @return A rsv_cache_t struct representing the created cache. If out of
+ * memory it has no slots yet, and pushes try to allocate them again.
+ */
+static inline rsv_cache_t rsv_cache_create(
+    size_t capacity, unsigned int key_size, unsigned int value_size,
+    unsigned int policy,
+    unsigned int (*custom_hash_func)(const void*, unsigned int),
+    int (*custom_compare_func)(const void*, const void*, unsigned int)) {
+  rsv_cache_t cache;
+  unsigned int slots = RSV_CACHE_MIN_SLOTS;
+
+  /* One spare slot, pushes insert before evicting */
+  while (slots <= capacity && slots < RSV_CACHE_MAX_INITIAL_SLOTS) {
+    slots *= 2;
+  }
+
+  cache.value_offset =
+      (unsigned int)(sizeof(rsv_cache_slot_t) +
+                     ((key_size + sizeof(void*) - 1) & ~(sizeof(void*) - 1)));
+  cache.slot_size =
+      (unsigned int)((cache.value_offset + value_size + sizeof(void*) - 1) &
+                     ~(sizeof(void*) - 1));
+  cache.slots = NULL;
+  cache.buckets = (unsigned int*)malloc(slots * sizeof(unsigned int));
+  cache.bucket_amount = 0;
+  cache.slot_amount = 0;
+  cache.slots_touched = 0;
+  cache.free_slot = RSV_CACHE_NONE;
+
+  if (cache.buckets != NULL && rsv_cache_grow(&cache, slots) == 0) {
+    memset(cache.buckets, 0xFF, slots * sizeof(unsigned int));
+    cache.bucket_amount = slots;
+  } else {
+    free(cache.buckets);
+    cache.buckets = NULL;
+  }
+
+  if (custom_hash_func == NULL) {
+    custom_hash_func = rsv_hash_table_hash;
+  }
+
+  if (custom_compare_func == NULL) {
+    custom_compare_func = rsv_hash_table_compare;
+  }
+
+  cache.newest = RSV_CACHE_NONE;
+  cache.oldest = RSV_CACHE_NONE;
+  cache.hand = 0;
+  cache.amount = 0;
+  cache.evictions = 0;
+  cache.capacity = capacity;
+  cache.weight = 0;
+  cache.key_size = key_size;
+  cache.value_size = value_size;
+  cache.policy = policy;
+  cache.custom_hash_func = custom_hash_func;
+  cache.custom_compare_func = custom_compare_func;
+  cache.weight_func = NULL;
+  cache.evict_func = NULL;
+  cache.context = NULL;
+
+  return cache;
+}
+
+/**
+ * @brief Destroys a cache, calling the evict function on every pair and
+ * freeing all associated memory.
+ *
+ * @param cache Pointer to the cache to destroy.
+ */
+static inline void rsv_cache_destroy(rsv_cache_t* cache) {
+  unsigned int i;
+
+  for (i = 0; cache->evict_func && i < cache->slots_touched; ++i) {
+    if (rsv_cache_slot(cache, i)->used) {
+      cache->evict_func(cache->context, rsv_cache_key(cache, i),
+                        rsv_cache_value(cache, i));
+    }
+  }
+
+  free(cache->slots);
+  free(cache->buckets);
+  cache->slots = NULL;
+  cache->buckets = NULL;
+  cache->bucket_amount = 0;
+  cache->slot_amount = 0;
+  cache->slots_touched = 0;
+  cache->free_slot = RSV_CACHE_NONE;
+  cache->amount = 0;
+  cache->weight = 0;
+}
+
+/**
+ * @brief Retrieves the value associated with the specified key, marking the
+ * pair as recently used.
+ *
+ * @param cache Pointer to the cache.
+ * @param key Pointer to the key.
+ * @return Pointer to the value associated with the key, or NULL if the key is
+ * not cached. Only valid until the cache is next changed.
+ */
+static inline void* rsv_cache_get(rsv_cache_t* cache, const void* key) {
+  unsigned int index = rsv_cache_find(
+      cache, key, cache->custom_hash_func(key, cache->key_size));
+
+  if (index == RSV_CACHE_NONE) {
+    return NULL;
+  }
+
+  if (cache->policy == RSV_CACHE_LRU) {
+    if (cache->newest != index) {
+      rsv_cache_unlink(cache, index);
+      rsv_cache_link(cache, index);
+    }
+  } else {
+    rsv_cache_slot(cache, index)->referenced = 1;
+  }
+
+  return rsv_cache_value(cache, index);
+}
+
+/**
+ * @brief Adds a key-value pair to the cache, replacing the value if the key is
+ * already cached, then evicts other pairs until the weight fits the capacity.
+ *
+ * @param cache Pointer to the cache.
+ * @param key Pointer to the key.
+ * @param value Pointer to the value.
+ * @return 0 on success, or ENOMEM if out of memory, in which case the cache
+ * is unchanged.
+ */
+static inline int rsv_cache_push(rsv_cache_t* cache, const void* key,
+                                  const void* value) {
+  unsigned int hash = cache->custom_hash_func(key, cache->key_size);
+  unsigned int index = rsv_cache_find(cache, key, hash);
+  size_t weight = cache->weight_func ? cache->weight_func(key, value) : 1;
+  rsv_cache_slot_t* slot;
+
+  if (index != RSV_CACHE_NONE) {
+    slot = rsv_cache_slot(cache, index);
+
+    if (cache->evict_func) {
+      cache->evict_func(cache->context, slot + 1,
+                        rsv_cache_value(cache, index));
+    }
+
+    if (cache->policy == RSV_CACHE_LRU) {
+      rsv_cache_unlink(cache, index);
+      rsv_cache_link(cache, index);
+    } else {
+      slot->referenced = 1;
+    }
+
+    cache->weight -= slot->weight;
+  } else {
+    unsigned int bucket;
+
+    if (cache->amount >= cache->bucket_amount && rsv_cache_rehash(cache) != 0) {
+      return ENOMEM;
+    }
+
+    index = rsv_cache_take_slot(cache);
+
+    if (index == RSV_CACHE_NONE) {
+      return ENOMEM;
+    }
+
+    slot = rsv_cache_slot(cache, index);
+    bucket = rsv_cache_bucket(cache, hash);
+    slot->next = cache->buckets[bucket];
+    slot->hash = hash;
+    slot->used = 1;
+    slot->referenced = 0;
+    cache->buckets[bucket] = index;
+    memcpy(slot + 1, key, cache->key_size);
+
+    if (cache->policy == RSV_CACHE_LRU) {
+      rsv_cache_link(cache, index);
+    }
+
+    cache->amount++;
+  }
+
+  memcpy(rsv_cache_value(cache, index), value, cache->value_size);
+  slot->weight = weight;
+  cache->weight += weight;
+
+  while (cache->weight > cache->capacity && cache->amount > 1) {
+    rsv_cache_remove(cache, rsv_cache_victim(cache, index));
+    cache->evictions++;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Removes a key-value pair from the cache, calling the evict function.
+ *
+ * @param cache Pointer to the cache.
+ * @param key Pointer to the key of the pair to remove.
+ * @return 1 if the pair was removed, 0 if the key was not cached.
+ */
+static inline int rsv_cache_pop(rsv_cache_t* cache, const void* key) {
+  unsigned int index = rsv_cache_find(
+      cache, key, cache->custom_hash_func(key, cache->key_size));
+
+  if (index == RSV_CACHE_NONE) {
+    return 0;
+  }
+
+  rsv_cache_remove(cache, index);
+
+  return 1;
+}
+
+#if defined(__unix__)
+
+#include "../threads/threads_pthreads.h"
+
+/**
+ * @brief A shard of a concurrent cache. Should not be directly used unless
+ * necessary.
+ *
+ */
+typedef struct rsv_concurrent_cache_shard_t {
+  rsv_rwlock_t lock;
+  rsv_cache_t cache;
+} RSV_CACHE_ALIGNED rsv_concurrent_cache_shard_t;
+
+/**
+ * @brief A cache which can be shared between threads. Keys are partitioned
+ * over independently locked shards, each a rsv_cache_t with an even part of
+ * the capacity. CLOCK reads only take the lock shared, LRU reads reorder a
+ * list and take it exclusively.
+ *
+ */
+typedef struct rsv_concurrent_cache_t {
+  /**
+   * @brief The shards of the cache.
+   *
+   */
+  rsv_concurrent_cache_shard_t* shards;
+  /**
+   * @brief The amount of shards, always a power of two.
+   *
+   */
+  unsigned int shard_amount;
+  /**
+   * @brief The amount of bits the mixed hash is shifted by to get the shard.
+   *
+   */
+  unsigned int shard_shift;
+  /**
+   * @brief The size of the key in memory.
+   *
+   */
+  unsigned int key_size;
+  /**
+   * @brief The size of the value in memory.
+   *
+   */
+  unsigned int value_size;
+  /**
+   * @brief RSV_CACHE_LRU or RSV_CACHE_CLOCK.
+   *
+   */
+  unsigned int policy;
+  /**
+   * @brief Use if the cache would need a custom hash function. Set to NULL for
+   * default hashing.
+   *
+   */
+  unsigned int (*custom_hash_func)(const void*, unsigned int);
+} rsv_concurrent_cache_t;
+
+/**
+ * @brief Creates a concurrent cache.
+ *
+ * @param cache Pointer to the concurrent cache to initialize.
+ * @param shard_amount Amount of shards, rounded up to a power of two.
+ * @param capacity The most weight held by the whole cache, split over the
+ * shards.
+ * @param key_size Size of each key in memory.
+ * @param value_size Size of each value in memory.
+ * @param policy RSV_CACHE_LRU or RSV_CACHE_CLOCK.
+ * @param custom_hash_func Pointer to a custom hash function, or NULL to use the
+ * default.
+ * @param custom_compare_func Pointer to a custom compare function, or NULL to
+ * use the default.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_concurrent_cache_create(
+    rsv_concurrent_cache_t* cache, unsigned int shard_amount, size_t capacity,
+    unsigned int key_size, unsigned int value_size, unsigned int policy,
+    unsigned int (*custom_hash_func)(const void*, unsigned int),
+    int (*custom_compare_func)(const void*, const void*, unsigned int)) {
+  unsigned int amount = 1;
+  unsigned int shift = 32;
+  size_t shard_capacity;
+  unsigned int i;
+  void* shards;
+
+  while (amount < shard_amount) {
+    amount *= 2;
+    shift--;
+  }
+
+  shard_capacity = capacity / amount > 0 ? capacity / amount : 1;
+
+  if (posix_memalign(&shards, RSV_CACHE_LINE_SIZE,
+                     amount * sizeof(rsv_concurrent_cache_shard_t)) != 0) {
+    return ENOMEM;
+  }
+
+  if (custom_hash_func == NULL) {
+    custom_hash_func = rsv_hash_table_hash;
+  }
+
+  cache->shards = (rsv_concurrent_cache_shard_t*)shards;
+  cache->shard_amount = amount;
+  cache->shard_shift = shift;
+  cache->key_size = key_size;
+  cache->value_size = value_size;
+  cache->policy = policy;
+  cache->custom_hash_func = custom_hash_func;
+
+  for (i = 0; i < amount; ++i) {
+    int result = rsv_rwlock_create(&cache->shards[i].lock);
+
+    if (result != 0) {
+      while (i-- > 0) {
+        rsv_cache_destroy(&cache->shards[i].cache);
+        rsv_rwlock_destroy(&cache->shards[i].lock);
+      }
+
+      free(cache->shards);
+      cache->shards = NULL;
+      cache->shard_amount = 0;
+      return result;
+    }
+
+    cache->shards[i].cache =
+        rsv_cache_create(shard_capacity, key_size, value_size, policy,
+                         custom_hash_func, custom_compare_func);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Sets the weight and evict functions of every shard. Call before
+ * sharing the cache with other threads. The evict function runs while the
+ * shard of the pair is locked, so it must not use the cache.
+ *
+ * @param cache Pointer to the concurrent cache.
+ * @param weight_func Pointer to the weight function, or NULL to weigh every
+ * pair as 1.
+ * @param evict_func Pointer to the evict function, or NULL.
+ * @param context Pointer passed to the evict function.
+ */
+static inline void rsv_concurrent_cache_callbacks(
+    rsv_concurrent_cache_t* cache,
+    size_t (*weight_func)(const void*, const void*),
+    void (*evict_func)(void*, const void*, void*), void* context) {
+  unsigned int i;
+
+  for (i = 0; i < cache->shard_amount; ++i) {
+    cache->shards[i].cache.weight_func = weight_func;
+    cache->shards[i].cache.evict_func = evict_func;
+    cache->shards[i].cache.context = context;
+  }
+}
+
+/**
+ * @brief Destroys a concurrent cache, calling the evict function on every pair
+ * and freeing all associated memory. No other thread may use the cache at the
+ * same time.
+ *
+ * @param cache Pointer to the concurrent cache to destroy.
+ */
+static inline void rsv_concurrent_cache_destroy(rsv_concurrent_cache_t* cache) {
+  unsigned int i;
+
+  for (i = 0; i < cache->shard_amount; ++i) {
+    rsv_cache_destroy(&cache->shards[i].cache);
+    rsv_rwlock_destroy(&cache->shards[i].lock);
+  }
+
+  free(cache->shards);
+  cache->shards = NULL;
+  cache->shard_amount = 0;
+}
+
+/**
+ * @brief Gets the shard which owns a hash, from the top bits of the mixed
+ * hash so that it does not correlate with the bucket within the shard.
+ * Should not be directly used unless necessary.
+ *
+ * @param cache Pointer to the concurrent cache.
+ * @param hash The hash of the key.
+ * @return Pointer to the shard.
+ */
+static inline rsv_concurrent_cache_shard_t*
+rsv_concurrent_cache_shard(rsv_concurrent_cache_t* cache, unsigned int hash) {
+  if (cache->shard_amount == 1) {
+    return cache->shards;
+  }
+
+  return &cache->shards[(hash * 2654435769u) >> cache->shard_shift];
+}
+
+/**
+ * @brief Retrieves a copy of the value associated with the specified key,
+ * marking the pair as recently used.
+ *
+ * @param cache Pointer to the concurrent cache.
+ * @param key Pointer to the key.
+ * @param value Pointer to where the value is copied, or NULL to only check
+ * for the key.
+ * @return 1 if the key was found, 0 otherwise.
+ */
+static inline int rsv_concurrent_cache_get(rsv_concurrent_cache_t* cache,
+                                           const void* key, void* value) {
+  unsigned int hash = cache->custom_hash_func(key, cache->key_size);
+  rsv_concurrent_cache_shard_t* shard = rsv_concurrent_cache_shard(cache, hash);
+  unsigned int index;
+
+  if (cache->policy == RSV_CACHE_LRU) {
+    void* found;
+
+    rsv_rwlock_write_lock(&shard->lock);
+    found = rsv_cache_get(&shard->cache, key);
+
+    if (found && value) {
+      memcpy(value, found, cache->value_size);
+    }
+
+    rsv_rwlock_unlock(&shard->lock);
+
+    return found != NULL;
+  }
+
+  rsv_rwlock_read_lock(&shard->lock);
+  index = rsv_cache_find(&shard->cache, key, hash);
+
+  if (index != RSV_CACHE_NONE) {
+    if (value) {
+      memcpy(value, rsv_cache_value(&shard->cache, index), cache->value_size);
+    }
+
+    /* Readers share the lock, so the bit is set atomically */
+    rsv_atomic_store(&rsv_cache_slot(&shard->cache, index)->referenced, 1,
+                     RSV_MEMORY_ORDER_RELAXED);
+  }
+
+  rsv_rwlock_unlock(&shard->lock);
+
+  return index != RSV_CACHE_NONE;
+}
+
+/**
+ * @brief Adds a key-value pair to the concurrent cache, like rsv_cache_push.
+ *
+ * @param cache Pointer to the concurrent cache.
+ * @param key Pointer to the key.
+ * @param value Pointer to the value.
+ * @return 0 on success, or ENOMEM if out of memory, in which case the cache
+ * is unchanged.
+ */
+static inline int rsv_concurrent_cache_push(rsv_concurrent_cache_t* cache,
+                                            const void* key,
+                                            const void* value) {
+  rsv_concurrent_cache_shard_t* shard = rsv_concurrent_cache_shard(
+      cache, cache->custom_hash_func(key, cache->key_size));
+  int result;
+
+  rsv_rwlock_write_lock(&shard->lock);
+  result = rsv_cache_push(&shard->cache, key, value);
+  rsv_rwlock_unlock(&shard->lock);
+
+  return result;
+}
+
+/**
+ * @brief Removes a key-value pair from the concurrent cache.
+ *
+ * @param cache Pointer to the concurrent cache.
+ * @param key Pointer to the key of the pair to remove.
+ * @return 1 if the pair was removed, 0 if the key was not cached.
+ */
+static inline int rsv_concurrent_cache_pop(rsv_concurrent_cache_t* cache,
+                                           const void* key) {
+  rsv_concurrent_cache_shard_t* shard = rsv_concurrent_cache_shard(
+      cache, cache->custom_hash_func(key, cache->key_size));
+  int popped;
+
+  rsv_rwlock_write_lock(&shard->lock);
+  popped = rsv_cache_pop(&shard->cache, key);
+  rsv_rwlock_unlock(&shard->lock);
+
+  return popped;
+}
+
+/**
+ * @brief Gets the amount of pairs in the concurrent cache. Pairs pushed or
+ * popped concurrently may or may not be counted.
+ *
+ * @param cache Pointer to the concurrent cache.
+ * @return The amount of pairs.
+ */
+static inline unsigned int
+rsv_concurrent_cache_amount(rsv_concurrent_cache_t* cache) {
+  unsigned int amount = 0;
+  unsigned int i;
+
+  for (i = 0; i < cache->shard_amount; ++i) {
+    rsv_rwlock_read_lock(&cache->shards[i].lock);
+    amount += cache->shards[i].cache.amount;
+    rsv_rwlock_unlock(&cache->shards[i].lock);
+  }
+
+  return amount;
+}
+
+#endif
+
+#endif /* RSV_CACHE_H */
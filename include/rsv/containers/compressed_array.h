@@ -0,0 +1,535 @@
+/*
+  compressed_array.h
+  Implementation of a compressed array of 64 bit integers
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#ifndef RSV_COMPRESSED_ARRAY_H
+#define RSV_COMPRESSED_ARRAY_H
+
+#include "dynamic_array.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RSV_COMPRESSED_ARRAY_BLOCK_SIZE 128
+#define RSV_COMPRESSED_ARRAY_LANES 4
+#define RSV_COMPRESSED_ARRAY_SLACK (RSV_COMPRESSED_ARRAY_LANES * 16)
+#define RSV_COMPRESSED_ARRAY_NO_BLOCK ((size_t)-1)
+
+#define RSV_COMPRESSED_ARRAY_FOR 0
+#define RSV_COMPRESSED_ARRAY_DELTA 1
+#define RSV_COMPRESSED_ARRAY_VARINT 2
+
+/* MSVC only accepts restrict in C as __restrict */
+#if !defined(RSV_RESTRICT)
+#if defined(_MSC_VER)
+#define RSV_RESTRICT __restrict
+#else
+#define RSV_RESTRICT restrict
+#endif
+#endif
+
+/**
+ * @brief The header of a compressed block. Should not be directly used unless
+ * necessary.
+ *
+ */
+typedef struct rsv_compressed_array_block_t {
+  /**
+   * @brief The lowest value for FOR, the first value otherwise.
+   *
+   */
+  uint64_t base;
+  /**
+   * @brief The lowest difference between neighbouring values, only used by
+   * DELTA.
+   *
+   */
+  uint64_t reference;
+  /**
+   * @brief The offset of the block in the data, always a multiple of 8.
+   *
+   */
+  size_t offset;
+  /**
+   * @brief RSV_COMPRESSED_ARRAY_FOR, DELTA or VARINT.
+   *
+   */
+  unsigned char encoding;
+  /**
+   * @brief The bits per packed value, only used by FOR and DELTA.
+   *
+   */
+  unsigned char width;
+} rsv_compressed_array_block_t;
+
+/**
+ * @brief An append-only array of 64 bit integers compressed in blocks of
+ * RSV_COMPRESSED_ARRAY_BLOCK_SIZE values. Each block is stored as the smallest
+ * of frame of reference bit-packing (FOR, values minus the lowest one),
+ * bit-packed differences between neighbouring values (DELTA) or zigzag varint
+ * differences (VARINT). Packed values are interleaved over
+ * RSV_COMPRESSED_ARRAY_LANES lanes of 64 bit words, so the decode loops work
+ * on whole vectors and compilers can vectorize them.
+ *
+ */
+typedef struct rsv_compressed_array_t {
+  /**
+   * @brief The header of each compressed block.
+   *
+   */
+  rsv_dynamic_array_t blocks;
+  /**
+   * @brief The compressed blocks, followed by RSV_COMPRESSED_ARRAY_SLACK
+   * zeroed bytes so that decoding may read past the last block.
+   *
+   */
+  unsigned char* data;
+  size_t data_size;
+  size_t data_capacity;
+  /**
+   * @brief The values pushed since the last full block.
+   *
+   */
+  uint64_t* pending;
+  /**
+   * @brief The last block decoded by rsv_compressed_array_get.
+   *
+   */
+  uint64_t* cache;
+  size_t cached_block;
+  /**
+   * @brief The amount of values in the array.
+   *
+   */
+  size_t amount;
+} rsv_compressed_array_t;
+
+/**
+ * @brief Gets the bits needed to store a value. Should not be directly used
+ * unless necessary.
+ *
+ * @param value The value.
+ * @return The amount of bits.
+ */
+static inline unsigned int rsv_compressed_array_width(uint64_t value) {
+  unsigned int width = 0;
+
+  while (value) {
+    width++;
+    value >>= 1;
+  }
+
+  return width;
+}
+
+/**
+ * @brief Gets the bytes taken by a block packed at a width. Should not be
+ * directly used unless necessary.
+ *
+ * @param width The bits per value.
+ * @return The amount of bytes, a multiple of 8.
+ */
+static inline size_t rsv_compressed_array_packed_size(unsigned int width) {
+  unsigned int per_lane =
+      RSV_COMPRESSED_ARRAY_BLOCK_SIZE / RSV_COMPRESSED_ARRAY_LANES;
+
+  return (size_t)(per_lane * width + 63) / 64 * RSV_COMPRESSED_ARRAY_LANES * 8;
+}
+
+/**
+ * @brief Gets a mask of the low bits of a width. Should not be directly used
+ * unless necessary.
+ *
+ * @param width The bits per value.
+ * @return The mask.
+ */
+static inline uint64_t rsv_compressed_array_mask(unsigned int width) {
+  return width == 64 ? ~(uint64_t)0 : ((uint64_t)1 << width) - 1;
+}
+
+/**
+ * @brief Packs a block of values. Value i is stored in lane i %
+ * RSV_COMPRESSED_ARRAY_LANES, so neighbouring values sit in neighbouring words
+ * at the same bit position. Should not be directly used unless necessary.
+ *
+ * @param words Pointer to the zeroed words to pack into.
+ * @param values Pointer to the values, each fitting the width.
+ * @param width The bits per value.
+ */
+static inline void rsv_compressed_array_pack(uint64_t* words,
+                                             const uint64_t* values,
+                                             unsigned int width) {
+  unsigned int k;
+  unsigned int lane;
+
+  for (k = 0; k < RSV_COMPRESSED_ARRAY_BLOCK_SIZE / RSV_COMPRESSED_ARRAY_LANES;
+       ++k) {
+    unsigned int bit = k * width;
+    unsigned int shift = bit & 63;
+    uint64_t* low = words + (bit >> 6) * RSV_COMPRESSED_ARRAY_LANES;
+
+    for (lane = 0; lane < RSV_COMPRESSED_ARRAY_LANES; ++lane) {
+      uint64_t value = values[k * RSV_COMPRESSED_ARRAY_LANES + lane];
+
+      low[lane] |= value << shift;
+
+      if (shift + width > 64) {
+        low[RSV_COMPRESSED_ARRAY_LANES + lane] |= value >> (64 - shift);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Unpacks a block of values. The inner loop does the same shifts for
+ * every lane and has no branches, so it vectorizes to one vector of lanes per
+ * step. Should not be directly used unless necessary.
+ *
+ * @param words Pointer to the packed words, readable RSV_COMPRESSED_ARRAY_SLACK
+ * bytes past the block.
+ * @param width The bits per value.
+ * @param values Pointer to where the values are unpacked.
+ */
+static inline void
+rsv_compressed_array_unpack(const uint64_t* RSV_RESTRICT words,
+                            unsigned int width, uint64_t* RSV_RESTRICT values) {
+  uint64_t mask = rsv_compressed_array_mask(width);
+  unsigned int k;
+  unsigned int lane;
+
+  for (k = 0; k < RSV_COMPRESSED_ARRAY_BLOCK_SIZE / RSV_COMPRESSED_ARRAY_LANES;
+       ++k) {
+    unsigned int bit = k * width;
+    unsigned int shift = bit & 63;
+    const uint64_t* low = words + (bit >> 6) * RSV_COMPRESSED_ARRAY_LANES;
+    const uint64_t* high = low + RSV_COMPRESSED_ARRAY_LANES;
+
+    /* Bits from the next word land above the width unless the value spans
+     * both, and shifting in two steps keeps a zero shift defined */
+    for (lane = 0; lane < RSV_COMPRESSED_ARRAY_LANES; ++lane) {
+      values[k * RSV_COMPRESSED_ARRAY_LANES + lane] =
+          ((low[lane] >> shift) | ((high[lane] << 1) << (63 - shift))) & mask;
+    }
+  }
+}
+
+/**
+ * @brief Makes room for a block in the data. Should not be directly used
+ * unless necessary.
+ *
+ * @param array Pointer to the compressed array.
+ * @param size The size of the block.
+ */
+static inline void rsv_compressed_array_reserve(rsv_compressed_array_t* array,
+                                                size_t size) {
+  size_t needed = array->data_size + size + RSV_COMPRESSED_ARRAY_SLACK;
+
+  if (needed > array->data_capacity) {
+    size_t capacity =
+        (size_t)(array->data_capacity * RSV_DYNAMIC_ARRAY_GROWTH_AMOUNT + 1);
+
+    array->data_capacity = capacity > needed ? capacity : needed;
+    array->data = (unsigned char*)realloc(array->data, array->data_capacity);
+  }
+
+  memset(array->data + array->data_size, 0, size + RSV_COMPRESSED_ARRAY_SLACK);
+}
+
+/**
+ * @brief Compresses the pending values into a block. Should not be directly
+ * used unless necessary.
+ *
+ * @param array Pointer to the compressed array.
+ */
+static inline void rsv_compressed_array_flush(rsv_compressed_array_t* array) {
+  uint64_t* values = array->pending;
+  uint64_t scratch[RSV_COMPRESSED_ARRAY_BLOCK_SIZE];
+  rsv_compressed_array_block_t block;
+  uint64_t minimum = values[0];
+  uint64_t maximum = values[0];
+  int64_t lowest_delta = 0;
+  int64_t highest_delta = 0;
+  unsigned int for_width;
+  unsigned int delta_width;
+  size_t varint_size = 0;
+  size_t size;
+  unsigned int i;
+
+  for (i = 0; i < RSV_COMPRESSED_ARRAY_BLOCK_SIZE; ++i) {
+    uint64_t difference = values[i] - (i > 0 ? values[i - 1] : 0);
+    int64_t delta = (int64_t)difference;
+    uint64_t zigzag =
+        i > 0 ? (difference << 1) ^ (0 - (difference >> 63)) : values[0];
+
+    minimum = values[i] < minimum ? values[i] : minimum;
+    maximum = values[i] > maximum ? values[i] : maximum;
+
+    if (i == 1 || (i > 1 && delta < lowest_delta)) {
+      lowest_delta = delta;
+    }
+
+    if (i == 1 || (i > 1 && delta > highest_delta)) {
+      highest_delta = delta;
+    }
+
+    do {
+      varint_size++;
+      zigzag >>= 7;
+    } while (zigzag);
+  }
+
+  for_width = rsv_compressed_array_width(maximum - minimum);
+  delta_width = rsv_compressed_array_width((uint64_t)highest_delta -
+                                           (uint64_t)lowest_delta);
+  varint_size = (varint_size + 7) & ~(size_t)7;
+  block.offset = array->data_size;
+  block.reference = (uint64_t)lowest_delta;
+
+  /* Prefer FOR on ties, it is the only encoding with O(1) random access */
+  if (rsv_compressed_array_packed_size(for_width) <=
+          rsv_compressed_array_packed_size(delta_width) &&
+      rsv_compressed_array_packed_size(for_width) <= varint_size) {
+    block.encoding = RSV_COMPRESSED_ARRAY_FOR;
+    block.base = minimum;
+    block.width = (unsigned char)for_width;
+    size = rsv_compressed_array_packed_size(for_width);
+
+    for (i = 0; i < RSV_COMPRESSED_ARRAY_BLOCK_SIZE; ++i) {
+      scratch[i] = values[i] - minimum;
+    }
+
+    rsv_compressed_array_reserve(array, size);
+    rsv_compressed_array_pack((uint64_t*)(array->data + block.offset), scratch,
+                              for_width);
+  } else if (rsv_compressed_array_packed_size(delta_width) <= varint_size) {
+    block.encoding = RSV_COMPRESSED_ARRAY_DELTA;
+    block.base = values[0];
+    block.width = (unsigned char)delta_width;
+    size = rsv_compressed_array_packed_size(delta_width);
+    scratch[0] = 0;
+
+    for (i = 1; i < RSV_COMPRESSED_ARRAY_BLOCK_SIZE; ++i) {
+      scratch[i] = values[i] - values[i - 1] - block.reference;
+    }
+
+    rsv_compressed_array_reserve(array, size);
+    rsv_compressed_array_pack((uint64_t*)(array->data + block.offset), scratch,
+                              delta_width);
+  } else {
+    unsigned char* output;
+
+    block.encoding = RSV_COMPRESSED_ARRAY_VARINT;
+    block.base = values[0];
+    block.width = 0;
+    size = varint_size;
+    rsv_compressed_array_reserve(array, size);
+    output = array->data + block.offset;
+
+    for (i = 0; i < RSV_COMPRESSED_ARRAY_BLOCK_SIZE; ++i) {
+      uint64_t difference = values[i] - (i > 0 ? values[i - 1] : 0);
+      uint64_t zigzag =
+          i > 0 ? (difference << 1) ^ (0 - (difference >> 63)) : values[0];
+
+      while (zigzag >= 0x80) {
+        *output++ = (unsigned char)(zigzag | 0x80);
+        zigzag >>= 7;
+      }
+
+      *output++ = (unsigned char)zigzag;
+    }
+  }
+
+  array->data_size += size;
+  rsv_dynamic_array_push(&array->blocks, &block);
+}
+
+/**
+ * @brief Creates a compressed array.
+ *
+ * @return A rsv_compressed_array_t struct representing the created compressed
+ * array.
+ */
+static inline rsv_compressed_array_t rsv_compressed_array_create(void) {
+  rsv_compressed_array_t array;
+
+  array.blocks =
+      rsv_dynamic_array_create(0, sizeof(rsv_compressed_array_block_t));
+  array.data = (unsigned char*)calloc(1, RSV_COMPRESSED_ARRAY_SLACK);
+  array.data_size = 0;
+  array.data_capacity = RSV_COMPRESSED_ARRAY_SLACK;
+  array.pending = (uint64_t*)malloc(RSV_COMPRESSED_ARRAY_BLOCK_SIZE * 2 *
+                                    sizeof(uint64_t));
+  array.cache = array.pending + RSV_COMPRESSED_ARRAY_BLOCK_SIZE;
+  array.cached_block = RSV_COMPRESSED_ARRAY_NO_BLOCK;
+  array.amount = 0;
+
+  return array;
+}
+
+/**
+ * @brief Destroys a compressed array, freeing all associated memory.
+ *
+ * @param array Pointer to the compressed array to destroy.
+ */
+static inline void rsv_compressed_array_destroy(rsv_compressed_array_t* array) {
+  rsv_dynamic_array_destroy(&array->blocks);
+  free(array->data);
+  free(array->pending);
+  array->data = NULL;
+  array->pending = NULL;
+  array->cache = NULL;
+  array->data_size = 0;
+  array->data_capacity = 0;
+  array->amount = 0;
+}
+
+/**
+ * @brief Adds a value to the end of the compressed array. Every
+ * RSV_COMPRESSED_ARRAY_BLOCK_SIZE values are compressed into a block.
+ *
+ * @param array Pointer to the compressed array.
+ * @param value The value to add.
+ */
+static inline void rsv_compressed_array_push(rsv_compressed_array_t* array,
+                                             uint64_t value) {
+  array->pending[array->amount % RSV_COMPRESSED_ARRAY_BLOCK_SIZE] = value;
+  array->amount++;
+
+  if (array->amount % RSV_COMPRESSED_ARRAY_BLOCK_SIZE == 0) {
+    rsv_compressed_array_flush(array);
+  }
+}
+
+/**
+ * @brief Decodes a block of values, for sequential scans.
+ *
+ * @param array Pointer to the compressed array.
+ * @param block Index of the block, the value index divided by
+ * RSV_COMPRESSED_ARRAY_BLOCK_SIZE.
+ * @param values Pointer to room for RSV_COMPRESSED_ARRAY_BLOCK_SIZE values.
+ * @return The amount of values decoded, less than a block for the last
+ * block and 0 past it.
+ */
+static inline unsigned int
+rsv_compressed_array_decode(const rsv_compressed_array_t* array, size_t block,
+                            uint64_t* values) {
+  const rsv_compressed_array_block_t* header;
+  const unsigned char* input;
+  unsigned int i;
+
+  if (block >= array->blocks.amount) {
+    unsigned int pending = array->amount % RSV_COMPRESSED_ARRAY_BLOCK_SIZE;
+
+    if (block > array->blocks.amount) {
+      return 0;
+    }
+
+    memcpy(values, array->pending, pending * sizeof(uint64_t));
+
+    return pending;
+  }
+
+  header = (const rsv_compressed_array_block_t*)array->blocks.data + block;
+  input = array->data + header->offset;
+
+  switch (header->encoding) {
+  case RSV_COMPRESSED_ARRAY_FOR:
+    rsv_compressed_array_unpack((const uint64_t*)input, header->width, values);
+
+    for (i = 0; i < RSV_COMPRESSED_ARRAY_BLOCK_SIZE; ++i) {
+      values[i] += header->base;
+    }
+    break;
+  case RSV_COMPRESSED_ARRAY_DELTA:
+    rsv_compressed_array_unpack((const uint64_t*)input, header->width, values);
+    values[0] = header->base;
+
+    for (i = 1; i < RSV_COMPRESSED_ARRAY_BLOCK_SIZE; ++i) {
+      values[i] += values[i - 1] + header->reference;
+    }
+    break;
+  default:
+    for (i = 0; i < RSV_COMPRESSED_ARRAY_BLOCK_SIZE; ++i) {
+      uint64_t zigzag = 0;
+      unsigned int shift = 0;
+
+      do {
+        zigzag |= (uint64_t)(*input & 0x7F) << shift;
+        shift += 7;
+      } while (*input++ & 0x80);
+
+      values[i] = i > 0 ? values[i - 1] + ((zigzag >> 1) ^ (0 - (zigzag & 1)))
+                        : zigzag;
+    }
+    break;
+  }
+
+  return RSV_COMPRESSED_ARRAY_BLOCK_SIZE;
+}
+
+/**
+ * @brief Gets the value at the specified index. FOR blocks are read in place,
+ * other blocks are decoded once and kept until another block is read, so
+ * reading indices in order decodes each block once.
+ *
+ * @param array Pointer to the compressed array.
+ * @param index Index of the value.
+ * @return The value, or 0 if the index is out of range.
+ */
+static inline uint64_t rsv_compressed_array_get(rsv_compressed_array_t* array,
+                                                size_t index) {
+  size_t block = index / RSV_COMPRESSED_ARRAY_BLOCK_SIZE;
+  unsigned int position =
+      (unsigned int)(index % RSV_COMPRESSED_ARRAY_BLOCK_SIZE);
+  const rsv_compressed_array_block_t* header;
+
+  if (index >= array->amount) {
+    return 0;
+  }
+
+  if (block == array->blocks.amount) {
+    return array->pending[position];
+  }
+
+  header = (const rsv_compressed_array_block_t*)array->blocks.data + block;
+
+  if (header->encoding == RSV_COMPRESSED_ARRAY_FOR) {
+    unsigned int bit =
+        position / RSV_COMPRESSED_ARRAY_LANES * (unsigned int)header->width;
+    unsigned int shift = bit & 63;
+    const uint64_t* low = (const uint64_t*)(array->data + header->offset) +
+                          (bit >> 6) * RSV_COMPRESSED_ARRAY_LANES +
+                          position % RSV_COMPRESSED_ARRAY_LANES;
+
+    return (((low[0] >> shift) |
+             ((low[RSV_COMPRESSED_ARRAY_LANES] << 1) << (63 - shift))) &
+            rsv_compressed_array_mask(header->width)) +
+           header->base;
+  }
+
+  if (array->cached_block != block) {
+    rsv_compressed_array_decode(array, block, array->cache);
+    array->cached_block = block;
+  }
+
+  return array->cache[position];
+}
+
+/**
+ * @brief Gets the bytes taken by the compressed blocks and their headers.
+ *
+ * @param array Pointer to the compressed array.
+ * @return The amount of bytes.
+ */
+static inline size_t
+rsv_compressed_array_size(const rsv_compressed_array_t* array) {
+  return array->data_size +
+         array->blocks.amount * sizeof(rsv_compressed_array_block_t);
+}
+
+#endif /* RSV_COMPRESSED_ARRAY_H */
@@ -0,0 +1,260 @@
+/*
+  concurrent_hash_table.h
+  Implementation of a concurrent hash table sharded over reader-writer locks
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#if defined(__unix__)
+
+#ifndef RSV_CONCURRENT_HASH_TABLE_H
+#define RSV_CONCURRENT_HASH_TABLE_H
+
+#include "../threads/threads_pthreads.h"
+#include "hash_table.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief A shard of a concurrent hash table. Should not be directly used
+ * unless necessary.
+ *
+ */
+typedef struct rsv_concurrent_hash_table_shard_t {
+  rsv_rwlock_t lock;
+  rsv_hash_table_t hash_table;
+} RSV_CACHE_ALIGNED rsv_concurrent_hash_table_shard_t;
+
+/**
+ * @brief A hash table which can be shared between threads. Keys are
+ * partitioned over independently locked shards, each a rsv_hash_table_t that
+ * resizes on its own, so threads working on different shards never wait on
+ * each other and lookups within a shard run in parallel.
+ *
+ */
+typedef struct rsv_concurrent_hash_table_t {
+  /**
+   * @brief The shards of the hash table.
+   *
+   */
+  rsv_concurrent_hash_table_shard_t* shards;
+  /**
+   * @brief The amount of shards, always a power of two.
+   *
+   */
+  unsigned int shard_amount;
+  /**
+   * @brief The amount of bits the mixed hash is shifted by to get the shard.
+   *
+   */
+  unsigned int shard_shift;
+  /**
+   * @brief The size of the key in memory.
+   *
+   */
+  unsigned int key_size;
+  /**
+   * @brief The size of the value in memory.
+   *
+   */
+  unsigned int value_size;
+  /**
+   * @brief Use if the hash table would need a custom hash function. Set to NULL
+   * for default hashing.
+   *
+   */
+  unsigned int (*custom_hash_func)(const void*, unsigned int);
+} rsv_concurrent_hash_table_t;
+
+/**
+ * @brief Creates a concurrent hash table.
+ *
+ * @param hash_table Pointer to the concurrent hash table to initialize.
+ * @param shard_amount Amount of shards, rounded up to a power of two.
+ * @param capacity Initial capacity of the whole hash table, split over the
+ * shards.
+ * @param key_size Size of each key in memory.
+ * @param value_size Size of each value in memory.
+ * @param custom_hash_func Pointer to a custom hash function, or NULL to use the
+ * default.
+ * @param custom_compare_func Pointer to a custom compare function, or NULL to
+ * use the default.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_concurrent_hash_table_create(
+    rsv_concurrent_hash_table_t* hash_table, unsigned int shard_amount,
+    unsigned int capacity, unsigned int key_size, unsigned int value_size,
+    unsigned int (*custom_hash_func)(const void*, unsigned int),
+    int (*custom_compare_func)(const void*, const void*, unsigned int)) {
+  unsigned int amount = 1;
+  unsigned int shift = 32;
+  unsigned int shard_capacity;
+  unsigned int i;
+  void* shards;
+
+  while (amount < shard_amount) {
+    amount *= 2;
+    shift--;
+  }
+
+  shard_capacity = capacity / amount > 0 ? capacity / amount : 1;
+
+  if (posix_memalign(&shards, RSV_CACHE_LINE_SIZE,
+                     amount * sizeof(rsv_concurrent_hash_table_shard_t)) != 0) {
+    return ENOMEM;
+  }
+
+  if (custom_hash_func == NULL) {
+    custom_hash_func = rsv_hash_table_hash;
+  }
+
+  hash_table->shards = (rsv_concurrent_hash_table_shard_t*)shards;
+  hash_table->shard_amount = amount;
+  hash_table->shard_shift = shift;
+  hash_table->key_size = key_size;
+  hash_table->value_size = value_size;
+  hash_table->custom_hash_func = custom_hash_func;
+
+  for (i = 0; i < amount; ++i) {
+    rsv_rwlock_create(&hash_table->shards[i].lock);
+    hash_table->shards[i].hash_table =
+        rsv_hash_table_create(shard_capacity, key_size, value_size,
+                              custom_hash_func, custom_compare_func);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Destroys a concurrent hash table, freeing all associated memory. No
+ * other thread may use the hash table at the same time.
+ *
+ * @param hash_table Pointer to the concurrent hash table to destroy.
+ */
+static inline void
+rsv_concurrent_hash_table_destroy(rsv_concurrent_hash_table_t* hash_table) {
+  unsigned int i;
+
+  for (i = 0; i < hash_table->shard_amount; ++i) {
+    rsv_hash_table_destroy(&hash_table->shards[i].hash_table);
+    rsv_rwlock_destroy(&hash_table->shards[i].lock);
+  }
+
+  free(hash_table->shards);
+  hash_table->shards = NULL;
+  hash_table->shard_amount = 0;
+}
+
+/**
+ * @brief Gets the shard which owns a key.
+ *
+ * The hash is mixed with a Fibonacci multiplier and its top bits pick the
+ * shard, so that the shard does not correlate with the bucket the shard's own
+ * table picks from the low bits.
+ *
+ * @param hash_table Pointer to the concurrent hash table.
+ * @param key Pointer to the key.
+ * @return Pointer to the shard.
+ */
+static inline rsv_concurrent_hash_table_shard_t*
+rsv_concurrent_hash_table_shard(rsv_concurrent_hash_table_t* hash_table,
+                                const void* key) {
+  unsigned int hash = hash_table->custom_hash_func(key, hash_table->key_size);
+
+  if (hash_table->shard_amount == 1) {
+    return hash_table->shards;
+  }
+
+  return &hash_table->shards[(hash * 2654435769u) >> hash_table->shard_shift];
+}
+
+/**
+ * @brief Retrieves a copy of the value associated with the specified key.
+ *
+ * @param hash_table Pointer to the concurrent hash table.
+ * @param key Pointer to the key.
+ * @param value Pointer to where the value is copied, or NULL to only check
+ * for the key.
+ * @return 1 if the key was found, 0 otherwise.
+ */
+static inline int
+rsv_concurrent_hash_table_get(rsv_concurrent_hash_table_t* hash_table,
+                              const void* key, void* value) {
+  rsv_concurrent_hash_table_shard_t* shard =
+      rsv_concurrent_hash_table_shard(hash_table, key);
+  void* found;
+
+  rsv_rwlock_read_lock(&shard->lock);
+  found = rsv_hash_table_get(&shard->hash_table, key);
+
+  if (found && value) {
+    memcpy(value, found, hash_table->value_size);
+  }
+
+  rsv_rwlock_unlock(&shard->lock);
+
+  return found != NULL;
+}
+
+/**
+ * @brief Adds a key-value pair to the concurrent hash table, replacing the
+ * value if the key is already present.
+ *
+ * @param hash_table Pointer to the concurrent hash table.
+ * @param key Pointer to the key.
+ * @param value Pointer to the value.
+ */
+static inline void
+rsv_concurrent_hash_table_push(rsv_concurrent_hash_table_t* hash_table,
+                               const void* key, const void* value) {
+  rsv_concurrent_hash_table_shard_t* shard =
+      rsv_concurrent_hash_table_shard(hash_table, key);
+
+  rsv_rwlock_write_lock(&shard->lock);
+  rsv_hash_table_push(&shard->hash_table, key, value);
+  rsv_rwlock_unlock(&shard->lock);
+}
+
+/**
+ * @brief Removes a key-value pair from the concurrent hash table.
+ *
+ * @param hash_table Pointer to the concurrent hash table.
+ * @param key Pointer to the key of the pair to remove.
+ */
+static inline void
+rsv_concurrent_hash_table_pop(rsv_concurrent_hash_table_t* hash_table,
+                              const void* key) {
+  rsv_concurrent_hash_table_shard_t* shard =
+      rsv_concurrent_hash_table_shard(hash_table, key);
+
+  rsv_rwlock_write_lock(&shard->lock);
+  rsv_hash_table_pop(&shard->hash_table, key);
+  rsv_rwlock_unlock(&shard->lock);
+}
+
+/**
+ * @brief Gets the amount of entries in the concurrent hash table. Entries
+ * pushed or popped concurrently may or may not be counted.
+ *
+ * @param hash_table Pointer to the concurrent hash table.
+ * @return The amount of entries.
+ */
+static inline unsigned int
+rsv_concurrent_hash_table_amount(rsv_concurrent_hash_table_t* hash_table) {
+  unsigned int amount = 0;
+  unsigned int i;
+
+  for (i = 0; i < hash_table->shard_amount; ++i) {
+    rsv_rwlock_read_lock(&hash_table->shards[i].lock);
+    amount += hash_table->shards[i].hash_table.amount;
+    rsv_rwlock_unlock(&hash_table->shards[i].lock);
+  }
+
+  return amount;
+}
+
+#endif /* RSV_CONCURRENT_HASH_TABLE_H */
+
+#endif
@@ -12,6 +12,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../stats.h"
+
 #define RSV_DYNAMIC_ARRAY_GROWTH_AMOUNT 1.61803398874989484820
 
 /**
@@ -40,6 +42,13 @@ typedef struct rsv_dynamic_array_t {
    *
    */
   unsigned int element_size;
+#if defined(RSV_STATS)
+  /**
+   * @brief Statistics of the array, only present when built with RSV_STATS.
+   *
+   */
+  rsv_stats_t stats;
+#endif
 } rsv_dynamic_array_t;
 
 /**
@@ -57,6 +66,8 @@ rsv_dynamic_array_create(unsigned int capacity, unsigned int element_size) {
   array.amount = 0;
   array.capacity = capacity;
   array.element_size = element_size;
+  RSV_STATS_CLEAR(array.stats);
+  RSV_STATS_ALLOCATE(array.stats, (size_t)capacity * element_size);
 
   return array;
 }
@@ -67,6 +78,7 @@ rsv_dynamic_array_create(unsigned int capacity, unsigned int element_size) {
  * @param array Pointer to the dynamic array to destroy.
  */
 static inline void rsv_dynamic_array_destroy(rsv_dynamic_array_t* array) {
+  RSV_STATS_FREE(array->stats, (size_t)array->capacity * array->element_size);
   free(array->data);
   array->data = NULL;
   array->amount = 0;
@@ -101,9 +113,14 @@ static inline void rsv_dynamic_array_push(rsv_dynamic_array_t* array,
   unsigned char* destination;
 
   if (array->amount >= array->capacity) {
+    RSV_STATS_ONLY(size_t old_bytes =
+                       (size_t)array->capacity * array->element_size;)
     array->capacity =
         (size_t)(array->capacity * RSV_DYNAMIC_ARRAY_GROWTH_AMOUNT + 1);
     array->data = realloc(array->data, array->capacity * array->element_size);
+    RSV_STATS_RESIZE(array->stats);
+    RSV_STATS_REALLOCATE(array->stats, old_bytes,
+                         (size_t)array->capacity * array->element_size);
   }
 
   destination =
@@ -125,8 +142,13 @@ static inline void rsv_dynamic_array_pop(rsv_dynamic_array_t* array) {
   array->amount--;
 
   if (array->amount < array->capacity / 4) {
+    RSV_STATS_ONLY(size_t old_bytes =
+                       (size_t)array->capacity * array->element_size;)
     array->capacity /= 2;
     array->data = realloc(array->data, array->capacity * array->element_size);
+    RSV_STATS_RESIZE(array->stats);
+    RSV_STATS_REALLOCATE(array->stats, old_bytes,
+                         (size_t)array->capacity * array->element_size);
   }
 }
 
@@ -12,6 +12,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../stats.h"
+
 #define RSV_HASH_SET_LOAD_FACTOR 0.75
 
 /**
@@ -61,6 +63,14 @@ typedef struct rsv_hash_set_t {
    *
    */
   int (*custom_compare_func)(const void*, const void*, unsigned int);
+#if defined(RSV_STATS)
+  /**
+   * @brief Statistics of the hash set, only present when built with
+   * RSV_STATS. Probes count the entries walked in a bucket chain.
+   *
+   */
+  rsv_stats_t stats;
+#endif
 } rsv_hash_set_t;
 
 /**
@@ -129,6 +139,8 @@ static inline rsv_hash_set_t rsv_hash_set_create(
 
   hash_set.custom_hash_func = custom_hash_func;
   hash_set.custom_compare_func = custom_compare_func;
+  RSV_STATS_CLEAR(hash_set.stats);
+  RSV_STATS_ALLOCATE(hash_set.stats, capacity * sizeof(rsv_hash_set_entry_t*));
 
   return hash_set;
 }
@@ -146,12 +158,16 @@ static inline void rsv_hash_set_destroy(rsv_hash_set_t* hash_set) {
 
     while (entry) {
       rsv_hash_set_entry_t* next = entry->next;
+      RSV_STATS_FREE(hash_set->stats, hash_set->element_size);
+      RSV_STATS_FREE(hash_set->stats, sizeof(rsv_hash_set_entry_t));
       free(entry->data);
       free(entry);
       entry = next;
     }
   }
 
+  RSV_STATS_FREE(hash_set->stats,
+                 hash_set->capacity * sizeof(rsv_hash_set_entry_t*));
   free(hash_set->data);
   hash_set->data = NULL;
   hash_set->amount = 0;
@@ -183,34 +199,56 @@ static inline void rsv_hash_set_resize(rsv_hash_set_t* hash_set,
     }
   }
 
+  RSV_STATS_RESIZE(hash_set->stats);
+  RSV_STATS_ALLOCATE(hash_set->stats,
+                     new_capacity * sizeof(rsv_hash_set_entry_t*));
+  RSV_STATS_FREE(hash_set->stats,
+                 hash_set->capacity * sizeof(rsv_hash_set_entry_t*));
   free(hash_set->data);
   hash_set->data = new_data;
   hash_set->capacity = new_capacity;
 }
 
 /**
- * @brief Checks if the hash set contains the specified data.
+ * @brief Retrieves the element stored in the hash set which is equal to the
+ * specified data.
  *
  * @param hash_set Pointer to the hash set.
- * @param data Pointer to the data to check for.
- * @return 1 if the data is in the hash set, 0 otherwise.
+ * @param data Pointer to the data to look for.
+ * @return Pointer to the stored element, or NULL if it is not in the hash set.
  */
-static inline int rsv_hash_set_contains(rsv_hash_set_t* hash_set,
-                                        const void* data) {
+static inline void* rsv_hash_set_get(rsv_hash_set_t* hash_set,
+                                     const void* data) {
   unsigned int index =
       hash_set->custom_hash_func(data, hash_set->element_size) %
       hash_set->capacity;
   rsv_hash_set_entry_t* entry = hash_set->data[index];
+  RSV_STATS_ONLY(unsigned int probes = 0;)
 
   while (entry) {
+    RSV_STATS_ONLY(probes++;)
     if (hash_set->custom_compare_func(entry->data, data,
                                       hash_set->element_size)) {
-      return 1;
+      RSV_STATS_PROBE(hash_set->stats, probes);
+      return entry->data;
     }
 
     entry = entry->next;
   }
-  return 0;
+  RSV_STATS_PROBE(hash_set->stats, probes);
+  return NULL;
+}
+
+/**
+ * @brief Checks if the hash set contains the specified data.
+ *
+ * @param hash_set Pointer to the hash set.
+ * @param data Pointer to the data to check for.
+ * @return 1 if the data is in the hash set, 0 otherwise.
+ */
+static inline int rsv_hash_set_contains(rsv_hash_set_t* hash_set,
+                                        const void* data) {
+  return rsv_hash_set_get(hash_set, data) != NULL;
 }
 
 /**
@@ -224,6 +262,7 @@ static inline void rsv_hash_set_push(rsv_hash_set_t* hash_set,
   unsigned int index;
   rsv_hash_set_entry_t* entry;
   rsv_hash_set_entry_t* new_entry;
+  RSV_STATS_ONLY(unsigned int probes = 0;)
 
   if ((float)hash_set->amount / hash_set->capacity > RSV_HASH_SET_LOAD_FACTOR) {
     rsv_hash_set_resize(hash_set, hash_set->capacity * 2);
@@ -234,13 +273,18 @@ static inline void rsv_hash_set_push(rsv_hash_set_t* hash_set,
   entry = hash_set->data[index];
 
   while (entry) {
+    RSV_STATS_ONLY(probes++;)
     if (hash_set->custom_compare_func(entry->data, data,
                                       hash_set->element_size)) {
+      RSV_STATS_PROBE(hash_set->stats, probes);
       return;
     }
     entry = entry->next;
   }
 
+  RSV_STATS_PROBE(hash_set->stats, probes);
+  RSV_STATS_ALLOCATE(hash_set->stats, sizeof(rsv_hash_set_entry_t));
+  RSV_STATS_ALLOCATE(hash_set->stats, hash_set->element_size);
   new_entry = (rsv_hash_set_entry_t*)malloc(sizeof(rsv_hash_set_entry_t));
   new_entry->data = malloc(hash_set->element_size);
   memcpy(new_entry->data, data, hash_set->element_size);
@@ -262,16 +306,21 @@ static inline void rsv_hash_set_pop(rsv_hash_set_t* hash_set,
       hash_set->capacity;
   rsv_hash_set_entry_t* entry = hash_set->data[index];
   rsv_hash_set_entry_t* prev = NULL;
+  RSV_STATS_ONLY(unsigned int probes = 0;)
 
   while (entry) {
+    RSV_STATS_ONLY(probes++;)
     if (hash_set->custom_compare_func(entry->data, data,
                                       hash_set->element_size)) {
+      RSV_STATS_PROBE(hash_set->stats, probes);
       if (prev) {
         prev->next = entry->next;
       } else {
         hash_set->data[index] = entry->next;
       }
 
+      RSV_STATS_FREE(hash_set->stats, hash_set->element_size);
+      RSV_STATS_FREE(hash_set->stats, sizeof(rsv_hash_set_entry_t));
       free(entry->data);
       free(entry);
       hash_set->amount--;
@@ -282,6 +331,35 @@ static inline void rsv_hash_set_pop(rsv_hash_set_t* hash_set,
     prev = entry;
     entry = entry->next;
   }
+
+  RSV_STATS_PROBE(hash_set->stats, probes);
+}
+
+#if defined(RSV_STATS)
+/**
+ * @brief Collects the current chain length of every bucket of a hash set,
+ * only present when built with RSV_STATS.
+ *
+ * @param hash_set Pointer to the hash set.
+ * @param histogram Pointer to the histogram to add the chain lengths to.
+ */
+static inline void
+rsv_hash_set_chain_lengths(rsv_hash_set_t* hash_set,
+                           rsv_stats_histogram_t* histogram) {
+  unsigned int i;
+
+  for (i = 0; i < hash_set->capacity; ++i) {
+    rsv_hash_set_entry_t* entry = hash_set->data[i];
+    unsigned int length = 0;
+
+    while (entry) {
+      length++;
+      entry = entry->next;
+    }
+
+    rsv_stats_histogram_add(histogram, length);
+  }
 }
+#endif
 
 #endif /* RSV_HASH_SET_H */
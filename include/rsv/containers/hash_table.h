@@ -12,6 +12,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../stats.h"
+
 #define RSV_HASH_TABLE_LOAD_FACTOR 0.75
 
 /**
@@ -68,6 +70,14 @@ typedef struct rsv_hash_table_t {
    *
    */
   int (*custom_compare_func)(const void*, const void*, unsigned int);
+#if defined(RSV_STATS)
+  /**
+   * @brief Statistics of the hash table, only present when built with
+   * RSV_STATS. Probes count the entries walked in a bucket chain.
+   *
+   */
+  rsv_stats_t stats;
+#endif
 } rsv_hash_table_t;
 
 /**
@@ -138,6 +148,9 @@ static inline rsv_hash_table_t rsv_hash_table_create(
 
   hash_table.custom_hash_func = custom_hash_func;
   hash_table.custom_compare_func = custom_compare_func;
+  RSV_STATS_CLEAR(hash_table.stats);
+  RSV_STATS_ALLOCATE(hash_table.stats,
+                     capacity * sizeof(rsv_hash_table_entry_t*));
 
   return hash_table;
 }
@@ -155,6 +168,9 @@ static inline void rsv_hash_table_destroy(rsv_hash_table_t* hash_table) {
 
     while (entry) {
       rsv_hash_table_entry_t* next = entry->next;
+      RSV_STATS_FREE(hash_table->stats, hash_table->key_size);
+      RSV_STATS_FREE(hash_table->stats, hash_table->value_size);
+      RSV_STATS_FREE(hash_table->stats, sizeof(rsv_hash_table_entry_t));
       free(entry->key);
       free(entry->value);
       free(entry);
@@ -162,6 +178,8 @@ static inline void rsv_hash_table_destroy(rsv_hash_table_t* hash_table) {
     }
   }
 
+  RSV_STATS_FREE(hash_table->stats,
+                 hash_table->capacity * sizeof(rsv_hash_table_entry_t*));
   free(hash_table->data);
   hash_table->data = NULL;
   hash_table->amount = 0;
@@ -193,6 +211,11 @@ static inline void rsv_hash_table_resize(rsv_hash_table_t* hash_table,
     }
   }
 
+  RSV_STATS_RESIZE(hash_table->stats);
+  RSV_STATS_ALLOCATE(hash_table->stats,
+                     new_capacity * sizeof(rsv_hash_table_entry_t*));
+  RSV_STATS_FREE(hash_table->stats,
+                 hash_table->capacity * sizeof(rsv_hash_table_entry_t*));
   free(hash_table->data);
   hash_table->data = new_data;
   hash_table->capacity = new_capacity;
@@ -212,14 +235,18 @@ static inline void* rsv_hash_table_get(rsv_hash_table_t* hash_table,
   unsigned int index = hash_table->custom_hash_func(key, hash_table->key_size) %
                        hash_table->capacity;
   rsv_hash_table_entry_t* entry = hash_table->data[index];
+  RSV_STATS_ONLY(unsigned int probes = 0;)
 
   while (entry) {
+    RSV_STATS_ONLY(probes++;)
     if (hash_table->custom_compare_func(entry->key, key,
                                         hash_table->key_size)) {
+      RSV_STATS_PROBE(hash_table->stats, probes);
       return entry->value;
     }
     entry = entry->next;
   }
+  RSV_STATS_PROBE(hash_table->stats, probes);
   return NULL;
 }
 
@@ -235,6 +262,7 @@ static inline void rsv_hash_table_push(rsv_hash_table_t* hash_table,
   unsigned int index;
   rsv_hash_table_entry_t* entry;
   rsv_hash_table_entry_t* new_entry;
+  RSV_STATS_ONLY(unsigned int probes = 0;)
 
   if ((float)hash_table->amount / hash_table->capacity >
       RSV_HASH_TABLE_LOAD_FACTOR) {
@@ -246,14 +274,20 @@ static inline void rsv_hash_table_push(rsv_hash_table_t* hash_table,
   entry = hash_table->data[index];
 
   while (entry) {
+    RSV_STATS_ONLY(probes++;)
     if (hash_table->custom_compare_func(entry->key, key,
                                         hash_table->key_size)) {
+      RSV_STATS_PROBE(hash_table->stats, probes);
       memcpy(entry->value, value, hash_table->value_size);
       return;
     }
     entry = entry->next;
   }
 
+  RSV_STATS_PROBE(hash_table->stats, probes);
+  RSV_STATS_ALLOCATE(hash_table->stats, sizeof(rsv_hash_table_entry_t));
+  RSV_STATS_ALLOCATE(hash_table->stats, hash_table->key_size);
+  RSV_STATS_ALLOCATE(hash_table->stats, hash_table->value_size);
   new_entry = (rsv_hash_table_entry_t*)malloc(sizeof(rsv_hash_table_entry_t));
   new_entry->key = malloc(hash_table->key_size);
   new_entry->value = malloc(hash_table->value_size);
@@ -276,16 +310,22 @@ static inline void rsv_hash_table_pop(rsv_hash_table_t* hash_table,
                        hash_table->capacity;
   rsv_hash_table_entry_t* entry = hash_table->data[index];
   rsv_hash_table_entry_t* prev = NULL;
+  RSV_STATS_ONLY(unsigned int probes = 0;)
 
   while (entry) {
+    RSV_STATS_ONLY(probes++;)
     if (hash_table->custom_compare_func(entry->key, key,
                                         hash_table->key_size)) {
+      RSV_STATS_PROBE(hash_table->stats, probes);
       if (prev) {
         prev->next = entry->next;
       } else {
         hash_table->data[index] = entry->next;
       }
 
+      RSV_STATS_FREE(hash_table->stats, hash_table->key_size);
+      RSV_STATS_FREE(hash_table->stats, hash_table->value_size);
+      RSV_STATS_FREE(hash_table->stats, sizeof(rsv_hash_table_entry_t));
       free(entry->key);
       free(entry->value);
       free(entry);
@@ -297,6 +337,35 @@ static inline void rsv_hash_table_pop(rsv_hash_table_t* hash_table,
     prev = entry;
     entry = entry->next;
   }
+
+  RSV_STATS_PROBE(hash_table->stats, probes);
+}
+
+#if defined(RSV_STATS)
+/**
+ * @brief Collects the current chain length of every bucket of a hash table,
+ * only present when built with RSV_STATS.
+ *
+ * @param hash_table Pointer to the hash table.
+ * @param histogram Pointer to the histogram to add the chain lengths to.
+ */
+static inline void
+rsv_hash_table_chain_lengths(rsv_hash_table_t* hash_table,
+                             rsv_stats_histogram_t* histogram) {
+  unsigned int i;
+
+  for (i = 0; i < hash_table->capacity; ++i) {
+    rsv_hash_table_entry_t* entry = hash_table->data[i];
+    unsigned int length = 0;
+
+    while (entry) {
+      length++;
+      entry = entry->next;
+    }
+
+    rsv_stats_histogram_add(histogram, length);
+  }
 }
+#endif
 
 #endif /* RSV_HASH_TABLE_H */
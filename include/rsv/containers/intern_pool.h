@@ -0,0 +1,429 @@
+/*
+  intern_pool.h
+  Implementation of a string interning pool
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#ifndef RSV_INTERN_POOL_H
+#define RSV_INTERN_POOL_H
+
+#include "dynamic_array.h"
+#include "hash_set.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RSV_INTERN_POOL_CHUNK_SIZE 65536
+
+/**
+ * @brief A chunk of the arena holding interned strings. Should not be directly
+ * used unless necessary.
+ *
+ */
+typedef struct rsv_intern_pool_chunk_t {
+  struct rsv_intern_pool_chunk_t* next;
+  size_t used;
+  size_t capacity;
+  unsigned int data[];
+} rsv_intern_pool_chunk_t;
+
+/**
+ * @brief The header stored in the arena before every interned string. Should
+ * not be directly used unless necessary.
+ *
+ */
+typedef struct rsv_intern_pool_header_t {
+  unsigned int id;
+  unsigned int length;
+} rsv_intern_pool_header_t;
+
+/**
+ * @brief The element of the hash set behind an intern pool. Should not be
+ * directly used unless necessary.
+ *
+ */
+typedef struct rsv_intern_pool_entry_t {
+  const char* string;
+  unsigned int length;
+} rsv_intern_pool_entry_t;
+
+/**
+ * @brief A pool which stores every distinct string once and hands out a
+ * stable pointer to it. Interning the same characters twice gives the same
+ * pointer, so interned strings are compared with ==. Each string also gets a
+ * small id, counting up from 0 in interning order.
+ *
+ */
+typedef struct rsv_intern_pool_t {
+  /**
+   * @brief The interned strings, used to find existing ones.
+   *
+   */
+  rsv_hash_set_t strings;
+  /**
+   * @brief The interned strings by id, as const char pointers.
+   *
+   */
+  rsv_dynamic_array_t ids;
+  /**
+   * @brief The chunk strings are currently appended to. Older chunks follow
+   * through their next pointer.
+   *
+   */
+  rsv_intern_pool_chunk_t* chunks;
+  /**
+   * @brief The amount of bytes of interned characters, without terminators.
+   *
+   */
+  size_t bytes;
+} rsv_intern_pool_t;
+
+/**
+ * @brief Hashes an intern pool entry by its characters.
+ *
+ * @param data Pointer to the entry.
+ * @param element_size Size of the entry in memory, unused.
+ * @return The generated hash value.
+ */
+static inline unsigned int rsv_intern_pool_hash(const void* data,
+                                                unsigned int element_size) {
+  const rsv_intern_pool_entry_t* entry = (const rsv_intern_pool_entry_t*)data;
+  unsigned int hash = 2166136261u;
+  unsigned int i;
+
+  (void)element_size;
+
+  for (i = 0; i < entry->length; ++i) {
+    hash = (hash ^ (unsigned char)entry->string[i]) * 16777619u;
+  }
+
+  return hash;
+}
+
+/**
+ * @brief Compares two intern pool entries by their characters.
+ *
+ * @param data_a Pointer to the first entry.
+ * @param data_b Pointer to the second entry.
+ * @param element_size Size of the entries in memory, unused.
+ * @return 1 if the characters are equal, 0 otherwise.
+ */
+static inline int rsv_intern_pool_compare(const void* data_a,
+                                          const void* data_b,
+                                          unsigned int element_size) {
+  const rsv_intern_pool_entry_t* entry_a =
+      (const rsv_intern_pool_entry_t*)data_a;
+  const rsv_intern_pool_entry_t* entry_b =
+      (const rsv_intern_pool_entry_t*)data_b;
+
+  (void)element_size;
+
+  return entry_a->length == entry_b->length &&
+         memcmp(entry_a->string, entry_b->string, entry_a->length) == 0;
+}
+
+/**
+ * @brief Creates an intern pool.
+ *
+ * @param capacity Initial capacity for distinct strings.
+ * @return A rsv_intern_pool_t struct representing the created intern pool.
+ */
+static inline rsv_intern_pool_t rsv_intern_pool_create(unsigned int capacity) {
+  rsv_intern_pool_t pool;
+
+  if (capacity == 0) {
+    capacity = 1;
+  }
+
+  pool.strings = rsv_hash_set_create(capacity, sizeof(rsv_intern_pool_entry_t),
+                                     rsv_intern_pool_hash,
+                                     rsv_intern_pool_compare);
+  pool.ids = rsv_dynamic_array_create(capacity, sizeof(const char*));
+  pool.chunks = NULL;
+  pool.bytes = 0;
+
+  return pool;
+}
+
+/**
+ * @brief Destroys an intern pool, freeing all associated memory. Every
+ * interned string becomes invalid.
+ *
+ * @param pool Pointer to the intern pool to destroy.
+ */
+static inline void rsv_intern_pool_destroy(rsv_intern_pool_t* pool) {
+  while (pool->chunks) {
+    rsv_intern_pool_chunk_t* next = pool->chunks->next;
+    free(pool->chunks);
+    pool->chunks = next;
+  }
+
+  rsv_hash_set_destroy(&pool->strings);
+  rsv_dynamic_array_destroy(&pool->ids);
+  pool->bytes = 0;
+}
+
+/**
+ * @brief Gets the amount of distinct strings in an intern pool.
+ *
+ * @param pool Pointer to the intern pool.
+ * @return The amount of distinct strings.
+ */
+static inline unsigned int rsv_intern_pool_amount(rsv_intern_pool_t* pool) {
+  return pool->ids.amount;
+}
+
+/**
+ * @brief Finds an interned string without interning it.
+ *
+ * @param pool Pointer to the intern pool.
+ * @param string Pointer to the characters, which may contain null bytes.
+ * @param length Amount of characters.
+ * @return The interned string, or NULL if it was never interned.
+ */
+static inline const char* rsv_intern_pool_find_n(rsv_intern_pool_t* pool,
+                                                 const char* string,
+                                                 unsigned int length) {
+  rsv_intern_pool_entry_t probe;
+  rsv_intern_pool_entry_t* entry;
+
+  probe.string = string;
+  probe.length = length;
+  entry = (rsv_intern_pool_entry_t*)rsv_hash_set_get(&pool->strings, &probe);
+
+  return entry ? entry->string : NULL;
+}
+
+/**
+ * @brief Finds an interned string without interning it.
+ *
+ * @param pool Pointer to the intern pool.
+ * @param string Pointer to the null terminated string.
+ * @return The interned string, or NULL if it was never interned.
+ */
+static inline const char* rsv_intern_pool_find(rsv_intern_pool_t* pool,
+                                               const char* string) {
+  return rsv_intern_pool_find_n(pool, string, (unsigned int)strlen(string));
+}
+
+/**
+ * @brief Interns a string. The characters are copied into the pool the first
+ * time, later calls with the same characters return the same pointer.
+ *
+ * @param pool Pointer to the intern pool.
+ * @param string Pointer to the characters, which may contain null bytes.
+ * @param length Amount of characters.
+ * @return The interned, null terminated string, valid until the pool is
+ * destroyed, or NULL if out of memory.
+ */
+static inline const char* rsv_intern_pool_intern_n(rsv_intern_pool_t* pool,
+                                                   const char* string,
+                                                   unsigned int length) {
+  const char* found = rsv_intern_pool_find_n(pool, string, length);
+  size_t record_size;
+  rsv_intern_pool_header_t* header;
+  rsv_intern_pool_entry_t entry;
+  char* characters;
+
+  if (found) {
+    return found;
+  }
+
+  /* Header, characters and terminator, rounded to keep headers aligned */
+  record_size = (sizeof(rsv_intern_pool_header_t) + length + 1 +
+                 sizeof(unsigned int) - 1) &
+                ~(sizeof(unsigned int) - 1);
+
+  if (pool->chunks == NULL ||
+      pool->chunks->capacity - pool->chunks->used < record_size) {
+    size_t capacity = record_size > RSV_INTERN_POOL_CHUNK_SIZE
+                          ? record_size
+                          : RSV_INTERN_POOL_CHUNK_SIZE;
+    rsv_intern_pool_chunk_t* chunk = (rsv_intern_pool_chunk_t*)malloc(
+        sizeof(rsv_intern_pool_chunk_t) + capacity);
+
+    if (chunk == NULL) {
+      return NULL;
+    }
+
+    chunk->next = pool->chunks;
+    chunk->used = 0;
+    chunk->capacity = capacity;
+    pool->chunks = chunk;
+  }
+
+  header = (rsv_intern_pool_header_t*)((char*)pool->chunks->data +
+                                       pool->chunks->used);
+  header->id = pool->ids.amount;
+  header->length = length;
+  characters = (char*)(header + 1);
+  memcpy(characters, string, length);
+  characters[length] = '\0';
+  pool->chunks->used += record_size;
+  pool->bytes += length;
+
+  entry.string = characters;
+  entry.length = length;
+  rsv_hash_set_push(&pool->strings, &entry);
+  rsv_dynamic_array_push(&pool->ids, &entry.string);
+
+  return characters;
+}
+
+/**
+ * @brief Interns a null terminated string.
+ *
+ * @param pool Pointer to the intern pool.
+ * @param string Pointer to the null terminated string.
+ * @return The interned string, valid until the pool is destroyed, or NULL if
+ * out of memory.
+ */
+static inline const char* rsv_intern_pool_intern(rsv_intern_pool_t* pool,
+                                                 const char* string) {
+  return rsv_intern_pool_intern_n(pool, string, (unsigned int)strlen(string));
+}
+
+/**
+ * @brief Gets the id of an interned string.
+ *
+ * @param interned A string returned by the intern pool.
+ * @return The id of the string.
+ */
+static inline unsigned int rsv_intern_pool_id(const char* interned) {
+  return ((const rsv_intern_pool_header_t*)interned - 1)->id;
+}
+
+/**
+ * @brief Gets the length of an interned string without scanning it.
+ *
+ * @param interned A string returned by the intern pool.
+ * @return The length of the string.
+ */
+static inline unsigned int rsv_intern_pool_length(const char* interned) {
+  return ((const rsv_intern_pool_header_t*)interned - 1)->length;
+}
+
+/**
+ * @brief Gets an interned string by its id.
+ *
+ * @param pool Pointer to the intern pool.
+ * @param id The id of the string.
+ * @return The interned string, or NULL if no string has the id.
+ */
+static inline const char* rsv_intern_pool_string(rsv_intern_pool_t* pool,
+                                                 unsigned int id) {
+  const char** string =
+      (const char**)rsv_dynamic_array_get(&pool->ids, id);
+
+  return string ? *string : NULL;
+}
+
+#if defined(__unix__)
+
+#include "../threads/threads_pthreads.h"
+
+/**
+ * @brief An intern pool which can be shared between threads. Lookups of
+ * strings which are already interned run in parallel, only new strings take
+ * the lock exclusively.
+ *
+ */
+typedef struct rsv_concurrent_intern_pool_t {
+  rsv_rwlock_t lock;
+  rsv_intern_pool_t pool;
+} rsv_concurrent_intern_pool_t;
+
+/**
+ * @brief Creates a concurrent intern pool.
+ *
+ * @param pool Pointer to the concurrent intern pool to initialize.
+ * @param capacity Initial capacity for distinct strings.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int
+rsv_concurrent_intern_pool_create(rsv_concurrent_intern_pool_t* pool,
+                                  unsigned int capacity) {
+  pool->pool = rsv_intern_pool_create(capacity);
+  return rsv_rwlock_create(&pool->lock);
+}
+
+/**
+ * @brief Destroys a concurrent intern pool, freeing all associated memory. No
+ * other thread may use the pool at the same time.
+ *
+ * @param pool Pointer to the concurrent intern pool to destroy.
+ */
+static inline void
+rsv_concurrent_intern_pool_destroy(rsv_concurrent_intern_pool_t* pool) {
+  rsv_intern_pool_destroy(&pool->pool);
+  rsv_rwlock_destroy(&pool->lock);
+}
+
+/**
+ * @brief Interns a string, like rsv_intern_pool_intern_n.
+ *
+ * @param pool Pointer to the concurrent intern pool.
+ * @param string Pointer to the characters, which may contain null bytes.
+ * @param length Amount of characters.
+ * @return The interned string, valid until the pool is destroyed, or NULL if
+ * out of memory.
+ */
+static inline const char*
+rsv_concurrent_intern_pool_intern_n(rsv_concurrent_intern_pool_t* pool,
+                                    const char* string, unsigned int length) {
+  const char* interned;
+
+  rsv_rwlock_read_lock(&pool->lock);
+  interned = rsv_intern_pool_find_n(&pool->pool, string, length);
+  rsv_rwlock_unlock(&pool->lock);
+
+  if (interned) {
+    return interned;
+  }
+
+  /* Interning looks the string up again, another thread may have won */
+  rsv_rwlock_write_lock(&pool->lock);
+  interned = rsv_intern_pool_intern_n(&pool->pool, string, length);
+  rsv_rwlock_unlock(&pool->lock);
+
+  return interned;
+}
+
+/**
+ * @brief Interns a null terminated string, like rsv_intern_pool_intern.
+ *
+ * @param pool Pointer to the concurrent intern pool.
+ * @param string Pointer to the null terminated string.
+ * @return The interned string, valid until the pool is destroyed, or NULL if
+ * out of memory.
+ */
+static inline const char*
+rsv_concurrent_intern_pool_intern(rsv_concurrent_intern_pool_t* pool,
+                                  const char* string) {
+  return rsv_concurrent_intern_pool_intern_n(pool, string,
+                                             (unsigned int)strlen(string));
+}
+
+/**
+ * @brief Gets an interned string by its id, like rsv_intern_pool_string.
+ *
+ * @param pool Pointer to the concurrent intern pool.
+ * @param id The id of the string.
+ * @return The interned string, or NULL if no string has the id.
+ */
+static inline const char*
+rsv_concurrent_intern_pool_string(rsv_concurrent_intern_pool_t* pool,
+                                  unsigned int id) {
+  const char* string;
+
+  rsv_rwlock_read_lock(&pool->lock);
+  string = rsv_intern_pool_string(&pool->pool, id);
+  rsv_rwlock_unlock(&pool->lock);
+
+  return string;
+}
+
+#endif
+
+#endif /* RSV_INTERN_POOL_H */
@@ -0,0 +1,515 @@
+/*
+  lockfree_hash_table.h
+  Implementation of a concurrent hash table with lock-free lookups
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#if defined(__unix__)
+
+#ifndef RSV_LOCKFREE_HASH_TABLE_H
+#define RSV_LOCKFREE_HASH_TABLE_H
+
+#include "../threads/atomic.h"
+#include "../threads/epoch.h"
+#include "../threads/threads_pthreads.h"
+#include "hash_table.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RSV_LOCKFREE_HASH_TABLE_LOAD_FACTOR 0.75
+
+/**
+ * @brief A lock-free hash table entry. Never modified once published, a new
+ * value replaces the whole entry. Should not be directly used unless necessary.
+ *
+ */
+typedef struct rsv_lockfree_hash_table_entry_t {
+  void* key;
+  void* value;
+  unsigned int hash;
+} rsv_lockfree_hash_table_entry_t;
+
+/**
+ * @brief The slot array of a lock-free hash table. Should not be directly used
+ * unless necessary.
+ *
+ */
+typedef struct rsv_lockfree_hash_table_array_t {
+  /**
+   * @brief The amount of slots, always a power of two.
+   *
+   */
+  unsigned int capacity;
+  /**
+   * @brief The amount of slots which are no longer empty, including removed
+   * entries.
+   *
+   */
+  unsigned int used;
+  rsv_lockfree_hash_table_entry_t* slots[];
+} rsv_lockfree_hash_table_array_t;
+
+/**
+ * @brief A hash table for read-mostly workloads shared between threads.
+ *
+ * Lookups take no locks and write no shared memory. They only have to be
+ * wrapped in rsv_epoch_enter and rsv_epoch_exit on a participant of the
+ * table's epoch domain. Writers publish immutable entries into an open
+ * addressed slot array with compare-and-swap and retire the entries they
+ * replace through the epoch domain. Resizing is the only operation that
+ * excludes writers, and never blocks readers.
+ *
+ */
+typedef struct rsv_lockfree_hash_table_t {
+  /**
+   * @brief The current slot array.
+   *
+   */
+  rsv_lockfree_hash_table_array_t* array;
+  /**
+   * @brief The amount of entries in the hash table.
+   *
+   */
+  unsigned int amount;
+  /**
+   * @brief The size of the key in memory.
+   *
+   */
+  unsigned int key_size;
+  /**
+   * @brief The size of the value in memory.
+   *
+   */
+  unsigned int value_size;
+  /**
+   * @brief Use if the hash table would need a custom hash function. Set to NULL
+   * for default hashing.
+   *
+   */
+  unsigned int (*custom_hash_func)(const void*, unsigned int);
+  /**
+   * @brief Use if the hash table would need a custom comparing function for
+   * comparing values inside the table. Set to NULL for default comparing.
+   *
+   */
+  int (*custom_compare_func)(const void*, const void*, unsigned int);
+  /**
+   * @brief Held shared by writers and exclusively while resizing.
+   *
+   */
+  rsv_rwlock_t resize_lock;
+  /**
+   * @brief The epoch domain through which replaced entries and slot arrays are
+   * reclaimed. Every thread using the table registers with it.
+   *
+   */
+  rsv_epoch_t epoch;
+  /**
+   * @brief Marks a slot whose entry was removed.
+   *
+   */
+  rsv_lockfree_hash_table_entry_t tombstone;
+} rsv_lockfree_hash_table_t;
+
+/**
+ * @brief Allocates an empty slot array.
+ *
+ * @param capacity Amount of slots, a power of two.
+ * @return Pointer to the slot array, or NULL if out of memory.
+ */
+static inline rsv_lockfree_hash_table_array_t*
+rsv_lockfree_hash_table_array_create(unsigned int capacity) {
+  return (rsv_lockfree_hash_table_array_t*)calloc(
+      1, sizeof(rsv_lockfree_hash_table_array_t) +
+             capacity * sizeof(rsv_lockfree_hash_table_entry_t*));
+}
+
+/**
+ * @brief Creates a lock-free hash table.
+ *
+ * @param hash_table Pointer to the lock-free hash table to initialize.
+ * @param capacity Initial amount of slots, rounded up to a power of two.
+ * @param key_size Size of each key in memory.
+ * @param value_size Size of each value in memory.
+ * @param custom_hash_func Pointer to a custom hash function, or NULL to use the
+ * default.
+ * @param custom_compare_func Pointer to a custom compare function, or NULL to
+ * use the default.
+ * @return 0 on success, or ENOMEM if the slots could not be allocated.
+ */
+static inline int rsv_lockfree_hash_table_create(
+    rsv_lockfree_hash_table_t* hash_table, unsigned int capacity,
+    unsigned int key_size, unsigned int value_size,
+    unsigned int (*custom_hash_func)(const void*, unsigned int),
+    int (*custom_compare_func)(const void*, const void*, unsigned int)) {
+  unsigned int slot_amount = 2;
+
+  while (slot_amount < capacity) {
+    slot_amount *= 2;
+  }
+
+  hash_table->array = rsv_lockfree_hash_table_array_create(slot_amount);
+
+  if (hash_table->array == NULL) {
+    return ENOMEM;
+  }
+
+  if (custom_hash_func == NULL) {
+    custom_hash_func = rsv_hash_table_hash;
+  }
+
+  if (custom_compare_func == NULL) {
+    custom_compare_func = rsv_hash_table_compare;
+  }
+
+  hash_table->array->capacity = slot_amount;
+  hash_table->amount = 0;
+  hash_table->key_size = key_size;
+  hash_table->value_size = value_size;
+  hash_table->custom_hash_func = custom_hash_func;
+  hash_table->custom_compare_func = custom_compare_func;
+  rsv_rwlock_create(&hash_table->resize_lock);
+  rsv_epoch_create(&hash_table->epoch);
+
+  return 0;
+}
+
+/**
+ * @brief Destroys a lock-free hash table, freeing all associated memory,
+ * including the participants of its epoch domain. No other thread may use the
+ * hash table at the same time.
+ *
+ * @param hash_table Pointer to the lock-free hash table to destroy.
+ */
+static inline void
+rsv_lockfree_hash_table_destroy(rsv_lockfree_hash_table_t* hash_table) {
+  unsigned int i;
+
+  for (i = 0; i < hash_table->array->capacity; ++i) {
+    rsv_lockfree_hash_table_entry_t* entry = hash_table->array->slots[i];
+
+    if (entry && entry != &hash_table->tombstone) {
+      free(entry);
+    }
+  }
+
+  free(hash_table->array);
+  hash_table->array = NULL;
+  hash_table->amount = 0;
+  rsv_epoch_destroy(&hash_table->epoch);
+  rsv_rwlock_destroy(&hash_table->resize_lock);
+}
+
+/**
+ * @brief Registers the calling thread with the epoch domain of a lock-free
+ * hash table.
+ *
+ * @param hash_table Pointer to the lock-free hash table.
+ * @return Pointer to the participant, or NULL if out of memory.
+ */
+static inline rsv_epoch_participant_t*
+rsv_lockfree_hash_table_register(rsv_lockfree_hash_table_t* hash_table) {
+  return rsv_epoch_register(&hash_table->epoch);
+}
+
+/**
+ * @brief Retrieves the value associated with the specified key. Takes no locks
+ * and writes no shared memory.
+ *
+ * Must be called between rsv_epoch_enter and rsv_epoch_exit on a participant
+ * of the hash table. The value must not be modified and stays valid until
+ * rsv_epoch_exit, even if the key is replaced or popped in the meantime.
+ *
+ * @param hash_table Pointer to the lock-free hash table.
+ * @param key Pointer to the key.
+ * @return Pointer to the value associated with the key, or NULL if the key is
+ * not found.
+ */
+static inline const void*
+rsv_lockfree_hash_table_get(rsv_lockfree_hash_table_t* hash_table,
+                            const void* key) {
+  rsv_lockfree_hash_table_array_t* array =
+      rsv_atomic_load(&hash_table->array, RSV_MEMORY_ORDER_ACQUIRE);
+  unsigned int hash = hash_table->custom_hash_func(key, hash_table->key_size);
+  unsigned int mask = array->capacity - 1;
+  unsigned int index = hash & mask;
+  unsigned int probe;
+
+  for (probe = 0; probe < array->capacity; ++probe) {
+    rsv_lockfree_hash_table_entry_t* entry =
+        rsv_atomic_load(&array->slots[index], RSV_MEMORY_ORDER_ACQUIRE);
+
+    if (entry == NULL) {
+      return NULL;
+    }
+
+    if (entry != &hash_table->tombstone && entry->hash == hash &&
+        hash_table->custom_compare_func(entry->key, key,
+                                        hash_table->key_size)) {
+      return entry->value;
+    }
+
+    index = (index + 1) & mask;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Replaces the slot array with one sized for the current amount of
+ * entries, dropping removed entries. Does nothing if another writer already
+ * replaced the given slot array.
+ *
+ * @param hash_table Pointer to the lock-free hash table.
+ * @param participant Pointer to the participant of the calling thread.
+ * @param array The slot array the caller found to be full.
+ * @return 0 on success, or ENOMEM if out of memory.
+ */
+static inline int
+rsv_lockfree_hash_table_resize(rsv_lockfree_hash_table_t* hash_table,
+                               rsv_epoch_participant_t* participant,
+                               rsv_lockfree_hash_table_array_t* array) {
+  rsv_lockfree_hash_table_array_t* new_array;
+  unsigned int new_capacity = array->capacity;
+  unsigned int i;
+  int error = 0;
+
+  rsv_rwlock_write_lock(&hash_table->resize_lock);
+
+  if (hash_table->array != array) {
+    rsv_rwlock_unlock(&hash_table->resize_lock);
+    return 0;
+  }
+
+  /* Only grow if the live entries alone fill half of the slots, otherwise
+   * rebuilding at the same size is enough to clear the tombstones */
+  if (hash_table->amount * 2 >= array->capacity) {
+    new_capacity *= 2;
+  }
+
+  new_array = rsv_lockfree_hash_table_array_create(new_capacity);
+
+  if (new_array == NULL) {
+    rsv_rwlock_unlock(&hash_table->resize_lock);
+    return ENOMEM;
+  }
+
+  new_array->capacity = new_capacity;
+
+  /* Entries are immutable, so both arrays can share them */
+  for (i = 0; i < array->capacity; ++i) {
+    rsv_lockfree_hash_table_entry_t* entry = array->slots[i];
+
+    if (entry && entry != &hash_table->tombstone) {
+      unsigned int index = entry->hash & (new_capacity - 1);
+
+      while (new_array->slots[index]) {
+        index = (index + 1) & (new_capacity - 1);
+      }
+
+      new_array->slots[index] = entry;
+      new_array->used++;
+    }
+  }
+
+  rsv_atomic_store(&hash_table->array, new_array, RSV_MEMORY_ORDER_RELEASE);
+
+  if (rsv_epoch_retire(participant, array, free) != 0) {
+    /* The old array cannot be tracked, keep it alive rather than risk a
+     * reader still scanning it */
+    error = ENOMEM;
+  }
+
+  rsv_rwlock_unlock(&hash_table->resize_lock);
+
+  return error;
+}
+
+/**
+ * @brief Adds a key-value pair to the lock-free hash table, replacing the
+ * value if the key is already present. Readers see either the old or the new
+ * value, never a mix of both.
+ *
+ * @param hash_table Pointer to the lock-free hash table.
+ * @param participant Pointer to the participant of the calling thread.
+ * @param key Pointer to the key.
+ * @param value Pointer to the value.
+ * @return 0 on success, or ENOMEM if out of memory.
+ */
+static inline int
+rsv_lockfree_hash_table_push(rsv_lockfree_hash_table_t* hash_table,
+                             rsv_epoch_participant_t* participant,
+                             const void* key, const void* value) {
+  unsigned int key_offset = (hash_table->key_size + sizeof(void*) - 1) &
+                            ~(unsigned int)(sizeof(void*) - 1);
+  rsv_lockfree_hash_table_entry_t* new_entry =
+      (rsv_lockfree_hash_table_entry_t*)malloc(
+          sizeof(rsv_lockfree_hash_table_entry_t) + key_offset +
+          hash_table->value_size);
+  rsv_lockfree_hash_table_entry_t* replaced = NULL;
+  int error = 0;
+
+  if (new_entry == NULL) {
+    return ENOMEM;
+  }
+
+  new_entry->key = new_entry + 1;
+  new_entry->value = (char*)new_entry->key + key_offset;
+  new_entry->hash = hash_table->custom_hash_func(key, hash_table->key_size);
+  memcpy(new_entry->key, key, hash_table->key_size);
+  memcpy(new_entry->value, value, hash_table->value_size);
+
+  rsv_epoch_enter(participant);
+
+  for (;;) {
+    rsv_lockfree_hash_table_array_t* array;
+    unsigned int mask;
+    unsigned int index;
+    unsigned int probe;
+    int done = 0;
+
+    rsv_rwlock_read_lock(&hash_table->resize_lock);
+    array = hash_table->array;
+    mask = array->capacity - 1;
+    index = new_entry->hash & mask;
+
+    if ((float)(rsv_atomic_load(&array->used, RSV_MEMORY_ORDER_RELAXED) + 1) /
+            array->capacity <=
+        RSV_LOCKFREE_HASH_TABLE_LOAD_FACTOR) {
+      for (probe = 0; probe < array->capacity && !done;) {
+        rsv_lockfree_hash_table_entry_t* entry =
+            rsv_atomic_load(&array->slots[index], RSV_MEMORY_ORDER_ACQUIRE);
+
+        if (entry == NULL) {
+          /* On failure entry holds what another writer put there, so the slot
+           * is examined again */
+          if (rsv_atomic_compare_exchange(
+                  &array->slots[index], &entry, new_entry,
+                  RSV_MEMORY_ORDER_RELEASE, RSV_MEMORY_ORDER_ACQUIRE)) {
+            rsv_atomic_fetch_add(&array->used, 1, RSV_MEMORY_ORDER_RELAXED);
+            rsv_atomic_fetch_add(&hash_table->amount, 1,
+                                 RSV_MEMORY_ORDER_RELAXED);
+            done = 1;
+          }
+        } else if (entry != &hash_table->tombstone &&
+                   entry->hash == new_entry->hash &&
+                   hash_table->custom_compare_func(entry->key, key,
+                                                   hash_table->key_size)) {
+          if (rsv_atomic_compare_exchange(
+                  &array->slots[index], &entry, new_entry,
+                  RSV_MEMORY_ORDER_RELEASE, RSV_MEMORY_ORDER_ACQUIRE)) {
+            replaced = entry;
+            done = 1;
+          }
+        } else {
+          index = (index + 1) & mask;
+          probe++;
+        }
+      }
+    }
+
+    rsv_rwlock_unlock(&hash_table->resize_lock);
+
+    if (done) {
+      break;
+    }
+
+    error = rsv_lockfree_hash_table_resize(hash_table, participant, array);
+
+    if (error != 0) {
+      free(new_entry);
+      break;
+    }
+  }
+
+  if (replaced && rsv_epoch_retire(participant, replaced, free) != 0) {
+    error = ENOMEM;
+  }
+
+  rsv_epoch_exit(participant);
+
+  return error;
+}
+
+/**
+ * @brief Removes a key-value pair from the lock-free hash table.
+ *
+ * @param hash_table Pointer to the lock-free hash table.
+ * @param participant Pointer to the participant of the calling thread.
+ * @param key Pointer to the key of the pair to remove.
+ * @return 1 if the key was removed, 0 if it was not found.
+ */
+static inline int
+rsv_lockfree_hash_table_pop(rsv_lockfree_hash_table_t* hash_table,
+                            rsv_epoch_participant_t* participant,
+                            const void* key) {
+  rsv_lockfree_hash_table_array_t* array;
+  rsv_lockfree_hash_table_entry_t* removed = NULL;
+  unsigned int hash = hash_table->custom_hash_func(key, hash_table->key_size);
+  unsigned int mask;
+  unsigned int index;
+  unsigned int probe;
+
+  rsv_epoch_enter(participant);
+  rsv_rwlock_read_lock(&hash_table->resize_lock);
+  array = hash_table->array;
+  mask = array->capacity - 1;
+  index = hash & mask;
+
+  for (probe = 0; probe < array->capacity;) {
+    rsv_lockfree_hash_table_entry_t* entry =
+        rsv_atomic_load(&array->slots[index], RSV_MEMORY_ORDER_ACQUIRE);
+
+    if (entry == NULL) {
+      break;
+    }
+
+    if (entry != &hash_table->tombstone && entry->hash == hash &&
+        hash_table->custom_compare_func(entry->key, key,
+                                        hash_table->key_size)) {
+      /* On failure the key was replaced or popped, so the slot is examined
+       * again */
+      if (rsv_atomic_compare_exchange(
+              &array->slots[index], &entry, &hash_table->tombstone,
+              RSV_MEMORY_ORDER_RELEASE, RSV_MEMORY_ORDER_ACQUIRE)) {
+        rsv_atomic_fetch_sub(&hash_table->amount, 1, RSV_MEMORY_ORDER_RELAXED);
+        removed = entry;
+        break;
+      }
+    } else {
+      index = (index + 1) & mask;
+      probe++;
+    }
+  }
+
+  rsv_rwlock_unlock(&hash_table->resize_lock);
+
+  /* Leak the entry rather than free it under a reader if it cannot be
+   * tracked */
+  if (removed) {
+    rsv_epoch_retire(participant, removed, free);
+  }
+
+  rsv_epoch_exit(participant);
+
+  return removed != NULL;
+}
+
+/**
+ * @brief Gets the amount of entries in the lock-free hash table. Entries
+ * pushed or popped concurrently may or may not be counted.
+ *
+ * @param hash_table Pointer to the lock-free hash table.
+ * @return The amount of entries.
+ */
+static inline unsigned int
+rsv_lockfree_hash_table_amount(rsv_lockfree_hash_table_t* hash_table) {
+  return rsv_atomic_load(&hash_table->amount, RSV_MEMORY_ORDER_RELAXED);
+}
+
+#endif /* RSV_LOCKFREE_HASH_TABLE_H */
+
+#endif
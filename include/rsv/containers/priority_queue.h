@@ -0,0 +1,716 @@
+/*
+  priority_queue.h
+  Implementation of a d-ary heap priority queue
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#ifndef RSV_PRIORITY_QUEUE_H
+#define RSV_PRIORITY_QUEUE_H
+
+#include "dynamic_array.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RSV_PRIORITY_QUEUE_ARITY 4
+#define RSV_PRIORITY_QUEUE_ALIGNMENT 64
+#define RSV_PRIORITY_QUEUE_NO_HANDLE 0xFFFFFFFFu
+
+/**
+ * @brief A priority queue stored as a d-ary heap in a cache line aligned
+ * array. The children of a node sit next to each other, so a wider heap walks
+ * fewer levels and compares siblings from the same cache line. Make sure to
+ * cast your type from the void pointer.
+ *
+ */
+typedef struct rsv_priority_queue_t {
+  /**
+   * @brief The elements in heap order, the first one being popped next. The
+   * root sits arity - 1 elements after a cache line boundary, so the children
+   * of every node start a multiple of arity elements after it.
+   *
+   */
+  void* data;
+  /**
+   * @brief The allocation holding the elements, data points into it.
+   *
+   */
+  void* memory;
+  /**
+   * @brief The amount of elements in the queue.
+   *
+   */
+  unsigned int amount;
+  /**
+   * @brief The amount of elements that can be stored.
+   *
+   */
+  unsigned int capacity;
+  /**
+   * @brief The handle of each element in heap order, only used when indexed.
+   *
+   */
+  rsv_dynamic_array_t handles;
+  /**
+   * @brief The heap index of each handle, or RSV_PRIORITY_QUEUE_NO_HANDLE for
+   * unused handles. Only used when indexed.
+   *
+   */
+  rsv_dynamic_array_t positions;
+  /**
+   * @brief Handles released by popped elements, reused by later pushes.
+   *
+   */
+  rsv_dynamic_array_t free_handles;
+  /**
+   * @brief Scratch space of one element.
+   *
+   */
+  void* scratch;
+  /**
+   * @brief The amount of children of each node.
+   *
+   */
+  unsigned int arity;
+  /**
+   * @brief The size of an element in memory.
+   *
+   */
+  unsigned int element_size;
+  /**
+   * @brief The most elements kept, or 0 for no limit. Once full, pushing an
+   * element which would be popped before the first element drops it,
+   * otherwise the first element is dropped, so the queue keeps the limit
+   * elements which are popped last (the k largest for an ascending compare).
+   *
+   */
+  unsigned int limit;
+  /**
+   * @brief 1 if elements have handles for updating and removing them, 0
+   * otherwise.
+   *
+   */
+  int indexed;
+  /**
+   * @brief Compares two elements, returning a negative value if the first
+   * should be popped before the second, 0 if they are equal and a positive
+   * value otherwise, like the compare function of qsort.
+   *
+   */
+  int (*compare_func)(const void*, const void*);
+} rsv_priority_queue_t;
+
+/**
+ * @brief Gets the element at a heap index. Should not be directly used unless
+ * necessary.
+ *
+ * @param queue Pointer to the priority queue.
+ * @param index The heap index.
+ * @return Pointer to the element.
+ */
+static inline void* rsv_priority_queue_at(rsv_priority_queue_t* queue,
+                                          unsigned int index) {
+  return (unsigned char*)queue->data + (size_t)index * queue->element_size;
+}
+
+/**
+ * @brief Moves the elements to a new allocation of a given capacity, aligning
+ * the groups of siblings to cache lines. Should not be directly used unless
+ * necessary.
+ *
+ * @param queue Pointer to the priority queue.
+ * @param capacity The new capacity, at least the amount of elements.
+ * @return 0 on success, or ENOMEM if out of memory, in which case the queue is
+ * unchanged.
+ */
+static inline int rsv_priority_queue_resize(rsv_priority_queue_t* queue,
+                                            unsigned int capacity) {
+  size_t offset = (size_t)(queue->arity - 1) * queue->element_size;
+  unsigned char* memory =
+      (unsigned char*)malloc(offset + (size_t)capacity * queue->element_size +
+                             RSV_PRIORITY_QUEUE_ALIGNMENT - 1);
+  unsigned char* data;
+
+  if (memory == NULL) {
+    return ENOMEM;
+  }
+
+  data = memory + offset +
+         (RSV_PRIORITY_QUEUE_ALIGNMENT -
+          (uintptr_t)memory % RSV_PRIORITY_QUEUE_ALIGNMENT) %
+             RSV_PRIORITY_QUEUE_ALIGNMENT;
+
+  if (queue->amount > 0) {
+    memcpy(data, queue->data, (size_t)queue->amount * queue->element_size);
+  }
+
+  free(queue->memory);
+  queue->memory = memory;
+  queue->data = data;
+  queue->capacity = capacity;
+
+  return 0;
+}
+
+/**
+ * @brief Stores an element and its handle at a heap index. Should not be
+ * directly used unless necessary.
+ *
+ * @param queue Pointer to the priority queue.
+ * @param index The heap index.
+ * @param element Pointer to the element.
+ * @param handle The handle of the element.
+ */
+static inline void rsv_priority_queue_place(rsv_priority_queue_t* queue,
+                                            unsigned int index,
+                                            const void* element,
+                                            unsigned int handle) {
+  memcpy(rsv_priority_queue_at(queue, index), element, queue->element_size);
+
+  if (queue->indexed) {
+    ((unsigned int*)queue->handles.data)[index] = handle;
+    ((unsigned int*)queue->positions.data)[handle] = index;
+  }
+}
+
+/**
+ * @brief Moves the element at one heap index to another. Should not be
+ * directly used unless necessary.
+ *
+ * @param queue Pointer to the priority queue.
+ * @param to The heap index to move to.
+ * @param from The heap index to move from.
+ */
+static inline void rsv_priority_queue_move(rsv_priority_queue_t* queue,
+                                           unsigned int to, unsigned int from) {
+  unsigned int handle = RSV_PRIORITY_QUEUE_NO_HANDLE;
+
+  if (queue->indexed) {
+    handle = ((unsigned int*)queue->handles.data)[from];
+  }
+
+  rsv_priority_queue_place(queue, to, rsv_priority_queue_at(queue, from),
+                           handle);
+}
+
+/**
+ * @brief Fills a hole towards the root, moving parents down until the element
+ * fits. Should not be directly used unless necessary.
+ *
+ * @param queue Pointer to the priority queue.
+ * @param index The heap index of the hole.
+ * @param element Pointer to the element to place, outside of the heap.
+ * @param handle The handle of the element.
+ * @return 1 if the element moved up, 0 if it was placed at the hole.
+ */
+static inline int rsv_priority_queue_sift_up(rsv_priority_queue_t* queue,
+                                             unsigned int index,
+                                             const void* element,
+                                             unsigned int handle) {
+  unsigned int start = index;
+
+  while (index > 0) {
+    unsigned int parent = (index - 1) / queue->arity;
+
+    if (queue->compare_func(element, rsv_priority_queue_at(queue, parent)) >=
+        0) {
+      break;
+    }
+
+    rsv_priority_queue_move(queue, index, parent);
+    index = parent;
+  }
+
+  rsv_priority_queue_place(queue, index, element, handle);
+
+  return index != start;
+}
+
+/**
+ * @brief Fills a hole towards the leaves, moving the leading child up until the
+ * element fits. Should not be directly used unless necessary.
+ *
+ * @param queue Pointer to the priority queue.
+ * @param index The heap index of the hole.
+ * @param element Pointer to the element to place, outside of the heap.
+ * @param handle The handle of the element.
+ */
+static inline void rsv_priority_queue_sift_down(rsv_priority_queue_t* queue,
+                                                unsigned int index,
+                                                const void* element,
+                                                unsigned int handle) {
+  unsigned int amount = queue->amount;
+
+  for (;;) {
+    unsigned int child = index * queue->arity + 1;
+    unsigned int best = child;
+    unsigned int end;
+
+    if (child >= amount || child <= index) {
+      break;
+    }
+
+    end = amount - child > queue->arity ? child + queue->arity : amount;
+
+    /* The siblings are contiguous and start a multiple of arity elements
+     * after a cache line boundary, so small elements share one line */
+    for (++child; child < end; ++child) {
+      if (queue->compare_func(rsv_priority_queue_at(queue, child),
+                              rsv_priority_queue_at(queue, best)) < 0) {
+        best = child;
+      }
+    }
+
+    if (queue->compare_func(rsv_priority_queue_at(queue, best), element) >=
+        0) {
+      break;
+    }
+
+    rsv_priority_queue_move(queue, index, best);
+    index = best;
+  }
+
+  rsv_priority_queue_place(queue, index, element, handle);
+}
+
+/**
+ * @brief Takes a handle for a new element. Should not be directly used unless
+ * necessary.
+ *
+ * @param queue Pointer to the priority queue.
+ * @return The handle, or RSV_PRIORITY_QUEUE_NO_HANDLE if the queue is not
+ * indexed.
+ */
+static inline unsigned int
+rsv_priority_queue_take_handle(rsv_priority_queue_t* queue) {
+  unsigned int handle;
+
+  if (!queue->indexed) {
+    return RSV_PRIORITY_QUEUE_NO_HANDLE;
+  }
+
+  if (queue->free_handles.amount > 0) {
+    handle = ((unsigned int*)
+                  queue->free_handles.data)[queue->free_handles.amount - 1];
+    rsv_dynamic_array_pop(&queue->free_handles);
+  } else {
+    handle = queue->positions.amount;
+    rsv_dynamic_array_push(&queue->positions, &handle);
+  }
+
+  return handle;
+}
+
+/**
+ * @brief Removes the last element of the heap, leaving a copy of it in the
+ * scratch space. Should not be directly used unless necessary.
+ *
+ * @param queue Pointer to the priority queue.
+ * @return The handle of the removed element.
+ */
+static inline unsigned int
+rsv_priority_queue_take_last(rsv_priority_queue_t* queue) {
+  unsigned int last = queue->amount - 1;
+  unsigned int handle = RSV_PRIORITY_QUEUE_NO_HANDLE;
+
+  memcpy(queue->scratch, rsv_priority_queue_at(queue, last),
+         queue->element_size);
+
+  if (queue->indexed) {
+    handle = ((unsigned int*)queue->handles.data)[last];
+    rsv_dynamic_array_pop(&queue->handles);
+  }
+
+  queue->amount--;
+
+  /* Shrinking is optional, the queue stays valid if it fails */
+  if (queue->amount < queue->capacity / 4) {
+    rsv_priority_queue_resize(queue, queue->capacity / 2);
+  }
+
+  return handle;
+}
+
+/**
+ * @brief Releases the handle of a removed element. Should not be directly used
+ * unless necessary.
+ *
+ * @param queue Pointer to the priority queue.
+ * @param handle The handle.
+ */
+static inline void rsv_priority_queue_release(rsv_priority_queue_t* queue,
+                                              unsigned int handle) {
+  if (queue->indexed) {
+    ((unsigned int*)queue->positions.data)[handle] =
+        RSV_PRIORITY_QUEUE_NO_HANDLE;
+    rsv_dynamic_array_push(&queue->free_handles, &handle);
+  }
+}
+
+/**
+ * @brief Creates a priority queue.
+ *
+ * @param capacity Initial capacity of the priority queue.
+ * @param element_size Size of each element in memory.
+ * @param arity Amount of children of each node, or 0 to use
+ * RSV_PRIORITY_QUEUE_ARITY. 4 or 8 keep the children of small elements within
+ * a cache line.
+ * @param compare_func Pointer to a function ordering the elements, returning a
+ * negative value if the first should be popped before the second.
+ * @param indexed 1 to give elements handles for updating and removing them, 0
+ * otherwise.
+ * @return A rsv_priority_queue_t struct representing the created priority
+ * queue.
+ */
+static inline rsv_priority_queue_t
+rsv_priority_queue_create(unsigned int capacity, unsigned int element_size,
+                          unsigned int arity,
+                          int (*compare_func)(const void*, const void*),
+                          int indexed) {
+  rsv_priority_queue_t queue;
+  unsigned int handle_capacity = indexed ? capacity : 0;
+
+  queue.data = NULL;
+  queue.memory = NULL;
+  queue.amount = 0;
+  queue.capacity = 0;
+  queue.handles =
+      rsv_dynamic_array_create(handle_capacity, sizeof(unsigned int));
+  queue.positions =
+      rsv_dynamic_array_create(handle_capacity, sizeof(unsigned int));
+  queue.free_handles = rsv_dynamic_array_create(0, sizeof(unsigned int));
+  queue.scratch = malloc(element_size);
+  queue.arity = arity >= 2 ? arity : RSV_PRIORITY_QUEUE_ARITY;
+  queue.element_size = element_size;
+  queue.limit = 0;
+  queue.indexed = indexed != 0;
+  queue.compare_func = compare_func;
+  rsv_priority_queue_resize(&queue, capacity);
+
+  return queue;
+}
+
+/**
+ * @brief Destroys a priority queue, freeing all associated memory.
+ *
+ * @param queue Pointer to the priority queue to destroy.
+ */
+static inline void rsv_priority_queue_destroy(rsv_priority_queue_t* queue) {
+  free(queue->memory);
+  queue->memory = NULL;
+  queue->data = NULL;
+  queue->amount = 0;
+  queue->capacity = 0;
+  rsv_dynamic_array_destroy(&queue->handles);
+  rsv_dynamic_array_destroy(&queue->positions);
+  rsv_dynamic_array_destroy(&queue->free_handles);
+  free(queue->scratch);
+  queue->scratch = NULL;
+}
+
+/**
+ * @brief Gets the element which would be popped next.
+ *
+ * @param queue Pointer to the priority queue.
+ * @return Pointer to the element, or NULL if the queue is empty.
+ */
+static inline void* rsv_priority_queue_peek(rsv_priority_queue_t* queue) {
+  if (queue->amount == 0) {
+    return NULL;
+  }
+
+  return queue->data;
+}
+
+/**
+ * @brief Gets the element of a handle.
+ *
+ * @param queue Pointer to the indexed priority queue.
+ * @param handle The handle of the element.
+ * @return Pointer to the element, or NULL if the handle is not in the queue.
+ * Only valid until the queue is next changed.
+ */
+static inline void* rsv_priority_queue_get(rsv_priority_queue_t* queue,
+                                           unsigned int handle) {
+  unsigned int index;
+
+  if (!queue->indexed || handle >= queue->positions.amount) {
+    return NULL;
+  }
+
+  index = ((unsigned int*)queue->positions.data)[handle];
+
+  if (index == RSV_PRIORITY_QUEUE_NO_HANDLE) {
+    return NULL;
+  }
+
+  return rsv_priority_queue_at(queue, index);
+}
+
+/**
+ * @brief Adds an element to the priority queue.
+ *
+ * @param queue Pointer to the priority queue.
+ * @param element Pointer to the element to add.
+ * @return The handle of the element, or RSV_PRIORITY_QUEUE_NO_HANDLE if the
+ * queue is not indexed, the element was dropped by the limit or the queue is
+ * out of memory.
+ */
+static inline unsigned int rsv_priority_queue_push(rsv_priority_queue_t* queue,
+                                                   const void* element) {
+  unsigned int handle;
+
+  if (queue->limit > 0 && queue->amount >= queue->limit) {
+    /* Full, so the element either replaces the first element or is dropped */
+    if (queue->compare_func(element, queue->data) <= 0) {
+      return RSV_PRIORITY_QUEUE_NO_HANDLE;
+    }
+
+    memcpy(queue->scratch, element, queue->element_size);
+
+    if (queue->indexed) {
+      rsv_priority_queue_release(queue,
+                                 ((unsigned int*)queue->handles.data)[0]);
+    }
+
+    handle = rsv_priority_queue_take_handle(queue);
+    rsv_priority_queue_sift_down(queue, 0, queue->scratch, handle);
+
+    return handle;
+  }
+
+  /* Copy first, the element could live inside the queue being grown */
+  memcpy(queue->scratch, element, queue->element_size);
+
+  if (queue->amount >= queue->capacity &&
+      rsv_priority_queue_resize(
+          queue, (unsigned int)(queue->capacity *
+                                    RSV_DYNAMIC_ARRAY_GROWTH_AMOUNT +
+                                1)) != 0) {
+    return RSV_PRIORITY_QUEUE_NO_HANDLE;
+  }
+
+  handle = rsv_priority_queue_take_handle(queue);
+  queue->amount++;
+
+  if (queue->indexed) {
+    rsv_dynamic_array_push(&queue->handles, &handle);
+  }
+
+  rsv_priority_queue_sift_up(queue, queue->amount - 1, queue->scratch, handle);
+
+  return handle;
+}
+
+/**
+ * @brief Removes the element which would be popped next.
+ *
+ * @param queue Pointer to the priority queue.
+ * @param element Pointer to copy the removed element to, or NULL.
+ * @return 1 if an element was removed, 0 if the queue is empty.
+ */
+static inline int rsv_priority_queue_pop(rsv_priority_queue_t* queue,
+                                         void* element) {
+  unsigned int handle;
+
+  if (queue->amount == 0) {
+    return 0;
+  }
+
+  if (element) {
+    memcpy(element, queue->data, queue->element_size);
+  }
+
+  if (queue->indexed) {
+    rsv_priority_queue_release(queue, ((unsigned int*)queue->handles.data)[0]);
+  }
+
+  handle = rsv_priority_queue_take_last(queue);
+
+  if (queue->amount > 0) {
+    rsv_priority_queue_sift_down(queue, 0, queue->scratch, handle);
+  }
+
+  return 1;
+}
+
+/**
+ * @brief Replaces the element of a handle and restores the heap order. Use
+ * this to decrease (or increase) the key of an element.
+ *
+ * @param queue Pointer to the indexed priority queue.
+ * @param handle The handle of the element.
+ * @param element Pointer to the new element.
+ * @return 1 if the element was updated, 0 if the handle is not in the queue.
+ */
+static inline int rsv_priority_queue_update(rsv_priority_queue_t* queue,
+                                            unsigned int handle,
+                                            const void* element) {
+  unsigned int index;
+
+  if (rsv_priority_queue_get(queue, handle) == NULL) {
+    return 0;
+  }
+
+  index = ((unsigned int*)queue->positions.data)[handle];
+  memcpy(queue->scratch, element, queue->element_size);
+
+  if (!rsv_priority_queue_sift_up(queue, index, queue->scratch, handle)) {
+    rsv_priority_queue_sift_down(queue, index, queue->scratch, handle);
+  }
+
+  return 1;
+}
+
+/**
+ * @brief Removes the element of a handle.
+ *
+ * @param queue Pointer to the indexed priority queue.
+ * @param handle The handle of the element.
+ * @param element Pointer to copy the removed element to, or NULL.
+ * @return 1 if the element was removed, 0 if the handle is not in the queue.
+ */
+static inline int rsv_priority_queue_remove(rsv_priority_queue_t* queue,
+                                            unsigned int handle,
+                                            void* element) {
+  unsigned int index;
+  unsigned int last_handle;
+  void* found = rsv_priority_queue_get(queue, handle);
+
+  if (found == NULL) {
+    return 0;
+  }
+
+  if (element) {
+    memcpy(element, found, queue->element_size);
+  }
+
+  index = ((unsigned int*)queue->positions.data)[handle];
+  rsv_priority_queue_release(queue, handle);
+  last_handle = rsv_priority_queue_take_last(queue);
+
+  /* The last element fills the hole, unless it was the removed one */
+  if (index < queue->amount &&
+      !rsv_priority_queue_sift_up(queue, index, queue->scratch, last_handle)) {
+    rsv_priority_queue_sift_down(queue, index, queue->scratch, last_handle);
+  }
+
+  return 1;
+}
+
+/**
+ * @brief Adds the elements of a dynamic array to the priority queue, then
+ * rebuilds the heap bottom up in linear time. Faster than pushing the elements
+ * one at a time. Ignores the limit of the queue.
+ *
+ * @param queue Pointer to the priority queue.
+ * @param array Pointer to a dynamic array of elements of the same size.
+ * @param handles Pointer to store the handle of each added element to in array
+ * order, or NULL.
+ * @return 0 on success, or ENOMEM if out of memory, in which case the queue is
+ * unchanged.
+ */
+static inline int rsv_priority_queue_heapify(rsv_priority_queue_t* queue,
+                                             const rsv_dynamic_array_t* array,
+                                             unsigned int* handles) {
+  unsigned int amount = queue->amount + array->amount;
+  unsigned int i;
+
+  if (amount > queue->capacity &&
+      rsv_priority_queue_resize(queue, amount) != 0) {
+    return ENOMEM;
+  }
+
+  for (i = 0; i < array->amount; ++i) {
+    unsigned int handle = rsv_priority_queue_take_handle(queue);
+
+    memcpy(rsv_priority_queue_at(queue, queue->amount),
+           (unsigned char*)array->data + (size_t)i * array->element_size,
+           queue->element_size);
+    queue->amount++;
+
+    if (queue->indexed) {
+      rsv_dynamic_array_push(&queue->handles, &handle);
+      ((unsigned int*)queue->positions.data)[handle] = queue->amount - 1;
+    }
+
+    if (handles) {
+      handles[i] = handle;
+    }
+  }
+
+  if (amount < 2) {
+    return 0;
+  }
+
+  /* Sift down every parent, starting from the last one */
+  for (i = (amount - 2) / queue->arity + 1; i-- > 0;) {
+    unsigned int handle = RSV_PRIORITY_QUEUE_NO_HANDLE;
+
+    if (queue->indexed) {
+      handle = ((unsigned int*)queue->handles.data)[i];
+    }
+
+    memcpy(queue->scratch, rsv_priority_queue_at(queue, i),
+           queue->element_size);
+    rsv_priority_queue_sift_down(queue, i, queue->scratch, handle);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Pops every element of the priority queue onto a dynamic array, in the
+ * order they are popped.
+ *
+ * @param queue Pointer to the priority queue.
+ * @param array Pointer to the dynamic array to push the elements to.
+ */
+static inline void rsv_priority_queue_drain(rsv_priority_queue_t* queue,
+                                            rsv_dynamic_array_t* array) {
+  while (queue->amount > 0) {
+    rsv_dynamic_array_push(array, queue->data);
+    rsv_priority_queue_pop(queue, NULL);
+  }
+}
+
+/**
+ * @brief Selects the k elements of a dynamic array which compare last, without
+ * sorting the whole array. Keeps a bounded heap of k elements, so it takes
+ * O(n log k) time and O(k) memory.
+ *
+ * @param array Pointer to the dynamic array of elements.
+ * @param k The amount of elements to select.
+ * @param compare_func Pointer to a function ordering the elements like the
+ * compare function of qsort. With an ascending compare the k largest elements
+ * are selected.
+ * @param output Pointer to the dynamic array to push the selected elements to,
+ * in ascending order of compare_func.
+ */
+static inline void
+rsv_priority_queue_top_k(const rsv_dynamic_array_t* array, unsigned int k,
+                         int (*compare_func)(const void*, const void*),
+                         rsv_dynamic_array_t* output) {
+  rsv_priority_queue_t queue;
+  unsigned int i;
+
+  if (k == 0) {
+    return;
+  }
+
+  queue = rsv_priority_queue_create(k, array->element_size, 0, compare_func, 0);
+  queue.limit = k;
+
+  for (i = 0; i < array->amount; ++i) {
+    rsv_priority_queue_push(&queue, (unsigned char*)array->data +
+                                        i * array->element_size);
+  }
+
+  rsv_priority_queue_drain(&queue, output);
+  rsv_priority_queue_destroy(&queue);
+}
+
+#endif /* RSV_PRIORITY_QUEUE_H */
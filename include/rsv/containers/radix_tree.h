@@ -0,0 +1,1410 @@
+/*
+  radix_tree.h
+  Implementation of an ordered map from byte strings as an adaptive radix tree
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#ifndef RSV_RADIX_TREE_H
+#define RSV_RADIX_TREE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define RSV_RADIX_TREE_NODE4 0
+#define RSV_RADIX_TREE_NODE16 1
+#define RSV_RADIX_TREE_NODE48 2
+#define RSV_RADIX_TREE_NODE256 3
+#define RSV_RADIX_TREE_PREFIX_SIZE 8
+#define RSV_RADIX_TREE_ITERATOR_DEPTH 32
+
+/**
+ * @brief A key and its value. Should not be directly used unless necessary.
+ *
+ */
+typedef struct rsv_radix_tree_leaf_t {
+  unsigned int length;
+  union {
+    void* pointer;
+    double floating;
+    long long integer;
+  } data[];
+} rsv_radix_tree_leaf_t;
+
+/**
+ * @brief The header shared by the inner node types. Should not be directly
+ * used unless necessary.
+ *
+ */
+typedef struct rsv_radix_tree_node_t {
+  unsigned char type;
+  unsigned short amount;
+  /**
+   * @brief The length of the compressed path below the parent. Only the first
+   * RSV_RADIX_TREE_PREFIX_SIZE bytes are stored, the rest are read from any
+   * leaf below when needed.
+   *
+   */
+  unsigned int prefix_length;
+  unsigned char prefix[RSV_RADIX_TREE_PREFIX_SIZE];
+  /**
+   * @brief The leaf whose key ends at this node, or NULL.
+   *
+   */
+  rsv_radix_tree_leaf_t* leaf;
+} rsv_radix_tree_node_t;
+
+/**
+ * @brief Inner nodes by the most children they hold. Node4 and Node16 keep
+ * sorted key bytes, Node48 maps every byte to a child slot and Node256 indexes
+ * its children by byte. Children are nodes, or leaves tagged by the low bit.
+ * Should not be directly used unless necessary.
+ *
+ */
+typedef struct rsv_radix_tree_node4_t {
+  rsv_radix_tree_node_t node;
+  unsigned char keys[4];
+  void* children[4];
+} rsv_radix_tree_node4_t;
+
+typedef struct rsv_radix_tree_node16_t {
+  rsv_radix_tree_node_t node;
+  unsigned char keys[16];
+  void* children[16];
+} rsv_radix_tree_node16_t;
+
+typedef struct rsv_radix_tree_node48_t {
+  rsv_radix_tree_node_t node;
+  /**
+   * @brief One more than the slot of each byte, 0 if it has no child.
+   *
+   */
+  unsigned char slots[256];
+  void* children[48];
+} rsv_radix_tree_node48_t;
+
+typedef struct rsv_radix_tree_node256_t {
+  rsv_radix_tree_node_t node;
+  void* children[256];
+} rsv_radix_tree_node256_t;
+
+/**
+ * @brief An ordered map from byte strings of any length to values, stored as
+ * an adaptive radix tree. Lookups take one node per key byte not covered by a
+ * compressed path, nodes grow and shrink between 4, 16, 48 and 256 children,
+ * and keys are ordered as bytes with shorter keys first. Make sure to cast
+ * your type from the void pointer.
+ *
+ */
+typedef struct rsv_radix_tree_t {
+  /**
+   * @brief The root node or leaf, or NULL if the tree is empty.
+   *
+   */
+  void* root;
+  /**
+   * @brief The amount of key-value pairs in the tree.
+   *
+   */
+  unsigned int amount;
+  /**
+   * @brief The size of the value in memory.
+   *
+   */
+  unsigned int value_size;
+} rsv_radix_tree_t;
+
+/**
+ * @brief A node on the path of an iterator and the key byte of the child the
+ * path takes, or -1 if the path ends at the leaf of the node itself. Should not
+ * be directly used unless necessary.
+ *
+ */
+typedef struct rsv_radix_tree_frame_t {
+  rsv_radix_tree_node_t* node;
+  int byte;
+} rsv_radix_tree_frame_t;
+
+/**
+ * @brief Iterates the key-value pairs of a tree in key order.
+ *
+ */
+typedef struct rsv_radix_tree_iterator_t {
+  const rsv_radix_tree_t* tree;
+  /**
+   * @brief The leaf returned next, or NULL if the iteration is done.
+   *
+   */
+  rsv_radix_tree_leaf_t* leaf;
+  /**
+   * @brief The nodes from the root down to the leaf returned next.
+   *
+   */
+  rsv_radix_tree_frame_t frames[RSV_RADIX_TREE_ITERATOR_DEPTH];
+  /**
+   * @brief The amount of frames, or RSV_RADIX_TREE_ITERATOR_DEPTH + 1 if the
+   * path is deeper than the frames kept.
+   *
+   */
+  unsigned int depth;
+  /**
+   * @brief Iteration stops at the first key not starting with this prefix.
+   *
+   */
+  const void* prefix;
+  unsigned int prefix_length;
+} rsv_radix_tree_iterator_t;
+
+/**
+ * @brief Checks if a child is a leaf. Should not be directly used unless
+ * necessary.
+ *
+ * @param child The child.
+ * @return 1 if the child is a leaf, 0 if it is a node.
+ */
+static inline int rsv_radix_tree_is_leaf(const void* child) {
+  return ((uintptr_t)child & 1) != 0;
+}
+
+/**
+ * @brief Gets the leaf of a tagged child. Should not be directly used unless
+ * necessary.
+ *
+ * @param child The child.
+ * @return Pointer to the leaf.
+ */
+static inline rsv_radix_tree_leaf_t* rsv_radix_tree_leaf(const void* child) {
+  return (rsv_radix_tree_leaf_t*)((uintptr_t)child & ~(uintptr_t)1);
+}
+
+/**
+ * @brief Tags a leaf to store it as a child. Should not be directly used
+ * unless necessary.
+ *
+ * @param leaf Pointer to the leaf.
+ * @return The child.
+ */
+static inline void* rsv_radix_tree_tag(rsv_radix_tree_leaf_t* leaf) {
+  return (void*)((uintptr_t)leaf | 1);
+}
+
+/**
+ * @brief Gets the key of a leaf. Should not be directly used unless necessary.
+ *
+ * @param leaf Pointer to the leaf.
+ * @return Pointer to the key.
+ */
+static inline unsigned char* rsv_radix_tree_key(rsv_radix_tree_leaf_t* leaf) {
+  return (unsigned char*)leaf->data;
+}
+
+/**
+ * @brief Gets the value of a leaf, stored aligned after its key. Should not be
+ * directly used unless necessary.
+ *
+ * @param leaf Pointer to the leaf.
+ * @return Pointer to the value.
+ */
+static inline void* rsv_radix_tree_value(rsv_radix_tree_leaf_t* leaf) {
+  return leaf->data + (leaf->length + sizeof(leaf->data[0]) - 1) /
+                          sizeof(leaf->data[0]);
+}
+
+/**
+ * @brief Checks if a leaf holds a key. Should not be directly used unless
+ * necessary.
+ *
+ * @param leaf Pointer to the leaf.
+ * @param key Pointer to the key.
+ * @param length Length of the key.
+ * @return 1 if the leaf holds the key, 0 otherwise.
+ */
+static inline int rsv_radix_tree_matches(rsv_radix_tree_leaf_t* leaf,
+                                         const unsigned char* key,
+                                         unsigned int length) {
+  return leaf->length == length &&
+         memcmp(rsv_radix_tree_key(leaf), key, length) == 0;
+}
+
+/**
+ * @brief Creates a leaf. Should not be directly used unless necessary.
+ *
+ * @param tree Pointer to the tree.
+ * @param key Pointer to the key.
+ * @param length Length of the key.
+ * @param value Pointer to the value.
+ * @return Pointer to the leaf.
+ */
+static inline rsv_radix_tree_leaf_t*
+rsv_radix_tree_leaf_create(rsv_radix_tree_t* tree, const unsigned char* key,
+                           unsigned int length, const void* value) {
+  rsv_radix_tree_leaf_t* leaf;
+  size_t unit = sizeof(leaf->data[0]);
+
+  leaf = (rsv_radix_tree_leaf_t*)malloc(sizeof(rsv_radix_tree_leaf_t) +
+                                        (length + unit - 1) / unit * unit +
+                                        tree->value_size);
+  leaf->length = length;
+  memcpy(rsv_radix_tree_key(leaf), key, length);
+  memcpy(rsv_radix_tree_value(leaf), value, tree->value_size);
+
+  return leaf;
+}
+
+/**
+ * @brief Creates an empty inner node. Should not be directly used unless
+ * necessary.
+ *
+ * @param type The node type.
+ * @return Pointer to the node.
+ */
+static inline rsv_radix_tree_node_t* rsv_radix_tree_node_create(
+    unsigned char type) {
+  static const size_t sizes[4] = {sizeof(rsv_radix_tree_node4_t),
+                                  sizeof(rsv_radix_tree_node16_t),
+                                  sizeof(rsv_radix_tree_node48_t),
+                                  sizeof(rsv_radix_tree_node256_t)};
+  rsv_radix_tree_node_t* node = (rsv_radix_tree_node_t*)calloc(1, sizes[type]);
+
+  node->type = type;
+
+  return node;
+}
+
+/**
+ * @brief Gets the child of a node for a key byte. Should not be directly used
+ * unless necessary.
+ *
+ * Node16 compares all of its key bytes at once with SSE2 where available.
+ *
+ * @param node Pointer to the node.
+ * @param byte The key byte.
+ * @return Pointer to the child slot, or NULL if there is no child.
+ */
+static inline void** rsv_radix_tree_find(rsv_radix_tree_node_t* node,
+                                         unsigned char byte) {
+  unsigned int i;
+
+  switch (node->type) {
+  case RSV_RADIX_TREE_NODE4: {
+    rsv_radix_tree_node4_t* node4 = (rsv_radix_tree_node4_t*)node;
+
+    for (i = 0; i < node->amount; ++i) {
+      if (node4->keys[i] == byte) {
+        return &node4->children[i];
+      }
+    }
+
+    return NULL;
+  }
+  case RSV_RADIX_TREE_NODE16: {
+    rsv_radix_tree_node16_t* node16 = (rsv_radix_tree_node16_t*)node;
+
+#if defined(__SSE2__)
+    unsigned int mask = (unsigned int)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_set1_epi8((char)byte),
+                       _mm_loadu_si128((const __m128i*)node16->keys)));
+
+    mask &= (1u << node->amount) - 1;
+
+    return mask ? &node16->children[__builtin_ctz(mask)] : NULL;
+#else
+    for (i = 0; i < node->amount; ++i) {
+      if (node16->keys[i] == byte) {
+        return &node16->children[i];
+      }
+    }
+
+    return NULL;
+#endif
+  }
+  case RSV_RADIX_TREE_NODE48: {
+    rsv_radix_tree_node48_t* node48 = (rsv_radix_tree_node48_t*)node;
+
+    return node48->slots[byte]
+               ? &node48->children[node48->slots[byte] - 1]
+               : NULL;
+  }
+  default: {
+    rsv_radix_tree_node256_t* node256 = (rsv_radix_tree_node256_t*)node;
+
+    return node256->children[byte] ? &node256->children[byte] : NULL;
+  }
+  }
+}
+
+/**
+ * @brief Gets the child of a node with the lowest key byte above a byte.
+ * Should not be directly used unless necessary.
+ *
+ * @param node Pointer to the node.
+ * @param byte The byte, or -1 to get the first child.
+ * @param found Pointer to store the key byte of the child in, or NULL.
+ * @return The child, or NULL if there is none.
+ */
+static inline void* rsv_radix_tree_after(rsv_radix_tree_node_t* node,
+                                         int byte, int* found) {
+  unsigned int i;
+
+  switch (node->type) {
+  case RSV_RADIX_TREE_NODE4:
+  case RSV_RADIX_TREE_NODE16: {
+    unsigned char* keys = node->type == RSV_RADIX_TREE_NODE4
+                              ? ((rsv_radix_tree_node4_t*)node)->keys
+                              : ((rsv_radix_tree_node16_t*)node)->keys;
+    void** children = node->type == RSV_RADIX_TREE_NODE4
+                          ? ((rsv_radix_tree_node4_t*)node)->children
+                          : ((rsv_radix_tree_node16_t*)node)->children;
+
+    for (i = 0; i < node->amount; ++i) {
+      if ((int)keys[i] > byte) {
+        if (found) {
+          *found = keys[i];
+        }
+
+        return children[i];
+      }
+    }
+
+    return NULL;
+  }
+  case RSV_RADIX_TREE_NODE48: {
+    rsv_radix_tree_node48_t* node48 = (rsv_radix_tree_node48_t*)node;
+
+    for (i = (unsigned int)(byte + 1); i < 256; ++i) {
+      if (node48->slots[i]) {
+        if (found) {
+          *found = (int)i;
+        }
+
+        return node48->children[node48->slots[i] - 1];
+      }
+    }
+
+    return NULL;
+  }
+  default: {
+    rsv_radix_tree_node256_t* node256 = (rsv_radix_tree_node256_t*)node;
+
+    for (i = (unsigned int)(byte + 1); i < 256; ++i) {
+      if (node256->children[i]) {
+        if (found) {
+          *found = (int)i;
+        }
+
+        return node256->children[i];
+      }
+    }
+
+    return NULL;
+  }
+  }
+}
+
+/**
+ * @brief Gets the leaf with the lowest key below a child. Should not be
+ * directly used unless necessary.
+ *
+ * @param child The child.
+ * @return Pointer to the leaf.
+ */
+static inline rsv_radix_tree_leaf_t* rsv_radix_tree_minimum(void* child) {
+  while (!rsv_radix_tree_is_leaf(child)) {
+    rsv_radix_tree_node_t* node = (rsv_radix_tree_node_t*)child;
+
+    if (node->leaf) {
+      return node->leaf;
+    }
+
+    child = rsv_radix_tree_after(node, -1, NULL);
+  }
+
+  return rsv_radix_tree_leaf(child);
+}
+
+/**
+ * @brief Gets the whole compressed path of a node. Should not be directly used
+ * unless necessary.
+ *
+ * @param node Pointer to the node.
+ * @param depth The depth of the key byte the path starts at.
+ * @return Pointer to the path.
+ */
+static inline const unsigned char*
+rsv_radix_tree_path(rsv_radix_tree_node_t* node, unsigned int depth) {
+  if (node->prefix_length <= RSV_RADIX_TREE_PREFIX_SIZE) {
+    return node->prefix;
+  }
+
+  return rsv_radix_tree_key(rsv_radix_tree_minimum(node)) + depth;
+}
+
+/**
+ * @brief Counts the bytes of a key matching the whole compressed path of a
+ * node. Should not be directly used unless necessary.
+ *
+ * @param node Pointer to the node.
+ * @param key Pointer to the key.
+ * @param length Length of the key.
+ * @param depth The depth of the key byte the path starts at.
+ * @return The amount of matching bytes.
+ */
+static inline unsigned int rsv_radix_tree_match(rsv_radix_tree_node_t* node,
+                                                const unsigned char* key,
+                                                unsigned int length,
+                                                unsigned int depth) {
+  const unsigned char* path = rsv_radix_tree_path(node, depth);
+  unsigned int limit = node->prefix_length < length - depth
+                           ? node->prefix_length
+                           : length - depth;
+  unsigned int i = 0;
+
+  while (i < limit && path[i] == key[depth + i]) {
+    i++;
+  }
+
+  return i;
+}
+
+/**
+ * @brief Appends a child to a node with room, in key byte order. Should not be
+ * directly used unless necessary.
+ *
+ * @param node Pointer to the node.
+ * @param byte The key byte, above those of the other children.
+ * @param child The child.
+ */
+static inline void rsv_radix_tree_append(rsv_radix_tree_node_t* node,
+                                         unsigned char byte, void* child) {
+  switch (node->type) {
+  case RSV_RADIX_TREE_NODE4:
+    ((rsv_radix_tree_node4_t*)node)->keys[node->amount] = byte;
+    ((rsv_radix_tree_node4_t*)node)->children[node->amount] = child;
+    break;
+  case RSV_RADIX_TREE_NODE16:
+    ((rsv_radix_tree_node16_t*)node)->keys[node->amount] = byte;
+    ((rsv_radix_tree_node16_t*)node)->children[node->amount] = child;
+    break;
+  case RSV_RADIX_TREE_NODE48:
+    ((rsv_radix_tree_node48_t*)node)->slots[byte] =
+        (unsigned char)(node->amount + 1);
+    ((rsv_radix_tree_node48_t*)node)->children[node->amount] = child;
+    break;
+  default:
+    ((rsv_radix_tree_node256_t*)node)->children[byte] = child;
+    break;
+  }
+
+  node->amount++;
+}
+
+/**
+ * @brief Replaces a node with a node of another type holding the same
+ * children. Should not be directly used unless necessary.
+ *
+ * @param slot Pointer to where the node is stored.
+ * @param type The new node type.
+ */
+static inline void rsv_radix_tree_convert(void** slot, unsigned char type) {
+  rsv_radix_tree_node_t* node = (rsv_radix_tree_node_t*)*slot;
+  rsv_radix_tree_node_t* converted = rsv_radix_tree_node_create(type);
+  unsigned int i;
+
+  converted->prefix_length = node->prefix_length;
+  memcpy(converted->prefix, node->prefix, RSV_RADIX_TREE_PREFIX_SIZE);
+  converted->leaf = node->leaf;
+
+  switch (node->type) {
+  case RSV_RADIX_TREE_NODE4:
+    for (i = 0; i < node->amount; ++i) {
+      rsv_radix_tree_append(converted, ((rsv_radix_tree_node4_t*)node)->keys[i],
+                            ((rsv_radix_tree_node4_t*)node)->children[i]);
+    }
+    break;
+  case RSV_RADIX_TREE_NODE16:
+    for (i = 0; i < node->amount; ++i) {
+      rsv_radix_tree_append(converted,
+                            ((rsv_radix_tree_node16_t*)node)->keys[i],
+                            ((rsv_radix_tree_node16_t*)node)->children[i]);
+    }
+    break;
+  case RSV_RADIX_TREE_NODE48:
+    for (i = 0; i < 256; ++i) {
+      rsv_radix_tree_node48_t* node48 = (rsv_radix_tree_node48_t*)node;
+
+      if (node48->slots[i]) {
+        rsv_radix_tree_append(converted, (unsigned char)i,
+                              node48->children[node48->slots[i] - 1]);
+      }
+    }
+    break;
+  default:
+    for (i = 0; i < 256; ++i) {
+      rsv_radix_tree_node256_t* node256 = (rsv_radix_tree_node256_t*)node;
+
+      if (node256->children[i]) {
+        rsv_radix_tree_append(converted, (unsigned char)i,
+                              node256->children[i]);
+      }
+    }
+    break;
+  }
+
+  free(node);
+  *slot = converted;
+}
+
+/**
+ * @brief Adds a child to a node, growing the node if it is full. Should not be
+ * directly used unless necessary.
+ *
+ * @param slot Pointer to where the node is stored.
+ * @param byte The key byte, which has no child yet.
+ * @param child The child.
+ */
+static inline void rsv_radix_tree_add(void** slot, unsigned char byte,
+                                      void* child) {
+  static const unsigned int capacities[3] = {4, 16, 48};
+  rsv_radix_tree_node_t* node = (rsv_radix_tree_node_t*)*slot;
+  unsigned int position = 0;
+
+  if (node->type != RSV_RADIX_TREE_NODE256 &&
+      node->amount == capacities[node->type]) {
+    rsv_radix_tree_convert(slot, (unsigned char)(node->type + 1));
+    node = (rsv_radix_tree_node_t*)*slot;
+  }
+
+  switch (node->type) {
+  case RSV_RADIX_TREE_NODE4: {
+    rsv_radix_tree_node4_t* node4 = (rsv_radix_tree_node4_t*)node;
+
+    while (position < node->amount && node4->keys[position] < byte) {
+      position++;
+    }
+
+    memmove(node4->keys + position + 1, node4->keys + position,
+            node->amount - position);
+    memmove(node4->children + position + 1, node4->children + position,
+            (node->amount - position) * sizeof(void*));
+    node4->keys[position] = byte;
+    node4->children[position] = child;
+    break;
+  }
+  case RSV_RADIX_TREE_NODE16: {
+    rsv_radix_tree_node16_t* node16 = (rsv_radix_tree_node16_t*)node;
+
+#if defined(__SSE2__)
+    /* Flip the sign bits to compare the bytes unsigned */
+    __m128i bias = _mm_set1_epi8((char)0x80);
+    unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmplt_epi8(
+        _mm_xor_si128(_mm_loadu_si128((const __m128i*)node16->keys), bias),
+        _mm_xor_si128(_mm_set1_epi8((char)byte), bias)));
+
+    position =
+        (unsigned int)__builtin_popcount(mask & ((1u << node->amount) - 1));
+#else
+    while (position < node->amount && node16->keys[position] < byte) {
+      position++;
+    }
+#endif
+
+    memmove(node16->keys + position + 1, node16->keys + position,
+            node->amount - position);
+    memmove(node16->children + position + 1, node16->children + position,
+            (node->amount - position) * sizeof(void*));
+    node16->keys[position] = byte;
+    node16->children[position] = child;
+    break;
+  }
+  case RSV_RADIX_TREE_NODE48: {
+    rsv_radix_tree_node48_t* node48 = (rsv_radix_tree_node48_t*)node;
+
+    while (node48->children[position]) {
+      position++;
+    }
+
+    node48->slots[byte] = (unsigned char)(position + 1);
+    node48->children[position] = child;
+    break;
+  }
+  default:
+    ((rsv_radix_tree_node256_t*)node)->children[byte] = child;
+    break;
+  }
+
+  node->amount++;
+}
+
+/**
+ * @brief Removes the child of a key byte from a node. Should not be directly
+ * used unless necessary.
+ *
+ * @param node Pointer to the node.
+ * @param byte The key byte, which has a child.
+ */
+static inline void rsv_radix_tree_remove(rsv_radix_tree_node_t* node,
+                                         unsigned char byte) {
+  unsigned int position = 0;
+
+  switch (node->type) {
+  case RSV_RADIX_TREE_NODE4:
+  case RSV_RADIX_TREE_NODE16: {
+    unsigned char* keys = node->type == RSV_RADIX_TREE_NODE4
+                              ? ((rsv_radix_tree_node4_t*)node)->keys
+                              : ((rsv_radix_tree_node16_t*)node)->keys;
+    void** children = node->type == RSV_RADIX_TREE_NODE4
+                          ? ((rsv_radix_tree_node4_t*)node)->children
+                          : ((rsv_radix_tree_node16_t*)node)->children;
+
+    while (keys[position] != byte) {
+      position++;
+    }
+
+    memmove(keys + position, keys + position + 1,
+            node->amount - position - 1);
+    memmove(children + position, children + position + 1,
+            (node->amount - position - 1) * sizeof(void*));
+    break;
+  }
+  case RSV_RADIX_TREE_NODE48: {
+    rsv_radix_tree_node48_t* node48 = (rsv_radix_tree_node48_t*)node;
+
+    node48->children[node48->slots[byte] - 1] = NULL;
+    node48->slots[byte] = 0;
+    break;
+  }
+  default:
+    ((rsv_radix_tree_node256_t*)node)->children[byte] = NULL;
+    break;
+  }
+
+  node->amount--;
+}
+
+/**
+ * @brief Shrinks a node after a removal, replacing it with a smaller node
+ * type, or with its only leaf or child. Should not be directly used unless
+ * necessary.
+ *
+ * @param slot Pointer to where the node is stored.
+ */
+static inline void rsv_radix_tree_shrink(void** slot) {
+  rsv_radix_tree_node_t* node = (rsv_radix_tree_node_t*)*slot;
+
+  switch (node->type) {
+  case RSV_RADIX_TREE_NODE4: {
+    void* child = ((rsv_radix_tree_node4_t*)node)->children[0];
+
+    if (node->amount == 0) {
+      *slot = rsv_radix_tree_tag(node->leaf);
+      free(node);
+    } else if (node->amount == 1 && node->leaf == NULL) {
+      if (!rsv_radix_tree_is_leaf(child)) {
+        /* Merge the path of the node, its key byte and the path of the child */
+        rsv_radix_tree_node_t* below = (rsv_radix_tree_node_t*)child;
+        unsigned char path[RSV_RADIX_TREE_PREFIX_SIZE * 2 + 1];
+        unsigned int stored = node->prefix_length < RSV_RADIX_TREE_PREFIX_SIZE
+                                  ? node->prefix_length
+                                  : RSV_RADIX_TREE_PREFIX_SIZE;
+
+        memcpy(path, node->prefix, stored);
+        path[stored] = ((rsv_radix_tree_node4_t*)node)->keys[0];
+        memcpy(path + stored + 1, below->prefix, RSV_RADIX_TREE_PREFIX_SIZE);
+        memcpy(below->prefix, path, RSV_RADIX_TREE_PREFIX_SIZE);
+        below->prefix_length += node->prefix_length + 1;
+      }
+
+      *slot = child;
+      free(node);
+    }
+    break;
+  }
+  case RSV_RADIX_TREE_NODE16:
+    if (node->amount < 3) {
+      rsv_radix_tree_convert(slot, RSV_RADIX_TREE_NODE4);
+    }
+    break;
+  case RSV_RADIX_TREE_NODE48:
+    if (node->amount < 12) {
+      rsv_radix_tree_convert(slot, RSV_RADIX_TREE_NODE16);
+    }
+    break;
+  default:
+    if (node->amount < 37) {
+      rsv_radix_tree_convert(slot, RSV_RADIX_TREE_NODE48);
+    }
+    break;
+  }
+}
+
+/**
+ * @brief Destroys a child and everything below it. Should not be directly used
+ * unless necessary.
+ *
+ * @param child The child.
+ */
+static inline void rsv_radix_tree_node_destroy(void* child) {
+  rsv_radix_tree_node_t* node;
+  void* below;
+  int byte = -1;
+
+  if (rsv_radix_tree_is_leaf(child)) {
+    free(rsv_radix_tree_leaf(child));
+    return;
+  }
+
+  node = (rsv_radix_tree_node_t*)child;
+
+  if (node->type == RSV_RADIX_TREE_NODE48 ||
+      node->type == RSV_RADIX_TREE_NODE256) {
+    for (byte = 0; byte < 256; ++byte) {
+      void** found = rsv_radix_tree_find(node, (unsigned char)byte);
+
+      if (found) {
+        rsv_radix_tree_node_destroy(*found);
+      }
+    }
+  } else {
+    unsigned int i;
+
+    for (i = 0; i < node->amount; ++i) {
+      below = node->type == RSV_RADIX_TREE_NODE4
+                  ? ((rsv_radix_tree_node4_t*)node)->children[i]
+                  : ((rsv_radix_tree_node16_t*)node)->children[i];
+      rsv_radix_tree_node_destroy(below);
+    }
+  }
+
+  free(node->leaf);
+  free(node);
+}
+
+/**
+ * @brief Creates a radix tree.
+ *
+ * @param value_size Size of each value in memory.
+ * @return A rsv_radix_tree_t struct representing the created tree.
+ */
+static inline rsv_radix_tree_t rsv_radix_tree_create(unsigned int value_size) {
+  rsv_radix_tree_t tree;
+
+  tree.root = NULL;
+  tree.amount = 0;
+  tree.value_size = value_size;
+
+  return tree;
+}
+
+/**
+ * @brief Destroys a radix tree, freeing all associated memory.
+ *
+ * @param tree Pointer to the tree to destroy.
+ */
+static inline void rsv_radix_tree_destroy(rsv_radix_tree_t* tree) {
+  if (tree->root) {
+    rsv_radix_tree_node_destroy(tree->root);
+  }
+
+  tree->root = NULL;
+  tree->amount = 0;
+}
+
+/**
+ * @brief Retrieves the value associated with the specified key.
+ *
+ * Paths longer than RSV_RADIX_TREE_PREFIX_SIZE are skipped without comparing
+ * their unstored bytes, the key of the leaf reached is compared at the end.
+ *
+ * @param tree Pointer to the tree.
+ * @param key Pointer to the key.
+ * @param length Length of the key in bytes.
+ * @return Pointer to the value associated with the key, or NULL if not found.
+ */
+static inline void* rsv_radix_tree_get(const rsv_radix_tree_t* tree,
+                                       const void* key, unsigned int length) {
+  const unsigned char* bytes = (const unsigned char*)key;
+  void* child = tree->root;
+  unsigned int depth = 0;
+
+  while (child) {
+    rsv_radix_tree_node_t* node;
+    void** found;
+
+    if (rsv_radix_tree_is_leaf(child)) {
+      rsv_radix_tree_leaf_t* leaf = rsv_radix_tree_leaf(child);
+
+      return rsv_radix_tree_matches(leaf, bytes, length)
+                 ? rsv_radix_tree_value(leaf)
+                 : NULL;
+    }
+
+    node = (rsv_radix_tree_node_t*)child;
+
+    if (node->prefix_length) {
+      if (length - depth < node->prefix_length ||
+          memcmp(node->prefix, bytes + depth,
+                 node->prefix_length < RSV_RADIX_TREE_PREFIX_SIZE
+                     ? node->prefix_length
+                     : RSV_RADIX_TREE_PREFIX_SIZE) != 0) {
+        return NULL;
+      }
+
+      depth += node->prefix_length;
+    }
+
+    if (depth == length) {
+      return node->leaf && rsv_radix_tree_matches(node->leaf, bytes, length)
+                 ? rsv_radix_tree_value(node->leaf)
+                 : NULL;
+    }
+
+    found = rsv_radix_tree_find(node, bytes[depth]);
+    child = found ? *found : NULL;
+    depth++;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Adds a key-value pair to the tree, replacing the value if the key is
+ * already present.
+ *
+ * @param tree Pointer to the tree.
+ * @param key Pointer to the key.
+ * @param length Length of the key in bytes.
+ * @param value Pointer to the value.
+ */
+static inline void rsv_radix_tree_push(rsv_radix_tree_t* tree, const void* key,
+                                       unsigned int length, const void* value) {
+  const unsigned char* bytes = (const unsigned char*)key;
+  void** slot = &tree->root;
+  unsigned int depth = 0;
+
+  for (;;) {
+    rsv_radix_tree_node_t* node;
+    rsv_radix_tree_node_t* split;
+    rsv_radix_tree_leaf_t* leaf;
+    void** found;
+
+    if (*slot == NULL) {
+      *slot = rsv_radix_tree_tag(
+          rsv_radix_tree_leaf_create(tree, bytes, length, value));
+      tree->amount++;
+      return;
+    }
+
+    if (rsv_radix_tree_is_leaf(*slot)) {
+      rsv_radix_tree_leaf_t* existing = rsv_radix_tree_leaf(*slot);
+      const unsigned char* existing_key = rsv_radix_tree_key(existing);
+      unsigned int limit =
+          existing->length < length ? existing->length : length;
+      unsigned int end = depth;
+
+      if (rsv_radix_tree_matches(existing, bytes, length)) {
+        memcpy(rsv_radix_tree_value(existing), value, tree->value_size);
+        return;
+      }
+
+      /* Both keys go below a node holding their common path */
+      while (end < limit && existing_key[end] == bytes[end]) {
+        end++;
+      }
+
+      split = rsv_radix_tree_node_create(RSV_RADIX_TREE_NODE4);
+      split->prefix_length = end - depth;
+      memcpy(split->prefix, bytes + depth,
+             end - depth < RSV_RADIX_TREE_PREFIX_SIZE
+                 ? end - depth
+                 : RSV_RADIX_TREE_PREFIX_SIZE);
+      leaf = rsv_radix_tree_leaf_create(tree, bytes, length, value);
+      *slot = split;
+
+      if (existing->length == end) {
+        split->leaf = existing;
+      } else {
+        rsv_radix_tree_add(slot, existing_key[end],
+                           rsv_radix_tree_tag(existing));
+      }
+
+      if (length == end) {
+        split->leaf = leaf;
+      } else {
+        rsv_radix_tree_add(slot, bytes[end], rsv_radix_tree_tag(leaf));
+      }
+
+      tree->amount++;
+      return;
+    }
+
+    node = (rsv_radix_tree_node_t*)*slot;
+
+    if (node->prefix_length) {
+      unsigned int matched = rsv_radix_tree_match(node, bytes, length, depth);
+
+      if (matched < node->prefix_length) {
+        /* Split the path where the key leaves it */
+        const unsigned char* path = rsv_radix_tree_path(node, depth);
+        unsigned char byte = path[matched];
+        unsigned int rest = node->prefix_length - matched - 1;
+
+        split = rsv_radix_tree_node_create(RSV_RADIX_TREE_NODE4);
+        split->prefix_length = matched;
+        memcpy(split->prefix, node->prefix, RSV_RADIX_TREE_PREFIX_SIZE);
+        memmove(node->prefix, path + matched + 1,
+                rest < RSV_RADIX_TREE_PREFIX_SIZE ? rest
+                                                  : RSV_RADIX_TREE_PREFIX_SIZE);
+        node->prefix_length = rest;
+        *slot = split;
+        rsv_radix_tree_add(slot, byte, node);
+        leaf = rsv_radix_tree_leaf_create(tree, bytes, length, value);
+
+        if (length == depth + matched) {
+          split->leaf = leaf;
+        } else {
+          rsv_radix_tree_add(slot, bytes[depth + matched],
+                             rsv_radix_tree_tag(leaf));
+        }
+
+        tree->amount++;
+        return;
+      }
+
+      depth += node->prefix_length;
+    }
+
+    if (depth == length) {
+      if (node->leaf) {
+        memcpy(rsv_radix_tree_value(node->leaf), value, tree->value_size);
+      } else {
+        node->leaf = rsv_radix_tree_leaf_create(tree, bytes, length, value);
+        tree->amount++;
+      }
+
+      return;
+    }
+
+    found = rsv_radix_tree_find(node, bytes[depth]);
+
+    if (found == NULL) {
+      rsv_radix_tree_add(slot, bytes[depth],
+                         rsv_radix_tree_tag(rsv_radix_tree_leaf_create(
+                             tree, bytes, length, value)));
+      tree->amount++;
+      return;
+    }
+
+    slot = found;
+    depth++;
+  }
+}
+
+/**
+ * @brief Removes a key-value pair from the tree.
+ *
+ * @param tree Pointer to the tree.
+ * @param key Pointer to the key.
+ * @param length Length of the key in bytes.
+ * @return 1 if the pair was removed, 0 if the key was not found.
+ */
+static inline int rsv_radix_tree_pop(rsv_radix_tree_t* tree, const void* key,
+                                     unsigned int length) {
+  const unsigned char* bytes = (const unsigned char*)key;
+  void** slot = &tree->root;
+  unsigned int depth = 0;
+
+  while (*slot) {
+    rsv_radix_tree_node_t* node;
+    void** found;
+
+    if (rsv_radix_tree_is_leaf(*slot)) {
+      if (!rsv_radix_tree_matches(rsv_radix_tree_leaf(*slot), bytes, length)) {
+        return 0;
+      }
+
+      free(rsv_radix_tree_leaf(*slot));
+      *slot = NULL;
+      tree->amount--;
+      return 1;
+    }
+
+    node = (rsv_radix_tree_node_t*)*slot;
+
+    if (node->prefix_length) {
+      if (length - depth < node->prefix_length ||
+          memcmp(node->prefix, bytes + depth,
+                 node->prefix_length < RSV_RADIX_TREE_PREFIX_SIZE
+                     ? node->prefix_length
+                     : RSV_RADIX_TREE_PREFIX_SIZE) != 0) {
+        return 0;
+      }
+
+      depth += node->prefix_length;
+    }
+
+    if (depth == length) {
+      if (node->leaf == NULL ||
+          !rsv_radix_tree_matches(node->leaf, bytes, length)) {
+        return 0;
+      }
+
+      free(node->leaf);
+      node->leaf = NULL;
+      rsv_radix_tree_shrink(slot);
+      tree->amount--;
+      return 1;
+    }
+
+    found = rsv_radix_tree_find(node, bytes[depth]);
+
+    if (found == NULL) {
+      return 0;
+    }
+
+    if (rsv_radix_tree_is_leaf(*found)) {
+      rsv_radix_tree_leaf_t* leaf = rsv_radix_tree_leaf(*found);
+
+      if (!rsv_radix_tree_matches(leaf, bytes, length)) {
+        return 0;
+      }
+
+      free(leaf);
+      rsv_radix_tree_remove(node, bytes[depth]);
+      rsv_radix_tree_shrink(slot);
+      tree->amount--;
+      return 1;
+    }
+
+    slot = found;
+    depth++;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Finds the longest key in the tree which is a prefix of a key, such as
+ * the most specific route for a path.
+ *
+ * @param tree Pointer to the tree.
+ * @param key Pointer to the key.
+ * @param length Length of the key in bytes.
+ * @param matched_length Pointer to store the length of the found key in, or
+ * NULL.
+ * @return Pointer to the value of the found key, or NULL if no key in the
+ * tree is a prefix of the key.
+ */
+static inline void*
+rsv_radix_tree_longest_prefix(const rsv_radix_tree_t* tree, const void* key,
+                              unsigned int length,
+                              unsigned int* matched_length) {
+  const unsigned char* bytes = (const unsigned char*)key;
+  rsv_radix_tree_leaf_t* best = NULL;
+  void* child = tree->root;
+  unsigned int depth = 0;
+
+  while (child) {
+    rsv_radix_tree_node_t* node;
+    void** found;
+
+    if (rsv_radix_tree_is_leaf(child)) {
+      rsv_radix_tree_leaf_t* leaf = rsv_radix_tree_leaf(child);
+
+      if (leaf->length <= length &&
+          memcmp(rsv_radix_tree_key(leaf), bytes, leaf->length) == 0) {
+        best = leaf;
+      }
+
+      break;
+    }
+
+    node = (rsv_radix_tree_node_t*)child;
+
+    /* Compare whole paths, so every leaf passed holds a prefix of the key */
+    if (node->prefix_length) {
+      if (rsv_radix_tree_match(node, bytes, length, depth) <
+          node->prefix_length) {
+        break;
+      }
+
+      depth += node->prefix_length;
+    }
+
+    if (node->leaf) {
+      best = node->leaf;
+    }
+
+    if (depth == length) {
+      break;
+    }
+
+    found = rsv_radix_tree_find(node, bytes[depth]);
+    child = found ? *found : NULL;
+    depth++;
+  }
+
+  if (best == NULL) {
+    return NULL;
+  }
+
+  if (matched_length) {
+    *matched_length = best->length;
+  }
+
+  return rsv_radix_tree_value(best);
+}
+
+/**
+ * @brief Adds a node to the path of an iterator. Should not be directly used
+ * unless necessary.
+ *
+ * @param iterator Pointer to the iterator.
+ * @param node Pointer to the node.
+ * @param byte The key byte of the child the path takes, or -1 for the leaf of
+ * the node.
+ */
+static inline void
+rsv_radix_tree_iterator_push(rsv_radix_tree_iterator_t* iterator,
+                             rsv_radix_tree_node_t* node, int byte) {
+  if (iterator->depth >= RSV_RADIX_TREE_ITERATOR_DEPTH) {
+    iterator->depth = RSV_RADIX_TREE_ITERATOR_DEPTH + 1;
+    return;
+  }
+
+  iterator->frames[iterator->depth].node = node;
+  iterator->frames[iterator->depth].byte = byte;
+  iterator->depth++;
+}
+
+/**
+ * @brief Gets the leaf with the lowest key below a child, adding the nodes
+ * passed to the path of an iterator. Should not be directly used unless
+ * necessary.
+ *
+ * @param iterator Pointer to the iterator.
+ * @param child The child.
+ * @return Pointer to the leaf.
+ */
+static inline rsv_radix_tree_leaf_t*
+rsv_radix_tree_iterator_descend(rsv_radix_tree_iterator_t* iterator,
+                                void* child) {
+  while (!rsv_radix_tree_is_leaf(child)) {
+    rsv_radix_tree_node_t* node = (rsv_radix_tree_node_t*)child;
+    int byte = -1;
+
+    if (node->leaf) {
+      rsv_radix_tree_iterator_push(iterator, node, -1);
+      return node->leaf;
+    }
+
+    child = rsv_radix_tree_after(node, -1, &byte);
+    rsv_radix_tree_iterator_push(iterator, node, byte);
+  }
+
+  return rsv_radix_tree_leaf(child);
+}
+
+/**
+ * @brief Finds the leaf with the lowest key above (or equal to) a key from the
+ * root, keeping the path to it in an iterator. Should not be directly used
+ * unless necessary.
+ *
+ * @param iterator Pointer to the iterator.
+ * @param key Pointer to the key.
+ * @param length Length of the key in bytes.
+ * @param or_equal 1 to also find an equal key.
+ * @return Pointer to the leaf, or NULL if there is none.
+ */
+static inline rsv_radix_tree_leaf_t*
+rsv_radix_tree_seek(rsv_radix_tree_iterator_t* iterator,
+                    const unsigned char* key, unsigned int length,
+                    int or_equal) {
+  void* child = iterator->tree->root;
+  void* above = NULL;
+  rsv_radix_tree_node_t* above_node = NULL;
+  unsigned int above_depth = 0;
+  int above_byte = -1;
+  unsigned int depth = 0;
+
+  iterator->depth = 0;
+
+  while (child) {
+    rsv_radix_tree_node_t* node;
+    void** found;
+    void* next;
+    int byte = -1;
+
+    if (rsv_radix_tree_is_leaf(child)) {
+      rsv_radix_tree_leaf_t* leaf = rsv_radix_tree_leaf(child);
+      int compared = memcmp(rsv_radix_tree_key(leaf), key,
+                            leaf->length < length ? leaf->length : length);
+
+      if (compared == 0) {
+        compared = (leaf->length > length) - (leaf->length < length);
+      }
+
+      if (compared > 0 || (compared == 0 && or_equal)) {
+        return leaf;
+      }
+
+      break;
+    }
+
+    node = (rsv_radix_tree_node_t*)child;
+
+    if (node->prefix_length) {
+      unsigned int limit = node->prefix_length < length - depth
+                               ? node->prefix_length
+                               : length - depth;
+      int compared =
+          memcmp(rsv_radix_tree_path(node, depth), key + depth, limit);
+
+      /* Every key below is higher if the path is, or if the key ends in it */
+      if (compared > 0 || (compared == 0 && limit < node->prefix_length)) {
+        return rsv_radix_tree_iterator_descend(iterator, node);
+      }
+
+      if (compared < 0) {
+        break;
+      }
+
+      depth += node->prefix_length;
+    }
+
+    if (depth == length) {
+      if (node->leaf && or_equal) {
+        rsv_radix_tree_iterator_push(iterator, node, -1);
+        return node->leaf;
+      }
+
+      next = rsv_radix_tree_after(node, -1, &byte);
+
+      if (next == NULL) {
+        break;
+      }
+
+      rsv_radix_tree_iterator_push(iterator, node, byte);
+      return rsv_radix_tree_iterator_descend(iterator, next);
+    }
+
+    /* The nearest higher branch, deeper branches are lower */
+    next = rsv_radix_tree_after(node, key[depth], &byte);
+
+    if (next) {
+      above = next;
+      above_node = node;
+      above_depth = iterator->depth;
+      above_byte = byte;
+    }
+
+    rsv_radix_tree_iterator_push(iterator, node, key[depth]);
+    found = rsv_radix_tree_find(node, key[depth]);
+    child = found ? *found : NULL;
+    depth++;
+  }
+
+  if (above == NULL) {
+    return NULL;
+  }
+
+  /* Go back up to the branch and take it instead */
+  iterator->depth = above_depth;
+  rsv_radix_tree_iterator_push(iterator, above_node, above_byte);
+
+  return rsv_radix_tree_iterator_descend(iterator, above);
+}
+
+/**
+ * @brief Creates an iterator over the keys starting with a prefix, in key
+ * order. The iterator is invalidated by changes to the tree.
+ *
+ * @param tree Pointer to the tree.
+ * @param prefix Pointer to the prefix, which must outlive the iterator.
+ * @param prefix_length Length of the prefix, 0 to iterate every key.
+ * @return The iterator.
+ */
+static inline rsv_radix_tree_iterator_t
+rsv_radix_tree_prefix(const rsv_radix_tree_t* tree, const void* prefix,
+                      unsigned int prefix_length) {
+  rsv_radix_tree_iterator_t iterator;
+
+  iterator.tree = tree;
+  iterator.leaf = rsv_radix_tree_seek(
+      &iterator, (const unsigned char*)(prefix_length ? prefix : ""),
+      prefix_length, 1);
+  iterator.prefix = prefix;
+  iterator.prefix_length = prefix_length;
+
+  return iterator;
+}
+
+/**
+ * @brief Gets the next key-value pair of an iterator. Each step climbs the
+ * path of the iterator to the nearest node with a higher child and takes the
+ * lowest leaf below it, so iterating the whole tree visits every node a
+ * constant amount of times. Paths deeper than RSV_RADIX_TREE_ITERATOR_DEPTH
+ * nodes are not kept, and the step after them seeks from the root instead.
+ *
+ * @param iterator Pointer to the iterator.
+ * @param key Pointer to store a pointer to the key in, or NULL.
+ * @param length Pointer to store the length of the key in, or NULL.
+ * @param value Pointer to store a pointer to the value in, or NULL.
+ * @return 1 if a pair was found, 0 if the iteration is done.
+ */
+static inline int rsv_radix_tree_iterator_next(
+    rsv_radix_tree_iterator_t* iterator, void** key, unsigned int* length,
+    void** value) {
+  rsv_radix_tree_leaf_t* leaf = iterator->leaf;
+
+  if (leaf == NULL || leaf->length < iterator->prefix_length ||
+      (iterator->prefix_length &&
+       memcmp(rsv_radix_tree_key(leaf), iterator->prefix,
+              iterator->prefix_length) != 0)) {
+    iterator->leaf = NULL;
+    return 0;
+  }
+
+  if (key) {
+    *key = rsv_radix_tree_key(leaf);
+  }
+
+  if (length) {
+    *length = leaf->length;
+  }
+
+  if (value) {
+    *value = rsv_radix_tree_value(leaf);
+  }
+
+  if (iterator->depth > RSV_RADIX_TREE_ITERATOR_DEPTH) {
+    iterator->leaf = rsv_radix_tree_seek(iterator, rsv_radix_tree_key(leaf),
+                                         leaf->length, 0);
+    return 1;
+  }
+
+  iterator->leaf = NULL;
+
+  while (iterator->depth > 0) {
+    rsv_radix_tree_frame_t* frame = &iterator->frames[iterator->depth - 1];
+    int byte = -1;
+    void* next = rsv_radix_tree_after(frame->node, frame->byte, &byte);
+
+    if (next) {
+      frame->byte = byte;
+      iterator->leaf = rsv_radix_tree_iterator_descend(iterator, next);
+      break;
+    }
+
+    iterator->depth--;
+  }
+
+  return 1;
+}
+
+#endif /* RSV_RADIX_TREE_H */
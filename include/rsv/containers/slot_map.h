@@ -0,0 +1,265 @@
+/*
+  slot_map.h
+  Implementation of a slot map with generational handles
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#ifndef RSV_SLOT_MAP_H
+#define RSV_SLOT_MAP_H
+
+#include "dynamic_array.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RSV_SLOT_MAP_NO_SLOT 0xFFFFFFFFu
+#define RSV_SLOT_MAP_MAX_GENERATION 0xFFFFFFFEu
+
+/**
+ * @brief A handle to an element of a slot map. A handle stays valid until its
+ * element is removed, after which it is detected as stale even if the slot is
+ * reused. A zeroed handle is never valid.
+ *
+ */
+typedef struct rsv_slot_map_handle_t {
+  unsigned int index;
+  unsigned int generation;
+} rsv_slot_map_handle_t;
+
+/**
+ * @brief A slot of a slot map. Should not be directly used unless necessary.
+ *
+ */
+typedef struct rsv_slot_map_slot_t {
+  /**
+   * @brief The index of the element in the dense array while the slot is used,
+   * or the next free slot while it is free.
+   *
+   */
+  unsigned int position;
+  /**
+   * @brief Odd while the slot is used, even while it is free.
+   *
+   */
+  unsigned int generation;
+} rsv_slot_map_slot_t;
+
+/**
+ * @brief A container giving each element a generational handle, with O(1)
+ * insertion, removal and lookup. Elements are kept densely packed in a dynamic
+ * array, filling the gap of a removed element with the last one, so they can
+ * be iterated linearly in no particular order. Make sure to cast your type
+ * from the void pointer.
+ *
+ */
+typedef struct rsv_slot_map_t {
+  /**
+   * @brief The elements, densely packed. elements.amount is the amount of
+   * elements in the slot map.
+   *
+   */
+  rsv_dynamic_array_t elements;
+  /**
+   * @brief The slot of each element in the dense array.
+   *
+   */
+  rsv_dynamic_array_t owners;
+  /**
+   * @brief The slots, indexed by handle.
+   *
+   */
+  rsv_dynamic_array_t slots;
+  /**
+   * @brief The first free slot, or RSV_SLOT_MAP_NO_SLOT.
+   *
+   */
+  unsigned int free_slot;
+} rsv_slot_map_t;
+
+/**
+ * @brief Gets the slot of a handle if the handle is valid. Should not be
+ * directly used unless necessary.
+ *
+ * @param map Pointer to the slot map.
+ * @param handle The handle.
+ * @return Pointer to the slot, or NULL if the handle is stale or invalid.
+ */
+static inline rsv_slot_map_slot_t*
+rsv_slot_map_slot(const rsv_slot_map_t* map, rsv_slot_map_handle_t handle) {
+  rsv_slot_map_slot_t* slot;
+
+  if (handle.index >= map->slots.amount) {
+    return NULL;
+  }
+
+  slot = (rsv_slot_map_slot_t*)map->slots.data + handle.index;
+
+  return slot->generation == handle.generation && (handle.generation & 1)
+             ? slot
+             : NULL;
+}
+
+/**
+ * @brief Creates a slot map.
+ *
+ * @param capacity Initial capacity of the slot map.
+ * @param element_size Size of each element in memory.
+ * @return A rsv_slot_map_t struct representing the created slot map.
+ */
+static inline rsv_slot_map_t rsv_slot_map_create(unsigned int capacity,
+                                                 unsigned int element_size) {
+  rsv_slot_map_t map;
+
+  map.elements = rsv_dynamic_array_create(capacity, element_size);
+  map.owners = rsv_dynamic_array_create(capacity, sizeof(unsigned int));
+  map.slots = rsv_dynamic_array_create(capacity, sizeof(rsv_slot_map_slot_t));
+  map.free_slot = RSV_SLOT_MAP_NO_SLOT;
+
+  return map;
+}
+
+/**
+ * @brief Destroys a slot map, freeing all associated memory.
+ *
+ * @param map Pointer to the slot map to destroy.
+ */
+static inline void rsv_slot_map_destroy(rsv_slot_map_t* map) {
+  rsv_dynamic_array_destroy(&map->elements);
+  rsv_dynamic_array_destroy(&map->owners);
+  rsv_dynamic_array_destroy(&map->slots);
+  map->free_slot = RSV_SLOT_MAP_NO_SLOT;
+}
+
+/**
+ * @brief Adds an element to the slot map.
+ *
+ * @param map Pointer to the slot map.
+ * @param element Pointer to the element to add.
+ * @return The handle of the element.
+ */
+static inline rsv_slot_map_handle_t rsv_slot_map_push(rsv_slot_map_t* map,
+                                                      const void* element) {
+  rsv_slot_map_handle_t handle;
+  rsv_slot_map_slot_t* slot;
+
+  if (map->free_slot != RSV_SLOT_MAP_NO_SLOT) {
+    handle.index = map->free_slot;
+    slot = (rsv_slot_map_slot_t*)map->slots.data + handle.index;
+    map->free_slot = slot->position;
+  } else {
+    rsv_slot_map_slot_t fresh = {0, 0};
+
+    handle.index = map->slots.amount;
+    rsv_dynamic_array_push(&map->slots, &fresh);
+    slot = (rsv_slot_map_slot_t*)map->slots.data + handle.index;
+  }
+
+  slot->generation++;
+  slot->position = map->elements.amount;
+  handle.generation = slot->generation;
+  rsv_dynamic_array_push(&map->elements, element);
+  rsv_dynamic_array_push(&map->owners, &handle.index);
+
+  return handle;
+}
+
+/**
+ * @brief Gets the element of a handle.
+ *
+ * @param map Pointer to the slot map.
+ * @param handle The handle.
+ * @return Pointer to the element, or NULL if the handle is stale or invalid.
+ * Only valid until the slot map is next changed.
+ */
+static inline void* rsv_slot_map_get(rsv_slot_map_t* map,
+                                     rsv_slot_map_handle_t handle) {
+  rsv_slot_map_slot_t* slot = rsv_slot_map_slot(map, handle);
+
+  return slot ? rsv_dynamic_array_get(&map->elements, slot->position) : NULL;
+}
+
+/**
+ * @brief Checks if a handle refers to an element of the slot map.
+ *
+ * @param map Pointer to the slot map.
+ * @param handle The handle.
+ * @return 1 if the handle is valid, 0 if it is stale or invalid.
+ */
+static inline int rsv_slot_map_contains(const rsv_slot_map_t* map,
+                                        rsv_slot_map_handle_t handle) {
+  return rsv_slot_map_slot(map, handle) != NULL;
+}
+
+/**
+ * @brief Gets the handle of an element by its index in the dense array, such
+ * as while iterating the elements.
+ *
+ * @param map Pointer to the slot map.
+ * @param position Index of the element in the dense array.
+ * @return The handle of the element.
+ */
+static inline rsv_slot_map_handle_t
+rsv_slot_map_handle(const rsv_slot_map_t* map, unsigned int position) {
+  rsv_slot_map_handle_t handle;
+
+  handle.index = ((unsigned int*)map->owners.data)[position];
+  handle.generation =
+      ((rsv_slot_map_slot_t*)map->slots.data)[handle.index].generation;
+
+  return handle;
+}
+
+/**
+ * @brief Removes the element of a handle, moving the last element into its
+ * place in the dense array.
+ *
+ * @param map Pointer to the slot map.
+ * @param handle The handle.
+ * @param element Pointer to where the removed element is copied, or NULL.
+ * @return 1 if the element was removed, 0 if the handle is stale or invalid.
+ */
+static inline int rsv_slot_map_pop(rsv_slot_map_t* map,
+                                   rsv_slot_map_handle_t handle,
+                                   void* element) {
+  rsv_slot_map_slot_t* slot = rsv_slot_map_slot(map, handle);
+  unsigned int element_size = map->elements.element_size;
+  unsigned int last = map->elements.amount - 1;
+  unsigned int position;
+  unsigned char* data;
+
+  if (slot == NULL) {
+    return 0;
+  }
+
+  position = slot->position;
+  data = (unsigned char*)map->elements.data;
+
+  if (element) {
+    memcpy(element, data + (size_t)position * element_size, element_size);
+  }
+
+  if (position != last) {
+    unsigned int owner = ((unsigned int*)map->owners.data)[last];
+
+    memcpy(data + (size_t)position * element_size,
+           data + (size_t)last * element_size, element_size);
+    ((unsigned int*)map->owners.data)[position] = owner;
+    ((rsv_slot_map_slot_t*)map->slots.data)[owner].position = position;
+  }
+
+  rsv_dynamic_array_pop(&map->elements);
+  rsv_dynamic_array_pop(&map->owners);
+
+  /* Slots whose generation would wrap are retired instead of reused */
+  slot->generation++;
+
+  if (slot->generation < RSV_SLOT_MAP_MAX_GENERATION) {
+    slot->position = map->free_slot;
+    map->free_slot = handle.index;
+  }
+
+  return 1;
+}
+
+#endif /* RSV_SLOT_MAP_H */
@@ -0,0 +1,638 @@
+/*
+  snapshot_hash_table.h
+  Implementation of a copy-on-write hash table with consistent snapshots
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#if defined(__unix__)
+
+#ifndef RSV_SNAPSHOT_HASH_TABLE_H
+#define RSV_SNAPSHOT_HASH_TABLE_H
+
+#include "../threads/atomic.h"
+#include "../threads/epoch.h"
+#include "../threads/threads_pthreads.h"
+#include "hash_table.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RSV_SNAPSHOT_HASH_TABLE_LOAD_FACTOR 0.75
+
+/**
+ * @brief A bucket of a snapshot hash table, holding its entries inline. Shared
+ * between every version it did not change in, and never modified once
+ * published. Should not be directly used unless necessary.
+ *
+ */
+typedef struct rsv_snapshot_hash_table_chain_t {
+  /**
+   * @brief The amount of versions referencing the chain.
+   *
+   */
+  unsigned int references;
+  /**
+   * @brief The amount of entries in the chain.
+   *
+   */
+  unsigned int amount;
+  /**
+   * @brief The amount of entries that can be stored.
+   *
+   */
+  unsigned int capacity;
+  /**
+   * @brief The entries, each a key followed by a value.
+   *
+   */
+  void* data[];
+} rsv_snapshot_hash_table_chain_t;
+
+/**
+ * @brief A version of a snapshot hash table. Never modified once published.
+ *
+ */
+typedef struct rsv_snapshot_hash_table_version_t {
+  /**
+   * @brief The amount of key-value pairs in the version.
+   *
+   */
+  unsigned int amount;
+  /**
+   * @brief The amount of buckets, always a power of two.
+   *
+   */
+  unsigned int capacity;
+  rsv_snapshot_hash_table_chain_t* buckets[];
+} rsv_snapshot_hash_table_version_t;
+
+/**
+ * @brief A hash table for configuration-style data shared between threads.
+ *
+ * Readers pin the current version without locking and see it unchanged until
+ * they unpin, however many writes happen in the meantime. A writer opens a
+ * draft with rsv_snapshot_hash_table_begin, applies any amount of changes and
+ * publishes them all at once with rsv_snapshot_hash_table_commit. Drafts share
+ * every bucket they do not change with the version they started from, so a
+ * commit copies only the touched buckets and one pointer per bucket. Replaced
+ * versions are reclaimed through the table's epoch domain.
+ *
+ */
+typedef struct rsv_snapshot_hash_table_t {
+  /**
+   * @brief The current version.
+   *
+   */
+  rsv_snapshot_hash_table_version_t* version;
+  /**
+   * @brief The version being written, or NULL outside of a write.
+   *
+   */
+  rsv_snapshot_hash_table_version_t* draft;
+  /**
+   * @brief The size of the key in memory.
+   *
+   */
+  unsigned int key_size;
+  /**
+   * @brief The size of the value in memory.
+   *
+   */
+  unsigned int value_size;
+  /**
+   * @brief The offset of the value from the start of an entry.
+   *
+   */
+  unsigned int value_offset;
+  /**
+   * @brief The size of an entry, a multiple of the pointer size.
+   *
+   */
+  unsigned int entry_size;
+  /**
+   * @brief Use if the hash table would need a custom hash function. Set to NULL
+   * for default hashing.
+   *
+   */
+  unsigned int (*custom_hash_func)(const void*, unsigned int);
+  /**
+   * @brief Use if the hash table would need a custom comparing function for
+   * comparing values inside the table. Set to NULL for default comparing.
+   *
+   */
+  int (*custom_compare_func)(const void*, const void*, unsigned int);
+  /**
+   * @brief Held by the writer from begin until commit or abort.
+   *
+   */
+  rsv_mutex_t writer_mutex;
+  /**
+   * @brief The epoch domain through which replaced versions are reclaimed.
+   * Every thread using the table registers with it.
+   *
+   */
+  rsv_epoch_t epoch;
+} rsv_snapshot_hash_table_t;
+
+/**
+ * @brief Drops a reference to a chain, freeing it with the last one.
+ *
+ * @param chain Pointer to the chain, may be NULL.
+ */
+static inline void
+rsv_snapshot_hash_table_chain_release(rsv_snapshot_hash_table_chain_t* chain) {
+  if (chain && rsv_atomic_fetch_sub(&chain->references, 1,
+                                    RSV_MEMORY_ORDER_ACQ_REL) == 1) {
+    free(chain);
+  }
+}
+
+/**
+ * @brief Allocates an empty version.
+ *
+ * @param capacity Amount of buckets, a power of two.
+ * @return Pointer to the version, or NULL if out of memory.
+ */
+static inline rsv_snapshot_hash_table_version_t*
+rsv_snapshot_hash_table_version_create(unsigned int capacity) {
+  rsv_snapshot_hash_table_version_t* version =
+      (rsv_snapshot_hash_table_version_t*)calloc(
+          1, sizeof(rsv_snapshot_hash_table_version_t) +
+                 capacity * sizeof(rsv_snapshot_hash_table_chain_t*));
+
+  if (version) {
+    version->capacity = capacity;
+  }
+
+  return version;
+}
+
+/**
+ * @brief Frees a version, dropping its references to its chains.
+ *
+ * @param pointer Pointer to the version.
+ */
+static inline void rsv_snapshot_hash_table_version_free(void* pointer) {
+  rsv_snapshot_hash_table_version_t* version =
+      (rsv_snapshot_hash_table_version_t*)pointer;
+  unsigned int i;
+
+  for (i = 0; i < version->capacity; ++i) {
+    rsv_snapshot_hash_table_chain_release(version->buckets[i]);
+  }
+
+  free(version);
+}
+
+/**
+ * @brief Creates a snapshot hash table.
+ *
+ * @param hash_table Pointer to the snapshot hash table to initialize.
+ * @param capacity Initial amount of buckets, rounded up to a power of two.
+ * @param key_size Size of each key in memory.
+ * @param value_size Size of each value in memory.
+ * @param custom_hash_func Pointer to a custom hash function, or NULL to use the
+ * default.
+ * @param custom_compare_func Pointer to a custom compare function, or NULL to
+ * use the default.
+ * @return 0 on success, or ENOMEM if the first version could not be allocated.
+ */
+static inline int rsv_snapshot_hash_table_create(
+    rsv_snapshot_hash_table_t* hash_table, unsigned int capacity,
+    unsigned int key_size, unsigned int value_size,
+    unsigned int (*custom_hash_func)(const void*, unsigned int),
+    int (*custom_compare_func)(const void*, const void*, unsigned int)) {
+  unsigned int bucket_amount = 1;
+
+  while (bucket_amount < capacity) {
+    bucket_amount *= 2;
+  }
+
+  hash_table->version = rsv_snapshot_hash_table_version_create(bucket_amount);
+
+  if (hash_table->version == NULL) {
+    return ENOMEM;
+  }
+
+  if (custom_hash_func == NULL) {
+    custom_hash_func = rsv_hash_table_hash;
+  }
+
+  if (custom_compare_func == NULL) {
+    custom_compare_func = rsv_hash_table_compare;
+  }
+
+  hash_table->draft = NULL;
+  hash_table->key_size = key_size;
+  hash_table->value_size = value_size;
+  hash_table->value_offset = (key_size + sizeof(void*) - 1) &
+                             ~(unsigned int)(sizeof(void*) - 1);
+  hash_table->entry_size = (hash_table->value_offset + value_size +
+                            sizeof(void*) - 1) &
+                           ~(unsigned int)(sizeof(void*) - 1);
+  hash_table->custom_hash_func = custom_hash_func;
+  hash_table->custom_compare_func = custom_compare_func;
+  rsv_mutex_create(&hash_table->writer_mutex);
+  rsv_epoch_create(&hash_table->epoch);
+
+  return 0;
+}
+
+/**
+ * @brief Destroys a snapshot hash table, freeing all associated memory,
+ * including the participants of its epoch domain. No other thread may use the
+ * hash table at the same time.
+ *
+ * @param hash_table Pointer to the snapshot hash table to destroy.
+ */
+static inline void
+rsv_snapshot_hash_table_destroy(rsv_snapshot_hash_table_t* hash_table) {
+  if (hash_table->draft) {
+    rsv_snapshot_hash_table_version_free(hash_table->draft);
+    hash_table->draft = NULL;
+  }
+
+  rsv_epoch_destroy(&hash_table->epoch);
+  rsv_snapshot_hash_table_version_free(hash_table->version);
+  hash_table->version = NULL;
+  rsv_mutex_destroy(&hash_table->writer_mutex);
+}
+
+/**
+ * @brief Registers the calling thread with the epoch domain of a snapshot hash
+ * table.
+ *
+ * @param hash_table Pointer to the snapshot hash table.
+ * @return Pointer to the participant, or NULL if out of memory.
+ */
+static inline rsv_epoch_participant_t*
+rsv_snapshot_hash_table_register(rsv_snapshot_hash_table_t* hash_table) {
+  return rsv_epoch_register(&hash_table->epoch);
+}
+
+/**
+ * @brief Pins the current version of a snapshot hash table. Takes no locks.
+ * The version stays valid and unchanged until rsv_snapshot_hash_table_unpin.
+ *
+ * @param hash_table Pointer to the snapshot hash table.
+ * @param participant Pointer to the participant of the calling thread.
+ * @return Pointer to the pinned version.
+ */
+static inline const rsv_snapshot_hash_table_version_t*
+rsv_snapshot_hash_table_pin(rsv_snapshot_hash_table_t* hash_table,
+                            rsv_epoch_participant_t* participant) {
+  rsv_epoch_enter(participant);
+  return rsv_atomic_load(&hash_table->version, RSV_MEMORY_ORDER_ACQUIRE);
+}
+
+/**
+ * @brief Unpins the version pinned by rsv_snapshot_hash_table_pin.
+ *
+ * @param participant Pointer to the participant of the calling thread.
+ */
+static inline void
+rsv_snapshot_hash_table_unpin(rsv_epoch_participant_t* participant) {
+  rsv_epoch_exit(participant);
+}
+
+/**
+ * @brief Finds the entry of a key within a chain.
+ *
+ * @param hash_table Pointer to the snapshot hash table.
+ * @param chain Pointer to the chain, may be NULL.
+ * @param key Pointer to the key.
+ * @return Index of the entry, or -1 if the key is not found.
+ */
+static inline int
+rsv_snapshot_hash_table_chain_find(const rsv_snapshot_hash_table_t* hash_table,
+                                   const rsv_snapshot_hash_table_chain_t* chain,
+                                   const void* key) {
+  unsigned int i;
+
+  if (chain == NULL) {
+    return -1;
+  }
+
+  for (i = 0; i < chain->amount; ++i) {
+    const char* entry = (const char*)chain->data + i * hash_table->entry_size;
+
+    if (hash_table->custom_compare_func(entry, key, hash_table->key_size)) {
+      return (int)i;
+    }
+  }
+
+  return -1;
+}
+
+/**
+ * @brief Retrieves the value associated with the specified key in a version.
+ *
+ * @param hash_table Pointer to the snapshot hash table.
+ * @param version Pointer to a pinned version, or the draft of the writer.
+ * @param key Pointer to the key.
+ * @return Pointer to the value, valid while the version is pinned, or NULL if
+ * the key is not found.
+ */
+static inline const void*
+rsv_snapshot_hash_table_get(const rsv_snapshot_hash_table_t* hash_table,
+                            const rsv_snapshot_hash_table_version_t* version,
+                            const void* key) {
+  unsigned int index =
+      hash_table->custom_hash_func(key, hash_table->key_size) &
+      (version->capacity - 1);
+  const rsv_snapshot_hash_table_chain_t* chain = version->buckets[index];
+  int found = rsv_snapshot_hash_table_chain_find(hash_table, chain, key);
+
+  if (found < 0) {
+    return NULL;
+  }
+
+  return (const char*)chain->data +
+         ((unsigned int)found * hash_table->entry_size +
+          hash_table->value_offset);
+}
+
+/**
+ * @brief Gets the amount of key-value pairs in a version.
+ *
+ * @param version Pointer to a pinned version.
+ * @return The amount of key-value pairs.
+ */
+static inline unsigned int rsv_snapshot_hash_table_amount(
+    const rsv_snapshot_hash_table_version_t* version) {
+  return version->amount;
+}
+
+/**
+ * @brief Starts a write by opening a draft of the current version. Blocks
+ * while another thread is writing.
+ *
+ * @param hash_table Pointer to the snapshot hash table.
+ * @return 0 on success, or ENOMEM if the draft could not be allocated, in
+ * which case no write was started.
+ */
+static inline int
+rsv_snapshot_hash_table_begin(rsv_snapshot_hash_table_t* hash_table) {
+  rsv_snapshot_hash_table_version_t* version;
+  rsv_snapshot_hash_table_version_t* draft;
+  unsigned int i;
+
+  rsv_mutex_lock(&hash_table->writer_mutex);
+  version = hash_table->version;
+  draft = rsv_snapshot_hash_table_version_create(version->capacity);
+
+  if (draft == NULL) {
+    rsv_mutex_unlock(&hash_table->writer_mutex);
+    return ENOMEM;
+  }
+
+  draft->amount = version->amount;
+
+  for (i = 0; i < version->capacity; ++i) {
+    draft->buckets[i] = version->buckets[i];
+
+    if (draft->buckets[i]) {
+      rsv_atomic_fetch_add(&draft->buckets[i]->references, 1,
+                           RSV_MEMORY_ORDER_RELAXED);
+    }
+  }
+
+  hash_table->draft = draft;
+
+  return 0;
+}
+
+/**
+ * @brief Gets a bucket of the draft which can be modified, copying it if it is
+ * shared with a published version, with room for at least one more entry.
+ *
+ * @param hash_table Pointer to the snapshot hash table.
+ * @param index Index of the bucket.
+ * @return Pointer to the chain, or NULL if out of memory.
+ */
+static inline rsv_snapshot_hash_table_chain_t*
+rsv_snapshot_hash_table_chain_own(rsv_snapshot_hash_table_t* hash_table,
+                                  unsigned int index) {
+  rsv_snapshot_hash_table_chain_t* chain = hash_table->draft->buckets[index];
+  rsv_snapshot_hash_table_chain_t* owned;
+  unsigned int amount = chain ? chain->amount : 0;
+  unsigned int capacity;
+
+  /* Only the draft references the chain, so it was created by this write */
+  if (chain && chain->amount < chain->capacity &&
+      rsv_atomic_load(&chain->references, RSV_MEMORY_ORDER_ACQUIRE) == 1) {
+    return chain;
+  }
+
+  capacity = amount < 2 ? 2 : amount * 2;
+  owned = (rsv_snapshot_hash_table_chain_t*)malloc(
+      sizeof(rsv_snapshot_hash_table_chain_t) +
+      capacity * hash_table->entry_size);
+
+  if (owned == NULL) {
+    return NULL;
+  }
+
+  owned->references = 1;
+  owned->amount = amount;
+  owned->capacity = capacity;
+
+  if (chain) {
+    memcpy(owned->data, chain->data, amount * hash_table->entry_size);
+    rsv_snapshot_hash_table_chain_release(chain);
+  }
+
+  hash_table->draft->buckets[index] = owned;
+
+  return owned;
+}
+
+/**
+ * @brief Doubles the amount of buckets of the draft. Every chain is rebuilt,
+ * so the next commit shares nothing with earlier versions.
+ *
+ * @param hash_table Pointer to the snapshot hash table.
+ * @return 0 on success, or ENOMEM if out of memory.
+ */
+static inline int
+rsv_snapshot_hash_table_resize(rsv_snapshot_hash_table_t* hash_table) {
+  rsv_snapshot_hash_table_version_t* draft = hash_table->draft;
+  unsigned int i;
+  unsigned int j;
+
+  hash_table->draft =
+      rsv_snapshot_hash_table_version_create(draft->capacity * 2);
+
+  if (hash_table->draft == NULL) {
+    hash_table->draft = draft;
+    return ENOMEM;
+  }
+
+  hash_table->draft->amount = draft->amount;
+
+  for (i = 0; i < draft->capacity; ++i) {
+    rsv_snapshot_hash_table_chain_t* chain = draft->buckets[i];
+
+    for (j = 0; chain && j < chain->amount; ++j) {
+      const char* entry = (const char*)chain->data + j * hash_table->entry_size;
+      unsigned int index =
+          hash_table->custom_hash_func(entry, hash_table->key_size) &
+          (hash_table->draft->capacity - 1);
+      rsv_snapshot_hash_table_chain_t* owned =
+          rsv_snapshot_hash_table_chain_own(hash_table, index);
+
+      if (owned == NULL) {
+        rsv_snapshot_hash_table_version_free(hash_table->draft);
+        hash_table->draft = draft;
+        return ENOMEM;
+      }
+
+      memcpy((char*)owned->data + owned->amount * hash_table->entry_size,
+             entry, hash_table->entry_size);
+      owned->amount++;
+    }
+  }
+
+  rsv_snapshot_hash_table_version_free(draft);
+
+  return 0;
+}
+
+/**
+ * @brief Adds a key-value pair to the draft, replacing the value if the key is
+ * already present. Only visible to readers after the commit.
+ *
+ * @param hash_table Pointer to the snapshot hash table, with a write started.
+ * @param key Pointer to the key.
+ * @param value Pointer to the value.
+ * @return 0 on success, or ENOMEM if out of memory, in which case the draft is
+ * unchanged.
+ */
+static inline int
+rsv_snapshot_hash_table_push(rsv_snapshot_hash_table_t* hash_table,
+                             const void* key, const void* value) {
+  unsigned int hash = hash_table->custom_hash_func(key, hash_table->key_size);
+  unsigned int index = hash & (hash_table->draft->capacity - 1);
+  rsv_snapshot_hash_table_chain_t* chain;
+  char* entry;
+  int found = rsv_snapshot_hash_table_chain_find(
+      hash_table, hash_table->draft->buckets[index], key);
+
+  if (found < 0 && (float)(hash_table->draft->amount + 1) /
+                           hash_table->draft->capacity >
+                       RSV_SNAPSHOT_HASH_TABLE_LOAD_FACTOR) {
+    if (rsv_snapshot_hash_table_resize(hash_table) != 0) {
+      return ENOMEM;
+    }
+
+    index = hash & (hash_table->draft->capacity - 1);
+  }
+
+  chain = rsv_snapshot_hash_table_chain_own(hash_table, index);
+
+  if (chain == NULL) {
+    return ENOMEM;
+  }
+
+  if (found < 0) {
+    entry = (char*)chain->data + chain->amount * hash_table->entry_size;
+    memcpy(entry, key, hash_table->key_size);
+    chain->amount++;
+    hash_table->draft->amount++;
+  } else {
+    entry = (char*)chain->data + (unsigned int)found * hash_table->entry_size;
+  }
+
+  memcpy(entry + hash_table->value_offset, value, hash_table->value_size);
+
+  return 0;
+}
+
+/**
+ * @brief Removes a key-value pair from the draft. Only visible to readers
+ * after the commit.
+ *
+ * @param hash_table Pointer to the snapshot hash table, with a write started.
+ * @param key Pointer to the key of the pair to remove.
+ * @return 0 on success, or ENOMEM if out of memory, in which case the draft is
+ * unchanged.
+ */
+static inline int
+rsv_snapshot_hash_table_pop(rsv_snapshot_hash_table_t* hash_table,
+                            const void* key) {
+  unsigned int index =
+      hash_table->custom_hash_func(key, hash_table->key_size) &
+      (hash_table->draft->capacity - 1);
+  rsv_snapshot_hash_table_chain_t* chain = hash_table->draft->buckets[index];
+  int found = rsv_snapshot_hash_table_chain_find(hash_table, chain, key);
+
+  if (found < 0) {
+    return 0;
+  }
+
+  if (chain->amount == 1) {
+    rsv_snapshot_hash_table_chain_release(chain);
+    hash_table->draft->buckets[index] = NULL;
+    hash_table->draft->amount--;
+    return 0;
+  }
+
+  chain = rsv_snapshot_hash_table_chain_own(hash_table, index);
+
+  if (chain == NULL) {
+    return ENOMEM;
+  }
+
+  /* Move the last entry into the gap */
+  chain->amount--;
+  memmove((char*)chain->data + (unsigned int)found * hash_table->entry_size,
+          (char*)chain->data + chain->amount * hash_table->entry_size,
+          hash_table->entry_size);
+  hash_table->draft->amount--;
+
+  return 0;
+}
+
+/**
+ * @brief Publishes the draft as the current version and ends the write.
+ * Readers which pin afterwards see every change of the write, readers which
+ * pinned before see none of them.
+ *
+ * @param hash_table Pointer to the snapshot hash table, with a write started.
+ * @param participant Pointer to the participant of the calling thread.
+ * @return 0 on success, or ENOMEM if the replaced version could not be
+ * retired, in which case it is leaked rather than freed under a reader.
+ */
+static inline int
+rsv_snapshot_hash_table_commit(rsv_snapshot_hash_table_t* hash_table,
+                               rsv_epoch_participant_t* participant) {
+  rsv_snapshot_hash_table_version_t* version = hash_table->version;
+  int error;
+
+  rsv_atomic_store(&hash_table->version, hash_table->draft,
+                   RSV_MEMORY_ORDER_RELEASE);
+  hash_table->draft = NULL;
+  error = rsv_epoch_retire(participant, version,
+                           rsv_snapshot_hash_table_version_free);
+  rsv_mutex_unlock(&hash_table->writer_mutex);
+
+  return error;
+}
+
+/**
+ * @brief Discards the draft and ends the write.
+ *
+ * @param hash_table Pointer to the snapshot hash table, with a write started.
+ */
+static inline void
+rsv_snapshot_hash_table_abort(rsv_snapshot_hash_table_t* hash_table) {
+  rsv_snapshot_hash_table_version_free(hash_table->draft);
+  hash_table->draft = NULL;
+  rsv_mutex_unlock(&hash_table->writer_mutex);
+}
+
+#endif /* RSV_SNAPSHOT_HASH_TABLE_H */
+
+#endif
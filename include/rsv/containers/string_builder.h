@@ -0,0 +1,296 @@
+/*
+  string_builder.h
+  Implementation of a growable string with small-string optimization
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#ifndef RSV_STRING_BUILDER_H
+#define RSV_STRING_BUILDER_H
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RSV_STRING_INLINE_CAPACITY 23
+#define RSV_STRING_GROWTH_AMOUNT 1.61803398874989484820
+
+#if defined(__GNUC__)
+#define RSV_STRING_PRINTF_FORMAT(format_index, first_index)                    \
+  __attribute__((format(printf, format_index, first_index)))
+#else
+#define RSV_STRING_PRINTF_FORMAT(format_index, first_index)
+#endif
+
+/**
+ * @brief A growable, null terminated string. Strings of up to
+ * RSV_STRING_INLINE_CAPACITY characters are stored inside the struct without
+ * allocating. Use rsv_string_data to access the characters, as they move when
+ * the string outgrows its inline storage.
+ *
+ */
+typedef struct rsv_string_t {
+  /**
+   * @brief The length of the string, without the null terminator.
+   *
+   */
+  size_t length;
+  /**
+   * @brief The amount of characters that can be stored without the null
+   * terminator. RSV_STRING_INLINE_CAPACITY while the string is inline.
+   *
+   */
+  size_t capacity;
+  /**
+   * @brief The characters, inline or on the heap depending on the capacity.
+   *
+   */
+  union {
+    char* heap;
+    char small[RSV_STRING_INLINE_CAPACITY + 1];
+  } storage;
+} rsv_string_t;
+
+/**
+ * @brief Creates an empty string. Does not allocate.
+ *
+ * @return A rsv_string_t struct representing the created string.
+ */
+static inline rsv_string_t rsv_string_create(void) {
+  rsv_string_t string;
+
+  string.length = 0;
+  string.capacity = RSV_STRING_INLINE_CAPACITY;
+  string.storage.small[0] = '\0';
+
+  return string;
+}
+
+/**
+ * @brief Destroys a string, freeing all associated memory. The string is left
+ * empty and can be reused.
+ *
+ * @param string Pointer to the string to destroy.
+ */
+static inline void rsv_string_destroy(rsv_string_t* string) {
+  if (string->capacity > RSV_STRING_INLINE_CAPACITY) {
+    free(string->storage.heap);
+  }
+
+  *string = rsv_string_create();
+}
+
+/**
+ * @brief Gets the characters of a string. Valid until the string is changed.
+ *
+ * @param string Pointer to the string.
+ * @return Pointer to the null terminated characters.
+ */
+static inline char* rsv_string_data(rsv_string_t* string) {
+  if (string->capacity > RSV_STRING_INLINE_CAPACITY) {
+    return string->storage.heap;
+  }
+
+  return string->storage.small;
+}
+
+/**
+ * @brief Makes sure a string can hold at least the given amount of characters
+ * without reallocating.
+ *
+ * @param string Pointer to the string.
+ * @param capacity Amount of characters, without the null terminator.
+ * @return 0 on success, or ENOMEM if out of memory, in which case the string
+ * is unchanged.
+ */
+static inline int rsv_string_reserve(rsv_string_t* string, size_t capacity) {
+  char* data;
+
+  if (capacity <= string->capacity) {
+    return 0;
+  }
+
+  if (string->capacity > RSV_STRING_INLINE_CAPACITY) {
+    data = (char*)realloc(string->storage.heap, capacity + 1);
+
+    if (data == NULL) {
+      return ENOMEM;
+    }
+  } else {
+    data = (char*)malloc(capacity + 1);
+
+    if (data == NULL) {
+      return ENOMEM;
+    }
+
+    memcpy(data, string->storage.small, string->length + 1);
+  }
+
+  string->storage.heap = data;
+  string->capacity = capacity;
+
+  return 0;
+}
+
+/**
+ * @brief Grows a string geometrically so that it can hold at least the given
+ * amount of characters.
+ *
+ * @param string Pointer to the string.
+ * @param required Amount of characters, without the null terminator.
+ * @return 0 on success, or ENOMEM if out of memory.
+ */
+static inline int rsv_string_grow(rsv_string_t* string, size_t required) {
+  size_t capacity;
+
+  if (required <= string->capacity) {
+    return 0;
+  }
+
+  capacity = (size_t)(string->capacity * RSV_STRING_GROWTH_AMOUNT + 1);
+
+  return rsv_string_reserve(string, capacity > required ? capacity : required);
+}
+
+/**
+ * @brief Empties a string, keeping its capacity for reuse.
+ *
+ * @param string Pointer to the string.
+ */
+static inline void rsv_string_clear(rsv_string_t* string) {
+  string->length = 0;
+  rsv_string_data(string)[0] = '\0';
+}
+
+/**
+ * @brief Appends characters to a string.
+ *
+ * @param string Pointer to the string.
+ * @param characters Pointer to the characters, which may contain null bytes
+ * and may be part of the string itself.
+ * @param amount Amount of characters to append.
+ * @return 0 on success, or ENOMEM if out of memory.
+ */
+static inline int rsv_string_append_n(rsv_string_t* string,
+                                      const char* characters, size_t amount) {
+  char* data = rsv_string_data(string);
+  int aliased = characters >= data && characters <= data + string->length;
+  size_t offset = aliased ? (size_t)(characters - data) : 0;
+
+  if (rsv_string_grow(string, string->length + amount) != 0) {
+    return ENOMEM;
+  }
+
+  /* Appending a part of the string itself, which may just have moved */
+  data = rsv_string_data(string);
+
+  if (aliased) {
+    characters = data + offset;
+  }
+
+  memmove(data + string->length, characters, amount);
+  string->length += amount;
+  data[string->length] = '\0';
+
+  return 0;
+}
+
+/**
+ * @brief Appends a null terminated string to a string.
+ *
+ * @param string Pointer to the string.
+ * @param source Pointer to the null terminated string to append.
+ * @return 0 on success, ENOMEM if out of memory or EINVAL if the source is
+ * NULL.
+ */
+static inline int rsv_string_append(rsv_string_t* string, const char* source) {
+  if (source == NULL) {
+    return EINVAL;
+  }
+
+  return rsv_string_append_n(string, source, strlen(source));
+}
+
+/**
+ * @brief Appends a single character to a string.
+ *
+ * @param string Pointer to the string.
+ * @param character The character to append.
+ * @return 0 on success, or ENOMEM if out of memory.
+ */
+static inline int rsv_string_push(rsv_string_t* string, char character) {
+  return rsv_string_append_n(string, &character, 1);
+}
+
+/**
+ * @brief Appends formatted text to a string, like vsnprintf.
+ *
+ * Formats into a buffer on the stack, or on the heap if the text is longer,
+ * before appending. The arguments may therefore point into the string itself.
+ *
+ * @param string Pointer to the string.
+ * @param format The printf-style format.
+ * @param arguments The arguments of the format.
+ * @return 0 on success, ENOMEM if out of memory or EINVAL if the format could
+ * not be applied. The string is unchanged on failure.
+ */
+static inline int rsv_string_appendfv(rsv_string_t* string, const char* format,
+                                      va_list arguments) {
+  char buffer[256];
+  char* text = buffer;
+  va_list copy;
+  int written;
+  int result;
+
+  va_copy(copy, arguments);
+  written = vsnprintf(buffer, sizeof(buffer), format, copy);
+  va_end(copy);
+
+  if (written < 0) {
+    return EINVAL;
+  }
+
+  if ((size_t)written >= sizeof(buffer)) {
+    text = (char*)malloc((size_t)written + 1);
+
+    if (text == NULL) {
+      return ENOMEM;
+    }
+
+    vsnprintf(text, (size_t)written + 1, format, arguments);
+  }
+
+  result = rsv_string_append_n(string, text, (size_t)written);
+
+  if (text != buffer) {
+    free(text);
+  }
+
+  return result;
+}
+
+/**
+ * @brief Appends formatted text to a string, like snprintf.
+ *
+ * @param string Pointer to the string.
+ * @param format The printf-style format.
+ * @return 0 on success, ENOMEM if out of memory or EINVAL if the format could
+ * not be applied. The string is unchanged on failure.
+ */
+RSV_STRING_PRINTF_FORMAT(2, 3)
+static inline int rsv_string_appendf(rsv_string_t* string, const char* format,
+                                     ...) {
+  va_list arguments;
+  int result;
+
+  va_start(arguments, format);
+  result = rsv_string_appendfv(string, format, arguments);
+  va_end(arguments);
+
+  return result;
+}
+
+#endif /* RSV_STRING_BUILDER_H */
@@ -0,0 +1,568 @@
+/*
+  file.h
+  Implementation of memory-mapped loading, buffered writing and record reading
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#if defined(__unix__)
+
+#ifndef RSV_FILE_H
+#define RSV_FILE_H
+
+#include "string_view.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RSV_FILE_BUFFER_SIZE 65536
+
+/**
+ * @brief Access hints for rsv_file_map. Hints the system does not support are
+ * ignored.
+ *
+ */
+#define RSV_FILE_SEQUENTIAL 0x01
+#define RSV_FILE_RANDOM 0x02
+#define RSV_FILE_WILL_NEED 0x04
+#define RSV_FILE_HUGE_PAGES 0x08
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ *
+ */
+typedef struct rsv_file_map_t {
+  /**
+   * @brief The contents of the file, NULL if it is empty.
+   *
+   */
+  const char* data;
+  /**
+   * @brief The size of the file in bytes.
+   *
+   */
+  size_t size;
+} rsv_file_map_t;
+
+/**
+ * @brief Writes to a file through a large buffer, so that small writes are
+ * coalesced into few system calls.
+ *
+ */
+typedef struct rsv_file_writer_t {
+  /**
+   * @brief The file descriptor.
+   *
+   */
+  int descriptor;
+  /**
+   * @brief The first error which occurred, or 0. Once set, every further
+   * write fails with it.
+   *
+   */
+  int error;
+  /**
+   * @brief The amount of buffered bytes.
+   *
+   */
+  size_t used;
+  /**
+   * @brief The size of the buffer.
+   *
+   */
+  size_t capacity;
+  /**
+   * @brief The buffer.
+   *
+   */
+  char* buffer;
+} rsv_file_writer_t;
+
+/**
+ * @brief Reads records separated by a delimiter, such as lines, handing out
+ * views into the mapped or buffered data instead of copying them.
+ *
+ */
+typedef struct rsv_file_reader_t {
+  /**
+   * @brief The data records are read from, the buffer or a view.
+   *
+   */
+  const char* data;
+  /**
+   * @brief The owned buffer, NULL when reading from a view.
+   *
+   */
+  char* buffer;
+  /**
+   * @brief The size of the buffer.
+   *
+   */
+  size_t capacity;
+  /**
+   * @brief Index of the first byte of the next record.
+   *
+   */
+  size_t start;
+  /**
+   * @brief Index one past the last byte of data.
+   *
+   */
+  size_t end;
+  /**
+   * @brief Index up to which the next record is known to have no delimiter.
+   *
+   */
+  size_t scanned;
+  /**
+   * @brief The file descriptor, or -1 when reading from a view.
+   *
+   */
+  int descriptor;
+  /**
+   * @brief 1 once there is no more data to read.
+   *
+   */
+  int eof;
+  /**
+   * @brief The error which stopped reading, or 0.
+   *
+   */
+  int error;
+} rsv_file_reader_t;
+
+/**
+ * @brief Maps a whole file into memory for reading.
+ *
+ * @param map Pointer to the map to create.
+ * @param path Path of the file.
+ * @param hints RSV_FILE_* access hints, or 0.
+ * @return 0 on success, or the error code of the failed system call. An empty
+ * file gives an empty map.
+ */
+static inline int rsv_file_map(rsv_file_map_t* map, const char* path,
+                               int hints) {
+  struct stat status;
+  void* data;
+  int descriptor = open(path, O_RDONLY | O_CLOEXEC);
+  int result;
+
+  map->data = NULL;
+  map->size = 0;
+
+  if (descriptor < 0) {
+    return errno;
+  }
+
+  if (fstat(descriptor, &status) != 0) {
+    result = errno;
+    close(descriptor);
+    return result;
+  }
+
+  if (status.st_size == 0) {
+    close(descriptor);
+    return 0;
+  }
+
+  data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor,
+              0);
+  result = data == MAP_FAILED ? errno : 0;
+  close(descriptor);
+
+  if (result != 0) {
+    return result;
+  }
+
+  /* Hints are advisory, failing to apply one is not an error */
+  if (hints & RSV_FILE_SEQUENTIAL) {
+    madvise(data, (size_t)status.st_size, MADV_SEQUENTIAL);
+  }
+
+  if (hints & RSV_FILE_RANDOM) {
+    madvise(data, (size_t)status.st_size, MADV_RANDOM);
+  }
+
+  if (hints & RSV_FILE_WILL_NEED) {
+    madvise(data, (size_t)status.st_size, MADV_WILLNEED);
+  }
+
+#if defined(MADV_HUGEPAGE)
+  if (hints & RSV_FILE_HUGE_PAGES) {
+    madvise(data, (size_t)status.st_size, MADV_HUGEPAGE);
+  }
+#endif
+
+  map->data = (const char*)data;
+  map->size = (size_t)status.st_size;
+
+  return 0;
+}
+
+/**
+ * @brief Unmaps a file. The map is left empty.
+ *
+ * @param map Pointer to the map.
+ */
+static inline void rsv_file_unmap(rsv_file_map_t* map) {
+  if (map->data != NULL) {
+    munmap((void*)map->data, map->size);
+  }
+
+  map->data = NULL;
+  map->size = 0;
+}
+
+/**
+ * @brief Gets a view of the contents of a mapped file.
+ *
+ * @param map Pointer to the map.
+ * @return The view, valid until the file is unmapped.
+ */
+static inline rsv_string_view_t rsv_file_map_view(const rsv_file_map_t* map) {
+  return rsv_string_view_create(map->data, map->size);
+}
+
+/**
+ * @brief Writes all of a buffer to a file descriptor, continuing after partial
+ * writes and interruptions.
+ *
+ * @param descriptor The file descriptor.
+ * @param data Pointer to the data.
+ * @param size The amount of bytes.
+ * @return 0 on success, or the error code of the failed write.
+ */
+static inline int rsv_file_write_all(int descriptor, const char* data,
+                                     size_t size) {
+  while (size > 0) {
+    ssize_t written = write(descriptor, data, size);
+
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return errno;
+    }
+
+    data += written;
+    size -= (size_t)written;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Opens a file for buffered writing, creating it if needed.
+ *
+ * @param writer Pointer to the writer to open.
+ * @param path Path of the file.
+ * @param append 1 to append to the file, 0 to truncate it.
+ * @param buffer_size The size of the buffer, or 0 for RSV_FILE_BUFFER_SIZE.
+ * @return 0 on success, ENOMEM if out of memory, or the error code of the
+ * failed system call.
+ */
+static inline int rsv_file_writer_open(rsv_file_writer_t* writer,
+                                       const char* path, int append,
+                                       size_t buffer_size) {
+  writer->used = 0;
+  writer->error = 0;
+  writer->descriptor = -1;
+  writer->capacity = buffer_size ? buffer_size : RSV_FILE_BUFFER_SIZE;
+  writer->buffer = (char*)malloc(writer->capacity);
+
+  if (writer->buffer == NULL) {
+    return ENOMEM;
+  }
+
+  writer->descriptor =
+      open(path, O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC),
+           0644);
+
+  if (writer->descriptor < 0) {
+    writer->error = errno;
+    writer->descriptor = -1;
+    free(writer->buffer);
+    writer->buffer = NULL;
+    return writer->error;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Writes the buffered bytes to the file.
+ *
+ * @param writer Pointer to the writer.
+ * @return 0 on success, or the first error of the writer.
+ */
+static inline int rsv_file_writer_flush(rsv_file_writer_t* writer) {
+  if (writer->error == 0 && writer->used > 0) {
+    writer->error =
+        rsv_file_write_all(writer->descriptor, writer->buffer, writer->used);
+    writer->used = 0;
+  }
+
+  return writer->error;
+}
+
+/**
+ * @brief Writes bytes to a file. Small writes are copied into the buffer,
+ * writes which do not fit in an empty buffer go straight to the file.
+ *
+ * @param writer Pointer to the writer.
+ * @param data Pointer to the data.
+ * @param size The amount of bytes.
+ * @return 0 on success, or the first error of the writer.
+ */
+static inline int rsv_file_writer_write(rsv_file_writer_t* writer,
+                                        const char* data, size_t size) {
+  if (writer->error != 0) {
+    return writer->error;
+  }
+
+  if (size > writer->capacity - writer->used &&
+      rsv_file_writer_flush(writer) != 0) {
+    return writer->error;
+  }
+
+  if (size >= writer->capacity) {
+    writer->error = rsv_file_write_all(writer->descriptor, data, size);
+    return writer->error;
+  }
+
+  if (size > 0) {
+    memcpy(writer->buffer + writer->used, data, size);
+    writer->used += size;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Writes a view to a file.
+ *
+ * @param writer Pointer to the writer.
+ * @param view The view to write.
+ * @return 0 on success, or the first error of the writer.
+ */
+static inline int rsv_file_writer_write_view(rsv_file_writer_t* writer,
+                                             rsv_string_view_t view) {
+  return rsv_file_writer_write(writer, view.data, view.length);
+}
+
+/**
+ * @brief Flushes and closes a file, freeing all associated memory.
+ *
+ * @param writer Pointer to the writer.
+ * @return 0 on success, or the first error of the writer, including a failed
+ * close.
+ */
+static inline int rsv_file_writer_close(rsv_file_writer_t* writer) {
+  int result = rsv_file_writer_flush(writer);
+
+  if (writer->descriptor >= 0 && close(writer->descriptor) != 0 &&
+      result == 0) {
+    result = errno;
+  }
+
+  free(writer->buffer);
+  writer->buffer = NULL;
+  writer->descriptor = -1;
+  writer->error = result;
+
+  return result;
+}
+
+/**
+ * @brief Opens a file for reading records through a buffer, which grows if a
+ * record does not fit.
+ *
+ * @param reader Pointer to the reader to open.
+ * @param path Path of the file.
+ * @param buffer_size The initial size of the buffer, or 0 for
+ * RSV_FILE_BUFFER_SIZE.
+ * @return 0 on success, ENOMEM if out of memory, or the error code of the
+ * failed system call.
+ */
+static inline int rsv_file_reader_open(rsv_file_reader_t* reader,
+                                       const char* path, size_t buffer_size) {
+  reader->start = 0;
+  reader->end = 0;
+  reader->scanned = 0;
+  reader->eof = 0;
+  reader->error = 0;
+  reader->descriptor = -1;
+  reader->capacity = buffer_size ? buffer_size : RSV_FILE_BUFFER_SIZE;
+  reader->buffer = (char*)malloc(reader->capacity);
+  reader->data = reader->buffer;
+
+  if (reader->buffer == NULL) {
+    return ENOMEM;
+  }
+
+  reader->descriptor = open(path, O_RDONLY | O_CLOEXEC);
+
+  if (reader->descriptor < 0) {
+    reader->error = errno;
+    reader->descriptor = -1;
+    free(reader->buffer);
+    reader->buffer = NULL;
+    return reader->error;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Creates a reader over data already in memory, such as a mapped file.
+ * Does not allocate.
+ *
+ * @param view The data to read records from.
+ * @return A rsv_file_reader_t struct representing the reader.
+ */
+static inline rsv_file_reader_t rsv_file_reader_create(rsv_string_view_t view) {
+  rsv_file_reader_t reader;
+
+  reader.data = view.data;
+  reader.buffer = NULL;
+  reader.capacity = view.length;
+  reader.start = 0;
+  reader.end = view.length;
+  reader.scanned = 0;
+  reader.descriptor = -1;
+  reader.eof = 1;
+  reader.error = 0;
+
+  return reader;
+}
+
+/**
+ * @brief Closes a reader, freeing all associated memory.
+ *
+ * @param reader Pointer to the reader.
+ */
+static inline void rsv_file_reader_close(rsv_file_reader_t* reader) {
+  if (reader->descriptor >= 0) {
+    close(reader->descriptor);
+  }
+
+  free(reader->buffer);
+  reader->buffer = NULL;
+  reader->data = NULL;
+  reader->descriptor = -1;
+}
+
+/**
+ * @brief Reads more data into the buffer of a reader, first moving the
+ * unread bytes to its start or growing it if it is full.
+ *
+ * @param reader Pointer to the reader.
+ * @return 0 on success, or the error which stopped reading.
+ */
+static inline int rsv_file_reader_fill(rsv_file_reader_t* reader) {
+  ssize_t amount;
+
+  if (reader->start > 0) {
+    memmove(reader->buffer, reader->buffer + reader->start,
+            reader->end - reader->start);
+    reader->end -= reader->start;
+    reader->scanned -= reader->start;
+    reader->start = 0;
+  } else if (reader->end == reader->capacity) {
+    char* buffer = (char*)realloc(reader->buffer, reader->capacity * 2);
+
+    if (buffer == NULL) {
+      return ENOMEM;
+    }
+
+    reader->buffer = buffer;
+    reader->data = buffer;
+    reader->capacity *= 2;
+  }
+
+  do {
+    amount = read(reader->descriptor, reader->buffer + reader->end,
+                  reader->capacity - reader->end);
+  } while (amount < 0 && errno == EINTR);
+
+  if (amount < 0) {
+    return errno;
+  }
+
+  if (amount == 0) {
+    reader->eof = 1;
+  }
+
+  reader->end += (size_t)amount;
+
+  return 0;
+}
+
+/**
+ * @brief Reads the next record. The delimiter is not part of the record, and
+ * the last record does not need one.
+ *
+ * @param reader Pointer to the reader.
+ * @param delimiter The character ending each record, such as '\n'.
+ * @param record Pointer to where the view of the record is stored. It stays
+ * valid until the next call, or as long as the data for readers created from
+ * a view.
+ * @return 1 if a record was read, 0 at the end of the data or on error, see
+ * rsv_file_reader_error.
+ */
+static inline int rsv_file_reader_next(rsv_file_reader_t* reader,
+                                       char delimiter,
+                                       rsv_string_view_t* record) {
+  while (reader->error == 0) {
+    size_t index = rsv_string_view_find_char(
+        rsv_string_view_create(reader->data + reader->scanned,
+                               reader->end - reader->scanned),
+        delimiter);
+
+    if (index != RSV_STRING_VIEW_NPOS) {
+      index += reader->scanned;
+      *record = rsv_string_view_create(reader->data + reader->start,
+                                       index - reader->start);
+      reader->start = index + 1;
+      reader->scanned = reader->start;
+      return 1;
+    }
+
+    reader->scanned = reader->end;
+
+    if (reader->eof) {
+      if (reader->start == reader->end) {
+        return 0;
+      }
+
+      *record = rsv_string_view_create(reader->data + reader->start,
+                                       reader->end - reader->start);
+      reader->start = reader->end;
+      return 1;
+    }
+
+    reader->error = rsv_file_reader_fill(reader);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Gets the error which stopped a reader.
+ *
+ * @param reader Pointer to the reader.
+ * @return 0 if the reader reached the end of the data, or an error code.
+ */
+static inline int rsv_file_reader_error(const rsv_file_reader_t* reader) {
+  return reader->error;
+}
+
+#endif /* RSV_FILE_H */
+
+#endif
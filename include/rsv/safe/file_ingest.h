@@ -0,0 +1,585 @@
+/*
+  file_ingest.h
+  Parallel, record-aligned file ingestion on top of the thread pool
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#if defined(__unix__)
+
+#ifndef RSV_FILE_INGEST_H
+#define RSV_FILE_INGEST_H
+
+#include "../containers/dynamic_array.h"
+#include "../containers/hash_table.h"
+#include "../threads/thread_pool.h"
+#include "file.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RSV_FILE_INGEST_CHUNK_SIZE (4 * 1024 * 1024)
+#define RSV_FILE_INGEST_CHUNKS_PER_WORKER 2
+
+/**
+ * @brief Describes how a file is ingested. Create it with
+ * rsv_file_ingest_create, then adjust the fields as needed.
+ *
+ */
+typedef struct rsv_file_ingest_t {
+  /**
+   * @brief Parses a chunk of whole records on a worker thread. The records
+   * keep their delimiters, iterate them with rsv_file_reader_create. Returns
+   * the partial result of the chunk, which may be NULL.
+   *
+   */
+  void* (*parse)(void* context, rsv_string_view_t records);
+  /**
+   * @brief Merges the partial result of a chunk on the calling thread, in
+   * file order, taking ownership of it. Returns 0, or an error code to stop
+   * ingesting.
+   *
+   */
+  int (*merge)(void* context, void* partial);
+  /**
+   * @brief Frees the partial result of a chunk which was parsed but not
+   * merged because ingesting stopped, or NULL.
+   *
+   */
+  void (*discard)(void* context, void* partial);
+  /**
+   * @brief Pointer passed to every callback.
+   *
+   */
+  void* context;
+  /**
+   * @brief The amount of bytes records are read in per chunk. A chunk also
+   * reads past its end up to the end of its last record.
+   *
+   */
+  size_t chunk_size;
+  /**
+   * @brief The most chunks read, parsed or waiting to be merged at once, which
+   * bounds the memory used. 0 picks one from the worker amount.
+   *
+   */
+  unsigned int window;
+  /**
+   * @brief The character ending each record.
+   *
+   */
+  char delimiter;
+} rsv_file_ingest_t;
+
+/**
+ * @brief A chunk being ingested. Should not be directly used unless
+ * necessary.
+ *
+ */
+typedef struct rsv_file_ingest_slot_t {
+  const rsv_file_ingest_t* ingest;
+  rsv_thread_pool_wait_t wait;
+  char* buffer;
+  size_t capacity;
+  off_t begin;
+  off_t end;
+  off_t file_size;
+  void* partial;
+  int descriptor;
+  int error;
+} rsv_file_ingest_slot_t;
+
+/**
+ * @brief Creates an ingestion description with the default chunk size,
+ * window and '\n' as delimiter.
+ *
+ * @param parse Parses a chunk of whole records into a partial result.
+ * @param merge Merges a partial result, in file order.
+ * @param context Pointer passed to every callback.
+ * @return A rsv_file_ingest_t struct representing the description.
+ */
+static inline rsv_file_ingest_t
+rsv_file_ingest_create(void* (*parse)(void*, rsv_string_view_t),
+                       int (*merge)(void*, void*), void* context) {
+  rsv_file_ingest_t ingest;
+
+  ingest.parse = parse;
+  ingest.merge = merge;
+  ingest.discard = NULL;
+  ingest.context = context;
+  ingest.chunk_size = RSV_FILE_INGEST_CHUNK_SIZE;
+  ingest.window = 0;
+  ingest.delimiter = '\n';
+
+  return ingest;
+}
+
+/**
+ * @brief Reads bytes at an offset of the file of a slot into its buffer,
+ * growing it if needed.
+ *
+ * @param slot Pointer to the slot.
+ * @param used The amount of bytes already in the buffer.
+ * @param offset The offset in the file to read from.
+ * @param size The amount of bytes to read.
+ * @param read Pointer to where the amount of bytes read is stored, less than
+ * size only at the end of the file.
+ * @return 0 on success, ENOMEM if out of memory, or the error code of pread.
+ */
+static inline int rsv_file_ingest_read(rsv_file_ingest_slot_t* slot,
+                                       size_t used, off_t offset, size_t size,
+                                       size_t* read) {
+  *read = 0;
+
+  if (used + size > slot->capacity) {
+    size_t capacity = slot->capacity * 2 > used + size ? slot->capacity * 2
+                                                       : used + size;
+    char* buffer = (char*)realloc(slot->buffer, capacity);
+
+    if (buffer == NULL) {
+      return ENOMEM;
+    }
+
+    slot->buffer = buffer;
+    slot->capacity = capacity;
+  }
+
+  while (*read < size) {
+    ssize_t amount = pread(slot->descriptor, slot->buffer + used + *read,
+                           size - *read, offset + (off_t)*read);
+
+    if (amount < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return errno;
+    }
+
+    if (amount == 0) {
+      break;
+    }
+
+    *read += (size_t)amount;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Reads the records of a chunk, which are those starting within
+ * [begin, end). The byte before the chunk tells whether a record starts at
+ * its first byte, and the last record is read to its end past the chunk.
+ *
+ * @param slot Pointer to the slot of the chunk.
+ * @param records Pointer to where the view of the records is stored.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_file_ingest_read_chunk(rsv_file_ingest_slot_t* slot,
+                                             rsv_string_view_t* records) {
+  char delimiter = slot->ingest->delimiter;
+  off_t offset = slot->begin > 0 ? slot->begin - 1 : 0;
+  size_t length;
+  size_t first = 0;
+  size_t scanned;
+  int result =
+      rsv_file_ingest_read(slot, 0, offset, (size_t)(slot->end - offset),
+                           &length);
+
+  *records = rsv_string_view_create(slot->buffer, 0);
+
+  if (result != 0 || length == 0) {
+    return result;
+  }
+
+  if (slot->begin > 0) {
+    /* A record starts after every delimiter at [begin - 1, end - 1) */
+    first = rsv_string_view_find_char(
+        rsv_string_view_create(slot->buffer, length - 1), delimiter);
+
+    if (first == RSV_STRING_VIEW_NPOS) {
+      return 0;
+    }
+
+    first++;
+  }
+
+  /* The last record ends at the first delimiter from end - 1 onwards */
+  scanned = length - 1;
+
+  while (1) {
+    size_t index = rsv_string_view_find_char(
+        rsv_string_view_create(slot->buffer + scanned, length - scanned),
+        delimiter);
+    size_t amount;
+
+    if (index != RSV_STRING_VIEW_NPOS) {
+      length = scanned + index + 1;
+      break;
+    }
+
+    if (offset + (off_t)length >= slot->file_size) {
+      break;
+    }
+
+    scanned = length;
+    result = rsv_file_ingest_read(slot, length, offset + (off_t)length,
+                                  slot->ingest->chunk_size, &amount);
+
+    if (result != 0) {
+      return result;
+    }
+
+    if (amount == 0) {
+      break;
+    }
+
+    length += amount;
+  }
+
+  *records = rsv_string_view_create(slot->buffer + first, length - first);
+
+  return 0;
+}
+
+/**
+ * @brief Reads and parses a single chunk on a worker.
+ *
+ * @param arg Pointer to the slot of the chunk.
+ */
+static inline void rsv_file_ingest_chunk_run(void* arg) {
+  rsv_file_ingest_slot_t* slot = (rsv_file_ingest_slot_t*)arg;
+  rsv_string_view_t records;
+
+  slot->partial = NULL;
+  slot->error = rsv_file_ingest_read_chunk(slot, &records);
+
+  if (slot->error == 0) {
+    slot->partial = slot->ingest->parse(slot->ingest->context, records);
+  }
+}
+
+/**
+ * @brief Ingests a file in parallel.
+ *
+ * The file is split into chunks of chunk_size bytes, each owning the records
+ * which start inside it. Workers read chunks with pread and parse them while
+ * the calling thread merges the finished ones in file order, so reading,
+ * parsing and merging overlap. No more than window chunks are in flight, and
+ * their buffers are reused.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param ingest Pointer to the ingestion description.
+ * @param path Path of the file.
+ * @return 0 on success, ENOMEM if out of memory, the error code of a failed
+ * system call, or the error returned by merge.
+ */
+static inline int rsv_file_ingest(rsv_thread_pool_t* pool,
+                                  const rsv_file_ingest_t* ingest,
+                                  const char* path) {
+  rsv_file_ingest_slot_t* slots;
+  struct stat status;
+  unsigned long chunk_amount;
+  unsigned long submitted = 0;
+  unsigned long merged = 0;
+  unsigned int window = ingest->window;
+  unsigned int i;
+  int descriptor;
+  int result = 0;
+
+  if (window == 0) {
+    window = pool->worker_amount * RSV_FILE_INGEST_CHUNKS_PER_WORKER;
+  }
+
+  if (ingest->chunk_size == 0) {
+    return EINVAL;
+  }
+
+  descriptor = open(path, O_RDONLY | O_CLOEXEC);
+
+  if (descriptor < 0) {
+    return errno;
+  }
+
+  if (fstat(descriptor, &status) != 0) {
+    result = errno;
+    close(descriptor);
+    return result;
+  }
+
+  chunk_amount = (unsigned long)((status.st_size + (off_t)ingest->chunk_size -
+                                  1) /
+                                 (off_t)ingest->chunk_size);
+  slots = (rsv_file_ingest_slot_t*)calloc(window,
+                                          sizeof(rsv_file_ingest_slot_t));
+
+  if (slots == NULL) {
+    close(descriptor);
+    return ENOMEM;
+  }
+
+  for (i = 0; i < window; ++i) {
+    slots[i].ingest = ingest;
+    slots[i].descriptor = descriptor;
+    slots[i].file_size = status.st_size;
+
+    result = rsv_thread_pool_wait_create(&slots[i].wait);
+
+    if (result != 0) {
+      window = i;
+      break;
+    }
+  }
+
+  while (merged < chunk_amount) {
+    rsv_file_ingest_slot_t* slot;
+
+    while (result == 0 && submitted < chunk_amount &&
+           submitted - merged < window) {
+      slot = &slots[submitted % window];
+      slot->begin = (off_t)submitted * (off_t)ingest->chunk_size;
+      slot->end = slot->begin + (off_t)ingest->chunk_size;
+      slot->end = slot->end < status.st_size ? slot->end : status.st_size;
+
+      if (rsv_thread_pool_submit(pool, &slot->wait, rsv_file_ingest_chunk_run,
+                                 slot) != 0) {
+        /* Out of memory, read the chunk on the calling thread */
+        rsv_file_ingest_chunk_run(slot);
+      }
+
+      submitted++;
+    }
+
+    if (merged == submitted) {
+      break;
+    }
+
+    slot = &slots[merged % window];
+    rsv_thread_pool_wait(pool, &slot->wait);
+    merged++;
+
+    if (result == 0) {
+      result = slot->error;
+    }
+
+    if (result == 0) {
+      result = ingest->merge(ingest->context, slot->partial);
+    } else if (slot->partial != NULL && ingest->discard != NULL) {
+      ingest->discard(ingest->context, slot->partial);
+    }
+  }
+
+  for (i = 0; i < window; ++i) {
+    rsv_thread_pool_wait_destroy(&slots[i].wait);
+    free(slots[i].buffer);
+  }
+
+  free(slots);
+  close(descriptor);
+
+  return result;
+}
+
+/**
+ * @brief Context of the container ingestion helpers. Should not be directly
+ * used unless necessary.
+ *
+ */
+typedef struct rsv_file_ingest_container_t {
+  int (*parse_record)(void*, rsv_string_view_t, void*, void*);
+  void* context;
+  void* container;
+  unsigned int element_size;
+  unsigned int key_size;
+  unsigned int value_size;
+  char delimiter;
+} rsv_file_ingest_container_t;
+
+/**
+ * @brief Parses the records of a chunk into a dynamic array of elements, or
+ * of keys each followed by its value.
+ *
+ * @param context Pointer to the container context.
+ * @param records The records of the chunk.
+ * @return The dynamic array, or NULL if out of memory.
+ */
+static inline void* rsv_file_ingest_container_parse(void* context,
+                                                    rsv_string_view_t records) {
+  rsv_file_ingest_container_t* container =
+      (rsv_file_ingest_container_t*)context;
+  rsv_file_reader_t reader = rsv_file_reader_create(records);
+  rsv_dynamic_array_t* partial =
+      (rsv_dynamic_array_t*)malloc(sizeof(rsv_dynamic_array_t));
+  unsigned char* element = (unsigned char*)malloc(container->element_size);
+  rsv_string_view_t record;
+
+  if (partial == NULL || element == NULL) {
+    free(partial);
+    free(element);
+    return NULL;
+  }
+
+  *partial = rsv_dynamic_array_create(64, container->element_size);
+
+  while (rsv_file_reader_next(&reader, container->delimiter, &record)) {
+    if (container->parse_record(container->context, record, element,
+                                element + container->key_size)) {
+      rsv_dynamic_array_push(partial, element);
+    }
+  }
+
+  free(element);
+
+  return partial;
+}
+
+/**
+ * @brief Frees the dynamic array of a chunk.
+ *
+ * @param context Pointer to the container context.
+ * @param partial Pointer to the dynamic array.
+ */
+static inline void rsv_file_ingest_container_discard(void* context,
+                                                     void* partial) {
+  (void)context;
+  rsv_dynamic_array_destroy((rsv_dynamic_array_t*)partial);
+  free(partial);
+}
+
+/**
+ * @brief Appends the elements of a chunk to the destination dynamic array.
+ *
+ * @param context Pointer to the container context.
+ * @param partial Pointer to the dynamic array of the chunk.
+ * @return 0 on success, or ENOMEM if the chunk ran out of memory.
+ */
+static inline int rsv_file_ingest_dynamic_array_merge(void* context,
+                                                      void* partial) {
+  rsv_file_ingest_container_t* container =
+      (rsv_file_ingest_container_t*)context;
+  rsv_dynamic_array_t* elements = (rsv_dynamic_array_t*)partial;
+  unsigned int i;
+
+  if (elements == NULL) {
+    return ENOMEM;
+  }
+
+  for (i = 0; i < elements->amount; ++i) {
+    rsv_dynamic_array_push((rsv_dynamic_array_t*)container->container,
+                           rsv_dynamic_array_get(elements, i));
+  }
+
+  rsv_file_ingest_container_discard(context, partial);
+
+  return 0;
+}
+
+/**
+ * @brief Pushes the keys and values of a chunk into the destination hash
+ * table.
+ *
+ * @param context Pointer to the container context.
+ * @param partial Pointer to the dynamic array of the chunk.
+ * @return 0 on success, or ENOMEM if the chunk ran out of memory.
+ */
+static inline int rsv_file_ingest_hash_table_merge(void* context,
+                                                   void* partial) {
+  rsv_file_ingest_container_t* container =
+      (rsv_file_ingest_container_t*)context;
+  rsv_dynamic_array_t* entries = (rsv_dynamic_array_t*)partial;
+  unsigned int i;
+
+  if (entries == NULL) {
+    return ENOMEM;
+  }
+
+  for (i = 0; i < entries->amount; ++i) {
+    unsigned char* entry = (unsigned char*)rsv_dynamic_array_get(entries, i);
+
+    rsv_hash_table_push((rsv_hash_table_t*)container->container, entry,
+                        entry + container->key_size);
+  }
+
+  rsv_file_ingest_container_discard(context, partial);
+
+  return 0;
+}
+
+/**
+ * @brief Ingests a file of records into a dynamic array, in file order.
+ * Records are parsed in parallel, and appended on the calling thread.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param path Path of the file.
+ * @param delimiter The character ending each record.
+ * @param array Pointer to the dynamic array to append to.
+ * @param parse_record Parses a record into the element pointed to by its
+ * third argument, the fourth is unused. Returns 1 to append the element, or 0
+ * to skip the record.
+ * @param context Pointer passed to every call of parse_record.
+ * @return 0 on success, or an error code as for rsv_file_ingest.
+ */
+static inline int rsv_file_ingest_dynamic_array(
+    rsv_thread_pool_t* pool, const char* path, char delimiter,
+    rsv_dynamic_array_t* array,
+    int (*parse_record)(void*, rsv_string_view_t, void*, void*),
+    void* context) {
+  rsv_file_ingest_container_t container;
+  rsv_file_ingest_t ingest = rsv_file_ingest_create(
+      rsv_file_ingest_container_parse, rsv_file_ingest_dynamic_array_merge,
+      &container);
+
+  container.parse_record = parse_record;
+  container.context = context;
+  container.container = array;
+  container.element_size = array->element_size;
+  container.key_size = array->element_size;
+  container.value_size = 0;
+  container.delimiter = delimiter;
+  ingest.discard = rsv_file_ingest_container_discard;
+  ingest.delimiter = delimiter;
+
+  return rsv_file_ingest(pool, &ingest, path);
+}
+
+/**
+ * @brief Ingests a file of records into a hash table. Records are parsed in
+ * parallel, and pushed on the calling thread in file order, so later records
+ * replace earlier ones with the same key.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param path Path of the file.
+ * @param delimiter The character ending each record.
+ * @param hash_table Pointer to the hash table to push into.
+ * @param parse_record Parses a record into the key and value pointed to by its
+ * third and fourth arguments. Returns 1 to push them, or 0 to skip the record.
+ * @param context Pointer passed to every call of parse_record.
+ * @return 0 on success, or an error code as for rsv_file_ingest.
+ */
+static inline int rsv_file_ingest_hash_table(
+    rsv_thread_pool_t* pool, const char* path, char delimiter,
+    rsv_hash_table_t* hash_table,
+    int (*parse_record)(void*, rsv_string_view_t, void*, void*),
+    void* context) {
+  rsv_file_ingest_container_t container;
+  rsv_file_ingest_t ingest = rsv_file_ingest_create(
+      rsv_file_ingest_container_parse, rsv_file_ingest_hash_table_merge,
+      &container);
+
+  container.parse_record = parse_record;
+  container.context = context;
+  container.container = hash_table;
+  container.key_size = hash_table->key_size;
+  container.value_size = hash_table->value_size;
+  container.element_size = container.key_size + container.value_size;
+  container.delimiter = delimiter;
+  ingest.discard = rsv_file_ingest_container_discard;
+  ingest.delimiter = delimiter;
+
+  return rsv_file_ingest(pool, &ingest, path);
+}
+
+#endif /* RSV_FILE_INGEST_H */
+
+#endif
@@ -9,15 +9,346 @@
 #ifndef RSV_STRCPY_H
 #define RSV_STRCPY_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RSV_STRING_BLOCK_SIZE 32
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define RSV_STRING_BLOCK_SIZE 16
+#endif
+
+#define RSV_STRING_PAGE_SIZE 4096
+
+/**
+ * @brief Disables address sanitizer checks on a function. The block routines
+ * read whole aligned blocks, which never cross a page but may extend past the
+ * end of a string, and so past the end of its allocation.
+ *
+ */
+#if defined(__SANITIZE_ADDRESS__)
+#define RSV_STRING_NO_SANITIZE __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define RSV_STRING_NO_SANITIZE __attribute__((no_sanitize_address))
+#endif
+#endif
+
+#if !defined(RSV_STRING_NO_SANITIZE)
+#define RSV_STRING_NO_SANITIZE
+#endif
+
+/**
+ * @brief The result of a bounded copy or concatenation.
+ *
+ */
+typedef struct rsv_string_result_t {
+  /**
+   * @brief The length of the resulting string, without the null terminator.
+   *
+   */
+  size_t length;
+  /**
+   * @brief 1 if the source did not fit and was truncated, 0 otherwise.
+   *
+   */
+  int truncated;
+} rsv_string_result_t;
+
+#if defined(RSV_STRING_BLOCK_SIZE)
+/**
+ * @brief Finds the bytes of an aligned block which are null or equal to a
+ * character.
+ *
+ * @param block Pointer to the block, aligned to RSV_STRING_BLOCK_SIZE.
+ * @param character The character to look for.
+ * @return A mask with bit i set if byte i matches.
+ */
+RSV_STRING_NO_SANITIZE static inline unsigned int
+rsv_string_block_match(const char* block, char character) {
+#if defined(__AVX2__)
+  __m256i data = _mm256_load_si256((const __m256i*)block);
+  __m256i matches =
+      _mm256_or_si256(_mm256_cmpeq_epi8(data, _mm256_setzero_si256()),
+                      _mm256_cmpeq_epi8(data, _mm256_set1_epi8(character)));
+
+  return (unsigned int)_mm256_movemask_epi8(matches);
+#else
+  __m128i data = _mm_load_si128((const __m128i*)block);
+  __m128i matches =
+      _mm_or_si128(_mm_cmpeq_epi8(data, _mm_setzero_si128()),
+                   _mm_cmpeq_epi8(data, _mm_set1_epi8(character)));
+
+  return (unsigned int)_mm_movemask_epi8(matches);
+#endif
+}
+
+/**
+ * @brief Finds the bytes at which two unaligned blocks differ or the first one
+ * is null. Both blocks must lie within a single page.
+ *
+ * @param block_a Pointer to the first block.
+ * @param block_b Pointer to the second block.
+ * @return A mask with bit i set if byte i differs or ends the first string.
+ */
+RSV_STRING_NO_SANITIZE static inline unsigned int
+rsv_string_block_mismatch(const char* block_a, const char* block_b) {
+#if defined(__AVX2__)
+  __m256i data_a = _mm256_loadu_si256((const __m256i*)block_a);
+  __m256i data_b = _mm256_loadu_si256((const __m256i*)block_b);
+  unsigned int equal =
+      (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(data_a, data_b));
+  unsigned int zero = (unsigned int)_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(data_a, _mm256_setzero_si256()));
+
+  return ~equal | zero;
+#else
+  __m128i data_a = _mm_loadu_si128((const __m128i*)block_a);
+  __m128i data_b = _mm_loadu_si128((const __m128i*)block_b);
+  unsigned int equal =
+      (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(data_a, data_b));
+  unsigned int zero = (unsigned int)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(data_a, _mm_setzero_si128()));
+
+  return (~equal & 0xffffu) | zero;
+#endif
+}
+#endif
+
+/**
+ * @brief Finds the first byte of a string which is null or equal to a
+ * character, looking at no more than a maximum amount of bytes.
+ *
+ * Processes a whole block per iteration where SSE2 or AVX2 is available. Loads
+ * are aligned, so they never cross into a page the string does not touch.
+ *
+ * @param string Pointer to the string.
+ * @param character The character to look for.
+ * @param max The maximum amount of bytes to look at.
+ * @return Index of the first matching byte, or max if none was found.
+ */
+RSV_STRING_NO_SANITIZE static inline size_t
+rsv_string_find(const char* string, char character, size_t max) {
+#if defined(RSV_STRING_BLOCK_SIZE)
+  size_t misalignment = (uintptr_t)string % RSV_STRING_BLOCK_SIZE;
+  size_t offset = RSV_STRING_BLOCK_SIZE - misalignment;
+  unsigned int mask;
+
+  if (max == 0) {
+    return 0;
+  }
+
+  /* Bytes before the string share the first block, drop their bits */
+  mask = rsv_string_block_match(string - misalignment, character) >>
+         misalignment;
+
+  if (mask) {
+    size_t index = (size_t)__builtin_ctz(mask);
+    return index < max ? index : max;
+  }
+
+  for (; offset < max; offset += RSV_STRING_BLOCK_SIZE) {
+    mask = rsv_string_block_match(string + offset, character);
+
+    if (mask) {
+      size_t index = offset + (size_t)__builtin_ctz(mask);
+      return index < max ? index : max;
+    }
+  }
+
+  return max;
+#else
+  size_t i;
+
+  for (i = 0; i < max && string[i] != '\0' && string[i] != character; i++) {
+  }
+
+  return i;
+#endif
+}
+
+/**
+ * @brief Gets the length of a string, looking at no more than a maximum
+ * amount of bytes.
+ *
+ * @param string Pointer to the string.
+ * @param max The maximum amount of bytes to look at.
+ * @return The length of the string, or max if no null terminator was found
+ * within it. 0 if the string is NULL.
+ */
+static inline size_t rsv_strnlen(const char* string, size_t max) {
+  if (string == NULL) {
+    return 0;
+  }
+
+  return rsv_string_find(string, '\0', max);
+}
+
+/**
+ * @brief Copies a string from the source to the destination with size
+ * limitation, like rsv_strcpy, and reports the outcome.
+ *
+ * @param destination A pointer to the destination buffer.
+ * @param source A pointer to the source string.
+ * @param destination_size The size of the destination buffer, including the
+ * null terminator.
+ * @return The length of the copied string and whether it was truncated. Nothing
+ * is written if the destination is NULL or its size is 0.
+ */
+static inline rsv_string_result_t rsv_strlcpy(char* destination,
+                                              const char* source,
+                                              size_t destination_size) {
+  rsv_string_result_t result;
+
+  result.length = 0;
+  result.truncated = 0;
+
+  if (destination == NULL || source == NULL || destination_size == 0) {
+    result.truncated = source != NULL && source[0] != '\0';
+    return result;
+  }
+
+  result.length = rsv_string_find(source, '\0', destination_size);
+
+  if (result.length == destination_size) {
+    result.length--;
+    result.truncated = 1;
+  }
+
+  memcpy(destination, source, result.length);
+  destination[result.length] = '\0';
+
+  return result;
+}
+
+/**
+ * @brief Appends a string to the string in the destination with size
+ * limitation. The destination is always left null terminated.
+ *
+ * @param destination A pointer to the null terminated destination string.
+ * @param source A pointer to the string to append.
+ * @param destination_size The size of the destination buffer, including the
+ * null terminator.
+ * @return The length of the resulting string and whether the source was
+ * truncated. If the destination holds no null terminator within its size,
+ * nothing is written and the result is truncated.
+ */
+static inline rsv_string_result_t rsv_strlcat(char* destination,
+                                              const char* source,
+                                              size_t destination_size) {
+  rsv_string_result_t result;
+  size_t length;
+
+  if (destination == NULL) {
+    return rsv_strlcpy(destination, source, destination_size);
+  }
+
+  length = rsv_string_find(destination, '\0', destination_size);
+
+  if (length == destination_size) {
+    result.length = length;
+    result.truncated = source != NULL && source[0] != '\0';
+    return result;
+  }
+
+  result = rsv_strlcpy(destination + length, source,
+                       destination_size - length);
+  result.length += length;
+
+  return result;
+}
+
+/**
+ * @brief Compares two strings, looking at no more than a maximum amount of
+ * bytes.
+ *
+ * Compares a whole block per iteration where SSE2 or AVX2 is available. A
+ * block is only loaded if it stays within the current page of both strings,
+ * the bytes around page ends are compared one by one.
+ *
+ * @param string_a Pointer to the first string.
+ * @param string_b Pointer to the second string.
+ * @param max The maximum amount of bytes to compare.
+ * @return 0 if the strings are equal, a negative value if the first one sorts
+ * first and a positive value otherwise.
+ */
+RSV_STRING_NO_SANITIZE static inline int
+rsv_strncmp(const char* string_a, const char* string_b, size_t max) {
+  size_t i = 0;
+
+  while (i < max) {
+#if defined(RSV_STRING_BLOCK_SIZE)
+    if ((uintptr_t)(string_a + i) % RSV_STRING_PAGE_SIZE <=
+            RSV_STRING_PAGE_SIZE - RSV_STRING_BLOCK_SIZE &&
+        (uintptr_t)(string_b + i) % RSV_STRING_PAGE_SIZE <=
+            RSV_STRING_PAGE_SIZE - RSV_STRING_BLOCK_SIZE) {
+      unsigned int mask =
+          rsv_string_block_mismatch(string_a + i, string_b + i);
+
+      if (mask == 0) {
+        i += RSV_STRING_BLOCK_SIZE;
+        continue;
+      }
+
+      i += (size_t)__builtin_ctz(mask);
+
+      if (i >= max) {
+        return 0;
+      }
+
+      return (unsigned char)string_a[i] - (unsigned char)string_b[i];
+    }
+#endif
+
+    if (string_a[i] != string_b[i] || string_a[i] == '\0') {
+      return (unsigned char)string_a[i] - (unsigned char)string_b[i];
+    }
+
+    i++;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Finds the first occurrence of a character in a string, looking at no
+ * more than a maximum amount of bytes.
+ *
+ * @param string Pointer to the string.
+ * @param character The character to find. The null terminator can be found
+ * too.
+ * @param max The maximum amount of bytes to look at.
+ * @return Pointer to the character, or NULL if it was not found before the end
+ * of the string or within max bytes.
+ */
+static inline const char* rsv_strnchr(const char* string, char character,
+                                      size_t max) {
+  size_t index;
+
+  if (string == NULL) {
+    return NULL;
+  }
+
+  index = rsv_string_find(string, character, max);
+
+  if (index < max && string[index] == character) {
+    return string + index;
+  }
+
+  return NULL;
+}
+
 /**
  * @brief Copies a string from the source to the destination with size
  * limitation.
  *
  * This function copies the string from the source to the destination ensuring
  * that it does not exceed the given destination size. If the source string is
- * longer than the destination size, it will be truncated to fit.
+ * longer than the destination size, it will be truncated to fit. Use
+ * rsv_strlcpy to also get the copied length and whether it was truncated.
  *
  * @param destination A pointer to the destination buffer where the string will
  * be copied.
@@ -31,17 +362,7 @@
  */
 static inline void rsv_strcpy(char* destination, const char* source,
                               size_t destination_size) {
-  size_t i;
-
-  if (destination == NULL || source == NULL || destination_size == 0) {
-    return;
-  }
-
-  for (i = 0; i < destination_size - 1 && source[i] != '\0'; i++) {
-    destination[i] = source[i];
-  }
-
-  destination[i] = '\0';
+  rsv_strlcpy(destination, source, destination_size);
 }
 
 #endif /* RSV_STRCPY_H */
@@ -0,0 +1,485 @@
+/*
+  string_view.h
+  Implementation of non-owning string views, splitting and searching
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#ifndef RSV_STRING_VIEW_H
+#define RSV_STRING_VIEW_H
+
+#include "string.h"
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @brief Returned by the find functions when nothing was found.
+ *
+ */
+#define RSV_STRING_VIEW_NPOS ((size_t)-1)
+
+/**
+ * @brief The most delimiters rsv_string_view_find_any compares a whole block
+ * against, larger sets are scanned one byte at a time through a table.
+ *
+ */
+#define RSV_STRING_VIEW_BLOCK_DELIMITERS 8
+
+#if defined(__AVX2__)
+typedef __m256i rsv_string_view_block_t;
+#define rsv_string_view_block_load(pointer)                                    \
+  _mm256_loadu_si256((const __m256i*)(pointer))
+#define rsv_string_view_block_splat(character) _mm256_set1_epi8(character)
+#define rsv_string_view_block_equal(block_a, block_b)                          \
+  ((unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block_a, block_b)))
+#elif defined(__SSE2__)
+typedef __m128i rsv_string_view_block_t;
+#define rsv_string_view_block_load(pointer)                                    \
+  _mm_loadu_si128((const __m128i*)(pointer))
+#define rsv_string_view_block_splat(character) _mm_set1_epi8(character)
+#define rsv_string_view_block_equal(block_a, block_b)                          \
+  ((unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block_a, block_b)))
+#endif
+
+/**
+ * @brief A non-owning view of characters. Views are not null terminated and
+ * stay valid as long as the characters they point to.
+ *
+ */
+typedef struct rsv_string_view_t {
+  /**
+   * @brief Pointer to the first character.
+   *
+   */
+  const char* data;
+  /**
+   * @brief The amount of characters.
+   *
+   */
+  size_t length;
+} rsv_string_view_t;
+
+/**
+ * @brief Iterates over the fields of a view separated by delimiters. Created
+ * by rsv_string_view_split or rsv_string_view_tokenize, and advanced with
+ * rsv_string_view_split_next.
+ *
+ */
+typedef struct rsv_string_view_split_t {
+  /**
+   * @brief The part of the view not split yet.
+   *
+   */
+  rsv_string_view_t rest;
+  /**
+   * @brief The delimiter characters.
+   *
+   */
+  rsv_string_view_t delimiters;
+  /**
+   * @brief 1 to skip empty fields, 0 to return them.
+   *
+   */
+  int skip_empty;
+  /**
+   * @brief 1 once the last field has been returned.
+   *
+   */
+  int done;
+} rsv_string_view_split_t;
+
+/**
+ * @brief Creates a view of characters.
+ *
+ * @param data Pointer to the first character.
+ * @param length Amount of characters.
+ * @return A rsv_string_view_t struct representing the view.
+ */
+static inline rsv_string_view_t rsv_string_view_create(const char* data,
+                                                       size_t length) {
+  rsv_string_view_t view;
+
+  view.data = data;
+  view.length = length;
+
+  return view;
+}
+
+/**
+ * @brief Creates a view of a null terminated string.
+ *
+ * @param string Pointer to the null terminated string, or NULL for an empty
+ * view.
+ * @return A rsv_string_view_t struct representing the view.
+ */
+static inline rsv_string_view_t rsv_string_view_from(const char* string) {
+  return rsv_string_view_create(string, string ? strlen(string) : 0);
+}
+
+/**
+ * @brief Creates a view of part of a view. The range is clamped to the view.
+ *
+ * @param view The view.
+ * @param offset Index of the first character.
+ * @param length Amount of characters.
+ * @return The view of the part.
+ */
+static inline rsv_string_view_t
+rsv_string_view_substring(rsv_string_view_t view, size_t offset,
+                          size_t length) {
+  if (offset > view.length) {
+    offset = view.length;
+  }
+
+  if (length > view.length - offset) {
+    length = view.length - offset;
+  }
+
+  return rsv_string_view_create(view.data + offset, length);
+}
+
+/**
+ * @brief Compares two views like strcmp, a shorter view sorting first when it
+ * is a prefix of the other.
+ *
+ * @param view_a The first view.
+ * @param view_b The second view.
+ * @return 0 if the views are equal, a negative value if the first one sorts
+ * first and a positive value otherwise.
+ */
+static inline int rsv_string_view_compare(rsv_string_view_t view_a,
+                                          rsv_string_view_t view_b) {
+  size_t length = view_a.length < view_b.length ? view_a.length : view_b.length;
+  int result = length > 0 ? memcmp(view_a.data, view_b.data, length) : 0;
+
+  if (result != 0) {
+    return result;
+  }
+
+  return (view_a.length > view_b.length) - (view_a.length < view_b.length);
+}
+
+/**
+ * @brief Checks whether two views hold the same characters.
+ *
+ * @param view_a The first view.
+ * @param view_b The second view.
+ * @return 1 if the views are equal, 0 otherwise.
+ */
+static inline int rsv_string_view_equal(rsv_string_view_t view_a,
+                                        rsv_string_view_t view_b) {
+  return view_a.length == view_b.length &&
+         (view_a.length == 0 ||
+          memcmp(view_a.data, view_b.data, view_a.length) == 0);
+}
+
+/**
+ * @brief Checks whether a view starts with a prefix.
+ *
+ * @param view The view.
+ * @param prefix The prefix.
+ * @return 1 if the view starts with the prefix, 0 otherwise.
+ */
+static inline int rsv_string_view_starts_with(rsv_string_view_t view,
+                                              rsv_string_view_t prefix) {
+  return view.length >= prefix.length &&
+         rsv_string_view_equal(rsv_string_view_substring(view, 0,
+                                                         prefix.length),
+                               prefix);
+}
+
+/**
+ * @brief Checks whether a view ends with a suffix.
+ *
+ * @param view The view.
+ * @param suffix The suffix.
+ * @return 1 if the view ends with the suffix, 0 otherwise.
+ */
+static inline int rsv_string_view_ends_with(rsv_string_view_t view,
+                                            rsv_string_view_t suffix) {
+  return view.length >= suffix.length &&
+         rsv_string_view_equal(
+             rsv_string_view_substring(view, view.length - suffix.length,
+                                       suffix.length),
+             suffix);
+}
+
+/**
+ * @brief Removes leading and trailing spaces, tabs, carriage returns and line
+ * feeds from a view.
+ *
+ * @param view The view.
+ * @return The trimmed view.
+ */
+static inline rsv_string_view_t rsv_string_view_trim(rsv_string_view_t view) {
+  while (view.length > 0 &&
+         (view.data[0] == ' ' || view.data[0] == '\t' ||
+          view.data[0] == '\r' || view.data[0] == '\n')) {
+    view.data++;
+    view.length--;
+  }
+
+  while (view.length > 0 && (view.data[view.length - 1] == ' ' ||
+                             view.data[view.length - 1] == '\t' ||
+                             view.data[view.length - 1] == '\r' ||
+                             view.data[view.length - 1] == '\n')) {
+    view.length--;
+  }
+
+  return view;
+}
+
+/**
+ * @brief Copies a view into a buffer as a null terminated string, truncating
+ * it to fit.
+ *
+ * @param view The view.
+ * @param destination A pointer to the destination buffer.
+ * @param destination_size The size of the destination buffer, including the
+ * null terminator.
+ * @return The length of the copied string and whether it was truncated.
+ */
+static inline rsv_string_result_t
+rsv_string_view_copy(rsv_string_view_t view, char* destination,
+                     size_t destination_size) {
+  rsv_string_result_t result;
+
+  result.length = 0;
+  result.truncated = view.length > 0;
+
+  if (destination == NULL || destination_size == 0) {
+    return result;
+  }
+
+  result.length =
+      view.length < destination_size ? view.length : destination_size - 1;
+  result.truncated = result.length < view.length;
+  memcpy(destination, view.data, result.length);
+  destination[result.length] = '\0';
+
+  return result;
+}
+
+/**
+ * @brief Finds the first occurrence of a character in a view.
+ *
+ * @param view The view.
+ * @param character The character to find.
+ * @return Index of the character, or RSV_STRING_VIEW_NPOS if not found.
+ */
+static inline size_t rsv_string_view_find_char(rsv_string_view_t view,
+                                               char character) {
+  const char* found =
+      view.length > 0
+          ? (const char*)memchr(view.data, (unsigned char)character,
+                                view.length)
+          : NULL;
+
+  return found ? (size_t)(found - view.data) : RSV_STRING_VIEW_NPOS;
+}
+
+/**
+ * @brief Finds the first occurrence of a substring in a view.
+ *
+ * Where SSE2 or AVX2 is available, a whole block of candidate positions is
+ * filtered at once by comparing the first and the last character of the
+ * needle, and only the positions where both match are compared in full.
+ *
+ * @param view The view to search in.
+ * @param needle The substring to find.
+ * @return Index of the substring, or RSV_STRING_VIEW_NPOS if not found. An
+ * empty needle is found at index 0.
+ */
+static inline size_t rsv_string_view_find(rsv_string_view_t view,
+                                          rsv_string_view_t needle) {
+  size_t i = 0;
+
+  if (needle.length == 0) {
+    return 0;
+  }
+
+  if (needle.length > view.length) {
+    return RSV_STRING_VIEW_NPOS;
+  }
+
+  if (needle.length == 1) {
+    return rsv_string_view_find_char(view, needle.data[0]);
+  }
+
+#if defined(RSV_STRING_BLOCK_SIZE)
+  {
+    rsv_string_view_block_t first = rsv_string_view_block_splat(needle.data[0]);
+    rsv_string_view_block_t last =
+        rsv_string_view_block_splat(needle.data[needle.length - 1]);
+
+    /* Both loads must stay within the view */
+    for (; i + needle.length - 1 + RSV_STRING_BLOCK_SIZE <= view.length;
+         i += RSV_STRING_BLOCK_SIZE) {
+      unsigned int mask =
+          rsv_string_view_block_equal(
+              first, rsv_string_view_block_load(view.data + i)) &
+          rsv_string_view_block_equal(
+              last, rsv_string_view_block_load(view.data + i +
+                                               needle.length - 1));
+
+      while (mask) {
+        size_t position = i + (size_t)__builtin_ctz(mask);
+
+        if (memcmp(view.data + position + 1, needle.data + 1,
+                   needle.length - 2) == 0) {
+          return position;
+        }
+
+        mask &= mask - 1;
+      }
+    }
+  }
+#endif
+
+  for (; i + needle.length <= view.length; ++i) {
+    if (view.data[i] == needle.data[0] &&
+        view.data[i + needle.length - 1] == needle.data[needle.length - 1] &&
+        memcmp(view.data + i + 1, needle.data + 1, needle.length - 2) == 0) {
+      return i;
+    }
+  }
+
+  return RSV_STRING_VIEW_NPOS;
+}
+
+/**
+ * @brief Finds the first character of a view which is one of a set of
+ * delimiters.
+ *
+ * Where SSE2 or AVX2 is available and there are at most
+ * RSV_STRING_VIEW_BLOCK_DELIMITERS delimiters, a whole block is compared
+ * against every delimiter at once.
+ *
+ * @param view The view to search in.
+ * @param delimiters The delimiter characters.
+ * @return Index of the first delimiter, or RSV_STRING_VIEW_NPOS if none was
+ * found.
+ */
+static inline size_t rsv_string_view_find_any(rsv_string_view_t view,
+                                              rsv_string_view_t delimiters) {
+  unsigned char table[256];
+  size_t i = 0;
+  size_t j;
+
+  if (delimiters.length == 1) {
+    return rsv_string_view_find_char(view, delimiters.data[0]);
+  }
+
+#if defined(RSV_STRING_BLOCK_SIZE)
+  if (delimiters.length <= RSV_STRING_VIEW_BLOCK_DELIMITERS) {
+    rsv_string_view_block_t splats[RSV_STRING_VIEW_BLOCK_DELIMITERS];
+
+    for (j = 0; j < delimiters.length; ++j) {
+      splats[j] = rsv_string_view_block_splat(delimiters.data[j]);
+    }
+
+    for (; i + RSV_STRING_BLOCK_SIZE <= view.length;
+         i += RSV_STRING_BLOCK_SIZE) {
+      rsv_string_view_block_t block = rsv_string_view_block_load(view.data + i);
+      unsigned int mask = 0;
+
+      for (j = 0; j < delimiters.length; ++j) {
+        mask |= rsv_string_view_block_equal(block, splats[j]);
+      }
+
+      if (mask) {
+        return i + (size_t)__builtin_ctz(mask);
+      }
+    }
+  }
+#endif
+
+  memset(table, 0, sizeof(table));
+
+  for (j = 0; j < delimiters.length; ++j) {
+    table[(unsigned char)delimiters.data[j]] = 1;
+  }
+
+  for (; i < view.length; ++i) {
+    if (table[(unsigned char)view.data[i]]) {
+      return i;
+    }
+  }
+
+  return RSV_STRING_VIEW_NPOS;
+}
+
+/**
+ * @brief Splits a view on a set of delimiters, keeping empty fields, as needed
+ * for formats such as CSV. "a,,b" gives "a", "" and "b".
+ *
+ * @param view The view to split.
+ * @param delimiters The delimiter characters.
+ * @return The split iterator.
+ */
+static inline rsv_string_view_split_t
+rsv_string_view_split(rsv_string_view_t view, rsv_string_view_t delimiters) {
+  rsv_string_view_split_t split;
+
+  split.rest = view;
+  split.delimiters = delimiters;
+  split.skip_empty = 0;
+  split.done = 0;
+
+  return split;
+}
+
+/**
+ * @brief Splits a view on a set of delimiters, skipping empty fields, like
+ * strtok. " a  b " split on spaces gives "a" and "b".
+ *
+ * @param view The view to split.
+ * @param delimiters The delimiter characters.
+ * @return The split iterator.
+ */
+static inline rsv_string_view_split_t
+rsv_string_view_tokenize(rsv_string_view_t view,
+                         rsv_string_view_t delimiters) {
+  rsv_string_view_split_t split = rsv_string_view_split(view, delimiters);
+
+  split.skip_empty = 1;
+
+  return split;
+}
+
+/**
+ * @brief Gets the next field of a split. Does not allocate or copy.
+ *
+ * @param split Pointer to the split iterator.
+ * @param field Pointer to where the view of the field is stored. Left
+ * unchanged once there are no more fields.
+ * @return 1 if a field was found, 0 once every field has been returned.
+ */
+static inline int rsv_string_view_split_next(rsv_string_view_split_t* split,
+                                             rsv_string_view_t* field) {
+  while (!split->done) {
+    size_t index = rsv_string_view_find_any(split->rest, split->delimiters);
+    rsv_string_view_t next;
+
+    if (index == RSV_STRING_VIEW_NPOS) {
+      next = split->rest;
+      split->rest.data += split->rest.length;
+      split->rest.length = 0;
+      split->done = 1;
+    } else {
+      next = rsv_string_view_create(split->rest.data, index);
+      split->rest.data += index + 1;
+      split->rest.length -= index + 1;
+    }
+
+    if (!split->skip_empty || next.length > 0) {
+      *field = next;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+#endif /* RSV_STRING_VIEW_H */
@@ -0,0 +1,487 @@
+/*
+  utf8.h
+  Implementation of UTF-8 validation and transcoding
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#ifndef RSV_UTF8_H
+#define RSV_UTF8_H
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define RSV_UTF8_BLOCK_SIZE 16
+
+/**
+ * @brief Error classes of the lookup table validator, one bit each. A pair of
+ * bytes is invalid if the classes of its first byte's high nibble, its first
+ * byte's low nibble and its second byte's high nibble share a bit.
+ *
+ */
+#define RSV_UTF8_TOO_SHORT 0x01
+#define RSV_UTF8_TOO_LONG 0x02
+#define RSV_UTF8_OVERLONG_3 0x04
+#define RSV_UTF8_TOO_LARGE 0x08
+#define RSV_UTF8_SURROGATE 0x10
+#define RSV_UTF8_OVERLONG_2 0x20
+#define RSV_UTF8_TOO_LARGE_1000 0x40
+#define RSV_UTF8_OVERLONG_4 0x40
+#define RSV_UTF8_TWO_CONTINUATIONS 0x80
+#define RSV_UTF8_CARRY                                                         \
+  (RSV_UTF8_TOO_SHORT | RSV_UTF8_TOO_LONG | RSV_UTF8_TWO_CONTINUATIONS)
+
+/**
+ * @brief Decodes a single UTF-8 sequence, following the well-formed byte
+ * sequences of the Unicode standard. Overlong forms, surrogates and code
+ * points above U+10FFFF are rejected.
+ *
+ * @param source Pointer to the first byte of the sequence.
+ * @param length The amount of bytes available, at least 1.
+ * @param codepoint Pointer to where the decoded code point is stored.
+ * @return The length of the sequence, or 0 if it is invalid or truncated.
+ */
+static inline size_t rsv_utf8_decode(const char* source, size_t length,
+                                     uint32_t* codepoint) {
+  const unsigned char* bytes = (const unsigned char*)source;
+  unsigned char lower = 0x80;
+  unsigned char upper = 0xbf;
+
+  if (bytes[0] < 0x80) {
+    *codepoint = bytes[0];
+    return 1;
+  }
+
+  if (bytes[0] < 0xc2) {
+    return 0;
+  }
+
+  if (bytes[0] < 0xe0) {
+    if (length < 2 || (bytes[1] & 0xc0) != 0x80) {
+      return 0;
+    }
+
+    *codepoint = (uint32_t)(bytes[0] & 0x1f) << 6 | (bytes[1] & 0x3f);
+    return 2;
+  }
+
+  if (bytes[0] < 0xf0) {
+    if (bytes[0] == 0xe0) {
+      lower = 0xa0;
+    } else if (bytes[0] == 0xed) {
+      upper = 0x9f;
+    }
+
+    if (length < 3 || bytes[1] < lower || bytes[1] > upper ||
+        (bytes[2] & 0xc0) != 0x80) {
+      return 0;
+    }
+
+    *codepoint = (uint32_t)(bytes[0] & 0x0f) << 12 |
+                 (uint32_t)(bytes[1] & 0x3f) << 6 | (bytes[2] & 0x3f);
+    return 3;
+  }
+
+  if (bytes[0] < 0xf5) {
+    if (bytes[0] == 0xf0) {
+      lower = 0x90;
+    } else if (bytes[0] == 0xf4) {
+      upper = 0x8f;
+    }
+
+    if (length < 4 || bytes[1] < lower || bytes[1] > upper ||
+        (bytes[2] & 0xc0) != 0x80 || (bytes[3] & 0xc0) != 0x80) {
+      return 0;
+    }
+
+    *codepoint = (uint32_t)(bytes[0] & 0x07) << 18 |
+                 (uint32_t)(bytes[1] & 0x3f) << 12 |
+                 (uint32_t)(bytes[2] & 0x3f) << 6 | (bytes[3] & 0x3f);
+    return 4;
+  }
+
+  return 0;
+}
+
+#if defined(__SSSE3__)
+/**
+ * @brief Finds the errors in a block of UTF-8, given the block before it.
+ *
+ * Every byte is classified together with the byte before it through three 16
+ * entry lookup tables. Third and fourth bytes of a sequence are checked
+ * separately, as they are the only continuations which may follow another
+ * continuation.
+ *
+ * @param input The block.
+ * @param previous The block before it, or zeroes at the start of the input.
+ * @return Non-zero bytes wherever there is an error.
+ */
+static inline __m128i rsv_utf8_block_errors(__m128i input, __m128i previous) {
+  const __m128i byte_1_high_table = _mm_setr_epi8(
+      RSV_UTF8_TOO_LONG, RSV_UTF8_TOO_LONG, RSV_UTF8_TOO_LONG,
+      RSV_UTF8_TOO_LONG, RSV_UTF8_TOO_LONG, RSV_UTF8_TOO_LONG,
+      RSV_UTF8_TOO_LONG, RSV_UTF8_TOO_LONG, (char)RSV_UTF8_TWO_CONTINUATIONS,
+      (char)RSV_UTF8_TWO_CONTINUATIONS, (char)RSV_UTF8_TWO_CONTINUATIONS,
+      (char)RSV_UTF8_TWO_CONTINUATIONS,
+      RSV_UTF8_TOO_SHORT | RSV_UTF8_OVERLONG_2, RSV_UTF8_TOO_SHORT,
+      RSV_UTF8_TOO_SHORT | RSV_UTF8_OVERLONG_3 | RSV_UTF8_SURROGATE,
+      RSV_UTF8_TOO_SHORT | RSV_UTF8_TOO_LARGE | RSV_UTF8_TOO_LARGE_1000 |
+          RSV_UTF8_OVERLONG_4);
+  const __m128i byte_1_low_table = _mm_setr_epi8(
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_OVERLONG_3 | RSV_UTF8_OVERLONG_2 |
+             RSV_UTF8_OVERLONG_4),
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_OVERLONG_2), (char)RSV_UTF8_CARRY,
+      (char)RSV_UTF8_CARRY, (char)(RSV_UTF8_CARRY | RSV_UTF8_TOO_LARGE),
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_TOO_LARGE | RSV_UTF8_TOO_LARGE_1000),
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_TOO_LARGE | RSV_UTF8_TOO_LARGE_1000),
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_TOO_LARGE | RSV_UTF8_TOO_LARGE_1000),
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_TOO_LARGE | RSV_UTF8_TOO_LARGE_1000),
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_TOO_LARGE | RSV_UTF8_TOO_LARGE_1000),
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_TOO_LARGE | RSV_UTF8_TOO_LARGE_1000),
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_TOO_LARGE | RSV_UTF8_TOO_LARGE_1000),
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_TOO_LARGE | RSV_UTF8_TOO_LARGE_1000),
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_TOO_LARGE | RSV_UTF8_TOO_LARGE_1000 |
+             RSV_UTF8_SURROGATE),
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_TOO_LARGE | RSV_UTF8_TOO_LARGE_1000),
+      (char)(RSV_UTF8_CARRY | RSV_UTF8_TOO_LARGE | RSV_UTF8_TOO_LARGE_1000));
+  const __m128i byte_2_high_table = _mm_setr_epi8(
+      RSV_UTF8_TOO_SHORT, RSV_UTF8_TOO_SHORT, RSV_UTF8_TOO_SHORT,
+      RSV_UTF8_TOO_SHORT, RSV_UTF8_TOO_SHORT, RSV_UTF8_TOO_SHORT,
+      RSV_UTF8_TOO_SHORT, RSV_UTF8_TOO_SHORT,
+      (char)(RSV_UTF8_TOO_LONG | RSV_UTF8_OVERLONG_2 |
+             RSV_UTF8_TWO_CONTINUATIONS | RSV_UTF8_OVERLONG_3 |
+             RSV_UTF8_TOO_LARGE_1000 | RSV_UTF8_OVERLONG_4),
+      (char)(RSV_UTF8_TOO_LONG | RSV_UTF8_OVERLONG_2 |
+             RSV_UTF8_TWO_CONTINUATIONS | RSV_UTF8_OVERLONG_3 |
+             RSV_UTF8_TOO_LARGE),
+      (char)(RSV_UTF8_TOO_LONG | RSV_UTF8_OVERLONG_2 |
+             RSV_UTF8_TWO_CONTINUATIONS | RSV_UTF8_SURROGATE |
+             RSV_UTF8_TOO_LARGE),
+      (char)(RSV_UTF8_TOO_LONG | RSV_UTF8_OVERLONG_2 |
+             RSV_UTF8_TWO_CONTINUATIONS | RSV_UTF8_SURROGATE |
+             RSV_UTF8_TOO_LARGE),
+      RSV_UTF8_TOO_SHORT, RSV_UTF8_TOO_SHORT, RSV_UTF8_TOO_SHORT,
+      RSV_UTF8_TOO_SHORT);
+  const __m128i low_nibble = _mm_set1_epi8(0x0f);
+  __m128i previous_1 = _mm_alignr_epi8(input, previous, 15);
+  __m128i previous_2 = _mm_alignr_epi8(input, previous, 14);
+  __m128i previous_3 = _mm_alignr_epi8(input, previous, 13);
+  __m128i byte_1_high = _mm_shuffle_epi8(
+      byte_1_high_table,
+      _mm_and_si128(_mm_srli_epi16(previous_1, 4), low_nibble));
+  __m128i byte_1_low = _mm_shuffle_epi8(byte_1_low_table,
+                                        _mm_and_si128(previous_1, low_nibble));
+  __m128i byte_2_high = _mm_shuffle_epi8(
+      byte_2_high_table, _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+  __m128i special =
+      _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+  /* Only bytes two and three after a 111xxxxx or 1111xxxx lead keep bit 7 */
+  __m128i third_or_fourth = _mm_or_si128(
+      _mm_subs_epu8(previous_2, _mm_set1_epi8((char)(0xe0 - 0x80))),
+      _mm_subs_epu8(previous_3, _mm_set1_epi8((char)(0xf0 - 0x80))));
+
+  return _mm_xor_si128(
+      _mm_and_si128(third_or_fourth, _mm_set1_epi8((char)0x80)), special);
+}
+#endif
+
+/**
+ * @brief Checks whether characters are valid UTF-8.
+ *
+ * Where SSSE3 is available, 16 bytes are validated at once through lookup
+ * tables without branching on the data. Otherwise blocks of ASCII are skipped
+ * with SSE2 where available, and the rest is decoded one sequence at a time.
+ *
+ * @param source Pointer to the characters.
+ * @param length The amount of bytes.
+ * @return 1 if the characters are valid UTF-8, 0 otherwise.
+ */
+static inline int rsv_utf8_validate(const char* source, size_t length) {
+  size_t i = 0;
+#if defined(__SSSE3__)
+  const __m128i incomplete_limit =
+      _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                    (char)(0xf0 - 1), (char)(0xe0 - 1), (char)(0xc0 - 1));
+  __m128i previous = _mm_setzero_si128();
+  __m128i incomplete = _mm_setzero_si128();
+  __m128i errors = _mm_setzero_si128();
+  char tail[RSV_UTF8_BLOCK_SIZE];
+
+  for (; i + RSV_UTF8_BLOCK_SIZE <= length; i += RSV_UTF8_BLOCK_SIZE) {
+    __m128i input = _mm_loadu_si128((const __m128i*)(source + i));
+
+    if (_mm_movemask_epi8(input) == 0) {
+      /* An ASCII block is only wrong if the block before it was cut short */
+      errors = _mm_or_si128(errors, incomplete);
+      incomplete = _mm_setzero_si128();
+    } else {
+      errors = _mm_or_si128(errors, rsv_utf8_block_errors(input, previous));
+      incomplete = _mm_subs_epu8(input, incomplete_limit);
+    }
+
+    previous = input;
+  }
+
+  /* Zero padding also catches a sequence cut short by the end of the input */
+  memset(tail, 0, sizeof(tail));
+
+  if (i < length) {
+    memcpy(tail, source + i, length - i);
+  }
+
+  errors = _mm_or_si128(
+      errors, rsv_utf8_block_errors(
+                  _mm_loadu_si128((const __m128i*)tail), previous));
+
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(errors, _mm_setzero_si128())) ==
+         0xffff;
+#else
+  uint32_t codepoint;
+
+  while (i < length) {
+    size_t sequence;
+
+#if defined(__SSE2__)
+    if (i + RSV_UTF8_BLOCK_SIZE <= length &&
+        _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(source + i))) ==
+            0) {
+      i += RSV_UTF8_BLOCK_SIZE;
+      continue;
+    }
+#endif
+
+    sequence = rsv_utf8_decode(source + i, length - i, &codepoint);
+
+    if (sequence == 0) {
+      return 0;
+    }
+
+    i += sequence;
+  }
+
+  return 1;
+#endif
+}
+
+/**
+ * @brief Counts the code points of valid UTF-8, which is the amount of bytes
+ * that are not continuation bytes. Processes 16 bytes at once where SSE2 is
+ * available.
+ *
+ * @param source Pointer to valid UTF-8.
+ * @param length The amount of bytes.
+ * @return The amount of code points.
+ */
+static inline size_t rsv_utf8_count(const char* source, size_t length) {
+  size_t amount = 0;
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  /* Continuation bytes are the signed values -128 to -65 */
+  for (; i + RSV_UTF8_BLOCK_SIZE <= length; i += RSV_UTF8_BLOCK_SIZE) {
+    __m128i input = _mm_loadu_si128((const __m128i*)(source + i));
+
+    amount += (size_t)__builtin_popcount((unsigned int)_mm_movemask_epi8(
+        _mm_cmpgt_epi8(input, _mm_set1_epi8(-65))));
+  }
+#endif
+
+  for (; i < length; i++) {
+    amount += ((unsigned char)source[i] & 0xc0) != 0x80;
+  }
+
+  return amount;
+}
+
+/**
+ * @brief Gets the amount of UTF-16 code units needed for valid UTF-8, which is
+ * the amount of code points plus one for every four byte sequence.
+ *
+ * @param source Pointer to valid UTF-8.
+ * @param length The amount of bytes.
+ * @return The amount of UTF-16 code units.
+ */
+static inline size_t rsv_utf8_utf16_length(const char* source,
+                                           size_t length) {
+  size_t amount = rsv_utf8_count(source, length);
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  /* Four byte leads are the signed values -16 to -1 */
+  for (; i + RSV_UTF8_BLOCK_SIZE <= length; i += RSV_UTF8_BLOCK_SIZE) {
+    __m128i input = _mm_loadu_si128((const __m128i*)(source + i));
+    __m128i leads =
+        _mm_and_si128(_mm_cmpgt_epi8(input, _mm_set1_epi8(-17)),
+                      _mm_cmplt_epi8(input, _mm_setzero_si128()));
+
+    amount += (size_t)__builtin_popcount(
+        (unsigned int)_mm_movemask_epi8(leads));
+  }
+#endif
+
+  for (; i < length; i++) {
+    amount += (unsigned char)source[i] >= 0xf0;
+  }
+
+  return amount;
+}
+
+/**
+ * @brief Converts UTF-8 to UTF-32. Blocks of ASCII are widened 16 bytes at
+ * once where SSE2 is available. rsv_utf8_count gives the amount of code units
+ * needed.
+ *
+ * @param source Pointer to the UTF-8.
+ * @param length The amount of bytes.
+ * @param destination Pointer to the destination buffer.
+ * @param destination_size The amount of code units the destination can hold.
+ * @param written Pointer to where the amount of code units written is stored,
+ * or NULL.
+ * @return 0 on success, EILSEQ if the source is not valid UTF-8 or ERANGE if
+ * the destination is too small. On failure the code units of the valid prefix
+ * which fit have been written.
+ */
+static inline int rsv_utf8_to_utf32(const char* source, size_t length,
+                                    uint32_t* destination,
+                                    size_t destination_size, size_t* written) {
+  size_t i = 0;
+  size_t j = 0;
+  int result = 0;
+
+  while (i < length) {
+    uint32_t codepoint;
+    size_t sequence;
+
+#if defined(__SSE2__)
+    if (i + RSV_UTF8_BLOCK_SIZE <= length &&
+        j + RSV_UTF8_BLOCK_SIZE <= destination_size) {
+      __m128i input = _mm_loadu_si128((const __m128i*)(source + i));
+
+      if (_mm_movemask_epi8(input) == 0) {
+        __m128i zero = _mm_setzero_si128();
+        __m128i low = _mm_unpacklo_epi8(input, zero);
+        __m128i high = _mm_unpackhi_epi8(input, zero);
+
+        _mm_storeu_si128((__m128i*)(destination + j),
+                         _mm_unpacklo_epi16(low, zero));
+        _mm_storeu_si128((__m128i*)(destination + j + 4),
+                         _mm_unpackhi_epi16(low, zero));
+        _mm_storeu_si128((__m128i*)(destination + j + 8),
+                         _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128((__m128i*)(destination + j + 12),
+                         _mm_unpackhi_epi16(high, zero));
+        i += RSV_UTF8_BLOCK_SIZE;
+        j += RSV_UTF8_BLOCK_SIZE;
+        continue;
+      }
+    }
+#endif
+
+    sequence = rsv_utf8_decode(source + i, length - i, &codepoint);
+
+    if (sequence == 0) {
+      result = EILSEQ;
+      break;
+    }
+
+    if (j == destination_size) {
+      result = ERANGE;
+      break;
+    }
+
+    destination[j++] = codepoint;
+    i += sequence;
+  }
+
+  if (written != NULL) {
+    *written = j;
+  }
+
+  return result;
+}
+
+/**
+ * @brief Converts UTF-8 to UTF-16, using surrogate pairs above U+FFFF. Blocks
+ * of ASCII are widened 16 bytes at once where SSE2 is available.
+ * rsv_utf8_utf16_length gives the amount of code units needed.
+ *
+ * @param source Pointer to the UTF-8.
+ * @param length The amount of bytes.
+ * @param destination Pointer to the destination buffer.
+ * @param destination_size The amount of code units the destination can hold.
+ * @param written Pointer to where the amount of code units written is stored,
+ * or NULL.
+ * @return 0 on success, EILSEQ if the source is not valid UTF-8 or ERANGE if
+ * the destination is too small. On failure the code units of the valid prefix
+ * which fit have been written, never half of a surrogate pair.
+ */
+static inline int rsv_utf8_to_utf16(const char* source, size_t length,
+                                    uint16_t* destination,
+                                    size_t destination_size, size_t* written) {
+  size_t i = 0;
+  size_t j = 0;
+  int result = 0;
+
+  while (i < length) {
+    uint32_t codepoint;
+    size_t sequence;
+
+#if defined(__SSE2__)
+    if (i + RSV_UTF8_BLOCK_SIZE <= length &&
+        j + RSV_UTF8_BLOCK_SIZE <= destination_size) {
+      __m128i input = _mm_loadu_si128((const __m128i*)(source + i));
+
+      if (_mm_movemask_epi8(input) == 0) {
+        __m128i zero = _mm_setzero_si128();
+
+        _mm_storeu_si128((__m128i*)(destination + j),
+                         _mm_unpacklo_epi8(input, zero));
+        _mm_storeu_si128((__m128i*)(destination + j + 8),
+                         _mm_unpackhi_epi8(input, zero));
+        i += RSV_UTF8_BLOCK_SIZE;
+        j += RSV_UTF8_BLOCK_SIZE;
+        continue;
+      }
+    }
+#endif
+
+    sequence = rsv_utf8_decode(source + i, length - i, &codepoint);
+
+    if (sequence == 0) {
+      result = EILSEQ;
+      break;
+    }
+
+    if (destination_size - j < (codepoint > 0xffff ? 2u : 1u)) {
+      result = ERANGE;
+      break;
+    }
+
+    if (codepoint > 0xffff) {
+      codepoint -= 0x10000;
+      destination[j++] = (uint16_t)(0xd800 | codepoint >> 10);
+      destination[j++] = (uint16_t)(0xdc00 | (codepoint & 0x3ff));
+    } else {
+      destination[j++] = (uint16_t)codepoint;
+    }
+
+    i += sequence;
+  }
+
+  if (written != NULL) {
+    *written = j;
+  }
+
+  return result;
+}
+
+#endif /* RSV_UTF8_H */
@@ -0,0 +1,278 @@
+/*
+  stats.h
+  Opt-in statistics of containers and locks, compiled in with RSV_STATS
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#ifndef RSV_STATS_H
+#define RSV_STATS_H
+
+/**
+ * @brief Statistics are only compiled in when RSV_STATS is defined, for every
+ * translation unit of the program. Otherwise the macros below expand to
+ * nothing and containers keep their usual layout.
+ *
+ */
+#if defined(RSV_STATS)
+
+#include <stdio.h>
+#include <string.h>
+
+#include "threads/atomic.h"
+
+#define RSV_STATS_HISTOGRAM_SIZE 32
+
+#define RSV_STATS_ONLY(code) code
+#define RSV_STATS_CLEAR(stats) rsv_stats_clear(&(stats))
+#define RSV_STATS_PROBE(stats, length) rsv_stats_probe(&(stats), length)
+#define RSV_STATS_ALLOCATE(stats, bytes) rsv_stats_allocate(&(stats), bytes)
+#define RSV_STATS_REALLOCATE(stats, old_bytes, new_bytes)                      \
+  rsv_stats_reallocate(&(stats), old_bytes, new_bytes)
+#define RSV_STATS_FREE(stats, bytes) rsv_stats_free(&(stats), bytes)
+#define RSV_STATS_RESIZE(stats) ((stats).resizes++)
+
+/**
+ * @brief A histogram with power of two buckets. Bucket 0 counts zeroes and
+ * bucket i counts values from 2^(i-1) to 2^i - 1, the last bucket also
+ * counting everything above.
+ *
+ */
+typedef struct rsv_stats_histogram_t {
+  unsigned long counts[RSV_STATS_HISTOGRAM_SIZE];
+} rsv_stats_histogram_t;
+
+/**
+ * @brief Statistics of a container.
+ *
+ */
+typedef struct rsv_stats_t {
+  /**
+   * @brief Entries visited by each lookup, such as the chain length walked in
+   * a hash table bucket.
+   *
+   */
+  rsv_stats_histogram_t probes;
+  /**
+   * @brief The amount of times the container was resized.
+   *
+   */
+  unsigned long resizes;
+  /**
+   * @brief The amount of allocations and reallocations made.
+   *
+   */
+  unsigned long allocations;
+  /**
+   * @brief The amount of frees made.
+   *
+   */
+  unsigned long frees;
+  /**
+   * @brief The amount of bytes currently allocated.
+   *
+   */
+  size_t bytes;
+  /**
+   * @brief The most bytes allocated at once.
+   *
+   */
+  size_t peak_bytes;
+} rsv_stats_t;
+
+/**
+ * @brief Gets the histogram bucket of a value.
+ *
+ * @param value The value.
+ * @return Index of the bucket.
+ */
+static inline unsigned int rsv_stats_bucket(unsigned long long value) {
+  unsigned int bucket = 0;
+
+  while (value > 0 && bucket < RSV_STATS_HISTOGRAM_SIZE - 1) {
+    value >>= 1;
+    bucket++;
+  }
+
+  return bucket;
+}
+
+/**
+ * @brief Adds a value to a histogram. Safe to call from several threads at
+ * once, since lookups of a container may run under a shared lock.
+ *
+ * @param histogram Pointer to the histogram.
+ * @param value The value.
+ */
+static inline void rsv_stats_histogram_add(rsv_stats_histogram_t* histogram,
+                                           unsigned long long value) {
+#if defined(__GNUC__)
+  rsv_atomic_fetch_add(&histogram->counts[rsv_stats_bucket(value)], 1,
+                       RSV_MEMORY_ORDER_RELAXED);
+#else
+  histogram->counts[rsv_stats_bucket(value)]++;
+#endif
+}
+
+/**
+ * @brief Gets the amount of values in a histogram.
+ *
+ * @param histogram Pointer to the histogram.
+ * @return The amount of values.
+ */
+static inline unsigned long
+rsv_stats_histogram_amount(const rsv_stats_histogram_t* histogram) {
+  unsigned long amount = 0;
+  unsigned int i;
+
+  for (i = 0; i < RSV_STATS_HISTOGRAM_SIZE; ++i) {
+    amount += histogram->counts[i];
+  }
+
+  return amount;
+}
+
+/**
+ * @brief Gets an upper bound of a percentile of a histogram.
+ *
+ * @param histogram Pointer to the histogram.
+ * @param percentile The percentile, from 0 to 1.
+ * @return The largest value of the bucket holding the percentile, 0 if the
+ * histogram is empty.
+ */
+static inline unsigned long long
+rsv_stats_histogram_percentile(const rsv_stats_histogram_t* histogram,
+                               double percentile) {
+  unsigned long amount = rsv_stats_histogram_amount(histogram);
+  unsigned long seen = 0;
+  unsigned int i;
+
+  for (i = 0; i < RSV_STATS_HISTOGRAM_SIZE && amount > 0; ++i) {
+    seen += histogram->counts[i];
+
+    if ((double)seen >= percentile * (double)amount) {
+      return i == 0 ? 0 : (1ull << i) - 1;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Clears the statistics of a container.
+ *
+ * @param stats Pointer to the statistics.
+ */
+static inline void rsv_stats_clear(rsv_stats_t* stats) {
+  memset(stats, 0, sizeof(rsv_stats_t));
+}
+
+/**
+ * @brief Records a lookup.
+ *
+ * @param stats Pointer to the statistics.
+ * @param length The amount of entries visited.
+ */
+static inline void rsv_stats_probe(rsv_stats_t* stats, unsigned int length) {
+  rsv_stats_histogram_add(&stats->probes, length);
+}
+
+/**
+ * @brief Records an allocation.
+ *
+ * @param stats Pointer to the statistics.
+ * @param bytes The size of the allocation.
+ */
+static inline void rsv_stats_allocate(rsv_stats_t* stats, size_t bytes) {
+  stats->allocations++;
+  stats->bytes += bytes;
+
+  if (stats->bytes > stats->peak_bytes) {
+    stats->peak_bytes = stats->bytes;
+  }
+}
+
+/**
+ * @brief Records a reallocation.
+ *
+ * @param stats Pointer to the statistics.
+ * @param old_bytes The size before the reallocation.
+ * @param new_bytes The size after the reallocation.
+ */
+static inline void rsv_stats_reallocate(rsv_stats_t* stats, size_t old_bytes,
+                                        size_t new_bytes) {
+  stats->bytes -= old_bytes;
+  rsv_stats_allocate(stats, new_bytes);
+}
+
+/**
+ * @brief Records a free.
+ *
+ * @param stats Pointer to the statistics.
+ * @param bytes The size of the freed allocation.
+ */
+static inline void rsv_stats_free(rsv_stats_t* stats, size_t bytes) {
+  stats->frees++;
+  stats->bytes -= bytes;
+}
+
+/**
+ * @brief Prints a histogram, one line per non-empty bucket.
+ *
+ * @param file The file to print to.
+ * @param histogram Pointer to the histogram.
+ */
+static inline void
+rsv_stats_histogram_dump(FILE* file, const rsv_stats_histogram_t* histogram) {
+  unsigned int i;
+
+  for (i = 0; i < RSV_STATS_HISTOGRAM_SIZE; ++i) {
+    if (histogram->counts[i] == 0) {
+      continue;
+    }
+
+    if (i == 0) {
+      fprintf(file, "    0: %lu\n", histogram->counts[i]);
+    } else if (i == RSV_STATS_HISTOGRAM_SIZE - 1) {
+      fprintf(file, "    %llu+: %lu\n", 1ull << (i - 1), histogram->counts[i]);
+    } else {
+      fprintf(file, "    %llu-%llu: %lu\n", 1ull << (i - 1), (1ull << i) - 1,
+              histogram->counts[i]);
+    }
+  }
+}
+
+/**
+ * @brief Prints the statistics of a container.
+ *
+ * @param file The file to print to.
+ * @param name The name to print the statistics under.
+ * @param stats Pointer to the statistics.
+ */
+static inline void rsv_stats_dump(FILE* file, const char* name,
+                                  const rsv_stats_t* stats) {
+  fprintf(file,
+          "%s:\n  bytes: %lu (peak %lu)\n  allocations: %lu\n  frees: %lu\n"
+          "  resizes: %lu\n  lookups: %lu (p50 <= %llu, p99 <= %llu)\n",
+          name, (unsigned long)stats->bytes, (unsigned long)stats->peak_bytes,
+          stats->allocations, stats->frees, stats->resizes,
+          rsv_stats_histogram_amount(&stats->probes),
+          rsv_stats_histogram_percentile(&stats->probes, 0.5),
+          rsv_stats_histogram_percentile(&stats->probes, 0.99));
+  rsv_stats_histogram_dump(file, &stats->probes);
+}
+
+#else
+
+#define RSV_STATS_ONLY(code)
+#define RSV_STATS_CLEAR(stats)
+#define RSV_STATS_PROBE(stats, length)
+#define RSV_STATS_ALLOCATE(stats, bytes)
+#define RSV_STATS_REALLOCATE(stats, old_bytes, new_bytes)
+#define RSV_STATS_FREE(stats, bytes)
+#define RSV_STATS_RESIZE(stats)
+
+#endif
+
+#endif /* RSV_STATS_H */
@@ -0,0 +1,169 @@
+/*
+  atomic.h
+  Portable atomic operations with explicit memory orders
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#if defined(__GNUC__)
+
+#ifndef RSV_ATOMIC_H
+#define RSV_ATOMIC_H
+
+/**
+ * @brief No ordering, only atomicity.
+ *
+ */
+#define RSV_MEMORY_ORDER_RELAXED __ATOMIC_RELAXED
+/**
+ * @brief Later reads and writes cannot move before this load.
+ *
+ */
+#define RSV_MEMORY_ORDER_ACQUIRE __ATOMIC_ACQUIRE
+/**
+ * @brief Earlier reads and writes cannot move after this store.
+ *
+ */
+#define RSV_MEMORY_ORDER_RELEASE __ATOMIC_RELEASE
+/**
+ * @brief Both acquire and release, for read-modify-write operations.
+ *
+ */
+#define RSV_MEMORY_ORDER_ACQ_REL __ATOMIC_ACQ_REL
+/**
+ * @brief Acquire and release, plus a single total order over every
+ * sequentially consistent operation.
+ *
+ */
+#define RSV_MEMORY_ORDER_SEQ_CST __ATOMIC_SEQ_CST
+
+/**
+ * @brief Atomically loads the value of an object.
+ *
+ * Works on any integer or pointer type of 1, 2, 4 or 8 bytes.
+ *
+ * @param object Pointer to the object.
+ * @param order Memory order of the load.
+ * @return The loaded value.
+ */
+#define rsv_atomic_load(object, order) __atomic_load_n(object, order)
+
+/**
+ * @brief Atomically stores a value into an object.
+ *
+ * @param object Pointer to the object.
+ * @param value Value to store.
+ * @param order Memory order of the store.
+ */
+#define rsv_atomic_store(object, value, order)                                 \
+  __atomic_store_n(object, value, order)
+
+/**
+ * @brief Atomically replaces the value of an object.
+ *
+ * @param object Pointer to the object.
+ * @param value Value to store.
+ * @param order Memory order of the operation.
+ * @return The value held before the exchange.
+ */
+#define rsv_atomic_exchange(object, value, order)                              \
+  __atomic_exchange_n(object, value, order)
+
+/**
+ * @brief Atomically replaces the value of an object if it equals the expected
+ * one.
+ *
+ * @param object Pointer to the object.
+ * @param expected Pointer to the expected value. Overwritten with the actual
+ * value when the exchange fails.
+ * @param desired Value to store on success.
+ * @param success Memory order on success.
+ * @param failure Memory order on failure, no stronger than success.
+ * @return 1 if the value was replaced, 0 otherwise.
+ */
+#define rsv_atomic_compare_exchange(object, expected, desired, success,        \
+                                    failure)                                   \
+  __atomic_compare_exchange_n(object, expected, desired, 0, success, failure)
+
+/**
+ * @brief Like rsv_atomic_compare_exchange, but allowed to fail spuriously.
+ * Cheaper on some architectures when used in a retry loop.
+ *
+ * @param object Pointer to the object.
+ * @param expected Pointer to the expected value. Overwritten with the actual
+ * value when the exchange fails.
+ * @param desired Value to store on success.
+ * @param success Memory order on success.
+ * @param failure Memory order on failure, no stronger than success.
+ * @return 1 if the value was replaced, 0 otherwise.
+ */
+#define rsv_atomic_compare_exchange_weak(object, expected, desired, success,   \
+                                         failure)                              \
+  __atomic_compare_exchange_n(object, expected, desired, 1, success, failure)
+
+/**
+ * @brief Atomically adds to an object.
+ *
+ * @param object Pointer to the object.
+ * @param value Value to add.
+ * @param order Memory order of the operation.
+ * @return The value held before the addition.
+ */
+#define rsv_atomic_fetch_add(object, value, order)                             \
+  __atomic_fetch_add(object, value, order)
+
+/**
+ * @brief Atomically subtracts from an object.
+ *
+ * @param object Pointer to the object.
+ * @param value Value to subtract.
+ * @param order Memory order of the operation.
+ * @return The value held before the subtraction.
+ */
+#define rsv_atomic_fetch_sub(object, value, order)                             \
+  __atomic_fetch_sub(object, value, order)
+
+/**
+ * @brief Atomically applies a bitwise and to an object.
+ *
+ * @param object Pointer to the object.
+ * @param value Operand of the bitwise and.
+ * @param order Memory order of the operation.
+ * @return The value held before the operation.
+ */
+#define rsv_atomic_fetch_and(object, value, order)                             \
+  __atomic_fetch_and(object, value, order)
+
+/**
+ * @brief Atomically applies a bitwise or to an object.
+ *
+ * @param object Pointer to the object.
+ * @param value Operand of the bitwise or.
+ * @param order Memory order of the operation.
+ * @return The value held before the operation.
+ */
+#define rsv_atomic_fetch_or(object, value, order)                              \
+  __atomic_fetch_or(object, value, order)
+
+/**
+ * @brief Atomically applies a bitwise xor to an object.
+ *
+ * @param object Pointer to the object.
+ * @param value Operand of the bitwise xor.
+ * @param order Memory order of the operation.
+ * @return The value held before the operation.
+ */
+#define rsv_atomic_fetch_xor(object, value, order)                             \
+  __atomic_fetch_xor(object, value, order)
+
+/**
+ * @brief Issues a memory fence.
+ *
+ * @param order Memory order of the fence.
+ */
+#define rsv_atomic_thread_fence(order) __atomic_thread_fence(order)
+
+#endif /* RSV_ATOMIC_H */
+
+#endif
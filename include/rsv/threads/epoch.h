@@ -0,0 +1,305 @@
+/*
+  epoch.h
+  Implementation of epoch-based memory reclamation for lock-free structures
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#if defined(__unix__)
+
+#ifndef RSV_EPOCH_H
+#define RSV_EPOCH_H
+
+#include "atomic.h"
+#include "threads_pthreads.h"
+#include <errno.h>
+#include <stdlib.h>
+
+#define RSV_EPOCH_COLLECT_THRESHOLD 64
+
+/**
+ * @brief A pointer waiting to be freed. Should not be directly used unless
+ * necessary.
+ *
+ */
+typedef struct rsv_epoch_retired_t {
+  void* pointer;
+  void (*free_func)(void*);
+  unsigned long epoch;
+  struct rsv_epoch_retired_t* next;
+} rsv_epoch_retired_t;
+
+/**
+ * @brief A thread taking part in an epoch domain. Obtained with
+ * rsv_epoch_register and used by one thread at a time.
+ *
+ */
+typedef struct rsv_epoch_participant_t {
+  /**
+   * @brief The epoch the participant entered, shifted left by one, with the
+   * lowest bit set while inside a critical section.
+   *
+   */
+  unsigned long local_epoch;
+  /**
+   * @brief How many times the participant entered without exiting.
+   *
+   */
+  unsigned int nesting;
+  /**
+   * @brief The amount of pointers retired since the last collection.
+   *
+   */
+  unsigned int retired_amount;
+  /**
+   * @brief The retired pointers, newest first.
+   *
+   */
+  rsv_epoch_retired_t* retired;
+  int in_use;
+  struct rsv_epoch_t* domain;
+  struct rsv_epoch_participant_t* next;
+} RSV_CACHE_ALIGNED rsv_epoch_participant_t;
+
+/**
+ * @brief An epoch-based reclamation domain.
+ *
+ * Readers wrap their accesses to shared nodes in rsv_epoch_enter and
+ * rsv_epoch_exit. Writers which unlink a node hand it to rsv_epoch_retire
+ * instead of freeing it, and it is only freed once every reader which could
+ * still hold a reference to it has exited. A retired pointer is safe to free
+ * once the global epoch has moved two steps past the epoch it was retired in.
+ *
+ */
+typedef struct rsv_epoch_t {
+  /**
+   * @brief The global epoch.
+   *
+   */
+  unsigned long global_epoch RSV_CACHE_ALIGNED;
+  /**
+   * @brief Every participant ever registered. Records are reused but never
+   * unlinked until the domain is destroyed.
+   *
+   */
+  rsv_epoch_participant_t* participants;
+} rsv_epoch_t;
+
+/**
+ * @brief Creates an epoch domain.
+ *
+ * @param epoch Pointer to the epoch domain to initialize.
+ * @return Always 0.
+ */
+static inline int rsv_epoch_create(rsv_epoch_t* epoch) {
+  epoch->global_epoch = 0;
+  epoch->participants = NULL;
+  return 0;
+}
+
+/**
+ * @brief Frees a list of retired pointers.
+ *
+ * @param retired Pointer to the first retired pointer of the list.
+ */
+static inline void rsv_epoch_free_retired(rsv_epoch_retired_t* retired) {
+  while (retired) {
+    rsv_epoch_retired_t* next = retired->next;
+    retired->free_func(retired->pointer);
+    free(retired);
+    retired = next;
+  }
+}
+
+/**
+ * @brief Destroys an epoch domain, freeing every participant and every
+ * pointer still waiting to be freed. No thread may use the domain anymore.
+ *
+ * @param epoch Pointer to the epoch domain to destroy.
+ */
+static inline void rsv_epoch_destroy(rsv_epoch_t* epoch) {
+  rsv_epoch_participant_t* participant = epoch->participants;
+
+  while (participant) {
+    rsv_epoch_participant_t* next = participant->next;
+    rsv_epoch_free_retired(participant->retired);
+    free(participant);
+    participant = next;
+  }
+
+  epoch->participants = NULL;
+}
+
+/**
+ * @brief Registers the calling thread with an epoch domain.
+ *
+ * @param epoch Pointer to the epoch domain.
+ * @return Pointer to the participant, or NULL if out of memory.
+ */
+static inline rsv_epoch_participant_t* rsv_epoch_register(rsv_epoch_t* epoch) {
+  rsv_epoch_participant_t* participant =
+      rsv_atomic_load(&epoch->participants, RSV_MEMORY_ORDER_ACQUIRE);
+  void* memory;
+
+  /* Reuse the record of a thread which unregistered */
+  for (; participant; participant = participant->next) {
+    int expected = 0;
+
+    if (rsv_atomic_load(&participant->in_use, RSV_MEMORY_ORDER_RELAXED) == 0 &&
+        rsv_atomic_compare_exchange(&participant->in_use, &expected, 1,
+                                    RSV_MEMORY_ORDER_ACQUIRE,
+                                    RSV_MEMORY_ORDER_RELAXED)) {
+      return participant;
+    }
+  }
+
+  if (posix_memalign(&memory, RSV_CACHE_LINE_SIZE,
+                     sizeof(rsv_epoch_participant_t)) != 0) {
+    return NULL;
+  }
+
+  participant = (rsv_epoch_participant_t*)memory;
+  participant->local_epoch = 0;
+  participant->nesting = 0;
+  participant->retired_amount = 0;
+  participant->retired = NULL;
+  participant->in_use = 1;
+  participant->domain = epoch;
+  participant->next =
+      rsv_atomic_load(&epoch->participants, RSV_MEMORY_ORDER_RELAXED);
+
+  while (!rsv_atomic_compare_exchange_weak(
+      &epoch->participants, &participant->next, participant,
+      RSV_MEMORY_ORDER_RELEASE, RSV_MEMORY_ORDER_RELAXED)) {
+  }
+
+  return participant;
+}
+
+/**
+ * @brief Unregisters a participant. Its pending retired pointers stay with
+ * the record and are freed by whichever thread reuses it, or when the domain
+ * is destroyed.
+ *
+ * @param participant Pointer to the participant.
+ */
+static inline void
+rsv_epoch_unregister(rsv_epoch_participant_t* participant) {
+  participant->nesting = 0;
+  rsv_atomic_store(&participant->local_epoch, 0, RSV_MEMORY_ORDER_RELEASE);
+  rsv_atomic_store(&participant->in_use, 0, RSV_MEMORY_ORDER_RELEASE);
+}
+
+/**
+ * @brief Enters a critical section. Nodes reachable from shared memory stay
+ * valid until the matching rsv_epoch_exit. Critical sections can be nested.
+ *
+ * @param participant Pointer to the participant of the calling thread.
+ */
+static inline void rsv_epoch_enter(rsv_epoch_participant_t* participant) {
+  if (participant->nesting++ == 0) {
+    unsigned long global = rsv_atomic_load(&participant->domain->global_epoch,
+                                           RSV_MEMORY_ORDER_ACQUIRE);
+
+    rsv_atomic_store(&participant->local_epoch, (global << 1) | 1,
+                     RSV_MEMORY_ORDER_RELAXED);
+    rsv_atomic_thread_fence(RSV_MEMORY_ORDER_SEQ_CST);
+  }
+}
+
+/**
+ * @brief Exits a critical section.
+ *
+ * @param participant Pointer to the participant of the calling thread.
+ */
+static inline void rsv_epoch_exit(rsv_epoch_participant_t* participant) {
+  if (--participant->nesting == 0) {
+    rsv_atomic_store(&participant->local_epoch, 0, RSV_MEMORY_ORDER_RELEASE);
+  }
+}
+
+/**
+ * @brief Advances the global epoch if every participant inside a critical
+ * section has observed it, then frees the participant's retired pointers
+ * which no reader can reach anymore.
+ *
+ * @param participant Pointer to the participant of the calling thread.
+ */
+static inline void rsv_epoch_collect(rsv_epoch_participant_t* participant) {
+  rsv_epoch_t* epoch = participant->domain;
+  rsv_epoch_participant_t* other;
+  rsv_epoch_retired_t** link;
+  unsigned long global;
+  int advance = 1;
+
+  rsv_atomic_thread_fence(RSV_MEMORY_ORDER_SEQ_CST);
+  global = rsv_atomic_load(&epoch->global_epoch, RSV_MEMORY_ORDER_ACQUIRE);
+  other = rsv_atomic_load(&epoch->participants, RSV_MEMORY_ORDER_ACQUIRE);
+
+  for (; other; other = other->next) {
+    unsigned long local =
+        rsv_atomic_load(&other->local_epoch, RSV_MEMORY_ORDER_ACQUIRE);
+
+    if ((local & 1) && (local >> 1) != global) {
+      advance = 0;
+      break;
+    }
+  }
+
+  if (advance && rsv_atomic_compare_exchange(&epoch->global_epoch, &global,
+                                             global + 1,
+                                             RSV_MEMORY_ORDER_ACQ_REL,
+                                             RSV_MEMORY_ORDER_ACQUIRE)) {
+    global++;
+  }
+
+  /* The list is newest first, so everything after the first old enough
+   * pointer is old enough as well */
+  link = &participant->retired;
+
+  while (*link && (*link)->epoch + 2 > global) {
+    link = &(*link)->next;
+  }
+
+  rsv_epoch_free_retired(*link);
+  *link = NULL;
+  participant->retired_amount = 0;
+}
+
+/**
+ * @brief Retires a pointer which has been unlinked from shared memory. It is
+ * freed once no reader can still hold a reference to it.
+ *
+ * @param participant Pointer to the participant of the calling thread.
+ * @param pointer The pointer to free.
+ * @param free_func Function which frees the pointer, such as free.
+ * @return 0 on success, or ENOMEM if the pointer could not be tracked, in
+ * which case nothing was retired.
+ */
+static inline int rsv_epoch_retire(rsv_epoch_participant_t* participant,
+                                   void* pointer, void (*free_func)(void*)) {
+  rsv_epoch_retired_t* retired =
+      (rsv_epoch_retired_t*)malloc(sizeof(rsv_epoch_retired_t));
+
+  if (retired == NULL) {
+    return ENOMEM;
+  }
+
+  retired->pointer = pointer;
+  retired->free_func = free_func;
+  retired->epoch = rsv_atomic_load(&participant->domain->global_epoch,
+                                   RSV_MEMORY_ORDER_ACQUIRE);
+  retired->next = participant->retired;
+  participant->retired = retired;
+
+  if (++participant->retired_amount >= RSV_EPOCH_COLLECT_THRESHOLD) {
+    rsv_epoch_collect(participant);
+  }
+
+  return 0;
+}
+
+#endif /* RSV_EPOCH_H */
+
+#endif
@@ -0,0 +1,282 @@
+/*
+  numa.h
+  Contains NUMA topology queries and node-local allocation helpers
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#if defined(__unix__)
+
+#ifndef RSV_NUMA_H
+#define RSV_NUMA_H
+
+#include "threads_pthreads.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RSV_NUMA_SYSFS_PATH "/sys/devices/system/node"
+
+/**
+ * @brief Parses a kernel CPU or node list such as "0-3,8,10-11".
+ *
+ * @param list The list to parse.
+ * @param set Pointer to the set which receives every listed number.
+ * @return 0 on success, or EINVAL if the list is malformed.
+ */
+static inline int rsv_numa_parse_list(const char* list, rsv_cpu_set_t* set) {
+  rsv_cpu_set_clear(set);
+
+  while (*list && *list != '\n') {
+    char* end;
+    unsigned long first = strtoul(list, &end, 10);
+    unsigned long last = first;
+
+    if (end == list) {
+      return EINVAL;
+    }
+
+    if (*end == '-') {
+      list = end + 1;
+      last = strtoul(list, &end, 10);
+
+      if (end == list || last < first) {
+        return EINVAL;
+      }
+    }
+
+    for (; first <= last && first < RSV_CPU_SET_SIZE; ++first) {
+      rsv_cpu_set_add(set, (unsigned int)first);
+    }
+
+    list = *end == ',' ? end + 1 : end;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Reads a list file from sysfs.
+ *
+ * @param path Path of the file.
+ * @param set Pointer to the set which receives every listed number.
+ * @return 0 on success, or an error code if the file cannot be read.
+ */
+static inline int rsv_numa_read_list(const char* path, rsv_cpu_set_t* set) {
+  char buffer[4096];
+  FILE* file = fopen(path, "r");
+  int result;
+
+  if (file == NULL) {
+    return errno;
+  }
+
+  if (fgets(buffer, sizeof(buffer), file)) {
+    result = rsv_numa_parse_list(buffer, set);
+  } else {
+    result = EIO;
+  }
+
+  fclose(file);
+
+  return result;
+}
+
+/**
+ * @brief Gets the amount of NUMA nodes. Nodes are numbered from 0 to the
+ * amount minus one, though some numbers may be offline on unusual systems.
+ *
+ * @return The amount of nodes, 1 if the system does not expose its topology.
+ */
+static inline unsigned int rsv_numa_node_amount(void) {
+  rsv_cpu_set_t nodes;
+  unsigned int amount = 1;
+  unsigned int i;
+
+  if (rsv_numa_read_list(RSV_NUMA_SYSFS_PATH "/online", &nodes) != 0) {
+    return 1;
+  }
+
+  for (i = 0; i < RSV_CPU_SET_SIZE; ++i) {
+    if (rsv_cpu_set_has(&nodes, i)) {
+      amount = i + 1;
+    }
+  }
+
+  return amount;
+}
+
+/**
+ * @brief Gets the CPUs of a NUMA node. On systems which do not expose their
+ * topology, node 0 holds every online CPU.
+ *
+ * @param node Number of the node.
+ * @param cpus Pointer to the CPU set to fill.
+ * @return 0 on success, or an error code such as ENOENT if the node does not
+ * exist.
+ */
+static inline int rsv_numa_node_cpus(unsigned int node, rsv_cpu_set_t* cpus) {
+  char path[64];
+  int result;
+
+  snprintf(path, sizeof(path), RSV_NUMA_SYSFS_PATH "/node%u/cpulist", node);
+  result = rsv_numa_read_list(path, cpus);
+
+  if (result != 0 && node == 0 && rsv_numa_node_amount() == 1) {
+    long cpu_amount = sysconf(_SC_NPROCESSORS_ONLN);
+    long i;
+
+    rsv_cpu_set_clear(cpus);
+
+    for (i = 0; i < (cpu_amount > 0 ? cpu_amount : 1); ++i) {
+      rsv_cpu_set_add(cpus, (unsigned int)i);
+    }
+
+    return 0;
+  }
+
+  return result;
+}
+
+/**
+ * @brief Gets the NUMA node of the CPU the calling thread is running on.
+ *
+ * @return The node, 0 if it cannot be determined.
+ */
+static inline unsigned int rsv_numa_current_node(void) {
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+  int cpu = sched_getcpu();
+  unsigned int amount = rsv_numa_node_amount();
+  unsigned int node;
+
+  for (node = 0; cpu >= 0 && node < amount; ++node) {
+    rsv_cpu_set_t cpus;
+
+    if (rsv_numa_node_cpus(node, &cpus) == 0 &&
+        rsv_cpu_set_has(&cpus, (unsigned int)cpu)) {
+      return node;
+    }
+  }
+#endif
+
+  return 0;
+}
+
+/**
+ * @brief Restricts the calling thread to the CPUs of a NUMA node.
+ *
+ * @param node Number of the node.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_numa_pin_current_thread(unsigned int node) {
+  rsv_cpu_set_t cpus;
+  int result = rsv_numa_node_cpus(node, &cpus);
+
+  if (result != 0) {
+    return result;
+  }
+
+  return rsv_thread_set_affinity(pthread_self(), &cpus);
+}
+
+/**
+ * @brief Fills thread attributes so that the thread runs on a NUMA node.
+ *
+ * @param attributes Pointer to initialized thread attributes.
+ * @param node Number of the node.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int
+rsv_numa_thread_attributes(rsv_thread_attributes_t* attributes,
+                           unsigned int node) {
+  return rsv_numa_node_cpus(node, &attributes->cpus);
+}
+
+/**
+ * @brief Allocates page-aligned memory and touches every page from the calling
+ * thread.
+ *
+ * Linux places a page on the node of the thread that first writes to it, so
+ * calling this from a thread pinned to a node keeps the memory on that node,
+ * wherever it is used from later. Free with free.
+ *
+ * @param size Size of the memory in bytes.
+ * @return Pointer to the zeroed memory, or NULL if out of memory.
+ */
+static inline void* rsv_numa_alloc_local(size_t size) {
+  long page_size = sysconf(_SC_PAGESIZE);
+  void* memory;
+
+  if (page_size <= 0) {
+    page_size = 4096;
+  }
+
+  if (posix_memalign(&memory, (size_t)page_size, size > 0 ? size : 1) != 0) {
+    return NULL;
+  }
+
+  memset(memory, 0, size);
+
+  return memory;
+}
+
+/**
+ * @brief Arguments of rsv_numa_alloc_node_main. Should not be directly used
+ * unless necessary.
+ *
+ */
+typedef struct rsv_numa_alloc_t {
+  size_t size;
+  void* memory;
+} rsv_numa_alloc_t;
+
+/**
+ * @brief Thread routine of rsv_numa_alloc_node.
+ *
+ * @param arg Pointer to a rsv_numa_alloc_t.
+ * @return NULL.
+ */
+static inline void* rsv_numa_alloc_node_main(void* arg) {
+  rsv_numa_alloc_t* alloc = (rsv_numa_alloc_t*)arg;
+
+  alloc->memory = rsv_numa_alloc_local(alloc->size);
+
+  return NULL;
+}
+
+/**
+ * @brief Allocates page-aligned memory on a NUMA node from any thread, by
+ * touching it from a short-lived thread pinned to the node. Useful to set up
+ * containers for workers before starting them. Free with free.
+ *
+ * @param node Number of the node.
+ * @param size Size of the memory in bytes.
+ * @return Pointer to the zeroed memory, or NULL on failure.
+ */
+static inline void* rsv_numa_alloc_node(unsigned int node, size_t size) {
+  rsv_thread_attributes_t attributes;
+  rsv_numa_alloc_t alloc;
+  rsv_thread_t thread;
+
+  rsv_thread_attributes_create(&attributes);
+  alloc.size = size;
+  alloc.memory = NULL;
+
+  if (rsv_numa_thread_attributes(&attributes, node) != 0 ||
+      rsv_thread_create_ex(&thread, &attributes, rsv_numa_alloc_node_main,
+                           &alloc) != 0) {
+    return NULL;
+  }
+
+  rsv_thread_join(thread, NULL);
+
+  return alloc.memory;
+}
+
+#endif /* RSV_NUMA_H */
+
+#endif
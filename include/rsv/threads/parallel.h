@@ -0,0 +1,644 @@
+/*
+  parallel.h
+  Data-parallel for-each, map and reduce on top of the thread pool
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#if defined(__unix__)
+
+#ifndef RSV_PARALLEL_H
+#define RSV_PARALLEL_H
+
+#include "../containers/dynamic_array.h"
+#include "../containers/hash_set.h"
+#include "../containers/hash_table.h"
+#include "thread_pool.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RSV_PARALLEL_CHUNKS_PER_WORKER 4
+
+/**
+ * @brief A chunk of a parallel loop. Should not be directly used unless
+ * necessary.
+ *
+ */
+typedef struct rsv_parallel_chunk_t {
+  void (*for_body)(void*, unsigned int, unsigned int);
+  void (*reduce_body)(void*, unsigned int, unsigned int, void*);
+  void* context;
+  void* partial;
+  unsigned int begin;
+  unsigned int end;
+} rsv_parallel_chunk_t;
+
+/**
+ * @brief Runs a single chunk of a parallel loop.
+ *
+ * @param arg Pointer to the chunk.
+ */
+static inline void rsv_parallel_chunk_run(void* arg) {
+  rsv_parallel_chunk_t* chunk = (rsv_parallel_chunk_t*)arg;
+
+  if (chunk->reduce_body) {
+    chunk->reduce_body(chunk->context, chunk->begin, chunk->end,
+                       chunk->partial);
+  } else {
+    chunk->for_body(chunk->context, chunk->begin, chunk->end);
+  }
+}
+
+/**
+ * @brief Gets the amount of chunks a range is split into.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param length Length of the range.
+ * @param grain Amount of indices per chunk, or 0 to pick one from the worker
+ * amount.
+ * @return The amount of chunks.
+ */
+static inline unsigned int rsv_parallel_chunk_amount(rsv_thread_pool_t* pool,
+                                                     unsigned int length,
+                                                     unsigned int* grain) {
+  if (length == 0) {
+    return 0;
+  }
+
+  if (*grain == 0) {
+    unsigned int target = pool->worker_amount * RSV_PARALLEL_CHUNKS_PER_WORKER;
+    *grain = (length + target - 1) / target;
+  }
+
+  return (length - 1) / *grain + 1;
+}
+
+/**
+ * @brief Splits a range into chunks and runs them on the thread pool.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param chunks Pointer to the chunks, filled in by this function.
+ * @param chunk_amount Amount of chunks.
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ * @param grain Amount of indices per chunk.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_parallel_run(rsv_thread_pool_t* pool,
+                                   rsv_parallel_chunk_t* chunks,
+                                   unsigned int chunk_amount,
+                                   unsigned int begin, unsigned int end,
+                                   unsigned int grain) {
+  rsv_thread_pool_wait_t wait;
+  unsigned int i;
+  int result = rsv_thread_pool_wait_create(&wait);
+
+  if (result != 0) {
+    return result;
+  }
+
+  for (i = 0; i < chunk_amount; ++i) {
+    chunks[i].begin = begin + i * grain;
+    chunks[i].end = end;
+
+    if (end - chunks[i].begin > grain) {
+      chunks[i].end = chunks[i].begin + grain;
+    }
+
+    if (result == 0) {
+      result = rsv_thread_pool_submit(pool, &wait, rsv_parallel_chunk_run,
+                                      &chunks[i]);
+    }
+
+    if (result != 0) {
+      /* Out of memory, run the rest on the calling thread */
+      rsv_parallel_chunk_run(&chunks[i]);
+    }
+  }
+
+  rsv_thread_pool_wait(pool, &wait);
+  rsv_thread_pool_wait_destroy(&wait);
+
+  return 0;
+}
+
+/**
+ * @brief Runs a loop body over the range [begin, end) in parallel.
+ *
+ * The range is split into chunks of `grain` indices, and the body is called
+ * once per chunk on one of the pool's workers. Can be called from inside a
+ * task of the same pool.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ * @param grain Amount of indices per chunk, or 0 to pick one from the worker
+ * amount.
+ * @param body Function called with the context and the bounds of a chunk.
+ * @param context Pointer passed to every call of the body.
+ * @return 0 on success, or ENOMEM if the chunks could not be allocated.
+ */
+static inline int rsv_parallel_for(rsv_thread_pool_t* pool, unsigned int begin,
+                                   unsigned int end, unsigned int grain,
+                                   void (*body)(void*, unsigned int,
+                                                unsigned int),
+                                   void* context) {
+  unsigned int chunk_amount =
+      rsv_parallel_chunk_amount(pool, end > begin ? end - begin : 0, &grain);
+  rsv_parallel_chunk_t* chunks;
+  unsigned int i;
+  int result;
+
+  if (chunk_amount == 0) {
+    return 0;
+  }
+
+  chunks = (rsv_parallel_chunk_t*)malloc(chunk_amount *
+                                         sizeof(rsv_parallel_chunk_t));
+
+  if (chunks == NULL) {
+    return ENOMEM;
+  }
+
+  for (i = 0; i < chunk_amount; ++i) {
+    chunks[i].for_body = body;
+    chunks[i].reduce_body = NULL;
+    chunks[i].context = context;
+    chunks[i].partial = NULL;
+  }
+
+  result = rsv_parallel_run(pool, chunks, chunk_amount, begin, end, grain);
+  free(chunks);
+
+  return result;
+}
+
+/**
+ * @brief Reduces the range [begin, end) in parallel.
+ *
+ * Every chunk accumulates into its own cache line aligned partial result,
+ * which starts as a copy of `result`. Once every chunk has finished the
+ * partials are combined into `result` in chunk order on the calling thread,
+ * so no locks are taken and the outcome does not depend on scheduling.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ * @param grain Amount of indices per chunk, or 0 to pick one from the worker
+ * amount.
+ * @param result Pointer to the result, which must hold the identity value of
+ * the reduction on entry.
+ * @param result_size Size of the result in memory.
+ * @param body Function called with the context, the bounds of a chunk and the
+ * chunk's partial result.
+ * @param combine Function called with the context, the result and a partial
+ * result to fold the partial into the result.
+ * @param context Pointer passed to every call of body and combine.
+ * @return 0 on success, or ENOMEM if the partials could not be allocated.
+ */
+static inline int rsv_parallel_reduce(
+    rsv_thread_pool_t* pool, unsigned int begin, unsigned int end,
+    unsigned int grain, void* result, unsigned int result_size,
+    void (*body)(void*, unsigned int, unsigned int, void*),
+    void (*combine)(void*, void*, const void*), void* context) {
+  unsigned int chunk_amount =
+      rsv_parallel_chunk_amount(pool, end > begin ? end - begin : 0, &grain);
+  unsigned int stride = (result_size + RSV_CACHE_LINE_SIZE - 1) /
+                        RSV_CACHE_LINE_SIZE * RSV_CACHE_LINE_SIZE;
+  rsv_parallel_chunk_t* chunks;
+  void* partials;
+  unsigned int i;
+  int error;
+
+  if (chunk_amount == 0) {
+    return 0;
+  }
+
+  chunks = (rsv_parallel_chunk_t*)malloc(chunk_amount *
+                                         sizeof(rsv_parallel_chunk_t));
+
+  if (chunks == NULL) {
+    return ENOMEM;
+  }
+
+  if (posix_memalign(&partials, RSV_CACHE_LINE_SIZE,
+                     (size_t)chunk_amount * stride) != 0) {
+    free(chunks);
+    return ENOMEM;
+  }
+
+  for (i = 0; i < chunk_amount; ++i) {
+    chunks[i].for_body = NULL;
+    chunks[i].reduce_body = body;
+    chunks[i].context = context;
+    chunks[i].partial = (unsigned char*)partials + (size_t)i * stride;
+    memcpy(chunks[i].partial, result, result_size);
+  }
+
+  error = rsv_parallel_run(pool, chunks, chunk_amount, begin, end, grain);
+
+  for (i = 0; i < chunk_amount; ++i) {
+    combine(context, result, chunks[i].partial);
+  }
+
+  free(partials);
+  free(chunks);
+
+  return error;
+}
+
+/**
+ * @brief Adapts a container callback to a chunked loop body. Should not be
+ * directly used unless necessary.
+ *
+ */
+typedef struct rsv_parallel_container_t {
+  void* container;
+  void* output;
+  void (*element_func)(void*, void*, unsigned int);
+  void (*map_func)(void*, const void*, void*);
+  void (*entry_func)(void*, const void*, void*);
+  void (*fold_func)(void*, void*, const void*, const void*);
+  void* context;
+} rsv_parallel_container_t;
+
+/**
+ * @brief Loop body calling the element function on a range of a dynamic array.
+ *
+ */
+static inline void rsv_parallel_dynamic_array_for_body(void* arg,
+                                                       unsigned int begin,
+                                                       unsigned int end) {
+  rsv_parallel_container_t* adapter = (rsv_parallel_container_t*)arg;
+  rsv_dynamic_array_t* array = (rsv_dynamic_array_t*)adapter->container;
+  unsigned int i;
+
+  for (i = begin; i < end; ++i) {
+    adapter->element_func(adapter->context,
+                          (unsigned char*)array->data + i * array->element_size,
+                          i);
+  }
+}
+
+/**
+ * @brief Loop body calling the map function on a range of a dynamic array.
+ *
+ */
+static inline void rsv_parallel_dynamic_array_map_body(void* arg,
+                                                       unsigned int begin,
+                                                       unsigned int end) {
+  rsv_parallel_container_t* adapter = (rsv_parallel_container_t*)arg;
+  rsv_dynamic_array_t* source = (rsv_dynamic_array_t*)adapter->container;
+  rsv_dynamic_array_t* destination = (rsv_dynamic_array_t*)adapter->output;
+  unsigned int i;
+
+  for (i = begin; i < end; ++i) {
+    adapter->map_func(
+        adapter->context,
+        (unsigned char*)source->data + i * source->element_size,
+        (unsigned char*)destination->data + i * destination->element_size);
+  }
+}
+
+/**
+ * @brief Loop body folding a range of a dynamic array into a partial.
+ *
+ */
+static inline void rsv_parallel_dynamic_array_reduce_body(void* arg,
+                                                          unsigned int begin,
+                                                          unsigned int end,
+                                                          void* partial) {
+  rsv_parallel_container_t* adapter = (rsv_parallel_container_t*)arg;
+  rsv_dynamic_array_t* array = (rsv_dynamic_array_t*)adapter->container;
+  unsigned int i;
+
+  for (i = begin; i < end; ++i) {
+    adapter->fold_func(
+        adapter->context, partial,
+        (unsigned char*)array->data + i * array->element_size, NULL);
+  }
+}
+
+/**
+ * @brief Loop body calling the entry function on a bucket range of a hash
+ * table.
+ *
+ */
+static inline void rsv_parallel_hash_table_for_body(void* arg,
+                                                    unsigned int begin,
+                                                    unsigned int end) {
+  rsv_parallel_container_t* adapter = (rsv_parallel_container_t*)arg;
+  rsv_hash_table_t* hash_table = (rsv_hash_table_t*)adapter->container;
+  unsigned int i;
+
+  for (i = begin; i < end; ++i) {
+    rsv_hash_table_entry_t* entry = hash_table->data[i];
+
+    while (entry) {
+      adapter->entry_func(adapter->context, entry->key, entry->value);
+      entry = entry->next;
+    }
+  }
+}
+
+/**
+ * @brief Loop body folding a bucket range of a hash table into a partial.
+ *
+ */
+static inline void rsv_parallel_hash_table_reduce_body(void* arg,
+                                                       unsigned int begin,
+                                                       unsigned int end,
+                                                       void* partial) {
+  rsv_parallel_container_t* adapter = (rsv_parallel_container_t*)arg;
+  rsv_hash_table_t* hash_table = (rsv_hash_table_t*)adapter->container;
+  unsigned int i;
+
+  for (i = begin; i < end; ++i) {
+    rsv_hash_table_entry_t* entry = hash_table->data[i];
+
+    while (entry) {
+      adapter->fold_func(adapter->context, partial, entry->key, entry->value);
+      entry = entry->next;
+    }
+  }
+}
+
+/**
+ * @brief Loop body calling the entry function on a bucket range of a hash
+ * set.
+ *
+ */
+static inline void rsv_parallel_hash_set_for_body(void* arg,
+                                                  unsigned int begin,
+                                                  unsigned int end) {
+  rsv_parallel_container_t* adapter = (rsv_parallel_container_t*)arg;
+  rsv_hash_set_t* hash_set = (rsv_hash_set_t*)adapter->container;
+  unsigned int i;
+
+  for (i = begin; i < end; ++i) {
+    rsv_hash_set_entry_t* entry = hash_set->data[i];
+
+    while (entry) {
+      adapter->entry_func(adapter->context, entry->data, NULL);
+      entry = entry->next;
+    }
+  }
+}
+
+/**
+ * @brief Loop body folding a bucket range of a hash set into a partial.
+ *
+ */
+static inline void rsv_parallel_hash_set_reduce_body(void* arg,
+                                                     unsigned int begin,
+                                                     unsigned int end,
+                                                     void* partial) {
+  rsv_parallel_container_t* adapter = (rsv_parallel_container_t*)arg;
+  rsv_hash_set_t* hash_set = (rsv_hash_set_t*)adapter->container;
+  unsigned int i;
+
+  for (i = begin; i < end; ++i) {
+    rsv_hash_set_entry_t* entry = hash_set->data[i];
+
+    while (entry) {
+      adapter->fold_func(adapter->context, partial, entry->data, NULL);
+      entry = entry->next;
+    }
+  }
+}
+
+/**
+ * @brief Calls a function on every element of a dynamic array in parallel.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param array Pointer to the dynamic array.
+ * @param grain Amount of elements per chunk, or 0 to pick one automatically.
+ * @param func Function called with the context, a pointer to the element and
+ * its index.
+ * @param context Pointer passed to every call of the function.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_parallel_for_dynamic_array(
+    rsv_thread_pool_t* pool, rsv_dynamic_array_t* array, unsigned int grain,
+    void (*func)(void*, void*, unsigned int), void* context) {
+  rsv_parallel_container_t adapter;
+
+  memset(&adapter, 0, sizeof(adapter));
+  adapter.container = array;
+  adapter.element_func = func;
+  adapter.context = context;
+
+  return rsv_parallel_for(pool, 0, array->amount, grain,
+                          rsv_parallel_dynamic_array_for_body, &adapter);
+}
+
+/**
+ * @brief Maps every element of a dynamic array into another dynamic array in
+ * parallel. The destination keeps its element size and ends up with as many
+ * elements as the source.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param source Pointer to the dynamic array to read from.
+ * @param destination Pointer to the dynamic array to write to.
+ * @param grain Amount of elements per chunk, or 0 to pick one automatically.
+ * @param func Function called with the context, a pointer to the source
+ * element and a pointer to the destination element.
+ * @param context Pointer passed to every call of the function.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_parallel_map_dynamic_array(
+    rsv_thread_pool_t* pool, rsv_dynamic_array_t* source,
+    rsv_dynamic_array_t* destination, unsigned int grain,
+    void (*func)(void*, const void*, void*), void* context) {
+  rsv_parallel_container_t adapter;
+
+  if (destination->capacity < source->amount) {
+    void* data =
+        realloc(destination->data, source->amount * destination->element_size);
+
+    if (data == NULL) {
+      return ENOMEM;
+    }
+
+    RSV_STATS_RESIZE(destination->stats);
+    RSV_STATS_REALLOCATE(
+        destination->stats,
+        (size_t)destination->capacity * destination->element_size,
+        (size_t)source->amount * destination->element_size);
+    destination->data = data;
+    destination->capacity = source->amount;
+  }
+
+  destination->amount = source->amount;
+
+  memset(&adapter, 0, sizeof(adapter));
+  adapter.container = source;
+  adapter.output = destination;
+  adapter.map_func = func;
+  adapter.context = context;
+
+  return rsv_parallel_for(pool, 0, source->amount, grain,
+                          rsv_parallel_dynamic_array_map_body, &adapter);
+}
+
+/**
+ * @brief Reduces the elements of a dynamic array in parallel.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param array Pointer to the dynamic array.
+ * @param grain Amount of elements per chunk, or 0 to pick one automatically.
+ * @param result Pointer to the result, which must hold the identity value of
+ * the reduction on entry.
+ * @param result_size Size of the result in memory.
+ * @param func Function called with the context, a partial result and a
+ * pointer to the element, to fold the element into the partial. The last
+ * argument is always NULL.
+ * @param combine Function called with the context, the result and a partial
+ * result to fold the partial into the result.
+ * @param context Pointer passed to every call of func and combine.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_parallel_reduce_dynamic_array(
+    rsv_thread_pool_t* pool, rsv_dynamic_array_t* array, unsigned int grain,
+    void* result, unsigned int result_size,
+    void (*func)(void*, void*, const void*, const void*),
+    void (*combine)(void*, void*, const void*), void* context) {
+  rsv_parallel_container_t adapter;
+
+  memset(&adapter, 0, sizeof(adapter));
+  adapter.container = array;
+  adapter.fold_func = func;
+  adapter.context = context;
+
+  return rsv_parallel_reduce(
+      pool, 0, array->amount, grain, result, result_size,
+      rsv_parallel_dynamic_array_reduce_body, combine, &adapter);
+}
+
+/**
+ * @brief Calls a function on every entry of a hash table in parallel. The
+ * bucket range of the table is split into chunks.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param hash_table Pointer to the hash table.
+ * @param grain Amount of buckets per chunk, or 0 to pick one automatically.
+ * @param func Function called with the context, a pointer to the key and a
+ * pointer to the value.
+ * @param context Pointer passed to every call of the function.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_parallel_for_hash_table(
+    rsv_thread_pool_t* pool, rsv_hash_table_t* hash_table, unsigned int grain,
+    void (*func)(void*, const void*, void*), void* context) {
+  rsv_parallel_container_t adapter;
+
+  memset(&adapter, 0, sizeof(adapter));
+  adapter.container = hash_table;
+  adapter.entry_func = func;
+  adapter.context = context;
+
+  return rsv_parallel_for(pool, 0, hash_table->capacity, grain,
+                          rsv_parallel_hash_table_for_body, &adapter);
+}
+
+/**
+ * @brief Reduces the entries of a hash table in parallel.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param hash_table Pointer to the hash table.
+ * @param grain Amount of buckets per chunk, or 0 to pick one automatically.
+ * @param result Pointer to the result, which must hold the identity value of
+ * the reduction on entry.
+ * @param result_size Size of the result in memory.
+ * @param func Function called with the context, a partial result, a pointer
+ * to the key and a pointer to the value, to fold the entry into the partial.
+ * @param combine Function called with the context, the result and a partial
+ * result to fold the partial into the result.
+ * @param context Pointer passed to every call of func and combine.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_parallel_reduce_hash_table(
+    rsv_thread_pool_t* pool, rsv_hash_table_t* hash_table, unsigned int grain,
+    void* result, unsigned int result_size,
+    void (*func)(void*, void*, const void*, const void*),
+    void (*combine)(void*, void*, const void*), void* context) {
+  rsv_parallel_container_t adapter;
+
+  memset(&adapter, 0, sizeof(adapter));
+  adapter.container = hash_table;
+  adapter.fold_func = func;
+  adapter.context = context;
+
+  return rsv_parallel_reduce(pool, 0, hash_table->capacity, grain, result,
+                             result_size, rsv_parallel_hash_table_reduce_body,
+                             combine, &adapter);
+}
+
+/**
+ * @brief Calls a function on every element of a hash set in parallel. The
+ * bucket range of the set is split into chunks.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param hash_set Pointer to the hash set.
+ * @param grain Amount of buckets per chunk, or 0 to pick one automatically.
+ * @param func Function called with the context and a pointer to the element.
+ * The last argument is always NULL.
+ * @param context Pointer passed to every call of the function.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_parallel_for_hash_set(rsv_thread_pool_t* pool,
+                                            rsv_hash_set_t* hash_set,
+                                            unsigned int grain,
+                                            void (*func)(void*, const void*,
+                                                         void*),
+                                            void* context) {
+  rsv_parallel_container_t adapter;
+
+  memset(&adapter, 0, sizeof(adapter));
+  adapter.container = hash_set;
+  adapter.entry_func = func;
+  adapter.context = context;
+
+  return rsv_parallel_for(pool, 0, hash_set->capacity, grain,
+                          rsv_parallel_hash_set_for_body, &adapter);
+}
+
+/**
+ * @brief Reduces the elements of a hash set in parallel.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param hash_set Pointer to the hash set.
+ * @param grain Amount of buckets per chunk, or 0 to pick one automatically.
+ * @param result Pointer to the result, which must hold the identity value of
+ * the reduction on entry.
+ * @param result_size Size of the result in memory.
+ * @param func Function called with the context, a partial result and a
+ * pointer to the element, to fold the element into the partial. The last
+ * argument is always NULL.
+ * @param combine Function called with the context, the result and a partial
+ * result to fold the partial into the result.
+ * @param context Pointer passed to every call of func and combine.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_parallel_reduce_hash_set(
+    rsv_thread_pool_t* pool, rsv_hash_set_t* hash_set, unsigned int grain,
+    void* result, unsigned int result_size,
+    void (*func)(void*, void*, const void*, const void*),
+    void (*combine)(void*, void*, const void*), void* context) {
+  rsv_parallel_container_t adapter;
+
+  memset(&adapter, 0, sizeof(adapter));
+  adapter.container = hash_set;
+  adapter.fold_func = func;
+  adapter.context = context;
+
+  return rsv_parallel_reduce(pool, 0, hash_set->capacity, grain, result,
+                             result_size, rsv_parallel_hash_set_reduce_body,
+                             combine, &adapter);
+}
+
+#endif /* RSV_PARALLEL_H */
+
+#endif
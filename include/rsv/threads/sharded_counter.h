@@ -0,0 +1,162 @@
+/*
+  sharded_counter.h
+  Implementation of a scalable counter sharded per CPU
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#if defined(__unix__)
+
+#ifndef RSV_SHARDED_COUNTER_H
+#define RSV_SHARDED_COUNTER_H
+
+#include "atomic.h"
+#include "threads_pthreads.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief A shard of a sharded counter. Should not be directly used unless
+ * necessary.
+ *
+ */
+typedef struct rsv_sharded_counter_shard_t {
+  long value;
+} RSV_CACHE_ALIGNED rsv_sharded_counter_shard_t;
+
+/**
+ * @brief A counter split into cache line sized shards. Threads running on
+ * different CPUs add to different shards, so increments do not contend, and
+ * reading the counter sums every shard.
+ *
+ */
+typedef struct rsv_sharded_counter_t {
+  /**
+   * @brief The shards of the counter.
+   *
+   */
+  rsv_sharded_counter_shard_t* shards;
+  /**
+   * @brief The amount of shards, always a power of two.
+   *
+   */
+  unsigned int shard_amount;
+} rsv_sharded_counter_t;
+
+/**
+ * @brief Creates a sharded counter starting at zero.
+ *
+ * @param counter Pointer to the counter to initialize.
+ * @param shard_amount Amount of shards, rounded up to a power of two, or 0 to
+ * use one per online CPU.
+ * @return 0 on success, or ENOMEM if the shards could not be allocated.
+ */
+static inline int rsv_sharded_counter_create(rsv_sharded_counter_t* counter,
+                                             unsigned int shard_amount) {
+  unsigned int amount = 1;
+  void* shards;
+
+  if (shard_amount == 0) {
+    long cpu_amount = sysconf(_SC_NPROCESSORS_ONLN);
+    shard_amount = cpu_amount > 0 ? (unsigned int)cpu_amount : 1;
+  }
+
+  while (amount < shard_amount) {
+    amount *= 2;
+  }
+
+  if (posix_memalign(&shards, RSV_CACHE_LINE_SIZE,
+                     amount * sizeof(rsv_sharded_counter_shard_t)) != 0) {
+    return ENOMEM;
+  }
+
+  memset(shards, 0, amount * sizeof(rsv_sharded_counter_shard_t));
+  counter->shards = (rsv_sharded_counter_shard_t*)shards;
+  counter->shard_amount = amount;
+
+  return 0;
+}
+
+/**
+ * @brief Destroys a sharded counter, freeing all associated memory.
+ *
+ * @param counter Pointer to the counter to destroy.
+ */
+static inline void rsv_sharded_counter_destroy(rsv_sharded_counter_t* counter) {
+  free(counter->shards);
+  counter->shards = NULL;
+  counter->shard_amount = 0;
+}
+
+/**
+ * @brief Gets the shard the calling thread should add to. Uses the current
+ * CPU where the platform exposes it, and a hash of the thread otherwise.
+ *
+ * @param counter Pointer to the counter.
+ * @return Pointer to the shard.
+ */
+static inline rsv_sharded_counter_shard_t*
+rsv_sharded_counter_shard(rsv_sharded_counter_t* counter) {
+  unsigned int index;
+
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+  int cpu = sched_getcpu();
+
+  if (cpu >= 0) {
+    index = (unsigned int)cpu;
+  } else
+#endif
+  {
+    pthread_t self = pthread_self();
+    const unsigned char* bytes = (const unsigned char*)&self;
+    unsigned int i;
+
+    index = 2166136261u;
+
+    for (i = 0; i < sizeof(self); ++i) {
+      index = (index ^ bytes[i]) * 16777619u;
+    }
+  }
+
+  return &counter->shards[index & (counter->shard_amount - 1)];
+}
+
+/**
+ * @brief Adds a value to a sharded counter.
+ *
+ * @param counter Pointer to the counter.
+ * @param value Value to add, may be negative.
+ */
+static inline void rsv_sharded_counter_add(rsv_sharded_counter_t* counter,
+                                           long value) {
+  rsv_atomic_fetch_add(&rsv_sharded_counter_shard(counter)->value, value,
+                       RSV_MEMORY_ORDER_RELAXED);
+}
+
+/**
+ * @brief Gets the value of a sharded counter by summing its shards.
+ *
+ * Concurrent additions may or may not be included, but once every adding
+ * thread has been joined the value is exact.
+ *
+ * @param counter Pointer to the counter.
+ * @return The value of the counter.
+ */
+static inline long rsv_sharded_counter_get(rsv_sharded_counter_t* counter) {
+  long sum = 0;
+  unsigned int i;
+
+  for (i = 0; i < counter->shard_amount; ++i) {
+    sum += rsv_atomic_load(&counter->shards[i].value, RSV_MEMORY_ORDER_RELAXED);
+  }
+
+  return sum;
+}
+
+#endif /* RSV_SHARDED_COUNTER_H */
+
+#endif
@@ -0,0 +1,752 @@
+/*
+  thread_pool.h
+  Implementation of a work-stealing thread pool
+
+  Reservoir Library
+  MIT License - https://choosealicense.com/licenses/mit/
+*/
+
+#if defined(__unix__)
+
+#ifndef RSV_THREAD_POOL_H
+#define RSV_THREAD_POOL_H
+
+#include "atomic.h"
+#include "threads_pthreads.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define RSV_THREAD_POOL_DEQUE_CAPACITY 256
+#define RSV_THREAD_POOL_SPIN_AMOUNT 64
+
+/**
+ * @brief A handle which tracks the completion of a group of submitted tasks.
+ *
+ */
+typedef struct rsv_thread_pool_wait_t {
+  /**
+   * @brief The amount of tasks in the group which have not finished yet.
+   *
+   */
+  long pending;
+  rsv_mutex_t mutex;
+  pthread_cond_t condition;
+} rsv_thread_pool_wait_t;
+
+/**
+ * @brief A thread pool task. Should not be directly used unless necessary.
+ *
+ */
+typedef struct rsv_thread_pool_task_t {
+  void (*func)(void*);
+  void* arg;
+  rsv_thread_pool_wait_t* wait;
+  struct rsv_thread_pool_task_t* next;
+} rsv_thread_pool_task_t;
+
+/**
+ * @brief The circular buffer of a work-stealing deque. Should not be directly
+ * used unless necessary.
+ *
+ */
+typedef struct rsv_thread_pool_buffer_t {
+  long capacity;
+  rsv_thread_pool_task_t** tasks;
+  /**
+   * @brief The buffer this one replaced. Thieves may still be reading from it,
+   * so it is kept alive until the pool is destroyed.
+   *
+   */
+  struct rsv_thread_pool_buffer_t* previous;
+} rsv_thread_pool_buffer_t;
+
+/**
+ * @brief A worker of a thread pool, owning a Chase-Lev work-stealing deque.
+ * Should not be directly used unless necessary.
+ *
+ */
+typedef struct rsv_thread_pool_worker_t {
+  long top RSV_CACHE_ALIGNED;
+  long bottom RSV_CACHE_ALIGNED;
+  rsv_thread_pool_buffer_t* buffer;
+  struct rsv_thread_pool_t* pool;
+  rsv_thread_t thread;
+  unsigned int index;
+  unsigned int seed;
+} RSV_CACHE_ALIGNED rsv_thread_pool_worker_t;
+
+/**
+ * @brief A persistent pool of worker threads which run submitted tasks. Idle
+ * workers steal tasks from busy ones.
+ *
+ */
+typedef struct rsv_thread_pool_t {
+  /**
+   * @brief The workers of the thread pool.
+   *
+   */
+  rsv_thread_pool_worker_t* workers;
+  /**
+   * @brief The amount of workers in the thread pool.
+   *
+   */
+  unsigned int worker_amount;
+  /**
+   * @brief The amount of tasks which have been submitted but not yet started.
+   *
+   */
+  long pending RSV_CACHE_ALIGNED;
+  long sleeping;
+  int stop;
+  rsv_thread_pool_task_t* injector_head;
+  rsv_thread_pool_task_t* injector_tail;
+  rsv_mutex_t injector_mutex;
+  rsv_mutex_t sleep_mutex;
+  pthread_cond_t sleep_condition;
+  pthread_key_t worker_key;
+} rsv_thread_pool_t;
+
+/**
+ * @brief Creates a wait handle for a group of tasks.
+ *
+ * @param wait Pointer to the wait handle to initialize.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_thread_pool_wait_create(rsv_thread_pool_wait_t* wait) {
+  int result;
+
+  wait->pending = 0;
+  result = rsv_mutex_create(&wait->mutex);
+
+  if (result != 0) {
+    return result;
+  }
+
+  result = pthread_cond_init(&wait->condition, NULL);
+
+  if (result != 0) {
+    rsv_mutex_destroy(&wait->mutex);
+  }
+
+  return result;
+}
+
+/**
+ * @brief Destroys a wait handle. All of its tasks must have finished.
+ *
+ * @param wait Pointer to the wait handle to destroy.
+ */
+static inline void rsv_thread_pool_wait_destroy(rsv_thread_pool_wait_t* wait) {
+  pthread_cond_destroy(&wait->condition);
+  rsv_mutex_destroy(&wait->mutex);
+}
+
+/**
+ * @brief Marks one task of a wait handle as finished.
+ *
+ * The count only reaches zero while holding the mutex, so a waiter which sees
+ * zero under the mutex knows no finishing task still touches the handle.
+ *
+ * @param wait Pointer to the wait handle.
+ */
+static inline void rsv_thread_pool_wait_finish(rsv_thread_pool_wait_t* wait) {
+  long pending = rsv_atomic_load(&wait->pending, RSV_MEMORY_ORDER_RELAXED);
+
+  while (pending > 1) {
+    if (rsv_atomic_compare_exchange_weak(&wait->pending, &pending, pending - 1,
+                                         RSV_MEMORY_ORDER_ACQ_REL,
+                                         RSV_MEMORY_ORDER_RELAXED)) {
+      return;
+    }
+  }
+
+  rsv_mutex_lock(&wait->mutex);
+
+  if (rsv_atomic_fetch_sub(&wait->pending, 1, RSV_MEMORY_ORDER_ACQ_REL) == 1) {
+    pthread_cond_broadcast(&wait->condition);
+  }
+
+  rsv_mutex_unlock(&wait->mutex);
+}
+
+/**
+ * @brief Allocates the circular buffer of a work-stealing deque.
+ *
+ * @param capacity Capacity of the buffer, must be a power of two.
+ * @return Pointer to the buffer, or NULL if out of memory.
+ */
+static inline rsv_thread_pool_buffer_t*
+rsv_thread_pool_buffer_create(long capacity) {
+  rsv_thread_pool_buffer_t* buffer =
+      (rsv_thread_pool_buffer_t*)malloc(sizeof(rsv_thread_pool_buffer_t));
+
+  if (buffer == NULL) {
+    return NULL;
+  }
+
+  buffer->tasks = (rsv_thread_pool_task_t**)malloc(
+      capacity * sizeof(rsv_thread_pool_task_t*));
+
+  if (buffer->tasks == NULL) {
+    free(buffer);
+    return NULL;
+  }
+
+  buffer->capacity = capacity;
+  buffer->previous = NULL;
+
+  return buffer;
+}
+
+/**
+ * @brief Pushes a task to the bottom of a worker's deque. Must only be called
+ * by the worker owning the deque.
+ *
+ * @param worker Pointer to the worker owning the deque.
+ * @param task Pointer to the task to push.
+ * @return 0 on success, or ENOMEM if the deque could not grow.
+ */
+static inline int rsv_thread_pool_deque_push(rsv_thread_pool_worker_t* worker,
+                                             rsv_thread_pool_task_t* task) {
+  long bottom = rsv_atomic_load(&worker->bottom, RSV_MEMORY_ORDER_RELAXED);
+  long top = rsv_atomic_load(&worker->top, RSV_MEMORY_ORDER_ACQUIRE);
+  rsv_thread_pool_buffer_t* buffer =
+      rsv_atomic_load(&worker->buffer, RSV_MEMORY_ORDER_RELAXED);
+
+  if (bottom - top > buffer->capacity - 1) {
+    rsv_thread_pool_buffer_t* grown =
+        rsv_thread_pool_buffer_create(buffer->capacity * 2);
+    long i;
+
+    if (grown == NULL) {
+      return ENOMEM;
+    }
+
+    for (i = top; i < bottom; ++i) {
+      grown->tasks[i & (grown->capacity - 1)] = rsv_atomic_load(
+          &buffer->tasks[i & (buffer->capacity - 1)], RSV_MEMORY_ORDER_RELAXED);
+    }
+
+    grown->previous = buffer;
+    rsv_atomic_store(&worker->buffer, grown, RSV_MEMORY_ORDER_RELEASE);
+    buffer = grown;
+  }
+
+  rsv_atomic_store(&buffer->tasks[bottom & (buffer->capacity - 1)], task,
+                   RSV_MEMORY_ORDER_RELAXED);
+  rsv_atomic_store(&worker->bottom, bottom + 1, RSV_MEMORY_ORDER_RELEASE);
+
+  return 0;
+}
+
+/**
+ * @brief Takes a task from the bottom of a worker's deque. Must only be called
+ * by the worker owning the deque.
+ *
+ * @param worker Pointer to the worker owning the deque.
+ * @return Pointer to the task, or NULL if the deque is empty.
+ */
+static inline rsv_thread_pool_task_t*
+rsv_thread_pool_deque_take(rsv_thread_pool_worker_t* worker) {
+  long bottom = rsv_atomic_load(&worker->bottom, RSV_MEMORY_ORDER_RELAXED) - 1;
+  rsv_thread_pool_buffer_t* buffer =
+      rsv_atomic_load(&worker->buffer, RSV_MEMORY_ORDER_RELAXED);
+  rsv_thread_pool_task_t* task = NULL;
+  long top;
+
+  rsv_atomic_store(&worker->bottom, bottom, RSV_MEMORY_ORDER_RELAXED);
+  rsv_atomic_thread_fence(RSV_MEMORY_ORDER_SEQ_CST);
+  top = rsv_atomic_load(&worker->top, RSV_MEMORY_ORDER_RELAXED);
+
+  if (top <= bottom) {
+    task = rsv_atomic_load(&buffer->tasks[bottom & (buffer->capacity - 1)],
+                           RSV_MEMORY_ORDER_RELAXED);
+
+    if (top == bottom) {
+      /* Last task, race against thieves for it */
+      if (!rsv_atomic_compare_exchange(&worker->top, &top, top + 1,
+                                       RSV_MEMORY_ORDER_SEQ_CST,
+                                       RSV_MEMORY_ORDER_RELAXED)) {
+        task = NULL;
+      }
+
+      rsv_atomic_store(&worker->bottom, bottom + 1, RSV_MEMORY_ORDER_RELAXED);
+    }
+  } else {
+    rsv_atomic_store(&worker->bottom, bottom + 1, RSV_MEMORY_ORDER_RELAXED);
+  }
+
+  return task;
+}
+
+/**
+ * @brief Steals a task from the top of a worker's deque. Can be called by any
+ * thread.
+ *
+ * @param worker Pointer to the worker to steal from.
+ * @return Pointer to the task, or NULL if the deque is empty or the steal lost
+ * a race.
+ */
+static inline rsv_thread_pool_task_t*
+rsv_thread_pool_deque_steal(rsv_thread_pool_worker_t* worker) {
+  long top = rsv_atomic_load(&worker->top, RSV_MEMORY_ORDER_ACQUIRE);
+  long bottom;
+
+  rsv_atomic_thread_fence(RSV_MEMORY_ORDER_SEQ_CST);
+  bottom = rsv_atomic_load(&worker->bottom, RSV_MEMORY_ORDER_ACQUIRE);
+
+  if (top < bottom) {
+    rsv_thread_pool_buffer_t* buffer =
+        rsv_atomic_load(&worker->buffer, RSV_MEMORY_ORDER_ACQUIRE);
+    rsv_thread_pool_task_t* task = rsv_atomic_load(
+        &buffer->tasks[top & (buffer->capacity - 1)], RSV_MEMORY_ORDER_RELAXED);
+
+    if (rsv_atomic_compare_exchange(&worker->top, &top, top + 1,
+                                    RSV_MEMORY_ORDER_SEQ_CST,
+                                    RSV_MEMORY_ORDER_RELAXED)) {
+      return task;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Gets the worker of the pool running on the calling thread.
+ *
+ * @param pool Pointer to the thread pool.
+ * @return Pointer to the worker, or NULL if the calling thread is not a worker
+ * of the pool.
+ */
+static inline rsv_thread_pool_worker_t*
+rsv_thread_pool_current_worker(rsv_thread_pool_t* pool) {
+  rsv_thread_pool_worker_t* worker =
+      (rsv_thread_pool_worker_t*)pthread_getspecific(pool->worker_key);
+
+  if (worker == NULL || worker->pool != pool) {
+    return NULL;
+  }
+
+  return worker;
+}
+
+/**
+ * @brief Gets the index of the worker running on the calling thread.
+ *
+ * @param pool Pointer to the thread pool.
+ * @return Index of the worker in [0, worker_amount), or -1 if the calling
+ * thread is not a worker of the pool.
+ */
+static inline int rsv_thread_pool_worker_index(rsv_thread_pool_t* pool) {
+  rsv_thread_pool_worker_t* worker = rsv_thread_pool_current_worker(pool);
+
+  return worker ? (int)worker->index : -1;
+}
+
+/**
+ * @brief Finds a task to run, looking at the calling worker's own deque, then
+ * the shared injection queue, then the other workers' deques.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param worker Pointer to the calling worker, or NULL if not a worker.
+ * @return Pointer to the task, or NULL if none was found.
+ */
+static inline rsv_thread_pool_task_t*
+rsv_thread_pool_find_task(rsv_thread_pool_t* pool,
+                          rsv_thread_pool_worker_t* worker) {
+  rsv_thread_pool_task_t* task = NULL;
+  unsigned int start = 0;
+  unsigned int i;
+
+  if (worker) {
+    task = rsv_thread_pool_deque_take(worker);
+
+    if (task) {
+      return task;
+    }
+  }
+
+  if (rsv_atomic_load(&pool->injector_head, RSV_MEMORY_ORDER_RELAXED)) {
+    rsv_mutex_lock(&pool->injector_mutex);
+    task = pool->injector_head;
+
+    if (task) {
+      rsv_atomic_store(&pool->injector_head, task->next,
+                       RSV_MEMORY_ORDER_RELAXED);
+
+      if (pool->injector_head == NULL) {
+        pool->injector_tail = NULL;
+      }
+    }
+
+    rsv_mutex_unlock(&pool->injector_mutex);
+
+    if (task) {
+      return task;
+    }
+  }
+
+  if (worker) {
+    /* xorshift to spread thieves over victims */
+    worker->seed ^= worker->seed << 13;
+    worker->seed ^= worker->seed >> 17;
+    worker->seed ^= worker->seed << 5;
+    start = worker->seed;
+  }
+
+  for (i = 0; i < pool->worker_amount; ++i) {
+    rsv_thread_pool_worker_t* victim =
+        &pool->workers[(start + i) % pool->worker_amount];
+
+    if (victim == worker) {
+      continue;
+    }
+
+    task = rsv_thread_pool_deque_steal(victim);
+
+    if (task) {
+      return task;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Runs a task and releases it.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param task Pointer to the task to run.
+ */
+static inline void rsv_thread_pool_run_task(rsv_thread_pool_t* pool,
+                                            rsv_thread_pool_task_t* task) {
+  rsv_thread_pool_wait_t* wait = task->wait;
+
+  rsv_atomic_fetch_sub(&pool->pending, 1, RSV_MEMORY_ORDER_SEQ_CST);
+  task->func(task->arg);
+  free(task);
+
+  if (wait) {
+    rsv_thread_pool_wait_finish(wait);
+  }
+}
+
+/**
+ * @brief The start routine of every worker thread.
+ *
+ * @param arg Pointer to the worker.
+ * @return Always NULL.
+ */
+static inline void* rsv_thread_pool_worker_main(void* arg) {
+  rsv_thread_pool_worker_t* worker = (rsv_thread_pool_worker_t*)arg;
+  rsv_thread_pool_t* pool = worker->pool;
+  unsigned int spins = 0;
+
+  pthread_setspecific(pool->worker_key, worker);
+
+  for (;;) {
+    rsv_thread_pool_task_t* task = rsv_thread_pool_find_task(pool, worker);
+
+    if (task) {
+      rsv_thread_pool_run_task(pool, task);
+      spins = 0;
+      continue;
+    }
+
+    if (rsv_atomic_load(&pool->stop, RSV_MEMORY_ORDER_ACQUIRE) &&
+        rsv_atomic_load(&pool->pending, RSV_MEMORY_ORDER_SEQ_CST) == 0) {
+      break;
+    }
+
+    if (++spins < RSV_THREAD_POOL_SPIN_AMOUNT) {
+      sched_yield();
+      continue;
+    }
+
+    /* Park until a submitter sees us sleeping or a task is pending */
+    rsv_mutex_lock(&pool->sleep_mutex);
+    rsv_atomic_fetch_add(&pool->sleeping, 1, RSV_MEMORY_ORDER_SEQ_CST);
+
+    while (rsv_atomic_load(&pool->pending, RSV_MEMORY_ORDER_SEQ_CST) == 0 &&
+           !rsv_atomic_load(&pool->stop, RSV_MEMORY_ORDER_ACQUIRE)) {
+      pthread_cond_wait(&pool->sleep_condition,
+                        rsv_mutex_native(&pool->sleep_mutex));
+    }
+
+    rsv_atomic_fetch_sub(&pool->sleeping, 1, RSV_MEMORY_ORDER_SEQ_CST);
+    rsv_mutex_unlock(&pool->sleep_mutex);
+    spins = 0;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Wakes a parked worker if there is any.
+ *
+ * @param pool Pointer to the thread pool.
+ */
+static inline void rsv_thread_pool_wake(rsv_thread_pool_t* pool) {
+  if (rsv_atomic_load(&pool->sleeping, RSV_MEMORY_ORDER_SEQ_CST) > 0) {
+    rsv_mutex_lock(&pool->sleep_mutex);
+    pthread_cond_signal(&pool->sleep_condition);
+    rsv_mutex_unlock(&pool->sleep_mutex);
+  }
+}
+
+/**
+ * @brief Stops the workers of a thread pool and frees its resources.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param thread_amount Amount of worker threads which were started.
+ */
+static inline void rsv_thread_pool_shutdown(rsv_thread_pool_t* pool,
+                                            unsigned int thread_amount) {
+  unsigned int i;
+
+  rsv_mutex_lock(&pool->sleep_mutex);
+  rsv_atomic_store(&pool->stop, 1, RSV_MEMORY_ORDER_RELEASE);
+  pthread_cond_broadcast(&pool->sleep_condition);
+  rsv_mutex_unlock(&pool->sleep_mutex);
+
+  for (i = 0; i < thread_amount; ++i) {
+    rsv_thread_join(pool->workers[i].thread, NULL);
+  }
+
+  for (i = 0; i < pool->worker_amount; ++i) {
+    rsv_thread_pool_buffer_t* buffer = pool->workers[i].buffer;
+
+    while (buffer) {
+      rsv_thread_pool_buffer_t* previous = buffer->previous;
+      free(buffer->tasks);
+      free(buffer);
+      buffer = previous;
+    }
+  }
+
+  pthread_key_delete(pool->worker_key);
+  pthread_cond_destroy(&pool->sleep_condition);
+  rsv_mutex_destroy(&pool->sleep_mutex);
+  rsv_mutex_destroy(&pool->injector_mutex);
+  free(pool->workers);
+  pool->workers = NULL;
+  pool->worker_amount = 0;
+}
+
+/**
+ * @brief Destroys a thread pool. Tasks which were already submitted are run
+ * to completion before the workers exit.
+ *
+ * @param pool Pointer to the thread pool to destroy.
+ */
+static inline void rsv_thread_pool_destroy(rsv_thread_pool_t* pool) {
+  rsv_thread_pool_shutdown(pool, pool->worker_amount);
+}
+
+/**
+ * @brief Creates a thread pool and starts its workers.
+ *
+ * @param pool Pointer to the thread pool to initialize.
+ * @param worker_amount Amount of worker threads, or 0 to use one per CPU the
+ * calling thread may run on.
+ * @param pin_workers Non-zero to pin worker i to the i-th CPU the calling
+ * thread may run on (modulo the CPU count) where the platform supports it.
+ * @return 0 on success, or an error code on failure.
+ */
+static inline int rsv_thread_pool_create(rsv_thread_pool_t* pool,
+                                         unsigned int worker_amount,
+                                         int pin_workers) {
+  rsv_cpu_set_t allowed;
+  unsigned int cpu = 0;
+  void* workers;
+  unsigned int i;
+  int result;
+
+  /* Without an affinity mask, assume the online CPUs are 0 to n - 1 */
+  if (rsv_thread_get_affinity(pthread_self(), &allowed) != 0 ||
+      rsv_cpu_set_amount(&allowed) == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+    rsv_cpu_set_clear(&allowed);
+    rsv_cpu_set_add(&allowed, 0);
+
+    for (i = 1; i < online; ++i) {
+      rsv_cpu_set_add(&allowed, i);
+    }
+  }
+
+  if (worker_amount == 0) {
+    worker_amount = rsv_cpu_set_amount(&allowed);
+  }
+
+  pool->pending = 0;
+  pool->sleeping = 0;
+  pool->stop = 0;
+  pool->injector_head = NULL;
+  pool->injector_tail = NULL;
+  pool->worker_amount = 0;
+
+  if (posix_memalign(&workers, RSV_CACHE_LINE_SIZE,
+                     worker_amount * sizeof(rsv_thread_pool_worker_t)) != 0) {
+    return ENOMEM;
+  }
+
+  pool->workers = (rsv_thread_pool_worker_t*)workers;
+
+  rsv_mutex_create(&pool->injector_mutex);
+  rsv_mutex_create(&pool->sleep_mutex);
+  pthread_cond_init(&pool->sleep_condition, NULL);
+  result = pthread_key_create(&pool->worker_key, NULL);
+
+  if (result != 0) {
+    pthread_cond_destroy(&pool->sleep_condition);
+    rsv_mutex_destroy(&pool->sleep_mutex);
+    rsv_mutex_destroy(&pool->injector_mutex);
+    free(pool->workers);
+    return result;
+  }
+
+  /* Every deque must exist before the first worker starts stealing */
+  for (i = 0; i < worker_amount; ++i) {
+    rsv_thread_pool_worker_t* worker = &pool->workers[i];
+
+    worker->top = 0;
+    worker->bottom = 0;
+    worker->pool = pool;
+    worker->index = i;
+    worker->seed = 2463534242u + i * 2654435761u;
+    worker->buffer =
+        rsv_thread_pool_buffer_create(RSV_THREAD_POOL_DEQUE_CAPACITY);
+
+    if (worker->buffer == NULL) {
+      pool->worker_amount = i;
+      rsv_thread_pool_shutdown(pool, 0);
+      return ENOMEM;
+    }
+  }
+
+  pool->worker_amount = worker_amount;
+
+  for (i = 0; i < worker_amount; ++i) {
+    rsv_thread_attributes_t attributes;
+    char name[32];
+
+    rsv_thread_attributes_create(&attributes);
+    snprintf(name, sizeof(name), "rsv-worker-%u", i);
+    attributes.name = name;
+
+    /* Walk the allowed CPUs in order, wrapping around past the last one */
+    if (pin_workers) {
+      while (!rsv_cpu_set_has(&allowed, cpu)) {
+        cpu = (cpu + 1) % RSV_CPU_SET_SIZE;
+      }
+
+      rsv_cpu_set_add(&attributes.cpus, cpu);
+      cpu = (cpu + 1) % RSV_CPU_SET_SIZE;
+    }
+
+    result = rsv_thread_create_ex(&pool->workers[i].thread, &attributes,
+                                  rsv_thread_pool_worker_main,
+                                  &pool->workers[i]);
+
+    if (result != 0) {
+      rsv_thread_pool_shutdown(pool, i);
+      return result;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Submits a task to the thread pool.
+ *
+ * When called from one of the pool's own tasks, the task is pushed onto the
+ * calling worker's deque, otherwise it goes through a shared queue.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param wait Pointer to a wait handle which tracks the task, or NULL.
+ * @param func Function to run.
+ * @param arg Argument passed to the function.
+ * @return 0 on success, or ENOMEM if the task could not be allocated.
+ */
+static inline int rsv_thread_pool_submit(rsv_thread_pool_t* pool,
+                                         rsv_thread_pool_wait_t* wait,
+                                         void (*func)(void*), void* arg) {
+  rsv_thread_pool_worker_t* worker = rsv_thread_pool_current_worker(pool);
+  rsv_thread_pool_task_t* task =
+      (rsv_thread_pool_task_t*)malloc(sizeof(rsv_thread_pool_task_t));
+
+  if (task == NULL) {
+    return ENOMEM;
+  }
+
+  task->func = func;
+  task->arg = arg;
+  task->wait = wait;
+  task->next = NULL;
+
+  if (wait) {
+    rsv_atomic_fetch_add(&wait->pending, 1, RSV_MEMORY_ORDER_RELAXED);
+  }
+
+  rsv_atomic_fetch_add(&pool->pending, 1, RSV_MEMORY_ORDER_SEQ_CST);
+
+  if (worker == NULL || rsv_thread_pool_deque_push(worker, task) != 0) {
+    rsv_mutex_lock(&pool->injector_mutex);
+
+    if (pool->injector_tail) {
+      pool->injector_tail->next = task;
+    } else {
+      rsv_atomic_store(&pool->injector_head, task, RSV_MEMORY_ORDER_RELAXED);
+    }
+
+    pool->injector_tail = task;
+    rsv_mutex_unlock(&pool->injector_mutex);
+  }
+
+  rsv_thread_pool_wake(pool);
+
+  return 0;
+}
+
+/**
+ * @brief Waits for every task tracked by a wait handle to finish.
+ *
+ * A worker calling this from inside a task keeps running other tasks while it
+ * waits, so nested waits cannot deadlock the pool.
+ *
+ * @param pool Pointer to the thread pool.
+ * @param wait Pointer to the wait handle.
+ */
+static inline void rsv_thread_pool_wait(rsv_thread_pool_t* pool,
+                                        rsv_thread_pool_wait_t* wait) {
+  rsv_thread_pool_worker_t* worker = rsv_thread_pool_current_worker(pool);
+
+  if (worker) {
+    while (rsv_atomic_load(&wait->pending, RSV_MEMORY_ORDER_ACQUIRE) > 0) {
+      rsv_thread_pool_task_t* task = rsv_thread_pool_find_task(pool, worker);
+
+      if (task) {
+        rsv_thread_pool_run_task(pool, task);
+      } else {
+        sched_yield();
+      }
+    }
+  }
+
+  rsv_mutex_lock(&wait->mutex);
+
+  while (rsv_atomic_load(&wait->pending, RSV_MEMORY_ORDER_ACQUIRE) > 0) {
+    pthread_cond_wait(&wait->condition, rsv_mutex_native(&wait->mutex));
+  }
+
+  rsv_mutex_unlock(&wait->mutex);
+}
+
+#endif /* RSV_THREAD_POOL_H */
+
+#endif
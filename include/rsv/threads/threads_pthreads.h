@@ -1,6 +1,6 @@
 /*
   threads_pthreads.h
-  Contains wrappers for pthreads api
+  Contains wrappers for pthreads api and synchronization primitives
 
   Reservoir Library
   MIT License - https://choosealicense.com/licenses/mit/
@@ -11,10 +11,188 @@
 #ifndef RSV_THREADS_UNIX_H
 #define RSV_THREADS_UNIX_H
 
+#include "../stats.h"
+#include "atomic.h"
+#include <errno.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(RSV_STATS)
+#include <time.h>
+#endif
+
+/**
+ * @brief Size in bytes of a cache line on the targeted hardware.
+ *
+ */
+#define RSV_CACHE_LINE_SIZE 64
+
+/**
+ * @brief Aligns a type or variable to a cache line so that it does not share
+ * one with its neighbours (false sharing).
+ *
+ */
+#define RSV_CACHE_ALIGNED __attribute__((aligned(RSV_CACHE_LINE_SIZE)))
+
+#define RSV_ADAPTIVE_MUTEX_SPIN_AMOUNT 100
+#define RSV_BARRIER_SERIAL_THREAD PTHREAD_BARRIER_SERIAL_THREAD
+#define RSV_ONCE_INIT {PTHREAD_ONCE_INIT}
+#define RSV_CPU_SET_SIZE 1024
+#define RSV_THREAD_NAME_SIZE 16
 
 typedef pthread_t rsv_thread_t;
+
+#if defined(RSV_STATS)
+/**
+ * @brief Statistics of a rsv_mutex_t, only present when built with RSV_STATS.
+ *
+ */
+typedef struct rsv_mutex_stats_t {
+  /**
+   * @brief The amount of times the mutex was locked.
+   *
+   */
+  unsigned long long locks;
+  /**
+   * @brief The amount of locks which found the mutex already held.
+   *
+   */
+  unsigned long long contended;
+  /**
+   * @brief Total nanoseconds spent waiting for contended locks.
+   *
+   */
+  unsigned long long wait_ns;
+  /**
+   * @brief Nanoseconds waited by each contended lock.
+   *
+   */
+  rsv_stats_histogram_t waits;
+} rsv_mutex_stats_t;
+
+/**
+ * @brief A mutex carrying its own statistics. They are only written while the
+ * mutex is held, so counting adds no cache line traffic beyond the lock itself.
+ *
+ */
+typedef struct rsv_mutex_t {
+  pthread_mutex_t mutex;
+  rsv_mutex_stats_t stats;
+} rsv_mutex_t;
+#else
 typedef pthread_mutex_t rsv_mutex_t;
+#endif
+
+/**
+ * @brief A reader-writer lock. Any amount of readers can hold it at once,
+ * writers hold it alone.
+ *
+ */
+typedef struct rsv_rwlock_t {
+  pthread_rwlock_t lock;
+} RSV_CACHE_ALIGNED rsv_rwlock_t;
+
+/**
+ * @brief A mutex which spins for a while before parking the thread in the
+ * kernel. Cheaper than rsv_mutex_t for short, briefly contended sections.
+ *
+ */
+typedef struct rsv_adaptive_mutex_t {
+  /**
+   * @brief 0 when unlocked, 1 when locked, 2 when locked with parked waiters.
+   *
+   */
+  int state;
+} RSV_CACHE_ALIGNED rsv_adaptive_mutex_t;
+
+/**
+ * @brief A fair ticket spinlock for very short critical sections. Threads
+ * acquire it in the order they asked for it.
+ *
+ */
+typedef struct rsv_spinlock_t {
+  unsigned int next;
+  unsigned int serving;
+} RSV_CACHE_ALIGNED rsv_spinlock_t;
+
+/**
+ * @brief A condition variable, used together with a rsv_mutex_t.
+ *
+ */
+typedef struct rsv_cond_t {
+  pthread_cond_t cond;
+} RSV_CACHE_ALIGNED rsv_cond_t;
+
+/**
+ * @brief A barrier which releases its threads once a set amount of them have
+ * reached it.
+ *
+ */
+typedef struct rsv_barrier_t {
+  pthread_barrier_t barrier;
+} RSV_CACHE_ALIGNED rsv_barrier_t;
+
+/**
+ * @brief A flag for running an initialization function exactly once. Must be
+ * initialized with RSV_ONCE_INIT.
+ *
+ */
+typedef struct rsv_once_t {
+  pthread_once_t once;
+} RSV_CACHE_ALIGNED rsv_once_t;
+
+/**
+ * @brief A set of CPUs, numbered from 0 to RSV_CPU_SET_SIZE - 1.
+ *
+ */
+typedef struct rsv_cpu_set_t {
+  unsigned long bits[RSV_CPU_SET_SIZE / (8 * sizeof(unsigned long))];
+} rsv_cpu_set_t;
+
+/**
+ * @brief Options for rsv_thread_create_ex. Initialize with
+ * rsv_thread_attributes_create, then change what is needed.
+ *
+ */
+typedef struct rsv_thread_attributes_t {
+  /**
+   * @brief The CPUs the thread may run on. Ignored if empty, or where the
+   * platform does not support affinity.
+   *
+   */
+  rsv_cpu_set_t cpus;
+  /**
+   * @brief Size of the stack in bytes, or 0 for the default.
+   *
+   */
+  size_t stack_size;
+  /**
+   * @brief Name shown by debuggers and tools such as top, or NULL. Truncated
+   * to RSV_THREAD_NAME_SIZE - 1 characters.
+   *
+   */
+  const char* name;
+} rsv_thread_attributes_t;
+
+/**
+ * @brief Hints the CPU that the calling thread is spinning.
+ *
+ */
+static inline void rsv_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield");
+#endif
+}
 
 /**
  * @brief Creates a new thread.
@@ -35,6 +213,229 @@ static inline int rsv_thread_create(rsv_thread_t* thread,
   return pthread_create(thread, NULL, start_routine, arg);
 }
 
+/**
+ * @brief Removes every CPU from a CPU set.
+ *
+ * @param cpus Pointer to the CPU set.
+ */
+static inline void rsv_cpu_set_clear(rsv_cpu_set_t* cpus) {
+  memset(cpus->bits, 0, sizeof(cpus->bits));
+}
+
+/**
+ * @brief Adds a CPU to a CPU set. CPUs past RSV_CPU_SET_SIZE are ignored.
+ *
+ * @param cpus Pointer to the CPU set.
+ * @param cpu Number of the CPU.
+ */
+static inline void rsv_cpu_set_add(rsv_cpu_set_t* cpus, unsigned int cpu) {
+  if (cpu < RSV_CPU_SET_SIZE) {
+    cpus->bits[cpu / (8 * sizeof(unsigned long))] |=
+        1ul << (cpu % (8 * sizeof(unsigned long)));
+  }
+}
+
+/**
+ * @brief Removes a CPU from a CPU set.
+ *
+ * @param cpus Pointer to the CPU set.
+ * @param cpu Number of the CPU.
+ */
+static inline void rsv_cpu_set_remove(rsv_cpu_set_t* cpus, unsigned int cpu) {
+  if (cpu < RSV_CPU_SET_SIZE) {
+    cpus->bits[cpu / (8 * sizeof(unsigned long))] &=
+        ~(1ul << (cpu % (8 * sizeof(unsigned long))));
+  }
+}
+
+/**
+ * @brief Checks whether a CPU set contains a CPU.
+ *
+ * @param cpus Pointer to the CPU set.
+ * @param cpu Number of the CPU.
+ * @return 1 if the CPU is in the set, 0 otherwise.
+ */
+static inline int rsv_cpu_set_has(const rsv_cpu_set_t* cpus, unsigned int cpu) {
+  if (cpu >= RSV_CPU_SET_SIZE) {
+    return 0;
+  }
+
+  return (cpus->bits[cpu / (8 * sizeof(unsigned long))] >>
+          (cpu % (8 * sizeof(unsigned long)))) &
+         1;
+}
+
+/**
+ * @brief Counts the CPUs in a CPU set.
+ *
+ * @param cpus Pointer to the CPU set.
+ * @return The amount of CPUs in the set.
+ */
+static inline unsigned int rsv_cpu_set_amount(const rsv_cpu_set_t* cpus) {
+  unsigned int amount = 0;
+  unsigned int i;
+
+  for (i = 0; i < sizeof(cpus->bits) / sizeof(cpus->bits[0]); ++i) {
+    amount += (unsigned int)__builtin_popcountl(cpus->bits[i]);
+  }
+
+  return amount;
+}
+
+#if defined(CPU_SET)
+/**
+ * @brief Converts a CPU set to the platform's cpu_set_t.
+ *
+ * @param cpus Pointer to the CPU set.
+ * @param set Pointer to the cpu_set_t to fill.
+ */
+static inline void rsv_cpu_set_to_native(const rsv_cpu_set_t* cpus,
+                                         cpu_set_t* set) {
+  unsigned int i;
+
+  CPU_ZERO(set);
+
+  for (i = 0; i < RSV_CPU_SET_SIZE && i < CPU_SETSIZE; ++i) {
+    if (rsv_cpu_set_has(cpus, i)) {
+      CPU_SET(i, set);
+    }
+  }
+}
+#endif
+
+/**
+ * @brief Initializes thread attributes to the defaults used by
+ * rsv_thread_create: no affinity, default stack size and no name.
+ *
+ * @param attributes Pointer to the attributes to initialize.
+ */
+static inline void
+rsv_thread_attributes_create(rsv_thread_attributes_t* attributes) {
+  rsv_cpu_set_clear(&attributes->cpus);
+  attributes->stack_size = 0;
+  attributes->name = NULL;
+}
+
+/**
+ * @brief Restricts a thread to a set of CPUs. Does nothing where the platform
+ * does not support affinity.
+ *
+ * @param thread The thread, such as the result of pthread_self.
+ * @param cpus Pointer to the CPU set.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_setaffinity_np`).
+ */
+static inline int rsv_thread_set_affinity(rsv_thread_t thread,
+                                          const rsv_cpu_set_t* cpus) {
+#if defined(CPU_SET)
+  cpu_set_t set;
+
+  rsv_cpu_set_to_native(cpus, &set);
+  return pthread_setaffinity_np(thread, sizeof(set), &set);
+#else
+  (void)thread;
+  (void)cpus;
+  return 0;
+#endif
+}
+
+/**
+ * @brief Gets the CPUs a thread may run on. This follows restrictions such as
+ * taskset or a cgroup cpuset, so the CPUs need not be numbered contiguously.
+ * The set is left empty where the platform does not support affinity.
+ *
+ * @param thread The thread, such as the result of pthread_self.
+ * @param cpus Pointer to the CPU set to fill.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_getaffinity_np`).
+ */
+static inline int rsv_thread_get_affinity(rsv_thread_t thread,
+                                          rsv_cpu_set_t* cpus) {
+#if defined(CPU_SET)
+  cpu_set_t set;
+  unsigned int i;
+  int result = pthread_getaffinity_np(thread, sizeof(set), &set);
+
+  rsv_cpu_set_clear(cpus);
+
+  for (i = 0; result == 0 && i < RSV_CPU_SET_SIZE && i < CPU_SETSIZE; ++i) {
+    if (CPU_ISSET(i, &set)) {
+      rsv_cpu_set_add(cpus, i);
+    }
+  }
+
+  return result;
+#else
+  (void)thread;
+  rsv_cpu_set_clear(cpus);
+  return 0;
+#endif
+}
+
+/**
+ * @brief Creates a new thread with the given attributes.
+ *
+ * The affinity is applied before the thread starts, so its stack and
+ * anything it allocates are first touched on the chosen CPUs.
+ *
+ * @param thread A pointer to the thread object to be created.
+ * @param attributes Pointer to the attributes of the thread, or NULL for the
+ * defaults.
+ * @param start_routine A function pointer representing the function that will
+ * be executed by the thread.
+ * @param arg A pointer to the argument that will be passed to the start
+ * routine.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_create` or the attribute setters).
+ */
+static inline int
+rsv_thread_create_ex(rsv_thread_t* thread,
+                     const rsv_thread_attributes_t* attributes,
+                     void* (*start_routine)(void*), void* arg) {
+  pthread_attr_t pthread_attributes;
+  int result = 0;
+
+  if (attributes == NULL) {
+    return pthread_create(thread, NULL, start_routine, arg);
+  }
+
+  pthread_attr_init(&pthread_attributes);
+
+  if (attributes->stack_size > 0) {
+    result =
+        pthread_attr_setstacksize(&pthread_attributes, attributes->stack_size);
+  }
+
+#if defined(CPU_SET)
+  if (result == 0 && rsv_cpu_set_amount(&attributes->cpus) > 0) {
+    cpu_set_t set;
+
+    rsv_cpu_set_to_native(&attributes->cpus, &set);
+    result = pthread_attr_setaffinity_np(&pthread_attributes, sizeof(set),
+                                         &set);
+  }
+#endif
+
+  if (result == 0) {
+    result = pthread_create(thread, &pthread_attributes, start_routine, arg);
+  }
+
+  pthread_attr_destroy(&pthread_attributes);
+
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+  /* Naming is best effort, a thread without a name works the same */
+  if (result == 0 && attributes->name) {
+    char name[RSV_THREAD_NAME_SIZE];
+
+    strncpy(name, attributes->name, sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    pthread_setname_np(*thread, name);
+  }
+#endif
+
+  return result;
+}
+
 /**
  * @brief Waits for the specified thread to terminate.
  *
@@ -51,6 +452,20 @@ static inline int rsv_thread_join(rsv_thread_t thread, void** retval) {
   return pthread_join(thread, retval);
 }
 
+/**
+ * @brief Gets the pthread mutex of a mutex, such as for pthread_cond_wait.
+ *
+ * @param mutex A pointer to the mutex.
+ * @return Pointer to the pthread mutex.
+ */
+static inline pthread_mutex_t* rsv_mutex_native(rsv_mutex_t* mutex) {
+#if defined(RSV_STATS)
+  return &mutex->mutex;
+#else
+  return mutex;
+#endif
+}
+
 /**
  * @brief Initializes a mutex.
  *
@@ -62,7 +477,11 @@ static inline int rsv_thread_join(rsv_thread_t thread, void** retval) {
  * `pthread_mutex_init`).
  */
 static inline int rsv_mutex_create(rsv_mutex_t* mutex) {
-  return pthread_mutex_init(mutex, NULL);
+#if defined(RSV_STATS)
+  memset(&mutex->stats, 0, sizeof(mutex->stats));
+#endif
+
+  return pthread_mutex_init(rsv_mutex_native(mutex), NULL);
 }
 
 /**
@@ -76,7 +495,7 @@ static inline int rsv_mutex_create(rsv_mutex_t* mutex) {
  * `pthread_mutex_destroy`).
  */
 static inline int rsv_mutex_destroy(rsv_mutex_t* mutex) {
-  return pthread_mutex_destroy(mutex);
+  return pthread_mutex_destroy(rsv_mutex_native(mutex));
 }
 
 /**
@@ -90,7 +509,37 @@ static inline int rsv_mutex_destroy(rsv_mutex_t* mutex) {
  * `pthread_mutex_lock`).
  */
 static inline int rsv_mutex_lock(rsv_mutex_t* mutex) {
+#if defined(RSV_STATS)
+  struct timespec start;
+  struct timespec end;
+  unsigned long long wait_ns;
+  int result;
+
+  /* Only time the locks which have to wait */
+  if (pthread_mutex_trylock(&mutex->mutex) == 0) {
+    mutex->stats.locks++;
+    return 0;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  result = pthread_mutex_lock(&mutex->mutex);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  if (result != 0) {
+    return result;
+  }
+
+  wait_ns = (unsigned long long)(end.tv_sec - start.tv_sec) * 1000000000ull +
+            (unsigned long long)end.tv_nsec - (unsigned long long)start.tv_nsec;
+  mutex->stats.locks++;
+  mutex->stats.contended++;
+  mutex->stats.wait_ns += wait_ns;
+  mutex->stats.waits.counts[rsv_stats_bucket(wait_ns)]++;
+
+  return 0;
+#else
   return pthread_mutex_lock(mutex);
+#endif
 }
 
 /**
@@ -104,7 +553,352 @@ static inline int rsv_mutex_lock(rsv_mutex_t* mutex) {
  * `pthread_mutex_unlock`).
  */
 static inline int rsv_mutex_unlock(rsv_mutex_t* mutex) {
-  return pthread_mutex_unlock(mutex);
+  return pthread_mutex_unlock(rsv_mutex_native(mutex));
+}
+
+#if defined(RSV_STATS)
+/**
+ * @brief Gets a copy of the statistics of a mutex. Briefly locks the mutex,
+ * without counting it.
+ *
+ * @param mutex A pointer to the mutex.
+ * @param stats Pointer to the statistics to fill in.
+ */
+static inline void rsv_mutex_stats_get(rsv_mutex_t* mutex,
+                                       rsv_mutex_stats_t* stats) {
+  pthread_mutex_lock(&mutex->mutex);
+  *stats = mutex->stats;
+  pthread_mutex_unlock(&mutex->mutex);
+}
+
+/**
+ * @brief Resets the statistics of a mutex to zero.
+ *
+ * @param mutex A pointer to the mutex.
+ */
+static inline void rsv_mutex_stats_reset(rsv_mutex_t* mutex) {
+  pthread_mutex_lock(&mutex->mutex);
+  memset(&mutex->stats, 0, sizeof(mutex->stats));
+  pthread_mutex_unlock(&mutex->mutex);
+}
+
+/**
+ * @brief Prints the statistics of a mutex.
+ *
+ * @param mutex A pointer to the mutex.
+ * @param file The file to print to.
+ */
+static inline void rsv_mutex_stats_dump(rsv_mutex_t* mutex, FILE* file) {
+  rsv_mutex_stats_t stats;
+
+  rsv_mutex_stats_get(mutex, &stats);
+  fprintf(file,
+          "mutex:\n  locks: %llu\n  contended: %llu\n  wait_ns: %llu "
+          "(p50 <= %llu, p99 <= %llu)\n",
+          stats.locks, stats.contended, stats.wait_ns,
+          rsv_stats_histogram_percentile(&stats.waits, 0.5),
+          rsv_stats_histogram_percentile(&stats.waits, 0.99));
+  rsv_stats_histogram_dump(file, &stats.waits);
+}
+#endif
+
+/**
+ * @brief Initializes a reader-writer lock.
+ *
+ * @param rwlock A pointer to the reader-writer lock to be initialized.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_rwlock_init`).
+ */
+static inline int rsv_rwlock_create(rsv_rwlock_t* rwlock) {
+  return pthread_rwlock_init(&rwlock->lock, NULL);
+}
+
+/**
+ * @brief Destroys a reader-writer lock.
+ *
+ * @param rwlock A pointer to the reader-writer lock to be destroyed.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_rwlock_destroy`).
+ */
+static inline int rsv_rwlock_destroy(rsv_rwlock_t* rwlock) {
+  return pthread_rwlock_destroy(&rwlock->lock);
+}
+
+/**
+ * @brief Locks a reader-writer lock for reading.
+ *
+ * @param rwlock A pointer to the reader-writer lock.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_rwlock_rdlock`).
+ */
+static inline int rsv_rwlock_read_lock(rsv_rwlock_t* rwlock) {
+  return pthread_rwlock_rdlock(&rwlock->lock);
+}
+
+/**
+ * @brief Locks a reader-writer lock for writing.
+ *
+ * @param rwlock A pointer to the reader-writer lock.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_rwlock_wrlock`).
+ */
+static inline int rsv_rwlock_write_lock(rsv_rwlock_t* rwlock) {
+  return pthread_rwlock_wrlock(&rwlock->lock);
+}
+
+/**
+ * @brief Unlocks a reader-writer lock held for either reading or writing.
+ *
+ * @param rwlock A pointer to the reader-writer lock.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_rwlock_unlock`).
+ */
+static inline int rsv_rwlock_unlock(rsv_rwlock_t* rwlock) {
+  return pthread_rwlock_unlock(&rwlock->lock);
+}
+
+/**
+ * @brief Initializes an adaptive mutex.
+ *
+ * @param mutex A pointer to the adaptive mutex to be initialized.
+ * @return Always 0.
+ */
+static inline int rsv_adaptive_mutex_create(rsv_adaptive_mutex_t* mutex) {
+  mutex->state = 0;
+  return 0;
+}
+
+/**
+ * @brief Destroys an adaptive mutex.
+ *
+ * @param mutex A pointer to the adaptive mutex to be destroyed.
+ * @return Always 0.
+ */
+static inline int rsv_adaptive_mutex_destroy(rsv_adaptive_mutex_t* mutex) {
+  (void)mutex;
+  return 0;
+}
+
+/**
+ * @brief Locks an adaptive mutex.
+ *
+ * Spins up to RSV_ADAPTIVE_MUTEX_SPIN_AMOUNT times, then parks the thread on a
+ * futex (or yields on platforms without futexes) until the mutex is released.
+ *
+ * @param mutex A pointer to the adaptive mutex to be locked.
+ * @return Always 0.
+ */
+static inline int rsv_adaptive_mutex_lock(rsv_adaptive_mutex_t* mutex) {
+  int expected = 0;
+  unsigned int i;
+
+  if (rsv_atomic_compare_exchange(&mutex->state, &expected, 1,
+                                  RSV_MEMORY_ORDER_ACQUIRE,
+                                  RSV_MEMORY_ORDER_RELAXED)) {
+    return 0;
+  }
+
+  for (i = 0; i < RSV_ADAPTIVE_MUTEX_SPIN_AMOUNT; ++i) {
+    expected = 0;
+
+    if (rsv_atomic_load(&mutex->state, RSV_MEMORY_ORDER_RELAXED) == 0 &&
+        rsv_atomic_compare_exchange(&mutex->state, &expected, 1,
+                                    RSV_MEMORY_ORDER_ACQUIRE,
+                                    RSV_MEMORY_ORDER_RELAXED)) {
+      return 0;
+    }
+
+    rsv_cpu_relax();
+  }
+
+  /* Mark the mutex as contended so the owner wakes us up on unlock */
+  while (rsv_atomic_exchange(&mutex->state, 2, RSV_MEMORY_ORDER_ACQUIRE) != 0) {
+#if defined(__linux__)
+    syscall(SYS_futex, &mutex->state, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+#else
+    sched_yield();
+#endif
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Unlocks an adaptive mutex.
+ *
+ * @param mutex A pointer to the adaptive mutex to be unlocked.
+ * @return Always 0.
+ */
+static inline int rsv_adaptive_mutex_unlock(rsv_adaptive_mutex_t* mutex) {
+  if (rsv_atomic_exchange(&mutex->state, 0, RSV_MEMORY_ORDER_RELEASE) == 2) {
+#if defined(__linux__)
+    syscall(SYS_futex, &mutex->state, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#endif
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Initializes a ticket spinlock.
+ *
+ * @param spinlock A pointer to the spinlock to be initialized.
+ * @return Always 0.
+ */
+static inline int rsv_spinlock_create(rsv_spinlock_t* spinlock) {
+  spinlock->next = 0;
+  spinlock->serving = 0;
+  return 0;
+}
+
+/**
+ * @brief Destroys a ticket spinlock.
+ *
+ * @param spinlock A pointer to the spinlock to be destroyed.
+ * @return Always 0.
+ */
+static inline int rsv_spinlock_destroy(rsv_spinlock_t* spinlock) {
+  (void)spinlock;
+  return 0;
+}
+
+/**
+ * @brief Locks a ticket spinlock, spinning until it is the caller's turn.
+ *
+ * @param spinlock A pointer to the spinlock to be locked.
+ * @return Always 0.
+ */
+static inline int rsv_spinlock_lock(rsv_spinlock_t* spinlock) {
+  unsigned int ticket =
+      rsv_atomic_fetch_add(&spinlock->next, 1, RSV_MEMORY_ORDER_RELAXED);
+
+  while (rsv_atomic_load(&spinlock->serving, RSV_MEMORY_ORDER_ACQUIRE) !=
+         ticket) {
+    rsv_cpu_relax();
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Unlocks a ticket spinlock, handing it to the next waiting thread.
+ *
+ * @param spinlock A pointer to the spinlock to be unlocked.
+ * @return Always 0.
+ */
+static inline int rsv_spinlock_unlock(rsv_spinlock_t* spinlock) {
+  unsigned int serving =
+      rsv_atomic_load(&spinlock->serving, RSV_MEMORY_ORDER_RELAXED);
+
+  rsv_atomic_store(&spinlock->serving, serving + 1, RSV_MEMORY_ORDER_RELEASE);
+  return 0;
+}
+
+/**
+ * @brief Initializes a condition variable.
+ *
+ * @param cond A pointer to the condition variable to be initialized.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_cond_init`).
+ */
+static inline int rsv_cond_create(rsv_cond_t* cond) {
+  return pthread_cond_init(&cond->cond, NULL);
+}
+
+/**
+ * @brief Destroys a condition variable.
+ *
+ * @param cond A pointer to the condition variable to be destroyed.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_cond_destroy`).
+ */
+static inline int rsv_cond_destroy(rsv_cond_t* cond) {
+  return pthread_cond_destroy(&cond->cond);
+}
+
+/**
+ * @brief Atomically unlocks a mutex and waits on a condition variable. The
+ * mutex is locked again before returning.
+ *
+ * @param cond A pointer to the condition variable.
+ * @param mutex A pointer to the mutex, which must be locked by the caller.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_cond_wait`).
+ */
+static inline int rsv_cond_wait(rsv_cond_t* cond, rsv_mutex_t* mutex) {
+  return pthread_cond_wait(&cond->cond, rsv_mutex_native(mutex));
+}
+
+/**
+ * @brief Wakes up one thread waiting on a condition variable.
+ *
+ * @param cond A pointer to the condition variable.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_cond_signal`).
+ */
+static inline int rsv_cond_signal(rsv_cond_t* cond) {
+  return pthread_cond_signal(&cond->cond);
+}
+
+/**
+ * @brief Wakes up every thread waiting on a condition variable.
+ *
+ * @param cond A pointer to the condition variable.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_cond_broadcast`).
+ */
+static inline int rsv_cond_broadcast(rsv_cond_t* cond) {
+  return pthread_cond_broadcast(&cond->cond);
+}
+
+/**
+ * @brief Initializes a barrier.
+ *
+ * @param barrier A pointer to the barrier to be initialized.
+ * @param amount The amount of threads which must reach the barrier before any
+ * of them is released.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_barrier_init`).
+ */
+static inline int rsv_barrier_create(rsv_barrier_t* barrier,
+                                     unsigned int amount) {
+  return pthread_barrier_init(&barrier->barrier, NULL, amount);
+}
+
+/**
+ * @brief Destroys a barrier.
+ *
+ * @param barrier A pointer to the barrier to be destroyed.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_barrier_destroy`).
+ */
+static inline int rsv_barrier_destroy(rsv_barrier_t* barrier) {
+  return pthread_barrier_destroy(&barrier->barrier);
+}
+
+/**
+ * @brief Waits until the set amount of threads have reached the barrier.
+ *
+ * @param barrier A pointer to the barrier.
+ * @return RSV_BARRIER_SERIAL_THREAD for exactly one of the released threads,
+ * 0 for the others, or an error code on failure (as returned by
+ * `pthread_barrier_wait`).
+ */
+static inline int rsv_barrier_wait(rsv_barrier_t* barrier) {
+  return pthread_barrier_wait(&barrier->barrier);
+}
+
+/**
+ * @brief Runs an initialization function exactly once, no matter how many
+ * threads call this with the same flag.
+ *
+ * @param once A pointer to the once flag, initialized with RSV_ONCE_INIT.
+ * @param init_routine The initialization function.
+ * @return 0 on success, or an error code on failure (as returned by
+ * `pthread_once`).
+ */
+static inline int rsv_once(rsv_once_t* once, void (*init_routine)(void)) {
+  return pthread_once(&once->once, init_routine);
 }
 
 #endif /* RSV_THREADS_UNIX_H */
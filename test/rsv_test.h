@@ -1,22 +1,72 @@
 #ifndef RSV_TEST_H
 #define RSV_TEST_H
 
+#include "test_atomic.h"
+#include "test_btree.h"
+#include "test_cache.h"
+#include "test_compressed_array.h"
+#include "test_concurrent_hash_table.h"
 #include "test_dynamic_array.h"
+#include "test_epoch.h"
+#include "test_file.h"
+#include "test_file_ingest.h"
 #include "test_hash_set.h"
 #include "test_hash_table.h"
+#include "test_intern_pool.h"
+#include "test_lockfree_hash_table.h"
+#include "test_numa.h"
+#include "test_parallel.h"
+#include "test_priority_queue.h"
+#include "test_radix_tree.h"
+#include "test_sharded_counter.h"
+#include "test_slot_map.h"
+#include "test_snapshot_hash_table.h"
+#include "test_stats.h"
 #include "test_string.h"
+#include "test_string_builder.h"
+#include "test_string_view.h"
+#include "test_thread_pool.h"
 #include "test_threads.h"
+#include "test_utf8.h"
 
 static inline int rsv_test_all(void) {
   int failed_tests = 0;
 
+  failed_tests += test_btree();
+  failed_tests += test_cache();
+  failed_tests += test_compressed_array();
   failed_tests += test_dynamic_array();
   failed_tests += test_hash_set();
   failed_tests += test_hash_table();
+  failed_tests += test_intern_pool();
+  failed_tests += test_priority_queue();
+  failed_tests += test_radix_tree();
+  failed_tests += test_slot_map();
   failed_tests += test_string();
+  failed_tests += test_string_builder();
+  failed_tests += test_string_view();
+  failed_tests += test_utf8();
+
+#if defined(__GNUC__)
+  failed_tests += test_atomic();
+#endif
 
 #if defined(__unix__)
+  failed_tests += test_file();
   failed_tests += test_threads();
+  failed_tests += test_numa();
+  failed_tests += test_thread_pool();
+  failed_tests += test_parallel();
+  failed_tests += test_file_ingest();
+  failed_tests += test_sharded_counter();
+  failed_tests += test_concurrent_hash_table();
+  failed_tests += test_epoch();
+  failed_tests += test_lockfree_hash_table();
+  failed_tests += test_snapshot_hash_table();
+#endif
+
+#if defined(RSV_STATS)
+  failed_tests += test_stats();
 #endif
 
   return failed_tests;
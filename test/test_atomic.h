@@ -0,0 +1,69 @@
+#if defined(__GNUC__)
+
+#ifndef TEST_ATOMIC_H
+#define TEST_ATOMIC_H
+
+#include "test.h"
+#include <rsv/threads/atomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static inline int test_atomic(void) {
+  int value;
+  int expected;
+  long wide;
+  void* pointer;
+
+  /* Test: Load and store */
+  rsv_atomic_store(&value, 10, RSV_MEMORY_ORDER_RELEASE);
+  TEST(rsv_atomic_load(&value, RSV_MEMORY_ORDER_ACQUIRE) == 10);
+
+  /* Test: Exchange */
+  TEST(rsv_atomic_exchange(&value, 20, RSV_MEMORY_ORDER_ACQ_REL) == 10);
+  TEST(value == 20);
+
+  /* Test: Compare exchange success */
+  expected = 20;
+  TEST(rsv_atomic_compare_exchange(&value, &expected, 30,
+                                   RSV_MEMORY_ORDER_SEQ_CST,
+                                   RSV_MEMORY_ORDER_RELAXED) == 1);
+  TEST(value == 30);
+
+  /* Test: Compare exchange failure reports the current value */
+  expected = 20;
+  TEST(rsv_atomic_compare_exchange(&value, &expected, 40,
+                                   RSV_MEMORY_ORDER_SEQ_CST,
+                                   RSV_MEMORY_ORDER_RELAXED) == 0);
+  TEST(expected == 30);
+  TEST(value == 30);
+
+  /* Test: Weak compare exchange in a retry loop */
+  expected = rsv_atomic_load(&value, RSV_MEMORY_ORDER_RELAXED);
+
+  while (!rsv_atomic_compare_exchange_weak(&value, &expected, expected + 1,
+                                           RSV_MEMORY_ORDER_ACQ_REL,
+                                           RSV_MEMORY_ORDER_RELAXED)) {
+  }
+
+  TEST(value == 31);
+
+  /* Test: Fetch operations return the previous value */
+  wide = 5;
+  TEST(rsv_atomic_fetch_add(&wide, 3, RSV_MEMORY_ORDER_RELAXED) == 5);
+  TEST(rsv_atomic_fetch_sub(&wide, 1, RSV_MEMORY_ORDER_RELAXED) == 8);
+  TEST(rsv_atomic_fetch_or(&wide, 8, RSV_MEMORY_ORDER_RELAXED) == 7);
+  TEST(rsv_atomic_fetch_and(&wide, 12, RSV_MEMORY_ORDER_RELAXED) == 15);
+  TEST(rsv_atomic_fetch_xor(&wide, 5, RSV_MEMORY_ORDER_RELAXED) == 12);
+  TEST(wide == 9);
+
+  /* Test: Pointers */
+  rsv_atomic_store(&pointer, &value, RSV_MEMORY_ORDER_RELAXED);
+  TEST(rsv_atomic_load(&pointer, RSV_MEMORY_ORDER_RELAXED) == &value);
+  rsv_atomic_thread_fence(RSV_MEMORY_ORDER_SEQ_CST);
+
+  return 0;
+}
+
+#endif /* TEST_ATOMIC_H */
+
+#endif
@@ -0,0 +1,317 @@
+#ifndef TEST_BTREE_H
+#define TEST_BTREE_H
+
+#include "test.h"
+#include <rsv/containers/btree.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Checks the order, fill and depth below a node, returning the pair count */
+static inline long btree_check_node(rsv_btree_t* tree, rsv_btree_node_t* node,
+                                    const void* lower, const void* upper,
+                                    unsigned int depth, int root) {
+  unsigned int minimum =
+      (node->leaf ? tree->leaf_capacity : tree->inner_capacity) / 2;
+  long amount = 0;
+  unsigned int i;
+
+  if (!root && node->amount < minimum) {
+    return -1;
+  }
+
+  for (i = 0; i < node->amount; ++i) {
+    unsigned char* key = rsv_btree_key(tree, node, i);
+
+    if ((i > 0 && tree->custom_compare_func(rsv_btree_key(tree, node, i - 1),
+                                            key, tree->key_size) >= 0) ||
+        (lower && tree->custom_compare_func(key, lower, tree->key_size) < 0) ||
+        (upper && tree->custom_compare_func(key, upper, tree->key_size) >= 0)) {
+      return -1;
+    }
+  }
+
+  if (node->leaf) {
+    return depth == tree->height ? (long)node->amount : -1;
+  }
+
+  for (i = 0; i <= node->amount; ++i) {
+    long below = btree_check_node(
+        tree, rsv_btree_children(tree, node)[i],
+        i > 0 ? rsv_btree_key(tree, node, i - 1) : lower,
+        i < node->amount ? rsv_btree_key(tree, node, i) : upper, depth + 1, 0);
+
+    if (below < 0) {
+      return -1;
+    }
+
+    amount += below;
+  }
+
+  return amount;
+}
+
+static inline int btree_check(rsv_btree_t* tree) {
+  if (tree->root == NULL) {
+    return tree->amount == 0 && tree->height == 0;
+  }
+
+  return btree_check_node(tree, tree->root, NULL, NULL, 1, 1) ==
+         (long)tree->amount;
+}
+
+static inline int test_btree(void) {
+  static unsigned char present[4096];
+  static int64_t sorted[5000];
+  static int64_t sorted_values[5000];
+  rsv_btree_iterator_t iterator;
+  rsv_btree_t tree;
+  unsigned int seed = 99;
+  unsigned int amount;
+  uint32_t key;
+  uint32_t value;
+  int64_t wide;
+  void* found_key;
+  void* found_value;
+  int i;
+
+  /* Test: Create tree */
+  tree = rsv_btree_create(0, sizeof(uint32_t), sizeof(uint32_t),
+                          rsv_btree_compare_uint32);
+  TEST(tree.amount == 0);
+  TEST(tree.key_type == RSV_BTREE_KEY_UINT32);
+  TEST(tree.leaf_capacity > RSV_BTREE_LINEAR_SEARCH);
+  key = 1;
+  TEST(rsv_btree_get(&tree, &key) == NULL);
+  rsv_btree_pop(&tree, &key);
+  iterator = rsv_btree_range(&tree, NULL, NULL);
+  TEST(rsv_btree_iterator_next(&iterator, NULL, NULL) == 0);
+
+  /* Test: Random pushes and pops against a reference */
+  memset(present, 0, sizeof(present));
+  amount = 0;
+
+  for (i = 0; i < 20000; i++) {
+    seed = seed * 1103515245 + 12345;
+    key = (seed >> 8) % 4096;
+
+    /* Keys above 2^31 check the unsigned compare */
+    if (key & 1) {
+      key |= 0x80000000u;
+    }
+
+    value = key * 3;
+
+    if ((seed >> 4) % 3 != 0) {
+      amount += !present[key & 4095];
+      present[key & 4095] = 1;
+      rsv_btree_push(&tree, &key, &value);
+    } else {
+      amount -= present[key & 4095];
+      present[key & 4095] = 0;
+      rsv_btree_pop(&tree, &key);
+    }
+
+    TEST(tree.amount == amount);
+  }
+
+  TEST(btree_check(&tree));
+  TEST(tree.height >= 2);
+
+  for (i = 0; i < 4096; i++) {
+    key = (uint32_t)i | (i & 1 ? 0x80000000u : 0);
+
+    if (present[i]) {
+      TEST(rsv_btree_get(&tree, &key) != NULL);
+      TEST(*(uint32_t*)rsv_btree_get(&tree, &key) == key * 3);
+    } else {
+      TEST(rsv_btree_get(&tree, &key) == NULL);
+    }
+  }
+
+  /* Test: In-order iteration visits even keys before odd ones */
+  iterator = rsv_btree_range(&tree, NULL, NULL);
+  value = 0;
+  amount = 0;
+
+  while (rsv_btree_iterator_next(&iterator, &found_key, &found_value)) {
+    TEST(amount == 0 || *(uint32_t*)found_key > value);
+    TEST(*(uint32_t*)found_value == *(uint32_t*)found_key * 3);
+    value = *(uint32_t*)found_key;
+    amount++;
+  }
+
+  TEST(amount == tree.amount);
+
+  /* Test: Range iteration */
+  key = 1000;
+  value = 2000;
+  iterator = rsv_btree_range(&tree, &key, &value);
+  amount = 0;
+
+  while (rsv_btree_iterator_next(&iterator, &found_key, NULL)) {
+    TEST(*(uint32_t*)found_key >= 1000 && *(uint32_t*)found_key < 2000);
+    amount++;
+  }
+
+  for (i = 1000; i < 2000; i += 2) {
+    amount -= present[i];
+  }
+
+  TEST(amount == 0);
+
+  /* Test: Pop everything */
+  for (i = 0; i < 4096; i++) {
+    key = (uint32_t)i | (i & 1 ? 0x80000000u : 0);
+    rsv_btree_pop(&tree, &key);
+  }
+
+  TEST(tree.amount == 0);
+  TEST(tree.root == NULL);
+  TEST(btree_check(&tree));
+  rsv_btree_destroy(&tree);
+
+  /* Test: Small nodes with signed 64 bit keys */
+  tree = rsv_btree_create(64, sizeof(int64_t), sizeof(int64_t),
+                          rsv_btree_compare_int64);
+  TEST(tree.key_type == RSV_BTREE_KEY_INT64);
+  TEST(tree.leaf_capacity == RSV_BTREE_MIN_CAPACITY);
+
+  for (i = 0; i < 3000; i++) {
+    wide = (int64_t)((i * 7919) % 3000) - 1500;
+    rsv_btree_push(&tree, &wide, &wide);
+    TEST(i % 500 != 0 || btree_check(&tree));
+  }
+
+  TEST(tree.amount == 3000);
+  TEST(btree_check(&tree));
+  TEST(tree.height > 4);
+
+  for (i = -1500; i < 1500; i++) {
+    wide = i;
+    TEST(rsv_btree_get(&tree, &wide) != NULL);
+    TEST(*(int64_t*)rsv_btree_get(&tree, &wide) == i);
+  }
+
+  for (i = 0; i < 3000; i += 2) {
+    wide = (int64_t)((i * 7919) % 3000) - 1500;
+    rsv_btree_pop(&tree, &wide);
+    TEST(i % 500 != 0 || btree_check(&tree));
+  }
+
+  TEST(tree.amount == 1500);
+  TEST(btree_check(&tree));
+
+  wide = -10;
+  iterator = rsv_btree_range(&tree, &wide, NULL);
+  TEST(rsv_btree_iterator_next(&iterator, &found_key, NULL) == 1);
+  TEST(*(int64_t*)found_key >= -10);
+  rsv_btree_destroy(&tree);
+
+  /* Test: Bulk load */
+  for (i = 0; i < 5000; i++) {
+    sorted[i] = (int64_t)i * 3 - 7000;
+    sorted_values[i] = i;
+  }
+
+  tree = rsv_btree_create(128, sizeof(int64_t), sizeof(int64_t),
+                          rsv_btree_compare_int64);
+  TEST(rsv_btree_bulk_load(&tree, sorted_values, sorted, 0) == 1);
+  TEST(tree.root == NULL);
+  TEST(rsv_btree_bulk_load(&tree, sorted, sorted_values, 5000) == 1);
+  TEST(tree.amount == 5000);
+  TEST(btree_check(&tree));
+  TEST(rsv_btree_bulk_load(&tree, sorted, sorted_values, 5000) == 0);
+
+  for (i = 0; i < 5000; i++) {
+    TEST(*(int64_t*)rsv_btree_get(&tree, &sorted[i]) == i);
+  }
+
+  wide = -6999;
+  TEST(rsv_btree_get(&tree, &wide) == NULL);
+
+  /* Bulk loaded trees keep working with pushes and pops */
+  for (i = 0; i < 5000; i += 3) {
+    rsv_btree_pop(&tree, &sorted[i]);
+    wide = sorted[i] + 1;
+    rsv_btree_push(&tree, &wide, &wide);
+  }
+
+  TEST(tree.amount == 5000);
+  TEST(btree_check(&tree));
+  rsv_btree_destroy(&tree);
+
+  tree = rsv_btree_create(0, sizeof(int64_t), sizeof(int64_t),
+                          rsv_btree_compare_int64);
+  sorted[10] = sorted[9];
+  TEST(rsv_btree_bulk_load(&tree, sorted, sorted_values, 5000) == 0);
+  TEST(rsv_btree_bulk_load(&tree, sorted, sorted_values, 1) == 1);
+  TEST(tree.amount == 1);
+  TEST(btree_check(&tree));
+  rsv_btree_destroy(&tree);
+
+  /* Test: Signed 32 and unsigned 64 bit keys */
+  tree = rsv_btree_create(0, sizeof(int32_t), sizeof(int32_t),
+                          rsv_btree_compare_int32);
+  TEST(tree.key_type == RSV_BTREE_KEY_INT32);
+
+  for (i = 500; i >= -500; i--) {
+    int32_t narrow = i;
+
+    rsv_btree_push(&tree, &narrow, &narrow);
+  }
+
+  TEST(btree_check(&tree));
+
+  for (i = -500; i <= 500; i++) {
+    int32_t narrow = i;
+
+    TEST(*(int32_t*)rsv_btree_get(&tree, &narrow) == i);
+  }
+
+  rsv_btree_destroy(&tree);
+  tree = rsv_btree_create(0, sizeof(uint64_t), sizeof(uint64_t),
+                          rsv_btree_compare_uint64);
+  TEST(tree.key_type == RSV_BTREE_KEY_UINT64);
+
+  for (i = 0; i < 1000; i++) {
+    uint64_t unsigned_wide = (uint64_t)i << (i % 2 ? 63 - i % 8 : 1);
+
+    rsv_btree_push(&tree, &unsigned_wide, &unsigned_wide);
+    TEST(*(uint64_t*)rsv_btree_get(&tree, &unsigned_wide) == unsigned_wide);
+  }
+
+  TEST(btree_check(&tree));
+  rsv_btree_destroy(&tree);
+
+  /* Test: Byte keys with prefix iteration */
+  tree = rsv_btree_create(256, 8, sizeof(int), NULL);
+  TEST(tree.key_type == RSV_BTREE_KEY_BYTES);
+
+  for (i = 0; i < 1000; i++) {
+    char name[16];
+
+    sprintf(name, "%c%c%06d", 'a' + i % 3, 'a' + i % 5, i);
+    rsv_btree_push(&tree, name, &i);
+  }
+
+  TEST(btree_check(&tree));
+  iterator = rsv_btree_prefix(&tree, "bc", 2);
+  amount = 0;
+
+  while (rsv_btree_iterator_next(&iterator, &found_key, &found_value)) {
+    int index = *(int*)found_value;
+
+    TEST(memcmp(found_key, "bc", 2) == 0);
+    TEST(index % 3 == 1 && index % 5 == 2);
+    amount++;
+  }
+
+  TEST(amount == 67);
+  iterator = rsv_btree_prefix(&tree, "zz", 2);
+  TEST(rsv_btree_iterator_next(&iterator, NULL, NULL) == 0);
+  rsv_btree_destroy(&tree);
+
+  return 0;
+}
+
+#endif /* TEST_BTREE_H */
@@ -0,0 +1,268 @@
+#ifndef TEST_CACHE_H
+#define TEST_CACHE_H
+
+#include "test.h"
+#include <rsv/containers/cache.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct cache_evicted_t {
+  int count;
+  int last_key;
+  long value_sum;
+} cache_evicted_t;
+
+static inline void cache_count_evicted(void* context, const void* key,
+                                       void* value) {
+  cache_evicted_t* evicted = (cache_evicted_t*)context;
+
+  evicted->count++;
+  evicted->last_key = *(const int*)key;
+  evicted->value_sum += *(int*)value;
+}
+
+/* Weighs a pair by its value, standing in for a byte size */
+static inline size_t cache_weigh_value(const void* key, const void* value) {
+  (void)key;
+  return (size_t)*(const int*)value;
+}
+
+#if defined(__unix__)
+typedef struct cache_data_t {
+  rsv_concurrent_cache_t* cache;
+  int offset;
+  int wrong;
+} cache_data_t;
+
+static inline void cache_count_evicted_atomic(void* context, const void* key,
+                                              void* value) {
+  (void)key;
+  (void)value;
+  rsv_atomic_fetch_add((int*)context, 1, RSV_MEMORY_ORDER_RELAXED);
+}
+
+static inline void* use_concurrent_cache(void* arg) {
+  cache_data_t* data = (cache_data_t*)arg;
+  int value;
+  int i;
+
+  for (i = 0; i < 5000; i++) {
+    int key = data->offset + i % 500;
+
+    if (rsv_concurrent_cache_get(data->cache, &key, &value)) {
+      data->wrong += value != key * 2;
+    } else {
+      value = key * 2;
+      rsv_concurrent_cache_push(data->cache, &key, &value);
+    }
+
+    if (i % 7 == 0) {
+      rsv_concurrent_cache_pop(data->cache, &key);
+    }
+  }
+
+  return NULL;
+}
+#endif
+
+static inline int test_cache(void) {
+  cache_evicted_t evicted = {0, 0, 0};
+  rsv_cache_t cache;
+  int key;
+  int value;
+  int i;
+
+  /* Test: Create cache */
+  cache = rsv_cache_create(3, sizeof(int), sizeof(int), RSV_CACHE_LRU, NULL,
+                           NULL);
+  cache.evict_func = cache_count_evicted;
+  cache.context = &evicted;
+  TEST(cache.amount == 0);
+  key = 1;
+  TEST(rsv_cache_get(&cache, &key) == NULL);
+  TEST(rsv_cache_pop(&cache, &key) == 0);
+
+  /* Test: LRU evicts the least recently used pair */
+  for (key = 1; key <= 3; key++) {
+    value = key * 10;
+    rsv_cache_push(&cache, &key, &value);
+  }
+
+  key = 1;
+  TEST(*(int*)rsv_cache_get(&cache, &key) == 10);
+  key = 4;
+  value = 40;
+  rsv_cache_push(&cache, &key, &value);
+  TEST(cache.amount == 3);
+  TEST(cache.evictions == 1);
+  TEST(evicted.count == 1 && evicted.last_key == 2);
+  key = 2;
+  TEST(rsv_cache_get(&cache, &key) == NULL);
+  key = 1;
+  TEST(rsv_cache_get(&cache, &key) != NULL);
+
+  /* Test: Replacing a value passes the old one to the evict function */
+  value = 11;
+  rsv_cache_push(&cache, &key, &value);
+  TEST(cache.amount == 3);
+  TEST(evicted.count == 2 && evicted.value_sum == 30);
+  TEST(*(int*)rsv_cache_get(&cache, &key) == 11);
+
+  TEST(rsv_cache_pop(&cache, &key) == 1);
+  TEST(cache.amount == 2);
+  TEST(evicted.count == 3);
+  rsv_cache_destroy(&cache);
+  TEST(evicted.count == 5);
+
+  /* Test: Growing past the initial slots and buckets */
+  cache = rsv_cache_create(1, sizeof(int), sizeof(int), RSV_CACHE_LRU, NULL,
+                           NULL);
+  cache.capacity = 5000;
+
+  for (i = 0; i < 20000; i++) {
+    value = i * 3;
+    rsv_cache_push(&cache, &i, &value);
+  }
+
+  TEST(cache.amount == 5000);
+  TEST(cache.evictions == 15000);
+
+  for (i = 0; i < 20000; i++) {
+    int* found = (int*)rsv_cache_get(&cache, &i);
+
+    TEST(i < 15000 ? found == NULL : found != NULL && *found == i * 3);
+  }
+
+  rsv_cache_destroy(&cache);
+
+  cache = rsv_cache_create(4, sizeof(int), sizeof(int), RSV_CACHE_LRU, NULL,
+                           NULL);
+
+  for (i = 0; i < 20000; i++) {
+    value = i;
+    rsv_cache_push(&cache, &i, &value);
+  }
+
+  TEST(cache.amount == 4);
+  TEST(cache.slot_amount == RSV_CACHE_MIN_SLOTS);
+  rsv_cache_destroy(&cache);
+
+  /* Test: CLOCK gives read pairs a second chance */
+  cache = rsv_cache_create(4, sizeof(int), sizeof(int), RSV_CACHE_CLOCK, NULL,
+                           NULL);
+
+  for (key = 0; key < 4; key++) {
+    rsv_cache_push(&cache, &key, &key);
+  }
+
+  key = 0;
+  TEST(rsv_cache_get(&cache, &key) != NULL);
+  key = 2;
+  TEST(rsv_cache_get(&cache, &key) != NULL);
+  key = 4;
+  rsv_cache_push(&cache, &key, &key);
+  key = 1;
+  TEST(rsv_cache_get(&cache, &key) == NULL);
+  key = 5;
+  rsv_cache_push(&cache, &key, &key);
+  key = 3;
+  TEST(rsv_cache_get(&cache, &key) == NULL);
+
+  for (key = 0; key <= 5; key += 2) {
+    TEST(rsv_cache_get(&cache, &key) != NULL);
+  }
+
+  TEST(cache.amount == 4);
+  rsv_cache_destroy(&cache);
+
+  /* Test: Weighted capacity */
+  cache = rsv_cache_create(100, sizeof(int), sizeof(int), RSV_CACHE_LRU, NULL,
+                           NULL);
+  cache.weight_func = cache_weigh_value;
+
+  for (key = 0; key < 10; key++) {
+    value = 30;
+    rsv_cache_push(&cache, &key, &value);
+    TEST(cache.weight <= 100);
+  }
+
+  TEST(cache.amount == 3);
+  TEST(cache.weight == 90);
+
+  /* A pair heavier than the capacity is kept on its own */
+  value = 500;
+  rsv_cache_push(&cache, &key, &value);
+  TEST(cache.amount == 1);
+  TEST(cache.weight == 500);
+  TEST(*(int*)rsv_cache_get(&cache, &key) == 500);
+  rsv_cache_destroy(&cache);
+
+  /* Test: A byte capacity does not size the slots */
+  cache = rsv_cache_create((size_t)64 << 20, sizeof(int), sizeof(int),
+                           RSV_CACHE_CLOCK, NULL, NULL);
+  cache.weight_func = cache_weigh_value;
+  TEST(cache.slot_amount == RSV_CACHE_MAX_INITIAL_SLOTS);
+
+  for (key = 0; key < 5000; key++) {
+    value = 4096;
+    TEST(rsv_cache_push(&cache, &key, &value) == 0);
+  }
+
+  TEST(cache.amount == 5000);
+  TEST(cache.evictions == 0);
+  TEST(cache.slot_amount == 8192);
+  TEST(cache.bucket_amount == 8192);
+  rsv_cache_destroy(&cache);
+  TEST(rsv_cache_get(&cache, &key) == NULL);
+
+#if defined(__unix__)
+  /* Test: Concurrent cache for both policies */
+  {
+    rsv_concurrent_cache_t concurrent_cache;
+    rsv_thread_t threads[4];
+    cache_data_t data[4];
+    unsigned int policy;
+    int evictions;
+
+    for (policy = RSV_CACHE_LRU; policy <= RSV_CACHE_CLOCK; policy++) {
+      TEST(rsv_concurrent_cache_create(&concurrent_cache, 3, 1000, sizeof(int),
+                                       sizeof(int), policy, NULL, NULL) == 0);
+      TEST(concurrent_cache.shard_amount == 4);
+      TEST(concurrent_cache.shards[0].cache.capacity == 250);
+      evictions = 0;
+      rsv_concurrent_cache_callbacks(&concurrent_cache, NULL,
+                                     cache_count_evicted_atomic, &evictions);
+
+      for (i = 0; i < 4; i++) {
+        data[i].cache = &concurrent_cache;
+        data[i].offset = i * 300;
+        data[i].wrong = 0;
+        TEST(rsv_thread_create(&threads[i], use_concurrent_cache, &data[i]) ==
+             0);
+      }
+
+      for (i = 0; i < 4; i++) {
+        TEST(rsv_thread_join(threads[i], NULL) == 0);
+        TEST(data[i].wrong == 0);
+      }
+
+      TEST(rsv_concurrent_cache_amount(&concurrent_cache) <= 1000);
+      TEST(evictions > 0);
+      key = -1;
+      TEST(rsv_concurrent_cache_get(&concurrent_cache, &key, NULL) == 0);
+      value = 7;
+      rsv_concurrent_cache_push(&concurrent_cache, &key, &value);
+      value = 0;
+      TEST(rsv_concurrent_cache_get(&concurrent_cache, &key, &value) == 1);
+      TEST(value == 7);
+      TEST(rsv_concurrent_cache_pop(&concurrent_cache, &key) == 1);
+      rsv_concurrent_cache_destroy(&concurrent_cache);
+      TEST(concurrent_cache.shards == NULL);
+    }
+  }
+#endif
+
+  return 0;
+}
+
+#endif /* TEST_CACHE_H */
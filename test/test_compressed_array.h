@@ -0,0 +1,134 @@
+#ifndef TEST_COMPRESSED_ARRAY_H
+#define TEST_COMPRESSED_ARRAY_H
+
+#include "test.h"
+#include <rsv/containers/compressed_array.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Fills values in runs of 1000 with a different shape per run */
+static inline uint64_t compressed_array_value(unsigned int i,
+                                              unsigned int* seed) {
+  *seed = *seed * 1103515245 + 12345;
+
+  switch (i / 1000 % 5) {
+  case 0:
+    /* Sorted with small gaps, DELTA */
+    return (uint64_t)i * 7 + (*seed >> 16) % 4;
+  case 1:
+    /* Small range around a large base, FOR */
+    return 0x123456789ull + (*seed >> 16) % 1000;
+  case 2:
+    /* Small values with rare huge outliers, VARINT */
+    return i % 61 == 0 ? (uint64_t)*seed << 40 : (*seed >> 16) % 50;
+  case 3:
+    /* Full 64 bit values */
+    return ((uint64_t)*seed << 32) ^ ((uint64_t)(*seed >> 3) * 2654435761u);
+  default:
+    /* Descending, negative deltas */
+    return 1000000000ull - (uint64_t)i * 13;
+  }
+}
+
+static inline int test_compressed_array(void) {
+  static uint64_t reference[10050];
+  uint64_t decoded[RSV_COMPRESSED_ARRAY_BLOCK_SIZE];
+  rsv_compressed_array_t array;
+  unsigned int encodings[3] = {0, 0, 0};
+  unsigned int seed = 2024;
+  unsigned int amount;
+  size_t block;
+  size_t i;
+
+  /* Test: Create compressed array */
+  array = rsv_compressed_array_create();
+  TEST(array.amount == 0);
+  TEST(rsv_compressed_array_get(&array, 0) == 0);
+  TEST(rsv_compressed_array_decode(&array, 0, decoded) == 0);
+  TEST(rsv_compressed_array_size(&array) == 0);
+
+  /* Test: Push values of every shape */
+  for (i = 0; i < 10050; i++) {
+    reference[i] = compressed_array_value((unsigned int)i, &seed);
+    rsv_compressed_array_push(&array, reference[i]);
+  }
+
+  TEST(array.amount == 10050);
+  TEST(array.blocks.amount == 10050 / RSV_COMPRESSED_ARRAY_BLOCK_SIZE);
+
+  for (block = 0; block < array.blocks.amount; block++) {
+    encodings[((rsv_compressed_array_block_t*)array.blocks.data)[block]
+                  .encoding]++;
+  }
+
+  TEST(encodings[RSV_COMPRESSED_ARRAY_FOR] > 0);
+  TEST(encodings[RSV_COMPRESSED_ARRAY_DELTA] > 0);
+  TEST(encodings[RSV_COMPRESSED_ARRAY_VARINT] > 0);
+
+  /* Test: Random access, in order and scattered */
+  for (i = 0; i < 10050; i++) {
+    TEST(rsv_compressed_array_get(&array, i) == reference[i]);
+  }
+
+  for (i = 0; i < 10050; i++) {
+    size_t index = (i * 7919) % 10050;
+
+    TEST(rsv_compressed_array_get(&array, index) == reference[index]);
+  }
+
+  TEST(rsv_compressed_array_get(&array, 10050) == 0);
+
+  /* Test: Block decode */
+  for (block = 0, i = 0; block <= array.blocks.amount; block++) {
+    unsigned int j;
+
+    amount = rsv_compressed_array_decode(&array, block, decoded);
+    TEST(amount == (block < array.blocks.amount
+                        ? RSV_COMPRESSED_ARRAY_BLOCK_SIZE
+                        : 10050 % RSV_COMPRESSED_ARRAY_BLOCK_SIZE));
+
+    for (j = 0; j < amount; j++, i++) {
+      TEST(decoded[j] == reference[i]);
+    }
+  }
+
+  TEST(i == 10050);
+  TEST(rsv_compressed_array_decode(&array, block, decoded) == 0);
+  rsv_compressed_array_destroy(&array);
+
+  /* Test: Sorted and small values compress well */
+  array = rsv_compressed_array_create();
+
+  for (i = 0; i < 100000; i++) {
+    rsv_compressed_array_push(&array, 1000000 + i * 3 + (i % 5 == 0));
+  }
+
+  TEST(rsv_compressed_array_size(&array) * 8 < array.amount * sizeof(uint64_t));
+  TEST(rsv_compressed_array_get(&array, 54321) == 1000000 + 54321 * 3);
+  rsv_compressed_array_destroy(&array);
+
+  array = rsv_compressed_array_create();
+
+  for (i = 0; i < 100000; i++) {
+    rsv_compressed_array_push(&array, (i * 2654435761u) % 4096);
+  }
+
+  TEST(rsv_compressed_array_size(&array) * 4 < array.amount * sizeof(uint64_t));
+  TEST(rsv_compressed_array_get(&array, 99999) == (99999 * 2654435761u) % 4096);
+  rsv_compressed_array_destroy(&array);
+
+  /* Test: Constant values take no packed bits */
+  array = rsv_compressed_array_create();
+
+  for (i = 0; i < 1024; i++) {
+    rsv_compressed_array_push(&array, 42);
+  }
+
+  TEST(array.data_size == 0);
+  TEST(rsv_compressed_array_get(&array, 1000) == 42);
+  rsv_compressed_array_destroy(&array);
+
+  return 0;
+}
+
+#endif /* TEST_COMPRESSED_ARRAY_H */
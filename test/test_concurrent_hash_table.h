@@ -0,0 +1,117 @@
+#if defined(__unix__)
+
+#ifndef TEST_CONCURRENT_HASH_TABLE_H
+#define TEST_CONCURRENT_HASH_TABLE_H
+
+#include "test.h"
+#include <rsv/containers/concurrent_hash_table.h>
+#include <rsv/safe/string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct concurrent_hash_table_data_t {
+  rsv_concurrent_hash_table_t* hash_table;
+  int offset;
+  int found;
+} concurrent_hash_table_data_t;
+
+static inline void* push_concurrent_hash_table(void* arg) {
+  concurrent_hash_table_data_t* data = (concurrent_hash_table_data_t*)arg;
+  int value;
+  int i;
+
+  for (i = 0; i < 1000; i++) {
+    int key = data->offset + i;
+    value = key * 2;
+    rsv_concurrent_hash_table_push(data->hash_table, &key, &value);
+
+    if (rsv_concurrent_hash_table_get(data->hash_table, &key, &value) &&
+        value == key * 2) {
+      data->found++;
+    }
+  }
+
+  return NULL;
+}
+
+static inline int test_concurrent_hash_table(void) {
+  int test_int;
+  char test_key[16];
+  rsv_concurrent_hash_table_t hash_table;
+  rsv_thread_t threads[4];
+  concurrent_hash_table_data_t data[4];
+  int i;
+
+  /* Test: Create concurrent hash table */
+  TEST(rsv_concurrent_hash_table_create(&hash_table, 3, 16, sizeof(test_key),
+                                        sizeof(int), NULL, NULL) == 0);
+  TEST(hash_table.shard_amount == 4);
+  TEST(rsv_concurrent_hash_table_amount(&hash_table) == 0);
+
+  /* Test: Insert key-value pairs */
+  rsv_strcpy(test_key, "key1", sizeof(test_key));
+  test_int = 100;
+  rsv_concurrent_hash_table_push(&hash_table, test_key, &test_int);
+
+  rsv_strcpy(test_key, "key2", sizeof(test_key));
+  test_int = 200;
+  rsv_concurrent_hash_table_push(&hash_table, test_key, &test_int);
+  TEST(rsv_concurrent_hash_table_amount(&hash_table) == 2);
+
+  /* Test: Retrieve values */
+  rsv_strcpy(test_key, "key1", sizeof(test_key));
+  TEST(rsv_concurrent_hash_table_get(&hash_table, test_key, &test_int) == 1);
+  TEST(test_int == 100);
+
+  /* Test: Replace a value */
+  test_int = 150;
+  rsv_concurrent_hash_table_push(&hash_table, test_key, &test_int);
+  TEST(rsv_concurrent_hash_table_amount(&hash_table) == 2);
+  TEST(rsv_concurrent_hash_table_get(&hash_table, test_key, &test_int) == 1);
+  TEST(test_int == 150);
+
+  /* Test: Remove key */
+  rsv_strcpy(test_key, "key2", sizeof(test_key));
+  rsv_concurrent_hash_table_pop(&hash_table, test_key);
+  TEST(rsv_concurrent_hash_table_amount(&hash_table) == 1);
+  TEST(rsv_concurrent_hash_table_get(&hash_table, test_key, NULL) == 0);
+
+  rsv_concurrent_hash_table_destroy(&hash_table);
+  TEST(hash_table.shards == NULL);
+
+  /* Test: Concurrent pushes and gets, shards resize independently */
+  TEST(rsv_concurrent_hash_table_create(&hash_table, 8, 8, sizeof(int),
+                                        sizeof(int), NULL, NULL) == 0);
+
+  for (i = 0; i < 4; i++) {
+    data[i].hash_table = &hash_table;
+    data[i].offset = i * 1000;
+    data[i].found = 0;
+    TEST(rsv_thread_create(&threads[i], push_concurrent_hash_table,
+                           &data[i]) == 0);
+  }
+
+  for (i = 0; i < 4; i++) {
+    TEST(rsv_thread_join(threads[i], NULL) == 0);
+    TEST(data[i].found == 1000);
+  }
+
+  TEST(rsv_concurrent_hash_table_amount(&hash_table) == 4000);
+
+  for (i = 0; i < 4000; i++) {
+    TEST(rsv_concurrent_hash_table_get(&hash_table, &i, &test_int) == 1);
+    TEST(test_int == i * 2);
+  }
+
+  for (i = 0; i < (int)hash_table.shard_amount; i++) {
+    TEST(hash_table.shards[i].hash_table.amount > 0);
+  }
+
+  rsv_concurrent_hash_table_destroy(&hash_table);
+
+  return 0;
+}
+
+#endif /* TEST_CONCURRENT_HASH_TABLE_H */
+
+#endif
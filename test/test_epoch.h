@@ -0,0 +1,75 @@
+#if defined(__unix__)
+
+#ifndef TEST_EPOCH_H
+#define TEST_EPOCH_H
+
+#include "test.h"
+#include <rsv/threads/epoch.h>
+#include <stdlib.h>
+
+static int epoch_freed = 0;
+
+static inline void free_epoch(void* pointer) {
+  free(pointer);
+  epoch_freed++;
+}
+
+static inline int test_epoch(void) {
+  rsv_epoch_t epoch;
+  rsv_epoch_participant_t* reader;
+  rsv_epoch_participant_t* writer;
+  int i;
+
+  /* Test: Create epoch domain and register participants */
+  TEST(rsv_epoch_create(&epoch) == 0);
+  reader = rsv_epoch_register(&epoch);
+  writer = rsv_epoch_register(&epoch);
+  TEST(reader != NULL && writer != NULL && reader != writer);
+
+  /* Test: Retired pointers outlive an active reader */
+  rsv_epoch_enter(reader);
+  TEST(rsv_epoch_retire(writer, malloc(16), free_epoch) == 0);
+
+  for (i = 0; i < 4; i++) {
+    rsv_epoch_collect(writer);
+  }
+
+  TEST(epoch_freed == 0);
+
+  /* Test: Nested critical sections keep the reader active */
+  rsv_epoch_enter(reader);
+  rsv_epoch_exit(reader);
+  rsv_epoch_collect(writer);
+  TEST(epoch_freed == 0);
+
+  /* Test: Retired pointers are freed once the reader exits */
+  rsv_epoch_exit(reader);
+
+  for (i = 0; i < 4; i++) {
+    rsv_epoch_collect(writer);
+  }
+
+  TEST(epoch_freed == 1);
+
+  /* Test: Unregistered records are reused */
+  rsv_epoch_unregister(reader);
+  TEST(rsv_epoch_register(&epoch) == reader);
+
+  /* Test: Retiring collects automatically */
+  for (i = 0; i < RSV_EPOCH_COLLECT_THRESHOLD * 4; i++) {
+    TEST(rsv_epoch_retire(writer, malloc(16), free_epoch) == 0);
+  }
+
+  TEST(epoch_freed > 1);
+
+  /* Test: Destroying frees what is still pending */
+  rsv_epoch_destroy(&epoch);
+  TEST(epoch_freed == 1 + RSV_EPOCH_COLLECT_THRESHOLD * 4);
+  TEST(epoch.participants == NULL);
+
+  return 0;
+}
+
+#endif /* TEST_EPOCH_H */
+
+#endif
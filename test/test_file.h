@@ -0,0 +1,127 @@
+#if defined(__unix__)
+
+#ifndef TEST_FILE_H
+#define TEST_FILE_H
+
+#include "test.h"
+#include <rsv/safe/file.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline int test_file(void) {
+  char path[] = "/tmp/rsv_test_file_XXXXXX";
+  char line[512];
+  rsv_file_writer_t writer;
+  rsv_file_reader_t reader;
+  rsv_file_map_t map;
+  rsv_string_view_t record;
+  size_t expected_size = 0;
+  int descriptor = mkstemp(path);
+  int amount;
+  int i;
+
+  TEST(descriptor >= 0);
+  close(descriptor);
+
+  /* Test: Small writes are coalesced, large ones go straight through */
+  TEST(rsv_file_writer_open(&writer, path, 0, 64) == 0);
+
+  for (i = 0; i < 1000; i++) {
+    int length = snprintf(line, sizeof(line), "line %d\n", i);
+
+    TEST(rsv_file_writer_write(&writer, line, (size_t)length) == 0);
+    expected_size += (size_t)length;
+  }
+
+  memset(line, 'x', 300);
+  line[300] = '\n';
+  TEST(rsv_file_writer_write(&writer, line, 301) == 0);
+  TEST(rsv_file_writer_write_view(&writer, rsv_string_view_from("last")) == 0);
+  expected_size += 305;
+  TEST(rsv_file_writer_close(&writer) == 0);
+
+  /* Test: Map the file */
+  TEST(rsv_file_map(&map, path, RSV_FILE_SEQUENTIAL | RSV_FILE_HUGE_PAGES) ==
+       0);
+  TEST(map.size == expected_size);
+  TEST(memcmp(map.data, "line 0\nline 1\n", 14) == 0);
+  TEST(rsv_string_view_ends_with(rsv_file_map_view(&map),
+                                 rsv_string_view_from("x\nlast")));
+
+  /* Test: Records from the mapping point into it */
+  reader = rsv_file_reader_create(rsv_file_map_view(&map));
+  amount = 0;
+
+  while (rsv_file_reader_next(&reader, '\n', &record)) {
+    TEST(record.data >= map.data && record.data < map.data + map.size);
+    amount++;
+  }
+
+  TEST(amount == 1002);
+  TEST(rsv_string_view_equal(record, rsv_string_view_from("last")));
+  TEST(rsv_file_reader_error(&reader) == 0);
+  rsv_file_reader_close(&reader);
+
+  /* Test: Buffered reading with a buffer smaller than a record */
+  TEST(rsv_file_reader_open(&reader, path, 16) == 0);
+
+  for (i = 0; i < 1000; i++) {
+    snprintf(line, sizeof(line), "line %d", i);
+    TEST(rsv_file_reader_next(&reader, '\n', &record) == 1);
+    TEST(rsv_string_view_equal(record, rsv_string_view_from(line)));
+  }
+
+  TEST(rsv_file_reader_next(&reader, '\n', &record) == 1);
+  TEST(record.length == 300 && record.data[299] == 'x');
+  TEST(rsv_file_reader_next(&reader, '\n', &record) == 1);
+  TEST(rsv_string_view_equal(record, rsv_string_view_from("last")));
+  TEST(rsv_file_reader_next(&reader, '\n', &record) == 0);
+  TEST(rsv_file_reader_error(&reader) == 0);
+  rsv_file_reader_close(&reader);
+  rsv_file_unmap(&map);
+  TEST(map.data == NULL && map.size == 0);
+
+  /* Test: Append, then read records ending with a delimiter */
+  TEST(rsv_file_writer_open(&writer, path, 0, 0) == 0);
+  TEST(rsv_file_writer_write(&writer, "a;b;", 4) == 0);
+  TEST(rsv_file_writer_close(&writer) == 0);
+  TEST(rsv_file_writer_open(&writer, path, 1, 0) == 0);
+  TEST(rsv_file_writer_write(&writer, ";c;", 3) == 0);
+  TEST(rsv_file_writer_close(&writer) == 0);
+  TEST(rsv_file_reader_open(&reader, path, 0) == 0);
+  amount = 0;
+
+  while (rsv_file_reader_next(&reader, ';', &record)) {
+    TEST(amount != 2 || record.length == 0);
+    amount++;
+  }
+
+  TEST(amount == 4);
+  rsv_file_reader_close(&reader);
+
+  /* Test: Empty and missing files */
+  TEST(rsv_file_writer_open(&writer, path, 0, 0) == 0);
+  TEST(rsv_file_writer_close(&writer) == 0);
+  TEST(rsv_file_map(&map, path, 0) == 0);
+  TEST(map.data == NULL && map.size == 0);
+  rsv_file_unmap(&map);
+  TEST(rsv_file_reader_open(&reader, path, 0) == 0);
+  TEST(rsv_file_reader_next(&reader, '\n', &record) == 0);
+  rsv_file_reader_close(&reader);
+  unlink(path);
+  TEST(rsv_file_map(&map, path, 0) == ENOENT);
+  TEST(rsv_file_reader_open(&reader, path, 0) == ENOENT);
+  TEST(reader.descriptor == -1);
+  rsv_file_reader_close(&reader);
+  TEST(rsv_file_writer_open(&writer, "/nonexistent/directory/file", 0, 0) ==
+       ENOENT);
+  TEST(writer.descriptor == -1);
+  TEST(rsv_file_writer_close(&writer) == ENOENT);
+
+  return 0;
+}
+
+#endif /* TEST_FILE_H */
+
+#endif
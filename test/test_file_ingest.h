@@ -0,0 +1,205 @@
+#if defined(__unix__)
+
+#ifndef TEST_FILE_INGEST_H
+#define TEST_FILE_INGEST_H
+
+#include "test.h"
+#include <rsv/safe/file_ingest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct test_file_ingest_state_t {
+  long partials;
+  long next;
+  int stop_at;
+} test_file_ingest_state_t;
+
+static inline int test_file_ingest_number(void* context,
+                                          rsv_string_view_t record,
+                                          void* key, void* value) {
+  int number = 0;
+  size_t i;
+
+  (void)context;
+  record = rsv_string_view_trim(record);
+
+  if (record.length == 0 || record.data[0] == '#') {
+    return 0;
+  }
+
+  for (i = 0; i < record.length && record.data[i] != ' '; ++i) {
+    number = number * 10 + (record.data[i] - '0');
+  }
+
+  memcpy(key, &number, sizeof(number));
+
+  if (value != NULL) {
+    int square = number * number;
+    memcpy(value, &square, sizeof(square));
+  }
+
+  return 1;
+}
+
+static inline int test_file_ingest_dynamic_array_record(
+    void* context, rsv_string_view_t record, void* element, void* unused) {
+  (void)unused;
+  return test_file_ingest_number(context, record, element, NULL);
+}
+
+static inline void* test_file_ingest_parse(void* context,
+                                           rsv_string_view_t records) {
+  test_file_ingest_state_t* state = (test_file_ingest_state_t*)context;
+  rsv_dynamic_array_t* numbers =
+      (rsv_dynamic_array_t*)malloc(sizeof(rsv_dynamic_array_t));
+  rsv_file_reader_t reader = rsv_file_reader_create(records);
+  rsv_string_view_t record;
+  int number;
+
+  *numbers = rsv_dynamic_array_create(8, sizeof(int));
+
+  while (rsv_file_reader_next(&reader, '\n', &record)) {
+    if (test_file_ingest_number(NULL, record, &number, NULL)) {
+      rsv_dynamic_array_push(numbers, &number);
+    }
+  }
+
+  rsv_atomic_fetch_add(&state->partials, 1, RSV_MEMORY_ORDER_RELAXED);
+
+  return numbers;
+}
+
+static inline void test_file_ingest_discard(void* context, void* partial) {
+  test_file_ingest_state_t* state = (test_file_ingest_state_t*)context;
+
+  rsv_dynamic_array_destroy((rsv_dynamic_array_t*)partial);
+  free(partial);
+  rsv_atomic_fetch_add(&state->partials, -1, RSV_MEMORY_ORDER_RELAXED);
+}
+
+static inline int test_file_ingest_merge(void* context, void* partial) {
+  test_file_ingest_state_t* state = (test_file_ingest_state_t*)context;
+  rsv_dynamic_array_t* numbers = (rsv_dynamic_array_t*)partial;
+  unsigned int i;
+  int result = 0;
+
+  for (i = 0; i < numbers->amount && result == 0; ++i) {
+    /* Merges must arrive in file order */
+    if (*(int*)rsv_dynamic_array_get(numbers, i) != state->next) {
+      result = EINVAL;
+    } else if (state->next++ == state->stop_at) {
+      result = ECANCELED;
+    }
+  }
+
+  test_file_ingest_discard(context, partial);
+
+  return result;
+}
+
+static inline int test_file_ingest(void) {
+  char path[] = "/tmp/rsv_test_ingest_XXXXXX";
+  rsv_thread_pool_t pool;
+  rsv_file_writer_t writer;
+  rsv_file_ingest_t ingest;
+  test_file_ingest_state_t state;
+  rsv_dynamic_array_t array;
+  rsv_hash_table_t hash_table;
+  char line[512];
+  int descriptor = mkstemp(path);
+  int i;
+
+  TEST(descriptor >= 0);
+  close(descriptor);
+  TEST(rsv_thread_pool_create(&pool, 4, 0) == 0);
+
+  /* Lines of varying length, some longer than a chunk, and comments */
+  TEST(rsv_file_writer_open(&writer, path, 0, 0) == 0);
+
+  for (i = 0; i < 5000; ++i) {
+    int length = snprintf(line, sizeof(line), "%d %.*s\n", i, i % 17 * 11,
+                          "padding padding padding padding padding padding "
+                          "padding padding padding padding padding padding "
+                          "padding padding padding padding padding padding "
+                          "padding padding padding padding padding padding");
+
+    TEST(rsv_file_writer_write(&writer, line, (size_t)length) == 0);
+
+    if (i % 100 == 0) {
+      TEST(rsv_file_writer_write(&writer, "# comment\n", 10) == 0);
+    }
+  }
+
+  /* The last record has no delimiter */
+  TEST(rsv_file_writer_write(&writer, "5000", 4) == 0);
+  TEST(rsv_file_writer_close(&writer) == 0);
+
+  /* Test: Records are parsed in parallel and merged in file order */
+  state.partials = 0;
+  state.next = 0;
+  state.stop_at = -1;
+  ingest = rsv_file_ingest_create(test_file_ingest_parse,
+                                  test_file_ingest_merge, &state);
+  ingest.discard = test_file_ingest_discard;
+  ingest.chunk_size = 64;
+  ingest.window = 3;
+  TEST(rsv_file_ingest(&pool, &ingest, path) == 0);
+  TEST(state.next == 5001);
+  TEST(state.partials == 0);
+
+  /* Test: Default chunk size and window */
+  state.next = 0;
+  ingest.chunk_size = RSV_FILE_INGEST_CHUNK_SIZE;
+  ingest.window = 0;
+  TEST(rsv_file_ingest(&pool, &ingest, path) == 0);
+  TEST(state.next == 5001);
+
+  /* Test: A failing merge stops ingesting and discards the rest */
+  state.next = 0;
+  state.stop_at = 2500;
+  ingest.chunk_size = 100;
+  ingest.window = 8;
+  TEST(rsv_file_ingest(&pool, &ingest, path) == ECANCELED);
+  TEST(state.next == 2501);
+  TEST(state.partials == 0);
+
+  /* Test: Ingest into containers */
+  array = rsv_dynamic_array_create(16, sizeof(int));
+  TEST(rsv_file_ingest_dynamic_array(&pool, path, '\n', &array,
+                                     test_file_ingest_dynamic_array_record,
+                                     NULL) == 0);
+  TEST(array.amount == 5001);
+
+  for (i = 0; i < 5001; ++i) {
+    TEST(*(int*)rsv_dynamic_array_get(&array, (unsigned int)i) == i);
+  }
+
+  rsv_dynamic_array_destroy(&array);
+
+  hash_table = rsv_hash_table_create(16, sizeof(int), sizeof(int), NULL, NULL);
+  TEST(rsv_file_ingest_hash_table(&pool, path, '\n', &hash_table,
+                                  test_file_ingest_number, NULL) == 0);
+  TEST(hash_table.amount == 5001);
+  i = 4321;
+  TEST(*(int*)rsv_hash_table_get(&hash_table, &i) == 4321 * 4321);
+  rsv_hash_table_destroy(&hash_table);
+
+  /* Test: Empty and missing files */
+  TEST(rsv_file_writer_open(&writer, path, 0, 0) == 0);
+  TEST(rsv_file_writer_close(&writer) == 0);
+  state.next = 0;
+  state.stop_at = -1;
+  TEST(rsv_file_ingest(&pool, &ingest, path) == 0);
+  TEST(state.next == 0);
+  unlink(path);
+  TEST(rsv_file_ingest(&pool, &ingest, path) == ENOENT);
+
+  rsv_thread_pool_destroy(&pool);
+
+  return 0;
+}
+
+#endif /* TEST_FILE_INGEST_H */
+
+#endif
@@ -41,6 +41,13 @@ static inline int test_hash_set(void) {
   test_key = &test_int;
   TEST(rsv_hash_set_contains(&hash_set, test_key) == 0);
 
+  /* Test: Get the stored element */
+  test_int = 100;
+  TEST(rsv_hash_set_get(&hash_set, &test_int) != &test_int);
+  TEST(*(int*)rsv_hash_set_get(&hash_set, &test_int) == 100);
+  test_int = 300;
+  TEST(rsv_hash_set_get(&hash_set, &test_int) == NULL);
+
   /* Test: Insert with key collision (same hash index) */
   test_int = 300;
   test_key = &test_int;
@@ -0,0 +1,137 @@
+#ifndef TEST_INTERN_POOL_H
+#define TEST_INTERN_POOL_H
+
+#include "test.h"
+#include <rsv/containers/intern_pool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__)
+typedef struct intern_pool_data_t {
+  rsv_concurrent_intern_pool_t* pool;
+  const char* interned[100];
+} intern_pool_data_t;
+
+static inline void* intern_concurrent_intern_pool(void* arg) {
+  intern_pool_data_t* data = (intern_pool_data_t*)arg;
+  char buffer[16];
+  int round;
+  int i;
+
+  for (round = 0; round < 10; round++) {
+    for (i = 0; i < 100; i++) {
+      snprintf(buffer, sizeof(buffer), "id%d", i);
+      data->interned[i] = rsv_concurrent_intern_pool_intern(data->pool, buffer);
+    }
+  }
+
+  return NULL;
+}
+#endif
+
+static inline int test_intern_pool(void) {
+  rsv_intern_pool_t pool = rsv_intern_pool_create(2);
+  char buffer[16];
+  char* large;
+  const char* first;
+  const char* second;
+  int i;
+
+  /* Test: Interning the same characters gives the same pointer */
+  snprintf(buffer, sizeof(buffer), "hello");
+  first = rsv_intern_pool_intern(&pool, buffer);
+  TEST(first != NULL && first != buffer);
+  TEST(strcmp(first, "hello") == 0);
+  second = rsv_intern_pool_intern(&pool, "hello");
+  TEST(first == second);
+  TEST(rsv_intern_pool_amount(&pool) == 1);
+
+  /* Test: Distinct strings get distinct pointers and ids */
+  second = rsv_intern_pool_intern(&pool, "world");
+  TEST(second != first);
+  TEST(rsv_intern_pool_id(first) == 0);
+  TEST(rsv_intern_pool_id(second) == 1);
+  TEST(rsv_intern_pool_length(second) == 5);
+  TEST(rsv_intern_pool_string(&pool, 1) == second);
+  TEST(rsv_intern_pool_string(&pool, 2) == NULL);
+
+  /* Test: Prefixes and embedded null bytes are distinct strings */
+  TEST(rsv_intern_pool_intern_n(&pool, "hello", 4) != first);
+  TEST(rsv_intern_pool_intern_n(&pool, "a\0b", 3) !=
+       rsv_intern_pool_intern_n(&pool, "a\0c", 3));
+  TEST(rsv_intern_pool_intern(&pool, "") != NULL);
+  TEST(rsv_intern_pool_amount(&pool) == 6);
+
+  /* Test: Find without interning */
+  TEST(rsv_intern_pool_find(&pool, "world") == second);
+  TEST(rsv_intern_pool_find(&pool, "missing") == NULL);
+  TEST(rsv_intern_pool_amount(&pool) == 6);
+
+  /* Test: Pointers stay stable while the pool grows */
+  for (i = 0; i < 20000; i++) {
+    snprintf(buffer, sizeof(buffer), "id%d", i);
+    TEST(rsv_intern_pool_intern(&pool, buffer) != NULL);
+  }
+
+  TEST(rsv_intern_pool_intern(&pool, "hello") == first);
+  TEST(strcmp(first, "hello") == 0);
+
+  for (i = 0; i < 20000; i += 997) {
+    snprintf(buffer, sizeof(buffer), "id%d", i);
+    TEST(strcmp(rsv_intern_pool_string(&pool, (unsigned int)i + 6), buffer) ==
+         0);
+  }
+
+  /* Test: Strings larger than a chunk */
+  large = (char*)malloc(RSV_INTERN_POOL_CHUNK_SIZE * 2);
+  memset(large, 'x', RSV_INTERN_POOL_CHUNK_SIZE * 2 - 1);
+  large[RSV_INTERN_POOL_CHUNK_SIZE * 2 - 1] = '\0';
+  first = rsv_intern_pool_intern(&pool, large);
+  TEST(first != NULL && strcmp(first, large) == 0);
+  TEST(rsv_intern_pool_intern(&pool, large) == first);
+  free(large);
+
+  rsv_intern_pool_destroy(&pool);
+  TEST(pool.chunks == NULL);
+
+#if defined(__unix__)
+  /* Test: Concurrent interning agrees on a single pointer per string */
+  {
+    rsv_concurrent_intern_pool_t concurrent_pool;
+    rsv_thread_t threads[4];
+    intern_pool_data_t data[4];
+    int j;
+
+    TEST(rsv_concurrent_intern_pool_create(&concurrent_pool, 16) == 0);
+
+    for (i = 0; i < 4; i++) {
+      data[i].pool = &concurrent_pool;
+      TEST(rsv_thread_create(&threads[i], intern_concurrent_intern_pool,
+                             &data[i]) == 0);
+    }
+
+    for (i = 0; i < 4; i++) {
+      TEST(rsv_thread_join(threads[i], NULL) == 0);
+    }
+
+    TEST(rsv_intern_pool_amount(&concurrent_pool.pool) == 100);
+
+    for (i = 0; i < 100; i++) {
+      for (j = 1; j < 4; j++) {
+        TEST(data[j].interned[i] == data[0].interned[i]);
+      }
+
+      TEST(rsv_concurrent_intern_pool_string(
+               &concurrent_pool, rsv_intern_pool_id(data[0].interned[i])) ==
+           data[0].interned[i]);
+    }
+
+    rsv_concurrent_intern_pool_destroy(&concurrent_pool);
+  }
+#endif
+
+  return 0;
+}
+
+#endif /* TEST_INTERN_POOL_H */
@@ -0,0 +1,183 @@
+#if defined(__unix__)
+
+#ifndef TEST_LOCKFREE_HASH_TABLE_H
+#define TEST_LOCKFREE_HASH_TABLE_H
+
+#include "test.h"
+#include <rsv/containers/lockfree_hash_table.h>
+#include <rsv/safe/string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct lockfree_hash_table_data_t {
+  rsv_lockfree_hash_table_t* hash_table;
+  int offset;
+  int mismatches;
+} lockfree_hash_table_data_t;
+
+static inline void* write_lockfree_hash_table(void* arg) {
+  lockfree_hash_table_data_t* data = (lockfree_hash_table_data_t*)arg;
+  rsv_epoch_participant_t* participant =
+      rsv_lockfree_hash_table_register(data->hash_table);
+  int value;
+  int i;
+
+  for (i = 0; i < 1000; i++) {
+    int key = data->offset + i;
+    value = key * 2;
+    rsv_lockfree_hash_table_push(data->hash_table, participant, &key, &value);
+    value = key * 3;
+    rsv_lockfree_hash_table_push(data->hash_table, participant, &key, &value);
+
+    if (i % 2) {
+      rsv_lockfree_hash_table_pop(data->hash_table, participant, &key);
+    }
+  }
+
+  rsv_epoch_unregister(participant);
+
+  return NULL;
+}
+
+static inline void* read_lockfree_hash_table(void* arg) {
+  lockfree_hash_table_data_t* data = (lockfree_hash_table_data_t*)arg;
+  rsv_epoch_participant_t* participant =
+      rsv_lockfree_hash_table_register(data->hash_table);
+  int round;
+  int key;
+
+  for (round = 0; round < 20; round++) {
+    for (key = 0; key < 2000; key++) {
+      const int* value;
+
+      rsv_epoch_enter(participant);
+      value = (const int*)rsv_lockfree_hash_table_get(data->hash_table, &key);
+
+      if (value && *value != key * 2 && *value != key * 3) {
+        data->mismatches++;
+      }
+
+      rsv_epoch_exit(participant);
+    }
+  }
+
+  rsv_epoch_unregister(participant);
+
+  return NULL;
+}
+
+static inline int test_lockfree_hash_table(void) {
+  int test_int;
+  char test_key[16];
+  const int* found;
+  rsv_lockfree_hash_table_t hash_table;
+  rsv_epoch_participant_t* participant;
+  rsv_thread_t threads[4];
+  lockfree_hash_table_data_t data[4];
+  int i;
+
+  /* Test: Create lock-free hash table */
+  TEST(rsv_lockfree_hash_table_create(&hash_table, 3, sizeof(test_key),
+                                      sizeof(int), NULL, NULL) == 0);
+  TEST(hash_table.array->capacity == 4);
+  participant = rsv_lockfree_hash_table_register(&hash_table);
+  TEST(participant != NULL);
+
+  /* Test: Insert key-value pairs */
+  rsv_strcpy(test_key, "key1", sizeof(test_key));
+  test_int = 100;
+  TEST(rsv_lockfree_hash_table_push(&hash_table, participant, test_key,
+                                    &test_int) == 0);
+
+  rsv_strcpy(test_key, "key2", sizeof(test_key));
+  test_int = 200;
+  TEST(rsv_lockfree_hash_table_push(&hash_table, participant, test_key,
+                                    &test_int) == 0);
+  TEST(rsv_lockfree_hash_table_amount(&hash_table) == 2);
+
+  /* Test: Retrieve values */
+  rsv_strcpy(test_key, "key1", sizeof(test_key));
+  rsv_epoch_enter(participant);
+  found = (const int*)rsv_lockfree_hash_table_get(&hash_table, test_key);
+  TEST(found != NULL && *found == 100);
+
+  /* Test: Replaced values stay readable until the reader exits */
+  test_int = 150;
+  TEST(rsv_lockfree_hash_table_push(&hash_table, participant, test_key,
+                                    &test_int) == 0);
+  TEST(*found == 100);
+  rsv_epoch_exit(participant);
+  TEST(rsv_lockfree_hash_table_amount(&hash_table) == 2);
+
+  rsv_epoch_enter(participant);
+  found = (const int*)rsv_lockfree_hash_table_get(&hash_table, test_key);
+  TEST(found != NULL && *found == 150);
+  rsv_epoch_exit(participant);
+
+  /* Test: Remove key */
+  rsv_strcpy(test_key, "key2", sizeof(test_key));
+  TEST(rsv_lockfree_hash_table_pop(&hash_table, participant, test_key) == 1);
+  TEST(rsv_lockfree_hash_table_pop(&hash_table, participant, test_key) == 0);
+  TEST(rsv_lockfree_hash_table_amount(&hash_table) == 1);
+  rsv_epoch_enter(participant);
+  TEST(rsv_lockfree_hash_table_get(&hash_table, test_key) == NULL);
+  rsv_epoch_exit(participant);
+
+  /* Test: Resize past the initial capacity */
+  for (i = 0; i < 100; i++) {
+    snprintf(test_key, sizeof(test_key), "grow%d", i);
+    TEST(rsv_lockfree_hash_table_push(&hash_table, participant, test_key,
+                                      &i) == 0);
+  }
+
+  TEST(rsv_lockfree_hash_table_amount(&hash_table) == 101);
+  TEST(hash_table.array->capacity >= 128);
+  rsv_epoch_enter(participant);
+
+  for (i = 0; i < 100; i++) {
+    snprintf(test_key, sizeof(test_key), "grow%d", i);
+    found = (const int*)rsv_lockfree_hash_table_get(&hash_table, test_key);
+    TEST(found != NULL && *found == i);
+  }
+
+  rsv_epoch_exit(participant);
+  rsv_lockfree_hash_table_destroy(&hash_table);
+  TEST(hash_table.array == NULL);
+
+  /* Test: Readers run concurrently with writers replacing and popping */
+  TEST(rsv_lockfree_hash_table_create(&hash_table, 8, sizeof(int), sizeof(int),
+                                      NULL, NULL) == 0);
+
+  for (i = 0; i < 4; i++) {
+    data[i].hash_table = &hash_table;
+    data[i].offset = (i / 2) * 1000;
+    data[i].mismatches = 0;
+    TEST(rsv_thread_create(&threads[i],
+                           i % 2 ? read_lockfree_hash_table
+                                 : write_lockfree_hash_table,
+                           &data[i]) == 0);
+  }
+
+  for (i = 0; i < 4; i++) {
+    TEST(rsv_thread_join(threads[i], NULL) == 0);
+    TEST(data[i].mismatches == 0);
+  }
+
+  TEST(rsv_lockfree_hash_table_amount(&hash_table) == 1000);
+  participant = rsv_lockfree_hash_table_register(&hash_table);
+  rsv_epoch_enter(participant);
+
+  for (i = 0; i < 2000; i++) {
+    found = (const int*)rsv_lockfree_hash_table_get(&hash_table, &i);
+    TEST(i % 2 ? found == NULL : found != NULL && *found == i * 3);
+  }
+
+  rsv_epoch_exit(participant);
+  rsv_lockfree_hash_table_destroy(&hash_table);
+
+  return 0;
+}
+
+#endif /* TEST_LOCKFREE_HASH_TABLE_H */
+
+#endif
@@ -0,0 +1,65 @@
+#if defined(__unix__)
+
+#ifndef TEST_NUMA_H
+#define TEST_NUMA_H
+
+#include "test.h"
+#include <rsv/threads/numa.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static inline int test_numa(void) {
+  rsv_cpu_set_t cpus;
+  rsv_thread_attributes_t attributes;
+  unsigned char* memory;
+  unsigned int node_amount;
+  unsigned int cpu_amount = 0;
+  unsigned int node;
+
+  /* Test: Parse kernel lists */
+  TEST(rsv_numa_parse_list("0-3,8,10-11\n", &cpus) == 0);
+  TEST(rsv_cpu_set_amount(&cpus) == 7);
+  TEST(rsv_cpu_set_has(&cpus, 2) && rsv_cpu_set_has(&cpus, 8));
+  TEST(!rsv_cpu_set_has(&cpus, 9));
+  TEST(rsv_numa_parse_list("", &cpus) == 0);
+  TEST(rsv_cpu_set_amount(&cpus) == 0);
+  TEST(rsv_numa_parse_list("3-1", &cpus) == EINVAL);
+  TEST(rsv_numa_parse_list("a", &cpus) == EINVAL);
+
+  /* Test: Every node has CPUs and the current node is one of them */
+  node_amount = rsv_numa_node_amount();
+  TEST(node_amount >= 1);
+
+  for (node = 0; node < node_amount; node++) {
+    if (rsv_numa_node_cpus(node, &cpus) == 0) {
+      cpu_amount += rsv_cpu_set_amount(&cpus);
+    }
+  }
+
+  TEST(cpu_amount >= 1);
+  TEST(rsv_numa_current_node() < node_amount);
+  TEST(rsv_numa_node_cpus(RSV_CPU_SET_SIZE, &cpus) != 0);
+
+  /* Test: Thread attributes for a node */
+  rsv_thread_attributes_create(&attributes);
+  TEST(rsv_numa_thread_attributes(&attributes, 0) == 0);
+  TEST(rsv_cpu_set_amount(&attributes.cpus) >= 1);
+
+  /* Test: First-touch allocation */
+  memory = (unsigned char*)rsv_numa_alloc_local(10000);
+  TEST(memory != NULL);
+  TEST(((size_t)memory) % 4096 == 0);
+  TEST(memory[0] == 0 && memory[9999] == 0);
+  free(memory);
+
+  memory = (unsigned char*)rsv_numa_alloc_node(0, 10000);
+  TEST(memory != NULL);
+  TEST(memory[0] == 0 && memory[9999] == 0);
+  free(memory);
+
+  return 0;
+}
+
+#endif /* TEST_NUMA_H */
+
+#endif
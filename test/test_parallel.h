@@ -0,0 +1,173 @@
+#if defined(__unix__)
+
+#ifndef TEST_PARALLEL_H
+#define TEST_PARALLEL_H
+
+#include "test.h"
+#include <rsv/threads/parallel.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static inline void test_parallel_square(void* context, unsigned int begin,
+                                        unsigned int end) {
+  int* values = (int*)context;
+  unsigned int i;
+
+  for (i = begin; i < end; ++i) {
+    values[i] = (int)(i * i);
+  }
+}
+
+static inline void test_parallel_sum_range(void* context, unsigned int begin,
+                                           unsigned int end, void* partial) {
+  unsigned int i;
+
+  (void)context;
+
+  for (i = begin; i < end; ++i) {
+    *(long*)partial += i;
+  }
+}
+
+static inline void test_parallel_combine(void* context, void* result,
+                                         const void* partial) {
+  (void)context;
+  *(long*)result += *(const long*)partial;
+}
+
+static inline void test_parallel_double(void* context, void* element,
+                                        unsigned int index) {
+  (void)context;
+  (void)index;
+  *(int*)element *= 2;
+}
+
+static inline void test_parallel_to_long(void* context, const void* source,
+                                         void* destination) {
+  (void)context;
+  *(long*)destination = *(const int*)source + 1;
+}
+
+static inline void test_parallel_sum_element(void* context, void* partial,
+                                             const void* key,
+                                             const void* value) {
+  (void)context;
+  (void)value;
+  *(long*)partial += *(const int*)key;
+}
+
+static inline void test_parallel_sum_value(void* context, void* partial,
+                                           const void* key, const void* value) {
+  (void)context;
+  (void)key;
+  *(long*)partial += *(const int*)value;
+}
+
+static inline void test_parallel_count_entry(void* context, const void* key,
+                                             void* value) {
+  (void)key;
+  (void)value;
+  rsv_atomic_fetch_add((long*)context, 1, RSV_MEMORY_ORDER_RELAXED);
+}
+
+static inline int test_parallel(void) {
+  rsv_thread_pool_t pool;
+  rsv_dynamic_array_t array;
+  rsv_dynamic_array_t mapped;
+  rsv_hash_table_t hash_table;
+  rsv_hash_set_t hash_set;
+  int values[1000];
+  long result;
+  int i;
+
+  TEST(rsv_thread_pool_create(&pool, 4, 0) == 0);
+
+  /* Test: Parallel for over a range */
+  TEST(rsv_parallel_for(&pool, 0, 1000, 7, test_parallel_square, values) ==
+       0);
+
+  for (i = 0; i < 1000; ++i) {
+    TEST(values[i] == i * i);
+  }
+
+  /* Test: Empty range */
+  TEST(rsv_parallel_for(&pool, 10, 10, 0, test_parallel_square, values) == 0);
+
+  /* Test: Parallel reduce over a range */
+  result = 0;
+  TEST(rsv_parallel_reduce(&pool, 0, 100000, 0, &result, sizeof(result),
+                           test_parallel_sum_range, test_parallel_combine,
+                           NULL) == 0);
+  TEST(result == 4999950000L);
+
+  /* Test: For each, map and reduce over a dynamic array */
+  array = rsv_dynamic_array_create(2, sizeof(int));
+
+  for (i = 0; i < 1000; ++i) {
+    rsv_dynamic_array_push(&array, &i);
+  }
+
+  TEST(rsv_parallel_for_dynamic_array(&pool, &array, 0, test_parallel_double,
+                                      NULL) == 0);
+  TEST(*(int*)rsv_dynamic_array_get(&array, 999) == 1998);
+
+  mapped = rsv_dynamic_array_create(1, sizeof(long));
+  TEST(rsv_parallel_map_dynamic_array(&pool, &array, &mapped, 16,
+                                      test_parallel_to_long, NULL) == 0);
+  TEST(mapped.amount == 1000);
+  TEST(*(long*)rsv_dynamic_array_get(&mapped, 999) == 1999);
+
+  result = 0;
+  TEST(rsv_parallel_reduce_dynamic_array(
+           &pool, &array, 0, &result, sizeof(result), test_parallel_sum_element,
+           test_parallel_combine, NULL) == 0);
+  TEST(result == 999000);
+
+  /* Test: For each and reduce over hash table buckets */
+  hash_table = rsv_hash_table_create(2, sizeof(int), sizeof(int), NULL, NULL);
+
+  for (i = 0; i < 500; ++i) {
+    rsv_hash_table_push(&hash_table, &i, &i);
+  }
+
+  result = 0;
+  TEST(rsv_parallel_for_hash_table(&pool, &hash_table, 0,
+                                   test_parallel_count_entry, &result) == 0);
+  TEST(result == 500);
+
+  result = 0;
+  TEST(rsv_parallel_reduce_hash_table(
+           &pool, &hash_table, 3, &result, sizeof(result),
+           test_parallel_sum_value, test_parallel_combine, NULL) == 0);
+  TEST(result == 124750);
+
+  /* Test: For each and reduce over hash set buckets */
+  hash_set = rsv_hash_set_create(2, sizeof(int), NULL, NULL);
+
+  for (i = 0; i < 500; ++i) {
+    rsv_hash_set_push(&hash_set, &i);
+  }
+
+  result = 0;
+  TEST(rsv_parallel_for_hash_set(&pool, &hash_set, 0,
+                                 test_parallel_count_entry, &result) == 0);
+  TEST(result == 500);
+
+  result = 0;
+  TEST(rsv_parallel_reduce_hash_set(&pool, &hash_set, 0, &result,
+                                    sizeof(result), test_parallel_sum_element,
+                                    test_parallel_combine, NULL) == 0);
+  TEST(result == 124750);
+
+  rsv_hash_set_destroy(&hash_set);
+  rsv_hash_table_destroy(&hash_table);
+  rsv_dynamic_array_destroy(&mapped);
+  rsv_dynamic_array_destroy(&array);
+  rsv_thread_pool_destroy(&pool);
+
+  return 0;
+}
+
+#endif /* TEST_PARALLEL_H */
+
+#endif
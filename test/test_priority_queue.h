@@ -0,0 +1,222 @@
+#ifndef TEST_PRIORITY_QUEUE_H
+#define TEST_PRIORITY_QUEUE_H
+
+#include "test.h"
+#include <rsv/containers/priority_queue.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static inline int priority_queue_compare_int(const void* a, const void* b) {
+  int value_a = *(const int*)a;
+  int value_b = *(const int*)b;
+
+  return (value_a > value_b) - (value_a < value_b);
+}
+
+static inline int priority_queue_check(rsv_priority_queue_t* queue) {
+  unsigned int i;
+
+  for (i = 1; i < queue->amount; ++i) {
+    unsigned int parent = (i - 1) / queue->arity;
+
+    if (priority_queue_compare_int(rsv_priority_queue_at(queue, parent),
+                                   rsv_priority_queue_at(queue, i)) > 0) {
+      return 0;
+    }
+  }
+
+  for (i = 0; queue->indexed && i < queue->amount; ++i) {
+    unsigned int handle = ((unsigned int*)queue->handles.data)[i];
+
+    if (((unsigned int*)queue->positions.data)[handle] != i) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static inline int test_priority_queue(void) {
+  rsv_priority_queue_t queue;
+  rsv_dynamic_array_t array;
+  rsv_dynamic_array_t output;
+  unsigned int handles[1000];
+  unsigned int seed = 12345;
+  unsigned int arity;
+  int value;
+  int previous;
+  int i;
+
+  /* Test: Create priority queue */
+  queue = rsv_priority_queue_create(4, sizeof(int), 0,
+                                    priority_queue_compare_int, 0);
+  TEST(queue.amount == 0);
+  TEST(queue.arity == RSV_PRIORITY_QUEUE_ARITY);
+  TEST(rsv_priority_queue_peek(&queue) == NULL);
+  TEST(rsv_priority_queue_pop(&queue, &value) == 0);
+
+  /* Test: Push and pop in order */
+  value = 5;
+  TEST(rsv_priority_queue_push(&queue, &value) ==
+       RSV_PRIORITY_QUEUE_NO_HANDLE);
+  value = 2;
+  rsv_priority_queue_push(&queue, &value);
+  value = 9;
+  rsv_priority_queue_push(&queue, &value);
+  TEST(*(int*)rsv_priority_queue_peek(&queue) == 2);
+  TEST(rsv_priority_queue_pop(&queue, &value) == 1);
+  TEST(value == 2);
+  TEST(rsv_priority_queue_pop(&queue, &value) == 1);
+  TEST(value == 5);
+  TEST(rsv_priority_queue_pop(&queue, NULL) == 1);
+  TEST(queue.amount == 0);
+  rsv_priority_queue_destroy(&queue);
+
+  /* Test: Random pushes pop sorted for several arities */
+  for (arity = 2; arity <= 8; arity *= 2) {
+    queue = rsv_priority_queue_create(0, sizeof(int), arity,
+                                      priority_queue_compare_int, 0);
+
+    for (i = 0; i < 1000; i++) {
+      seed = seed * 1103515245 + 12345;
+      value = (int)(seed >> 16) % 500;
+      rsv_priority_queue_push(&queue, &value);
+    }
+
+    TEST(priority_queue_check(&queue));
+
+    /* Test: The children of a node share one cache line */
+    for (i = 0; i < 100; i++) {
+      uintptr_t first =
+          (uintptr_t)rsv_priority_queue_at(&queue, (unsigned int)i * arity + 1);
+
+      TEST(first / RSV_PRIORITY_QUEUE_ALIGNMENT ==
+           (first + arity * sizeof(int) - 1) / RSV_PRIORITY_QUEUE_ALIGNMENT);
+    }
+
+    previous = -1;
+
+    while (rsv_priority_queue_pop(&queue, &value)) {
+      TEST(value >= previous);
+      previous = value;
+    }
+
+    rsv_priority_queue_destroy(&queue);
+  }
+
+  /* Test: Decrease key and remove through handles */
+  queue = rsv_priority_queue_create(0, sizeof(int), 8,
+                                    priority_queue_compare_int, 1);
+
+  for (i = 0; i < 1000; i++) {
+    value = 1000 + i;
+    handles[i] = rsv_priority_queue_push(&queue, &value);
+    TEST(handles[i] == (unsigned int)i);
+  }
+
+  value = 1;
+  TEST(rsv_priority_queue_update(&queue, handles[700], &value) == 1);
+  TEST(*(int*)rsv_priority_queue_peek(&queue) == 1);
+  value = 5000;
+  TEST(rsv_priority_queue_update(&queue, handles[700], &value) == 1);
+  TEST(*(int*)rsv_priority_queue_peek(&queue) == 1000);
+  TEST(*(int*)rsv_priority_queue_get(&queue, handles[700]) == 5000);
+  TEST(priority_queue_check(&queue));
+
+  for (i = 0; i < 1000; i += 3) {
+    TEST(rsv_priority_queue_remove(&queue, handles[i], &value) == 1);
+    TEST(value == (i == 700 ? 5000 : 1000 + i));
+    TEST(rsv_priority_queue_get(&queue, handles[i]) == NULL);
+  }
+
+  TEST(rsv_priority_queue_remove(&queue, handles[0], NULL) == 0);
+  TEST(rsv_priority_queue_update(&queue, handles[0], &value) == 0);
+  TEST(priority_queue_check(&queue));
+
+  /* Released handles are reused */
+  value = 0;
+  TEST(rsv_priority_queue_push(&queue, &value) == handles[999]);
+  TEST(rsv_priority_queue_pop(&queue, &value) == 1);
+  TEST(value == 0);
+  TEST(rsv_priority_queue_pop(&queue, &value) == 1);
+  TEST(value == 1001);
+  TEST(rsv_priority_queue_get(&queue, handles[1]) == NULL);
+  TEST(priority_queue_check(&queue));
+  rsv_priority_queue_destroy(&queue);
+
+  /* Test: Heapify from an array */
+  array = rsv_dynamic_array_create(0, sizeof(int));
+
+  for (i = 0; i < 1000; i++) {
+    seed = seed * 1103515245 + 12345;
+    value = (int)(seed >> 16) % 500;
+    rsv_dynamic_array_push(&array, &value);
+  }
+
+  queue = rsv_priority_queue_create(0, sizeof(int), 4,
+                                    priority_queue_compare_int, 1);
+  value = 250;
+  rsv_priority_queue_push(&queue, &value);
+  TEST(rsv_priority_queue_heapify(&queue, &array, handles) == 0);
+  TEST(queue.amount == 1001);
+  TEST(priority_queue_check(&queue));
+
+  for (i = 0; i < 1000; i++) {
+    TEST(*(int*)rsv_priority_queue_get(&queue, handles[i]) ==
+         ((int*)array.data)[i]);
+  }
+
+  output = rsv_dynamic_array_create(0, sizeof(int));
+  rsv_priority_queue_drain(&queue, &output);
+  TEST(output.amount == 1001);
+  TEST(queue.amount == 0);
+
+  for (i = 1; i < 1001; i++) {
+    TEST(((int*)output.data)[i - 1] <= ((int*)output.data)[i]);
+  }
+
+  rsv_priority_queue_destroy(&queue);
+  rsv_dynamic_array_destroy(&output);
+
+  /* Test: Top k */
+  output = rsv_dynamic_array_create(0, sizeof(int));
+  rsv_priority_queue_top_k(&array, 10, priority_queue_compare_int, &output);
+  TEST(output.amount == 10);
+  qsort(array.data, array.amount, sizeof(int), priority_queue_compare_int);
+
+  for (i = 0; i < 10; i++) {
+    TEST(((int*)output.data)[i] == ((int*)array.data)[990 + i]);
+  }
+
+  rsv_dynamic_array_destroy(&output);
+  output = rsv_dynamic_array_create(0, sizeof(int));
+  rsv_priority_queue_top_k(&array, 2000, priority_queue_compare_int, &output);
+  TEST(output.amount == 1000);
+  TEST(memcmp(output.data, array.data, 1000 * sizeof(int)) == 0);
+  rsv_dynamic_array_destroy(&output);
+
+  /* Test: Bounded indexed queue releases dropped handles */
+  queue = rsv_priority_queue_create(0, sizeof(int), 4,
+                                    priority_queue_compare_int, 1);
+  queue.limit = 3;
+
+  for (i = 0; i < 3; i++) {
+    value = 10 * (i + 1);
+    handles[i] = rsv_priority_queue_push(&queue, &value);
+  }
+
+  value = 5;
+  TEST(rsv_priority_queue_push(&queue, &value) ==
+       RSV_PRIORITY_QUEUE_NO_HANDLE);
+  value = 25;
+  TEST(rsv_priority_queue_push(&queue, &value) == handles[0]);
+  TEST(*(int*)rsv_priority_queue_peek(&queue) == 20);
+  TEST(queue.amount == 3);
+  TEST(priority_queue_check(&queue));
+  rsv_priority_queue_destroy(&queue);
+
+  rsv_dynamic_array_destroy(&array);
+  return 0;
+}
+
+#endif /* TEST_PRIORITY_QUEUE_H */
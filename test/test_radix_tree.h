@@ -0,0 +1,295 @@
+#ifndef TEST_RADIX_TREE_H
+#define TEST_RADIX_TREE_H
+
+#include "test.h"
+#include <rsv/containers/radix_tree.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct radix_tree_key_t {
+  char bytes[32];
+  unsigned int length;
+} radix_tree_key_t;
+
+/* Spells a number in bijective base 3, so every number gets its own key and
+ * some keys are prefixes of others. Every fourth key shares a long path */
+static inline radix_tree_key_t radix_tree_make_key(unsigned int number) {
+  radix_tree_key_t key;
+  unsigned int length = 0;
+
+  if (number % 4 == 0) {
+    memcpy(key.bytes, "/shared/long/path/", 18);
+    length = 18;
+  }
+
+  while (number > 0) {
+    number--;
+    key.bytes[length++] = (char)('a' + number % 3);
+    number /= 3;
+  }
+
+  key.length = length;
+
+  return key;
+}
+
+static inline int radix_tree_compare_keys(const void* a, const void* b) {
+  const radix_tree_key_t* key_a = (const radix_tree_key_t*)a;
+  const radix_tree_key_t* key_b = (const radix_tree_key_t*)b;
+  unsigned int shorter =
+      key_a->length < key_b->length ? key_a->length : key_b->length;
+  int compared = memcmp(key_a->bytes, key_b->bytes, shorter);
+
+  if (compared != 0) {
+    return compared;
+  }
+
+  return (key_a->length > key_b->length) - (key_a->length < key_b->length);
+}
+
+static inline int test_radix_tree(void) {
+  static radix_tree_key_t sorted[3000];
+  static unsigned char present[3000];
+  char deep[RSV_RADIX_TREE_ITERATOR_DEPTH + 8];
+  rsv_radix_tree_iterator_t iterator;
+  rsv_radix_tree_t tree;
+  radix_tree_key_t key;
+  unsigned int seed = 4242;
+  unsigned int amount;
+  unsigned int length;
+  unsigned int matched;
+  void* found_key;
+  void* found_value;
+  int value;
+  int i;
+
+  /* Test: Create tree */
+  tree = rsv_radix_tree_create(sizeof(int));
+  TEST(tree.amount == 0);
+  TEST(rsv_radix_tree_get(&tree, "a", 1) == NULL);
+  TEST(rsv_radix_tree_pop(&tree, "a", 1) == 0);
+  iterator = rsv_radix_tree_prefix(&tree, NULL, 0);
+  TEST(rsv_radix_tree_iterator_next(&iterator, NULL, NULL, NULL) == 0);
+
+  /* Test: Random pushes and pops against a reference */
+  memset(present, 0, sizeof(present));
+  amount = 0;
+
+  for (i = 0; i < 20000; i++) {
+    unsigned int number;
+
+    seed = seed * 1103515245 + 12345;
+    number = (seed >> 8) % 3000;
+    key = radix_tree_make_key(number);
+    value = (int)number;
+
+    if ((seed >> 4) % 3 != 0) {
+      amount += !present[number];
+      present[number] = 1;
+      rsv_radix_tree_push(&tree, key.bytes, key.length, &value);
+    } else {
+      TEST(rsv_radix_tree_pop(&tree, key.bytes, key.length) ==
+           present[number]);
+      amount -= present[number];
+      present[number] = 0;
+    }
+
+    TEST(tree.amount == amount);
+  }
+
+  for (i = 0; i < 3000; i++) {
+    int* found;
+
+    key = radix_tree_make_key((unsigned int)i);
+    found = (int*)rsv_radix_tree_get(&tree, key.bytes, key.length);
+    TEST(present[i] ? found != NULL && *found == i : found == NULL);
+  }
+
+  /* Test: Iteration follows byte order, shorter keys first */
+  amount = 0;
+
+  for (i = 0; i < 3000; i++) {
+    if (present[i]) {
+      sorted[amount++] = radix_tree_make_key((unsigned int)i);
+    }
+  }
+
+  qsort(sorted, amount, sizeof(radix_tree_key_t), radix_tree_compare_keys);
+  iterator = rsv_radix_tree_prefix(&tree, NULL, 0);
+
+  for (i = 0; i < (int)amount; i++) {
+    TEST(rsv_radix_tree_iterator_next(&iterator, &found_key, &length,
+                                      &found_value) == 1);
+    TEST(length == sorted[i].length);
+    TEST(memcmp(found_key, sorted[i].bytes, length) == 0);
+  }
+
+  TEST(rsv_radix_tree_iterator_next(&iterator, NULL, NULL, NULL) == 0);
+
+  /* Test: Prefix iteration, including a prefix ending inside a long path */
+  iterator = rsv_radix_tree_prefix(&tree, "/shared/lo", 10);
+  length = 0;
+
+  while (rsv_radix_tree_iterator_next(&iterator, &found_key, NULL,
+                                      &found_value)) {
+    TEST(*(int*)found_value % 4 == 0);
+    length++;
+  }
+
+  amount = 0;
+
+  for (i = 0; i < 3000; i += 4) {
+    amount += present[i];
+  }
+
+  TEST(length == amount);
+  iterator = rsv_radix_tree_prefix(&tree, "ab", 2);
+
+  while (rsv_radix_tree_iterator_next(&iterator, &found_key, &length, NULL)) {
+    TEST(length >= 2 && memcmp(found_key, "ab", 2) == 0);
+  }
+
+  iterator = rsv_radix_tree_prefix(&tree, "/shared/lost", 12);
+  TEST(rsv_radix_tree_iterator_next(&iterator, NULL, NULL, NULL) == 0);
+
+  /* Test: Pop everything */
+  for (i = 0; i < 3000; i++) {
+    key = radix_tree_make_key((unsigned int)i);
+    TEST(rsv_radix_tree_pop(&tree, key.bytes, key.length) == present[i]);
+  }
+
+  TEST(tree.amount == 0);
+  TEST(tree.root == NULL);
+
+  /* Test: Nodes grow to 256 children and shrink back */
+  for (i = 0; i < 256; i++) {
+    unsigned char bytes[2];
+
+    bytes[0] = (unsigned char)(255 - i);
+    bytes[1] = 'x';
+    value = i;
+    rsv_radix_tree_push(&tree, bytes, 2, &value);
+    TEST(i == 0 || ((rsv_radix_tree_node_t*)tree.root)->type ==
+                       (i < 4    ? RSV_RADIX_TREE_NODE4
+                        : i < 16 ? RSV_RADIX_TREE_NODE16
+                        : i < 48 ? RSV_RADIX_TREE_NODE48
+                                 : RSV_RADIX_TREE_NODE256));
+  }
+
+  rsv_radix_tree_push(&tree, "", 0, &value);
+  TEST(tree.amount == 257);
+
+  for (i = 0; i < 256; i++) {
+    unsigned char bytes[2];
+
+    bytes[0] = (unsigned char)i;
+    bytes[1] = 'x';
+    TEST(*(int*)rsv_radix_tree_get(&tree, bytes, 2) == 255 - i);
+  }
+
+  for (i = 0; i < 256; i += 2) {
+    unsigned char bytes[2];
+
+    bytes[0] = (unsigned char)i;
+    bytes[1] = 'x';
+    TEST(rsv_radix_tree_pop(&tree, bytes, 2) == 1);
+  }
+
+  TEST(((rsv_radix_tree_node_t*)tree.root)->type == RSV_RADIX_TREE_NODE256);
+  iterator = rsv_radix_tree_prefix(&tree, NULL, 0);
+  TEST(rsv_radix_tree_iterator_next(&iterator, NULL, &length, NULL) == 1);
+  TEST(length == 0);
+
+  for (i = 1; i < 256; i += 2) {
+    TEST(rsv_radix_tree_iterator_next(&iterator, &found_key, NULL, NULL) == 1);
+    TEST(*(unsigned char*)found_key == i);
+  }
+
+  TEST(rsv_radix_tree_iterator_next(&iterator, NULL, NULL, NULL) == 0);
+
+  for (i = 1; i < 256; i += 2) {
+    unsigned char bytes[2];
+
+    bytes[0] = (unsigned char)i;
+    bytes[1] = 'x';
+    TEST(rsv_radix_tree_pop(&tree, bytes, 2) == 1);
+  }
+
+  TEST(tree.amount == 1);
+  TEST(rsv_radix_tree_is_leaf(tree.root));
+  TEST(*(int*)rsv_radix_tree_get(&tree, "", 0) == 255);
+  rsv_radix_tree_destroy(&tree);
+
+  /* Test: Iteration through paths deeper than the iterator keeps, the keys
+   * of "a" repeated pop first, then the ones ending in "b" */
+  tree = rsv_radix_tree_create(sizeof(int));
+  memset(deep, 'a', sizeof(deep));
+  amount = sizeof(deep);
+
+  for (i = 0; i < (int)amount; i++) {
+    value = i;
+    rsv_radix_tree_push(&tree, deep, (unsigned int)i + 1, &value);
+    deep[i] = 'b';
+    value = 2 * (int)amount - 1 - i;
+    rsv_radix_tree_push(&tree, deep, (unsigned int)i + 1, &value);
+    deep[i] = 'a';
+  }
+
+  iterator = rsv_radix_tree_prefix(&tree, NULL, 0);
+
+  for (i = 0; i < 2 * (int)amount; i++) {
+    TEST(rsv_radix_tree_iterator_next(&iterator, NULL, NULL, &found_value) ==
+         1);
+    TEST(*(int*)found_value == i);
+  }
+
+  TEST(rsv_radix_tree_iterator_next(&iterator, NULL, NULL, NULL) == 0);
+  iterator = rsv_radix_tree_prefix(&tree, deep, 20);
+  length = 0;
+
+  while (rsv_radix_tree_iterator_next(&iterator, NULL, NULL, &found_value)) {
+    length++;
+  }
+
+  TEST(length == 2 * (amount - 20) + 1);
+  rsv_radix_tree_destroy(&tree);
+
+  /* Test: Longest prefix match for routing */
+  tree = rsv_radix_tree_create(sizeof(int));
+  value = 1;
+  rsv_radix_tree_push(&tree, "/", 1, &value);
+  value = 2;
+  rsv_radix_tree_push(&tree, "/api", 4, &value);
+  value = 3;
+  rsv_radix_tree_push(&tree, "/api/v1/", 8, &value);
+  value = 4;
+  rsv_radix_tree_push(&tree, "/api/v1/users/profile", 21, &value);
+  value = 5;
+  rsv_radix_tree_push(&tree, "/static/", 8, &value);
+
+  TEST(*(int*)rsv_radix_tree_longest_prefix(&tree, "/api/v1/orders", 14,
+                                            &matched) == 3);
+  TEST(matched == 8);
+  TEST(*(int*)rsv_radix_tree_longest_prefix(&tree, "/api/v2", 7, &matched) ==
+       2);
+  TEST(matched == 4);
+  TEST(*(int*)rsv_radix_tree_longest_prefix(
+           &tree, "/api/v1/users/profile/edit", 26, &matched) == 4);
+  TEST(*(int*)rsv_radix_tree_longest_prefix(&tree, "/api/v1/users/profilX",
+                                            21, &matched) == 3);
+  TEST(*(int*)rsv_radix_tree_longest_prefix(&tree, "/static", 7, &matched) ==
+       1);
+  TEST(rsv_radix_tree_longest_prefix(&tree, "api", 3, NULL) == NULL);
+
+  /* Removing a route falls back to the next shorter one */
+  TEST(rsv_radix_tree_pop(&tree, "/api/v1/", 8) == 1);
+  TEST(*(int*)rsv_radix_tree_longest_prefix(&tree, "/api/v1/orders", 14,
+                                            &matched) == 2);
+  TEST(*(int*)rsv_radix_tree_get(&tree, "/api/v1/users/profile", 21) == 4);
+  rsv_radix_tree_destroy(&tree);
+
+  return 0;
+}
+
+#endif /* TEST_RADIX_TREE_H */
@@ -0,0 +1,60 @@
+#if defined(__unix__)
+
+#ifndef TEST_SHARDED_COUNTER_H
+#define TEST_SHARDED_COUNTER_H
+
+#include "test.h"
+#include <rsv/threads/sharded_counter.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static inline void* increment_sharded_counter(void* arg) {
+  rsv_sharded_counter_t* counter = (rsv_sharded_counter_t*)arg;
+  int i;
+
+  for (i = 0; i < 1000; i++) {
+    rsv_sharded_counter_add(counter, 1);
+  }
+
+  return NULL;
+}
+
+static inline int test_sharded_counter(void) {
+  rsv_sharded_counter_t counter;
+  rsv_thread_t threads[8];
+  int i;
+
+  /* Test: Create counter */
+  TEST(rsv_sharded_counter_create(&counter, 3) == 0);
+  TEST(counter.shard_amount == 4);
+  TEST(rsv_sharded_counter_get(&counter) == 0);
+
+  /* Test: Add and subtract */
+  rsv_sharded_counter_add(&counter, 10);
+  rsv_sharded_counter_add(&counter, -3);
+  TEST(rsv_sharded_counter_get(&counter) == 7);
+  rsv_sharded_counter_destroy(&counter);
+  TEST(counter.shards == NULL);
+
+  /* Test: Concurrent increments */
+  TEST(rsv_sharded_counter_create(&counter, 0) == 0);
+  TEST(counter.shard_amount >= 1);
+
+  for (i = 0; i < 8; i++) {
+    TEST(rsv_thread_create(&threads[i], increment_sharded_counter,
+                           &counter) == 0);
+  }
+
+  for (i = 0; i < 8; i++) {
+    TEST(rsv_thread_join(threads[i], NULL) == 0);
+  }
+
+  TEST(rsv_sharded_counter_get(&counter) == 8000);
+  rsv_sharded_counter_destroy(&counter);
+
+  return 0;
+}
+
+#endif /* TEST_SHARDED_COUNTER_H */
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef TEST_SLOT_MAP_H
+#define TEST_SLOT_MAP_H
+
+#include "test.h"
+#include <rsv/containers/slot_map.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static inline int test_slot_map(void) {
+  static rsv_slot_map_handle_t handles[1000];
+  static unsigned char alive[1000];
+  rsv_slot_map_handle_t stale;
+  rsv_slot_map_handle_t handle;
+  rsv_slot_map_handle_t zero = {0, 0};
+  rsv_slot_map_t map;
+  unsigned int seed = 777;
+  unsigned int amount;
+  long sum;
+  long expected;
+  int value;
+  int i;
+
+  /* Test: Create slot map */
+  map = rsv_slot_map_create(0, sizeof(int));
+  TEST(map.elements.amount == 0);
+  TEST(rsv_slot_map_get(&map, zero) == NULL);
+  TEST(rsv_slot_map_pop(&map, zero, NULL) == 0);
+
+  /* Test: Push and get */
+  for (i = 0; i < 1000; i++) {
+    handles[i] = rsv_slot_map_push(&map, &i);
+    alive[i] = 1;
+    TEST(*(int*)rsv_slot_map_get(&map, handles[i]) == i);
+  }
+
+  TEST(map.elements.amount == 1000);
+  TEST(rsv_slot_map_contains(&map, handles[500]));
+  TEST(!rsv_slot_map_contains(&map, zero));
+
+  /* Test: Random removals keep the elements dense */
+  amount = 1000;
+
+  for (i = 0; i < 600; i++) {
+    unsigned int index;
+
+    seed = seed * 1103515245 + 12345;
+    index = (seed >> 8) % 1000;
+    TEST(rsv_slot_map_pop(&map, handles[index], &value) == alive[index]);
+
+    if (alive[index]) {
+      TEST(value == (int)index);
+      amount--;
+    }
+
+    alive[index] = 0;
+    TEST(rsv_slot_map_get(&map, handles[index]) == NULL);
+  }
+
+  TEST(map.elements.amount == amount);
+  sum = 0;
+  expected = 0;
+
+  for (i = 0; i < (int)map.elements.amount; i++) {
+    value = ((int*)map.elements.data)[i];
+    handle = rsv_slot_map_handle(&map, (unsigned int)i);
+    TEST(handle.index == handles[value].index);
+    TEST(handle.generation == handles[value].generation);
+    sum += value;
+  }
+
+  for (i = 0; i < 1000; i++) {
+    expected += alive[i] ? i : 0;
+
+    if (alive[i]) {
+      TEST(*(int*)rsv_slot_map_get(&map, handles[i]) == i);
+    }
+  }
+
+  TEST(sum == expected);
+
+  /* Test: Reused slots do not revive stale handles */
+  i = 0;
+
+  while (!alive[i]) {
+    i++;
+  }
+
+  stale = handles[i];
+  alive[i] = 0;
+  TEST(rsv_slot_map_pop(&map, stale, NULL) == 1);
+  value = -1;
+  handle = rsv_slot_map_push(&map, &value);
+  TEST(map.slots.amount == 1000);
+  TEST(handle.index == stale.index);
+  TEST(handle.generation != stale.generation);
+  TEST(rsv_slot_map_get(&map, stale) == NULL);
+
+  for (i = 0; i < 1000; i++) {
+    if (!alive[i]) {
+      TEST(rsv_slot_map_get(&map, handles[i]) == NULL);
+    }
+  }
+
+  TEST(*(int*)rsv_slot_map_get(&map, handle) == -1);
+  TEST(rsv_slot_map_pop(&map, handle, NULL) == 1);
+  TEST(rsv_slot_map_pop(&map, handle, NULL) == 0);
+
+  /* Test: Pop everything */
+  for (i = 0; i < 1000; i++) {
+    TEST(rsv_slot_map_pop(&map, handles[i], NULL) == alive[i]);
+  }
+
+  TEST(map.elements.amount == 0);
+  rsv_slot_map_destroy(&map);
+
+  /* Test: Slots are retired before their generation wraps */
+  map = rsv_slot_map_create(4, sizeof(int));
+  value = 1;
+  handle = rsv_slot_map_push(&map, &value);
+  ((rsv_slot_map_slot_t*)map.slots.data)[handle.index].generation =
+      RSV_SLOT_MAP_MAX_GENERATION - 1;
+  handle.generation = RSV_SLOT_MAP_MAX_GENERATION - 1;
+  TEST(rsv_slot_map_pop(&map, handle, NULL) == 1);
+  TEST(map.free_slot == RSV_SLOT_MAP_NO_SLOT);
+  handle = rsv_slot_map_push(&map, &value);
+  TEST(handle.index == 1);
+  rsv_slot_map_destroy(&map);
+
+  return 0;
+}
+
+#endif /* TEST_SLOT_MAP_H */
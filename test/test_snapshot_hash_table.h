@@ -0,0 +1,203 @@
+#if defined(__unix__)
+
+#ifndef TEST_SNAPSHOT_HASH_TABLE_H
+#define TEST_SNAPSHOT_HASH_TABLE_H
+
+#include "test.h"
+#include <rsv/containers/snapshot_hash_table.h>
+#include <rsv/safe/string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct snapshot_hash_table_data_t {
+  rsv_snapshot_hash_table_t* hash_table;
+  int mismatches;
+} snapshot_hash_table_data_t;
+
+static inline void* read_snapshot_hash_table(void* arg) {
+  snapshot_hash_table_data_t* data = (snapshot_hash_table_data_t*)arg;
+  rsv_epoch_participant_t* participant =
+      rsv_snapshot_hash_table_register(data->hash_table);
+  int round;
+  int key;
+
+  for (round = 0; round < 200; round++) {
+    const rsv_snapshot_hash_table_version_t* version =
+        rsv_snapshot_hash_table_pin(data->hash_table, participant);
+    const int* first;
+
+    /* Every key of a version holds the same generation */
+    key = 0;
+    first = (const int*)rsv_snapshot_hash_table_get(data->hash_table, version,
+                                                    &key);
+
+    for (key = 1; key < 64; key++) {
+      const int* value = (const int*)rsv_snapshot_hash_table_get(
+          data->hash_table, version, &key);
+
+      if (value == NULL || first == NULL || *value != *first) {
+        data->mismatches++;
+      }
+    }
+
+    rsv_snapshot_hash_table_unpin(participant);
+  }
+
+  rsv_epoch_unregister(participant);
+
+  return NULL;
+}
+
+static inline int test_snapshot_hash_table(void) {
+  int test_int;
+  char test_key[16];
+  const int* found;
+  rsv_snapshot_hash_table_t hash_table;
+  const rsv_snapshot_hash_table_version_t* snapshot;
+  const rsv_snapshot_hash_table_version_t* version;
+  rsv_epoch_participant_t* participant;
+  rsv_thread_t threads[2];
+  snapshot_hash_table_data_t data[2];
+  int generation;
+  int i;
+
+  /* Test: Create snapshot hash table */
+  TEST(rsv_snapshot_hash_table_create(&hash_table, 3, sizeof(test_key),
+                                      sizeof(int), NULL, NULL) == 0);
+  TEST(hash_table.version->capacity == 4);
+  participant = rsv_snapshot_hash_table_register(&hash_table);
+  TEST(participant != NULL);
+
+  /* Test: Writes become visible on commit */
+  TEST(rsv_snapshot_hash_table_begin(&hash_table) == 0);
+  rsv_strcpy(test_key, "key1", sizeof(test_key));
+  test_int = 100;
+  TEST(rsv_snapshot_hash_table_push(&hash_table, test_key, &test_int) == 0);
+  rsv_strcpy(test_key, "key2", sizeof(test_key));
+  test_int = 200;
+  TEST(rsv_snapshot_hash_table_push(&hash_table, test_key, &test_int) == 0);
+  TEST(rsv_snapshot_hash_table_amount(hash_table.draft) == 2);
+
+  version = rsv_snapshot_hash_table_pin(&hash_table, participant);
+  TEST(rsv_snapshot_hash_table_amount(version) == 0);
+  TEST(rsv_snapshot_hash_table_get(&hash_table, version, test_key) == NULL);
+  rsv_snapshot_hash_table_unpin(participant);
+
+  TEST(rsv_snapshot_hash_table_commit(&hash_table, participant) == 0);
+  snapshot = rsv_snapshot_hash_table_pin(&hash_table, participant);
+  TEST(rsv_snapshot_hash_table_amount(snapshot) == 2);
+  found = (const int*)rsv_snapshot_hash_table_get(&hash_table, snapshot,
+                                                  test_key);
+  TEST(found != NULL && *found == 200);
+
+  /* Test: A pinned snapshot does not see later commits */
+  TEST(rsv_snapshot_hash_table_begin(&hash_table) == 0);
+  test_int = 250;
+  TEST(rsv_snapshot_hash_table_push(&hash_table, test_key, &test_int) == 0);
+  rsv_strcpy(test_key, "key1", sizeof(test_key));
+  TEST(rsv_snapshot_hash_table_pop(&hash_table, test_key) == 0);
+  TEST(rsv_snapshot_hash_table_commit(&hash_table, participant) == 0);
+
+  found = (const int*)rsv_snapshot_hash_table_get(&hash_table, snapshot,
+                                                  test_key);
+  TEST(found != NULL && *found == 100);
+  rsv_strcpy(test_key, "key2", sizeof(test_key));
+  found = (const int*)rsv_snapshot_hash_table_get(&hash_table, snapshot,
+                                                  test_key);
+  TEST(found != NULL && *found == 200);
+  rsv_snapshot_hash_table_unpin(participant);
+
+  version = rsv_snapshot_hash_table_pin(&hash_table, participant);
+  TEST(rsv_snapshot_hash_table_amount(version) == 1);
+  found =
+      (const int*)rsv_snapshot_hash_table_get(&hash_table, version, test_key);
+  TEST(found != NULL && *found == 250);
+  rsv_strcpy(test_key, "key1", sizeof(test_key));
+  TEST(rsv_snapshot_hash_table_get(&hash_table, version, test_key) == NULL);
+  rsv_snapshot_hash_table_unpin(participant);
+
+  /* Test: Aborted writes are discarded */
+  TEST(rsv_snapshot_hash_table_begin(&hash_table) == 0);
+  TEST(rsv_snapshot_hash_table_push(&hash_table, test_key, &test_int) == 0);
+  rsv_snapshot_hash_table_abort(&hash_table);
+  version = rsv_snapshot_hash_table_pin(&hash_table, participant);
+  TEST(rsv_snapshot_hash_table_get(&hash_table, version, test_key) == NULL);
+  rsv_snapshot_hash_table_unpin(participant);
+
+  /* Test: Untouched buckets are shared between versions */
+  version = hash_table.version;
+  TEST(rsv_snapshot_hash_table_begin(&hash_table) == 0);
+
+  for (i = 0; i < (int)version->capacity; i++) {
+    TEST(hash_table.draft->buckets[i] == version->buckets[i]);
+  }
+
+  rsv_snapshot_hash_table_abort(&hash_table);
+
+  /* Test: Resize past the initial capacity */
+  TEST(rsv_snapshot_hash_table_begin(&hash_table) == 0);
+
+  for (i = 0; i < 100; i++) {
+    snprintf(test_key, sizeof(test_key), "grow%d", i);
+    TEST(rsv_snapshot_hash_table_push(&hash_table, test_key, &i) == 0);
+  }
+
+  TEST(rsv_snapshot_hash_table_commit(&hash_table, participant) == 0);
+  version = rsv_snapshot_hash_table_pin(&hash_table, participant);
+  TEST(rsv_snapshot_hash_table_amount(version) == 101);
+  TEST(version->capacity >= 128);
+
+  for (i = 0; i < 100; i++) {
+    snprintf(test_key, sizeof(test_key), "grow%d", i);
+    found =
+        (const int*)rsv_snapshot_hash_table_get(&hash_table, version, test_key);
+    TEST(found != NULL && *found == i);
+  }
+
+  rsv_snapshot_hash_table_unpin(participant);
+  rsv_snapshot_hash_table_destroy(&hash_table);
+  TEST(hash_table.version == NULL);
+
+  /* Test: Readers never see a partially applied write */
+  TEST(rsv_snapshot_hash_table_create(&hash_table, 16, sizeof(int),
+                                      sizeof(int), NULL, NULL) == 0);
+  participant = rsv_snapshot_hash_table_register(&hash_table);
+  TEST(rsv_snapshot_hash_table_begin(&hash_table) == 0);
+  generation = 0;
+
+  for (i = 0; i < 64; i++) {
+    TEST(rsv_snapshot_hash_table_push(&hash_table, &i, &generation) == 0);
+  }
+
+  TEST(rsv_snapshot_hash_table_commit(&hash_table, participant) == 0);
+
+  for (i = 0; i < 2; i++) {
+    data[i].hash_table = &hash_table;
+    data[i].mismatches = 0;
+    TEST(rsv_thread_create(&threads[i], read_snapshot_hash_table, &data[i]) ==
+         0);
+  }
+
+  for (generation = 1; generation <= 200; generation++) {
+    TEST(rsv_snapshot_hash_table_begin(&hash_table) == 0);
+
+    for (i = 0; i < 64; i++) {
+      TEST(rsv_snapshot_hash_table_push(&hash_table, &i, &generation) == 0);
+    }
+
+    TEST(rsv_snapshot_hash_table_commit(&hash_table, participant) == 0);
+  }
+
+  for (i = 0; i < 2; i++) {
+    TEST(rsv_thread_join(threads[i], NULL) == 0);
+    TEST(data[i].mismatches == 0);
+  }
+
+  rsv_snapshot_hash_table_destroy(&hash_table);
+
+  return 0;
+}
+
+#endif /* TEST_SNAPSHOT_HASH_TABLE_H */
+
+#endif
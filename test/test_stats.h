@@ -0,0 +1,190 @@
+#if defined(RSV_STATS)
+
+#ifndef TEST_STATS_H
+#define TEST_STATS_H
+
+#include "test.h"
+#include <rsv/containers/dynamic_array.h>
+#include <rsv/containers/hash_set.h>
+#include <rsv/containers/hash_table.h>
+#include <rsv/stats.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__unix__)
+#include <rsv/threads/threads_pthreads.h>
+
+static inline void* lock_stats_mutex(void* arg) {
+  rsv_mutex_t* mutex = (rsv_mutex_t*)arg;
+  int i;
+
+  for (i = 0; i < 1000; i++) {
+    rsv_mutex_lock(mutex);
+    rsv_mutex_unlock(mutex);
+  }
+
+  return NULL;
+}
+#endif
+
+static inline unsigned int stats_constant_hash(const void* data,
+                                               unsigned int element_size) {
+  (void)data;
+  (void)element_size;
+  return 0;
+}
+
+static inline int test_stats(void) {
+  rsv_stats_histogram_t histogram;
+  rsv_dynamic_array_t array;
+  rsv_hash_table_t hash_table;
+  rsv_hash_set_t hash_set;
+  FILE* file;
+  int i;
+
+  /* Test: Histogram buckets */
+  memset(&histogram, 0, sizeof(histogram));
+  TEST(rsv_stats_bucket(0) == 0);
+  TEST(rsv_stats_bucket(1) == 1);
+  TEST(rsv_stats_bucket(2) == 2);
+  TEST(rsv_stats_bucket(3) == 2);
+  TEST(rsv_stats_bucket(4) == 3);
+  TEST(rsv_stats_bucket(~0ull) == RSV_STATS_HISTOGRAM_SIZE - 1);
+  TEST(rsv_stats_histogram_percentile(&histogram, 0.5) == 0);
+
+  for (i = 0; i < 99; i++) {
+    rsv_stats_histogram_add(&histogram, 1);
+  }
+
+  rsv_stats_histogram_add(&histogram, 100);
+  TEST(rsv_stats_histogram_amount(&histogram) == 100);
+  TEST(rsv_stats_histogram_percentile(&histogram, 0.5) == 1);
+  TEST(rsv_stats_histogram_percentile(&histogram, 1.0) == 127);
+
+  /* Test: Dynamic array allocations and resizes */
+  array = rsv_dynamic_array_create(1, sizeof(int));
+  TEST(array.stats.allocations == 1);
+  TEST(array.stats.bytes == sizeof(int));
+
+  for (i = 0; i < 100; i++) {
+    rsv_dynamic_array_push(&array, &i);
+  }
+
+  TEST(array.stats.resizes > 0);
+  TEST(array.stats.allocations == array.stats.resizes + 1);
+  TEST(array.stats.bytes == array.capacity * sizeof(int));
+  TEST(array.stats.peak_bytes >= array.stats.bytes);
+
+  for (i = 0; i < 100; i++) {
+    rsv_dynamic_array_pop(&array);
+  }
+
+  TEST(array.stats.bytes == array.capacity * sizeof(int));
+  TEST(array.stats.peak_bytes > array.stats.bytes);
+  rsv_dynamic_array_destroy(&array);
+  TEST(array.stats.bytes == 0);
+  TEST(array.stats.frees == 1);
+
+  /* Test: Hash table chain lengths and bytes */
+  hash_table = rsv_hash_table_create(4, sizeof(int), sizeof(int),
+                                     stats_constant_hash, NULL);
+
+  for (i = 0; i < 3; i++) {
+    rsv_hash_table_push(&hash_table, &i, &i);
+  }
+
+  TEST(hash_table.stats.resizes == 0);
+  TEST(hash_table.stats.allocations == 1 + 3 * 3);
+  TEST(hash_table.stats.bytes ==
+       4 * sizeof(rsv_hash_table_entry_t*) +
+           3 * (sizeof(rsv_hash_table_entry_t) + 2 * sizeof(int)));
+
+  /* Pushes walked chains of 0, 1 and 2 entries */
+  TEST(hash_table.stats.probes.counts[0] == 1);
+  TEST(hash_table.stats.probes.counts[1] == 1);
+  TEST(hash_table.stats.probes.counts[2] == 1);
+
+  /* The first key pushed is at the end of the chain */
+  i = 0;
+  TEST(rsv_hash_table_get(&hash_table, &i) != NULL);
+  TEST(hash_table.stats.probes.counts[2] == 2);
+
+  memset(&histogram, 0, sizeof(histogram));
+  rsv_hash_table_chain_lengths(&hash_table, &histogram);
+  TEST(histogram.counts[0] == 3);
+  TEST(histogram.counts[2] == 1);
+
+  for (i = 3; i < 8; i++) {
+    rsv_hash_table_push(&hash_table, &i, &i);
+  }
+
+  TEST(hash_table.stats.resizes == 2);
+
+  for (i = 0; i < 8; i++) {
+    rsv_hash_table_pop(&hash_table, &i);
+  }
+
+  TEST(hash_table.stats.bytes ==
+       hash_table.capacity * sizeof(rsv_hash_table_entry_t*));
+
+  file = tmpfile();
+  TEST(file != NULL);
+  rsv_stats_dump(file, "hash_table", &hash_table.stats);
+  TEST(ftell(file) > 0);
+  fclose(file);
+
+  rsv_hash_table_destroy(&hash_table);
+  TEST(hash_table.stats.bytes == 0);
+  TEST(hash_table.stats.frees == hash_table.stats.allocations);
+
+  /* Test: Hash set */
+  hash_set = rsv_hash_set_create(16, sizeof(int), NULL, NULL);
+
+  for (i = 0; i < 100; i++) {
+    rsv_hash_set_push(&hash_set, &i);
+  }
+
+  TEST(hash_set.stats.resizes > 0);
+  TEST(rsv_stats_histogram_amount(&hash_set.stats.probes) == 100);
+  memset(&histogram, 0, sizeof(histogram));
+  rsv_hash_set_chain_lengths(&hash_set, &histogram);
+  TEST(rsv_stats_histogram_amount(&histogram) == hash_set.capacity);
+  rsv_hash_set_destroy(&hash_set);
+  TEST(hash_set.stats.bytes == 0);
+
+#if defined(__unix__)
+  /* Test: Mutex lock statistics */
+  {
+    rsv_mutex_stats_t stats;
+    rsv_thread_t threads[4];
+    rsv_mutex_t mutex;
+
+    TEST(rsv_mutex_create(&mutex) == 0);
+
+    for (i = 0; i < 4; i++) {
+      TEST(rsv_thread_create(&threads[i], lock_stats_mutex, &mutex) == 0);
+    }
+
+    for (i = 0; i < 4; i++) {
+      TEST(rsv_thread_join(threads[i], NULL) == 0);
+    }
+
+    rsv_mutex_stats_get(&mutex, &stats);
+    TEST(stats.locks == 4000);
+    TEST(stats.contended <= stats.locks);
+    TEST(rsv_stats_histogram_amount(&stats.waits) == stats.contended);
+
+    rsv_mutex_stats_reset(&mutex);
+    rsv_mutex_stats_get(&mutex, &stats);
+    TEST(stats.locks == 0);
+    TEST(stats.wait_ns == 0);
+    TEST(rsv_mutex_destroy(&mutex) == 0);
+  }
+#endif
+
+  return 0;
+}
+
+#endif /* TEST_STATS_H */
+
+#endif
@@ -7,6 +7,137 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__unix__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static inline int test_string_bounded(void) {
+  char buffer[100];
+  char other[100];
+  rsv_string_result_t result;
+  size_t offset;
+  size_t length;
+
+  /* Test: Bounded length */
+  TEST(rsv_strnlen("hello", 10) == 5);
+  TEST(rsv_strnlen("hello", 3) == 3);
+  TEST(rsv_strnlen("", 10) == 0);
+  TEST(rsv_strnlen(NULL, 10) == 0);
+
+  /* Test: Copy reports length and truncation */
+  result = rsv_strlcpy(buffer, "hello", 10);
+  TEST(result.length == 5 && !result.truncated);
+  TEST(strcmp(buffer, "hello") == 0);
+  result = rsv_strlcpy(buffer, "verylongstring", 10);
+  TEST(result.length == 9 && result.truncated);
+  TEST(strcmp(buffer, "verylongs") == 0);
+  result = rsv_strlcpy(buffer, "123456789", 10);
+  TEST(result.length == 9 && !result.truncated);
+  result = rsv_strlcpy(buffer, "test", 0);
+  TEST(result.length == 0 && result.truncated);
+  result = rsv_strlcpy(NULL, "test", 10);
+  TEST(result.length == 0 && result.truncated);
+
+  /* Test: Concatenate */
+  rsv_strcpy(buffer, "key", 10);
+  result = rsv_strlcat(buffer, "1", 10);
+  TEST(result.length == 4 && !result.truncated);
+  TEST(strcmp(buffer, "key1") == 0);
+  result = rsv_strlcat(buffer, "-suffix", 10);
+  TEST(result.length == 9 && result.truncated);
+  TEST(strcmp(buffer, "key1-suff") == 0);
+  memset(buffer, 'x', 10);
+  result = rsv_strlcat(buffer, "a", 10);
+  TEST(result.length == 10 && result.truncated);
+  TEST(buffer[9] == 'x');
+
+  /* Test: Compare */
+  TEST(rsv_strncmp("abc", "abc", 10) == 0);
+  TEST(rsv_strncmp("abc", "abd", 10) < 0);
+  TEST(rsv_strncmp("abd", "abc", 10) > 0);
+  TEST(rsv_strncmp("abc", "abd", 2) == 0);
+  TEST(rsv_strncmp("ab", "abc", 10) < 0);
+  TEST(rsv_strncmp("\xff", "a", 10) > 0);
+  TEST(rsv_strncmp("abc", "xyz", 0) == 0);
+
+  /* Test: Find character */
+  rsv_strcpy(buffer, "hello", sizeof(buffer));
+  TEST(rsv_strnchr(buffer, 'l', 10) == buffer + 2);
+  TEST(rsv_strnchr("hello", 'z', 10) == NULL);
+  TEST(rsv_strnchr("hello", 'o', 4) == NULL);
+  TEST(rsv_strnchr("hello", '\0', 10) != NULL);
+  TEST(rsv_strnchr(NULL, 'a', 10) == NULL);
+
+  /* Test: Every alignment and length against the standard functions */
+  for (offset = 0; offset < 40; offset++) {
+    for (length = 0; length + offset < 90; length++) {
+      char* string = buffer + offset;
+
+      memset(buffer, 'a', sizeof(buffer));
+      string[length] = '\0';
+      TEST(rsv_strnlen(string, 95 - offset) == length);
+      TEST(rsv_strnlen(string, length / 2) == length / 2);
+      TEST(rsv_strnchr(string, 'b', 95 - offset) == NULL);
+
+      if (length > 0) {
+        string[length - 1] = 'b';
+        TEST(rsv_strnchr(string, 'b', 95 - offset) == string + length - 1);
+      }
+
+      memcpy(other, buffer, sizeof(buffer));
+      TEST((rsv_strncmp(string, other + 3, 100) > 0) ==
+           (strncmp(string, other + 3, 100) > 0));
+      TEST((rsv_strncmp(string, other + 3, 100) < 0) ==
+           (strncmp(string, other + 3, 100) < 0));
+      TEST(rsv_strncmp(string, other + offset, 100) == 0);
+
+      if (length > 0) {
+        other[offset + length - 1] = 'c';
+        TEST(rsv_strncmp(string, other + offset, 100) < 0);
+        TEST(rsv_strncmp(string, other + offset, length - 1) == 0);
+      }
+
+      result = rsv_strlcpy(other, string, 20);
+      TEST(result.length == (length < 19 ? length : 19));
+      TEST(result.truncated == (length > 19));
+      TEST(strncmp(other, string, result.length) == 0);
+      TEST(other[result.length] == '\0');
+    }
+  }
+
+#if defined(__unix__)
+  /* Test: Strings ending right before an inaccessible page */
+  {
+    long page_size = sysconf(_SC_PAGESIZE);
+    char* pages = (char*)mmap(NULL, (size_t)page_size * 2,
+                              PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    TEST(pages != MAP_FAILED);
+    TEST(mprotect(pages + page_size, (size_t)page_size, PROT_NONE) == 0);
+
+    for (length = 0; length < 70; length++) {
+      char* string = pages + page_size - length - 1;
+
+      memset(string, 'a', length);
+      string[length] = '\0';
+      TEST(rsv_strnlen(string, 1000) == length);
+      TEST(rsv_strnchr(string, 'z', 1000) == NULL);
+      TEST(rsv_strncmp(string, string, 1000) == 0);
+      TEST(rsv_strncmp(string, pages + page_size - 1, 1000) ==
+           (length ? 'a' : 0));
+      result = rsv_strlcpy(buffer, string, sizeof(buffer));
+      TEST(result.length == length && !result.truncated);
+    }
+
+    munmap(pages, (size_t)page_size * 2);
+  }
+#endif
+
+  return 0;
+}
+
 static inline int test_string(void) {
   char dest[10];
 
@@ -42,7 +173,7 @@ static inline int test_string(void) {
   /* Test: dest_size is 0 */
   rsv_strcpy(dest, "test", 0); /* Should do nothing, no TEST needed */
 
-  return 0;
+  return test_string_bounded();
 }
 
 #endif /* TEST_RSV_STRCPY_H */
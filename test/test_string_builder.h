@@ -0,0 +1,104 @@
+#ifndef TEST_STRING_BUILDER_H
+#define TEST_STRING_BUILDER_H
+
+#include "test.h"
+#include <rsv/containers/string_builder.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline int test_string_builder(void) {
+  rsv_string_t string = rsv_string_create();
+  char expected[256];
+  size_t capacity;
+  int i;
+
+  /* Test: Create string */
+  TEST(string.length == 0);
+  TEST(strcmp(rsv_string_data(&string), "") == 0);
+
+  /* Test: Short strings stay inline */
+  TEST(rsv_string_append(&string, "hello") == 0);
+  TEST(rsv_string_push(&string, ' ') == 0);
+  TEST(rsv_string_appendf(&string, "%s %d", "world", 42) == 0);
+  TEST(string.length == 14);
+  TEST(strcmp(rsv_string_data(&string), "hello world 42") == 0);
+  TEST(string.capacity == RSV_STRING_INLINE_CAPACITY);
+  TEST(rsv_string_data(&string) == string.storage.small);
+
+  /* Test: Exactly the inline capacity */
+  rsv_string_clear(&string);
+  TEST(rsv_string_append(&string, "12345678901234567890123") == 0);
+  TEST(string.length == RSV_STRING_INLINE_CAPACITY);
+  TEST(string.capacity == RSV_STRING_INLINE_CAPACITY);
+
+  /* Test: Growing moves the string to the heap */
+  TEST(rsv_string_push(&string, '4') == 0);
+  TEST(string.capacity > RSV_STRING_INLINE_CAPACITY);
+  TEST(strcmp(rsv_string_data(&string), "123456789012345678901234") == 0);
+
+  /* Test: Formatting past the spare capacity */
+  rsv_string_clear(&string);
+  expected[0] = '\0';
+
+  for (i = 0; i < 30; i++) {
+    char part[16];
+
+    snprintf(part, sizeof(part), "[%d:%x]", i, i * 7);
+    strcat(expected, part);
+    TEST(rsv_string_appendf(&string, "[%d:%x]", i, i * 7) == 0);
+  }
+
+  TEST(string.length == strlen(expected));
+  TEST(strcmp(rsv_string_data(&string), expected) == 0);
+
+  /* Test: Clear keeps the capacity */
+  capacity = string.capacity;
+  rsv_string_clear(&string);
+  TEST(string.length == 0 && string.capacity == capacity);
+  TEST(strcmp(rsv_string_data(&string), "") == 0);
+
+  /* Test: Reserve */
+  TEST(rsv_string_reserve(&string, 10) == 0);
+  TEST(string.capacity == capacity);
+  TEST(rsv_string_reserve(&string, 1000) == 0);
+  TEST(string.capacity == 1000);
+
+  /* Test: Append with embedded null bytes */
+  TEST(rsv_string_append_n(&string, "a\0b", 3) == 0);
+  TEST(string.length == 3 && rsv_string_data(&string)[2] == 'b');
+
+  rsv_string_destroy(&string);
+  TEST(string.length == 0 && string.capacity == RSV_STRING_INLINE_CAPACITY);
+
+  /* Test: Append the string to itself across a reallocation */
+  TEST(rsv_string_append(&string, "0123456789abcdef") == 0);
+  TEST(rsv_string_append(&string, rsv_string_data(&string)) == 0);
+  TEST(strcmp(rsv_string_data(&string),
+              "0123456789abcdef0123456789abcdef") == 0);
+  TEST(rsv_string_appendf(&string, "<%s>", rsv_string_data(&string)) == 0);
+  TEST(string.length == 66);
+  TEST(strcmp(rsv_string_data(&string) + 32,
+              "<0123456789abcdef0123456789abcdef>") == 0);
+
+  for (i = 0; i < 4; i++) {
+    TEST(rsv_string_appendf(&string, "%s", rsv_string_data(&string)) == 0);
+  }
+
+  TEST(string.length == 66 * 16);
+  TEST(memcmp(rsv_string_data(&string) + 66 * 15, rsv_string_data(&string),
+              66) == 0);
+  TEST(rsv_string_append(&string, NULL) == EINVAL);
+  TEST(string.length == 66 * 16);
+  rsv_string_destroy(&string);
+
+  /* Test: Reserve from inline keeps the contents */
+  TEST(rsv_string_append(&string, "inline") == 0);
+  TEST(rsv_string_reserve(&string, 100) == 0);
+  TEST(strcmp(rsv_string_data(&string), "inline") == 0);
+  rsv_string_destroy(&string);
+
+  return 0;
+}
+
+#endif /* TEST_STRING_BUILDER_H */
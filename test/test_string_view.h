@@ -0,0 +1,177 @@
+#ifndef TEST_STRING_VIEW_H
+#define TEST_STRING_VIEW_H
+
+#include "test.h"
+#include <rsv/safe/string_view.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static inline size_t test_string_view_naive_find(rsv_string_view_t view,
+                                                 rsv_string_view_t needle) {
+  size_t i;
+
+  for (i = 0; i + needle.length <= view.length; i++) {
+    if (memcmp(view.data + i, needle.data, needle.length) == 0) {
+      return i;
+    }
+  }
+
+  return RSV_STRING_VIEW_NPOS;
+}
+
+static inline int test_string_view(void) {
+  const char* text = "alpha,beta,,gamma";
+  rsv_string_view_t view = rsv_string_view_from(text);
+  rsv_string_view_t field;
+  rsv_string_view_split_t split;
+  char buffer[128];
+  char needle[8];
+  rsv_string_result_t result;
+  size_t length;
+  size_t i;
+  int amount;
+
+  /* Test: Create views */
+  TEST(view.data == text && view.length == 17);
+  TEST(rsv_string_view_from(NULL).length == 0);
+  TEST(rsv_string_view_equal(rsv_string_view_substring(view, 6, 4),
+                             rsv_string_view_from("beta")));
+  TEST(rsv_string_view_substring(view, 15, 10).length == 2);
+  TEST(rsv_string_view_substring(view, 30, 10).length == 0);
+
+  /* Test: Compare views */
+  TEST(rsv_string_view_compare(rsv_string_view_from("abc"),
+                               rsv_string_view_from("abc")) == 0);
+  TEST(rsv_string_view_compare(rsv_string_view_from("ab"),
+                               rsv_string_view_from("abc")) < 0);
+  TEST(rsv_string_view_compare(rsv_string_view_from("abd"),
+                               rsv_string_view_from("abc")) > 0);
+  TEST(!rsv_string_view_equal(rsv_string_view_from("abc"),
+                              rsv_string_view_from("abd")));
+  TEST(rsv_string_view_starts_with(view, rsv_string_view_from("alp")));
+  TEST(!rsv_string_view_starts_with(view, rsv_string_view_from("beta")));
+  TEST(rsv_string_view_ends_with(view, rsv_string_view_from("gamma")));
+  TEST(!rsv_string_view_ends_with(rsv_string_view_from("a"), view));
+
+  /* Test: Trim and copy */
+  field = rsv_string_view_trim(rsv_string_view_from(" \t hi there\r\n"));
+  TEST(rsv_string_view_equal(field, rsv_string_view_from("hi there")));
+  TEST(rsv_string_view_trim(rsv_string_view_from("  ")).length == 0);
+  result = rsv_string_view_copy(field, buffer, sizeof(buffer));
+  TEST(result.length == 8 && !result.truncated);
+  TEST(strcmp(buffer, "hi there") == 0);
+  result = rsv_string_view_copy(field, buffer, 4);
+  TEST(result.length == 3 && result.truncated);
+  TEST(strcmp(buffer, "hi ") == 0);
+
+  /* Test: Split keeps empty fields */
+  split = rsv_string_view_split(view, rsv_string_view_from(","));
+  TEST(rsv_string_view_split_next(&split, &field) == 1);
+  TEST(rsv_string_view_equal(field, rsv_string_view_from("alpha")));
+  TEST(field.data == text);
+  TEST(rsv_string_view_split_next(&split, &field) == 1);
+  TEST(rsv_string_view_equal(field, rsv_string_view_from("beta")));
+  TEST(rsv_string_view_split_next(&split, &field) == 1);
+  TEST(field.length == 0);
+  TEST(rsv_string_view_split_next(&split, &field) == 1);
+  TEST(rsv_string_view_equal(field, rsv_string_view_from("gamma")));
+  TEST(rsv_string_view_split_next(&split, &field) == 0);
+
+  split = rsv_string_view_split(rsv_string_view_from("a,"),
+                                rsv_string_view_from(","));
+  TEST(rsv_string_view_split_next(&split, &field) == 1 && field.length == 1);
+  TEST(rsv_string_view_split_next(&split, &field) == 1 && field.length == 0);
+  TEST(rsv_string_view_split_next(&split, &field) == 0);
+
+  /* Test: Tokenize skips empty fields */
+  split = rsv_string_view_tokenize(
+      rsv_string_view_from("  one two\t\tthree \n"),
+      rsv_string_view_from(" \t\n"));
+  amount = 0;
+
+  while (rsv_string_view_split_next(&split, &field)) {
+    TEST(field.length > 0);
+    amount++;
+  }
+
+  TEST(amount == 3);
+  TEST(rsv_string_view_equal(field, rsv_string_view_from("three")));
+
+  split = rsv_string_view_tokenize(rsv_string_view_from(""),
+                                   rsv_string_view_from(" "));
+  TEST(rsv_string_view_split_next(&split, &field) == 0);
+
+  /* Test: Find characters and delimiters */
+  TEST(rsv_string_view_find_char(view, ',') == 5);
+  TEST(rsv_string_view_find_char(view, 'z') == RSV_STRING_VIEW_NPOS);
+  TEST(rsv_string_view_find_any(view, rsv_string_view_from(";g")) == 12);
+  TEST(rsv_string_view_find_any(view, rsv_string_view_from("xyz")) ==
+       RSV_STRING_VIEW_NPOS);
+  TEST(rsv_string_view_find_any(
+           view, rsv_string_view_from("0123456789ABCDEFm")) == 14);
+
+  /* Test: Find substrings */
+  TEST(rsv_string_view_find(view, rsv_string_view_from("")) == 0);
+  TEST(rsv_string_view_find(view, rsv_string_view_from("gamma")) == 12);
+  TEST(rsv_string_view_find(view, rsv_string_view_from("ta,")) == 8);
+  TEST(rsv_string_view_find(view, rsv_string_view_from("gammas")) ==
+       RSV_STRING_VIEW_NPOS);
+
+  /* Test: Every needle length and position against a naive search */
+  for (length = 2; length < sizeof(needle); length++) {
+    for (i = 0; i + length <= 100; i++) {
+      rsv_string_view_t haystack = rsv_string_view_create(buffer, 100);
+      rsv_string_view_t pattern = rsv_string_view_create(needle, length);
+
+      memset(buffer, 'a', sizeof(buffer));
+      memset(needle, 'a', sizeof(needle));
+      needle[length - 1] = 'b';
+      /* Near misses sharing the first and last character */
+      buffer[i / 2 + length - 1] = 'b';
+      buffer[i / 2 + 1] = 'c';
+      buffer[i + length - 1] = 'b';
+      TEST(rsv_string_view_find(haystack, pattern) ==
+           test_string_view_naive_find(haystack, pattern));
+      TEST(rsv_string_view_find_any(haystack, rsv_string_view_from("bc")) ==
+           (i / 2 + 1 < i / 2 + length - 1 ? i / 2 + 1 : i / 2 + length - 1));
+    }
+  }
+
+#if defined(__unix__)
+  /* Test: Views ending right before an inaccessible page */
+  {
+    long page_size = sysconf(_SC_PAGESIZE);
+    char* pages = (char*)mmap(NULL, (size_t)page_size * 2,
+                              PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    TEST(pages != MAP_FAILED);
+    TEST(mprotect(pages + page_size, (size_t)page_size, PROT_NONE) == 0);
+
+    for (length = 0; length < 70; length++) {
+      rsv_string_view_t haystack =
+          rsv_string_view_create(pages + page_size - length, length);
+
+      memset(pages + page_size - length, 'a', length);
+      TEST(rsv_string_view_find(haystack, rsv_string_view_from("ab")) ==
+           RSV_STRING_VIEW_NPOS);
+      TEST(rsv_string_view_find_any(haystack, rsv_string_view_from(",;")) ==
+           RSV_STRING_VIEW_NPOS);
+      TEST(rsv_string_view_find(haystack, rsv_string_view_from("aa")) ==
+           (length >= 2 ? 0 : RSV_STRING_VIEW_NPOS));
+    }
+
+    munmap(pages, (size_t)page_size * 2);
+  }
+#endif
+
+  return 0;
+}
+
+#endif /* TEST_STRING_VIEW_H */
@@ -0,0 +1,135 @@
+#if defined(__unix__)
+
+#ifndef TEST_THREAD_POOL_H
+#define TEST_THREAD_POOL_H
+
+#include "test.h"
+#include <rsv/threads/thread_pool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct test_thread_pool_data_t {
+  rsv_thread_pool_t* pool;
+  long counter;
+  unsigned int depth;
+} test_thread_pool_data_t;
+
+static inline void test_thread_pool_increment(void* arg) {
+  test_thread_pool_data_t* data = (test_thread_pool_data_t*)arg;
+
+  rsv_atomic_fetch_add(&data->counter, 1, RSV_MEMORY_ORDER_RELAXED);
+}
+
+static inline void test_thread_pool_spawn(void* arg);
+
+typedef struct test_thread_pool_node_t {
+  test_thread_pool_data_t* data;
+  unsigned int depth;
+} test_thread_pool_node_t;
+
+static inline void test_thread_pool_spawn(void* arg) {
+  test_thread_pool_node_t* node = (test_thread_pool_node_t*)arg;
+  test_thread_pool_node_t children[2];
+  rsv_thread_pool_wait_t wait;
+  unsigned int i;
+
+  rsv_atomic_fetch_add(&node->data->counter, 1, RSV_MEMORY_ORDER_RELAXED);
+
+  if (node->depth == 0) {
+    return;
+  }
+
+  rsv_thread_pool_wait_create(&wait);
+
+  for (i = 0; i < 2; ++i) {
+    children[i].data = node->data;
+    children[i].depth = node->depth - 1;
+    rsv_thread_pool_submit(node->data->pool, &wait, test_thread_pool_spawn,
+                           &children[i]);
+  }
+
+  rsv_thread_pool_wait(node->data->pool, &wait);
+  rsv_thread_pool_wait_destroy(&wait);
+}
+
+static inline int test_thread_pool(void) {
+  rsv_thread_pool_t pool;
+  rsv_cpu_set_t allowed;
+  rsv_thread_pool_wait_t wait;
+  test_thread_pool_data_t data;
+  test_thread_pool_node_t root;
+  unsigned int i;
+
+  /* Test: Create thread pool */
+  TEST(rsv_thread_pool_create(&pool, 4, 0) == 0);
+  TEST(pool.worker_amount == 4);
+  TEST(rsv_thread_pool_worker_index(&pool) == -1);
+  TEST(rsv_thread_pool_wait_create(&wait) == 0);
+
+  /* Test: Run tasks submitted from outside the pool */
+  data.pool = &pool;
+  data.counter = 0;
+
+  for (i = 0; i < 10000; ++i) {
+    TEST(rsv_thread_pool_submit(&pool, &wait, test_thread_pool_increment,
+                                &data) == 0);
+  }
+
+  rsv_thread_pool_wait(&pool, &wait);
+  TEST(data.counter == 10000);
+
+  /* Test: Tasks submitting and waiting on tasks */
+  data.counter = 0;
+  root.data = &data;
+  root.depth = 10;
+  TEST(rsv_thread_pool_submit(&pool, &wait, test_thread_pool_spawn, &root) ==
+       0);
+  rsv_thread_pool_wait(&pool, &wait);
+  TEST(data.counter == (1 << 11) - 1);
+
+  rsv_thread_pool_wait_destroy(&wait);
+  rsv_thread_pool_destroy(&pool);
+  TEST(pool.worker_amount == 0);
+
+  /* Test: Pinning only uses the CPUs of the affinity mask */
+  TEST(rsv_thread_get_affinity(pthread_self(), &allowed) == 0);
+
+  if (rsv_cpu_set_amount(&allowed) > 0) {
+    rsv_cpu_set_t restricted;
+    unsigned int cpu = RSV_CPU_SET_SIZE - 1;
+
+    while (!rsv_cpu_set_has(&allowed, cpu)) {
+      cpu--;
+    }
+
+    rsv_cpu_set_clear(&restricted);
+    rsv_cpu_set_add(&restricted, cpu);
+    TEST(rsv_thread_set_affinity(pthread_self(), &restricted) == 0);
+    TEST(rsv_thread_pool_create(&pool, 0, 1) == 0);
+    TEST(pool.worker_amount == 1);
+    rsv_thread_pool_destroy(&pool);
+    TEST(rsv_thread_pool_create(&pool, 3, 1) == 0);
+    rsv_thread_pool_destroy(&pool);
+    TEST(rsv_thread_set_affinity(pthread_self(), &allowed) == 0);
+  }
+
+  /* Test: Default worker amount with pinning */
+  TEST(rsv_thread_pool_create(&pool, 0, 1) == 0);
+  TEST(pool.worker_amount >= 1);
+
+  /* Test: Destroy runs tasks which are still queued */
+  data.counter = 0;
+
+  for (i = 0; i < 100; ++i) {
+    rsv_thread_pool_submit(&pool, NULL, test_thread_pool_increment, &data);
+  }
+
+  rsv_thread_pool_destroy(&pool);
+  TEST(data.counter == 100);
+
+  return 0;
+}
+
+#endif /* TEST_THREAD_POOL_H */
+
+#endif
@@ -7,6 +7,7 @@
 #include <rsv/threads/threads_pthreads.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 typedef struct shared_data_t {
   int counter;
@@ -26,6 +27,198 @@ static inline void* increment_counter(void* arg) {
   return NULL;
 }
 
+typedef struct shared_sync_data_t {
+  int adaptive_counter;
+  int spin_counter;
+  int write_counter;
+  int readers;
+  int ready;
+  rsv_rwlock_t rwlock;
+  rsv_adaptive_mutex_t adaptive_mutex;
+  rsv_spinlock_t spinlock;
+  rsv_mutex_t mutex;
+  rsv_cond_t cond;
+  rsv_barrier_t barrier;
+} shared_sync_data_t;
+
+static int once_counter = 0;
+
+static inline void increment_once_counter(void) {
+  once_counter++;
+}
+
+static inline void* increment_counter_sync(void* arg) {
+  shared_sync_data_t* data = (shared_sync_data_t*)arg;
+  int i;
+
+  for (i = 0; i < 1000; i++) {
+    rsv_adaptive_mutex_lock(&data->adaptive_mutex);
+    data->adaptive_counter++;
+    rsv_adaptive_mutex_unlock(&data->adaptive_mutex);
+
+    rsv_spinlock_lock(&data->spinlock);
+    data->spin_counter++;
+    rsv_spinlock_unlock(&data->spinlock);
+
+    rsv_rwlock_write_lock(&data->rwlock);
+    data->write_counter++;
+    rsv_rwlock_unlock(&data->rwlock);
+
+    rsv_rwlock_read_lock(&data->rwlock);
+    rsv_atomic_fetch_add(&data->readers, 1, RSV_MEMORY_ORDER_RELAXED);
+    rsv_rwlock_unlock(&data->rwlock);
+  }
+
+  rsv_barrier_wait(&data->barrier);
+
+  rsv_mutex_lock(&data->mutex);
+
+  while (!data->ready) {
+    rsv_cond_wait(&data->cond, &data->mutex);
+  }
+
+  rsv_mutex_unlock(&data->mutex);
+
+  return NULL;
+}
+
+static inline int test_threads_sync(void) {
+  rsv_thread_t threads[4];
+  shared_sync_data_t sync_data;
+  rsv_once_t once = RSV_ONCE_INIT;
+  int i;
+
+  sync_data.adaptive_counter = 0;
+  sync_data.spin_counter = 0;
+  sync_data.write_counter = 0;
+  sync_data.readers = 0;
+  sync_data.ready = 0;
+
+  TEST(rsv_rwlock_create(&sync_data.rwlock) == 0);
+  TEST(rsv_adaptive_mutex_create(&sync_data.adaptive_mutex) == 0);
+  TEST(rsv_spinlock_create(&sync_data.spinlock) == 0);
+  TEST(rsv_mutex_create(&sync_data.mutex) == 0);
+  TEST(rsv_cond_create(&sync_data.cond) == 0);
+  TEST(rsv_barrier_create(&sync_data.barrier, 4) == 0);
+
+  /* Test: Primitives are cache line aligned */
+  TEST(sizeof(rsv_rwlock_t) % RSV_CACHE_LINE_SIZE == 0);
+  TEST(sizeof(rsv_spinlock_t) % RSV_CACHE_LINE_SIZE == 0);
+  TEST(((size_t)&sync_data.adaptive_mutex) % RSV_CACHE_LINE_SIZE == 0);
+
+  /* Test: Synchronization primitives under contention */
+  for (i = 0; i < 4; i++) {
+    TEST(rsv_thread_create(&threads[i], increment_counter_sync, &sync_data) ==
+         0);
+  }
+
+  rsv_mutex_lock(&sync_data.mutex);
+  sync_data.ready = 1;
+  rsv_cond_broadcast(&sync_data.cond);
+  rsv_mutex_unlock(&sync_data.mutex);
+
+  for (i = 0; i < 4; i++) {
+    TEST(rsv_thread_join(threads[i], NULL) == 0);
+  }
+
+  TEST(sync_data.adaptive_counter == 4000);
+  TEST(sync_data.spin_counter == 4000);
+  TEST(sync_data.write_counter == 4000);
+  TEST(sync_data.readers == 4000);
+
+  /* Test: Once runs its routine a single time */
+  TEST(rsv_once(&once, increment_once_counter) == 0);
+  TEST(rsv_once(&once, increment_once_counter) == 0);
+  TEST(once_counter == 1);
+
+  rsv_barrier_destroy(&sync_data.barrier);
+  rsv_cond_destroy(&sync_data.cond);
+  rsv_mutex_destroy(&sync_data.mutex);
+  rsv_spinlock_destroy(&sync_data.spinlock);
+  rsv_adaptive_mutex_destroy(&sync_data.adaptive_mutex);
+  rsv_rwlock_destroy(&sync_data.rwlock);
+
+  return 0;
+}
+
+typedef struct thread_attributes_data_t {
+  int cpu;
+  char name[RSV_THREAD_NAME_SIZE];
+} thread_attributes_data_t;
+
+static inline void* inspect_thread(void* arg) {
+  thread_attributes_data_t* data = (thread_attributes_data_t*)arg;
+
+  data->cpu = -1;
+
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+  data->cpu = sched_getcpu();
+  pthread_getname_np(pthread_self(), data->name, sizeof(data->name));
+#endif
+
+  return NULL;
+}
+
+static inline int test_threads_attributes(void) {
+  rsv_thread_attributes_t attributes;
+  thread_attributes_data_t data;
+  rsv_cpu_set_t cpus;
+  rsv_thread_t thread;
+  unsigned int cpu = 0;
+
+  /* Test: CPU sets */
+  rsv_cpu_set_clear(&cpus);
+  TEST(rsv_cpu_set_amount(&cpus) == 0);
+  rsv_cpu_set_add(&cpus, 3);
+  rsv_cpu_set_add(&cpus, 100);
+  rsv_cpu_set_add(&cpus, RSV_CPU_SET_SIZE);
+  TEST(rsv_cpu_set_has(&cpus, 3) && rsv_cpu_set_has(&cpus, 100));
+  TEST(!rsv_cpu_set_has(&cpus, 4));
+  TEST(rsv_cpu_set_amount(&cpus) == 2);
+  rsv_cpu_set_remove(&cpus, 3);
+  TEST(!rsv_cpu_set_has(&cpus, 3));
+
+  /* Test: Default attributes */
+  rsv_thread_attributes_create(&attributes);
+  data.name[0] = '\0';
+  TEST(rsv_thread_create_ex(&thread, &attributes, inspect_thread, &data) ==
+       0);
+  TEST(rsv_thread_join(thread, NULL) == 0);
+  TEST(rsv_thread_create_ex(&thread, NULL, inspect_thread, &data) == 0);
+  TEST(rsv_thread_join(thread, NULL) == 0);
+
+  /* Test: Affinity, stack size and name */
+#if defined(CPU_SET)
+  {
+    cpu_set_t allowed;
+
+    TEST(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+
+    while (!CPU_ISSET(cpu, &allowed)) {
+      cpu++;
+    }
+  }
+#endif
+
+  rsv_cpu_set_add(&attributes.cpus, cpu);
+  attributes.stack_size = 1 << 20;
+  attributes.name = "rsv-test-thread-long-name";
+  TEST(rsv_thread_create_ex(&thread, &attributes, inspect_thread, &data) ==
+       0);
+  TEST(rsv_thread_join(thread, NULL) == 0);
+
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+  TEST(data.cpu == (int)cpu);
+  TEST(strcmp(data.name, "rsv-test-thread") == 0);
+#endif
+
+  /* Test: Invalid stack size is reported */
+  attributes.stack_size = 1;
+  TEST(rsv_thread_create_ex(&thread, &attributes, inspect_thread, &data) != 0);
+
+  return 0;
+}
+
 static inline int test_threads(void) {
   rsv_thread_t thread1;
   rsv_thread_t thread2;
@@ -47,7 +240,7 @@ static inline int test_threads(void) {
   TEST(data.counter == 2000);
   rsv_mutex_destroy(&data.mutex);
 
-  return 0;
+  return test_threads_sync() + test_threads_attributes();
 }
 
 #endif /* TEST_THREADS_H */
@@ -0,0 +1,263 @@
+#ifndef TEST_UTF8_H
+#define TEST_UTF8_H
+
+#include "test.h"
+#include <rsv/safe/utf8.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Reference decoder, working from the code point value rather than byte
+   ranges. Returns the sequence length, or 0 if invalid */
+static inline size_t test_utf8_reference_decode(const unsigned char* bytes,
+                                                size_t length,
+                                                uint32_t* codepoint) {
+  static const uint32_t minimum[5] = {0, 0, 0x80, 0x800, 0x10000};
+  size_t sequence;
+  size_t i;
+
+  if (bytes[0] < 0x80) {
+    sequence = 1;
+    *codepoint = bytes[0];
+  } else if ((bytes[0] & 0xe0) == 0xc0) {
+    sequence = 2;
+    *codepoint = bytes[0] & 0x1f;
+  } else if ((bytes[0] & 0xf0) == 0xe0) {
+    sequence = 3;
+    *codepoint = bytes[0] & 0x0f;
+  } else if ((bytes[0] & 0xf8) == 0xf0) {
+    sequence = 4;
+    *codepoint = bytes[0] & 0x07;
+  } else {
+    return 0;
+  }
+
+  if (sequence > length) {
+    return 0;
+  }
+
+  for (i = 1; i < sequence; i++) {
+    if ((bytes[i] & 0xc0) != 0x80) {
+      return 0;
+    }
+
+    *codepoint = *codepoint << 6 | (bytes[i] & 0x3f);
+  }
+
+  if (*codepoint < minimum[sequence] || *codepoint > 0x10ffff ||
+      (*codepoint >= 0xd800 && *codepoint <= 0xdfff)) {
+    return 0;
+  }
+
+  return sequence;
+}
+
+static inline int test_utf8_reference_validate(const unsigned char* bytes,
+                                               size_t length) {
+  uint32_t codepoint;
+  size_t i = 0;
+
+  while (i < length) {
+    size_t sequence =
+        test_utf8_reference_decode(bytes + i, length - i, &codepoint);
+
+    if (sequence == 0) {
+      return 0;
+    }
+
+    i += sequence;
+  }
+
+  return 1;
+}
+
+static inline int test_utf8(void) {
+  static const unsigned char edges[] = {
+      0x00, 0x41, 0x7f, 0x80, 0x8f, 0x90, 0x9f, 0xa0, 0xbf, 0xc0, 0xc1, 0xc2,
+      0xdf, 0xe0, 0xe1, 0xec, 0xed, 0xee, 0xef, 0xf0, 0xf1, 0xf4, 0xf5, 0xff};
+  const size_t edge_amount = sizeof(edges);
+  const char* mixed = "a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80z";
+  unsigned char buffer[64];
+  uint32_t utf32[64];
+  uint16_t utf16[64];
+  uint32_t codepoint;
+  size_t written;
+  size_t offset;
+  size_t a, b, c, d;
+  unsigned int seed = 12345;
+  int failures = 0;
+  int i;
+
+  /* Test: Known strings */
+  TEST(rsv_utf8_validate("", 0) == 1);
+  TEST(rsv_utf8_validate(NULL, 0) == 1);
+  TEST(rsv_utf8_validate(mixed, strlen(mixed)) == 1);
+  TEST(rsv_utf8_validate("\xc0\xaf", 2) == 0);
+  TEST(rsv_utf8_validate("\xed\xa0\x80", 3) == 0);
+  TEST(rsv_utf8_validate("\xf4\x90\x80\x80", 4) == 0);
+  TEST(rsv_utf8_validate("\xe2\x82", 2) == 0);
+  TEST(rsv_utf8_count(mixed, strlen(mixed)) == 5);
+  TEST(rsv_utf8_utf16_length(mixed, strlen(mixed)) == 6);
+  TEST(rsv_utf8_decode("\xf0\x9f\x98\x80", 4, &codepoint) == 4);
+  TEST(codepoint == 0x1f600);
+
+  /* Test: Every sequence of up to three bytes against the reference */
+  for (a = 0; a < 256; a++) {
+    buffer[0] = (unsigned char)a;
+    failures += rsv_utf8_validate((const char*)buffer, 1) !=
+                test_utf8_reference_validate(buffer, 1);
+
+    for (b = 0; b < 256; b++) {
+      buffer[1] = (unsigned char)b;
+      failures += rsv_utf8_validate((const char*)buffer, 2) !=
+                  test_utf8_reference_validate(buffer, 2);
+
+      for (c = 0; c < 256; c++) {
+        buffer[2] = (unsigned char)c;
+        failures += rsv_utf8_validate((const char*)buffer, 3) !=
+                    test_utf8_reference_validate(buffer, 3);
+      }
+    }
+  }
+
+  TEST(failures == 0);
+
+  /* Test: Every four byte lead and second byte against the reference */
+  for (a = 0xf0; a < 0x100; a++) {
+    for (b = 0; b < 256; b++) {
+      for (c = 0; c < edge_amount; c++) {
+        for (d = 0; d < edge_amount; d++) {
+          buffer[0] = (unsigned char)a;
+          buffer[1] = (unsigned char)b;
+          buffer[2] = edges[c];
+          buffer[3] = edges[d];
+          failures += rsv_utf8_validate((const char*)buffer, 4) !=
+                      test_utf8_reference_validate(buffer, 4);
+        }
+      }
+    }
+  }
+
+  TEST(failures == 0);
+
+  /* Test: Edge bytes straddling block boundaries and the end of the input */
+  for (offset = 12; offset <= 16; offset++) {
+    for (a = 0; a < edge_amount; a++) {
+      for (b = 0; b < edge_amount; b++) {
+        for (c = 0; c < edge_amount; c++) {
+          for (d = 0; d < edge_amount; d++) {
+            memset(buffer, 'a', 32);
+            buffer[offset] = edges[a];
+            buffer[offset + 1] = edges[b];
+            buffer[offset + 2] = edges[c];
+            buffer[offset + 3] = edges[d];
+            failures += rsv_utf8_validate((const char*)buffer, 32) !=
+                        test_utf8_reference_validate(buffer, 32);
+            failures +=
+                rsv_utf8_validate((const char*)buffer, offset + 4) !=
+                test_utf8_reference_validate(buffer, offset + 4);
+          }
+        }
+      }
+    }
+  }
+
+  TEST(failures == 0);
+
+  /* Test: Random strings of valid code points, then with one byte changed */
+  for (i = 0; i < 20000; i++) {
+    size_t length = 0;
+    size_t count = 0;
+    size_t units = 0;
+
+    while (length < sizeof(buffer) - 4) {
+      uint32_t value;
+
+      seed = seed * 1103515245u + 12345u;
+      value = (seed >> 8) % (seed & 0x100 ? 0x110000 : 0x80);
+
+      if (value >= 0xd800 && value <= 0xdfff) {
+        continue;
+      }
+
+      if (value < 0x80) {
+        buffer[length++] = (unsigned char)value;
+      } else if (value < 0x800) {
+        buffer[length++] = (unsigned char)(0xc0 | value >> 6);
+        buffer[length++] = (unsigned char)(0x80 | (value & 0x3f));
+      } else if (value < 0x10000) {
+        buffer[length++] = (unsigned char)(0xe0 | value >> 12);
+        buffer[length++] = (unsigned char)(0x80 | (value >> 6 & 0x3f));
+        buffer[length++] = (unsigned char)(0x80 | (value & 0x3f));
+      } else {
+        buffer[length++] = (unsigned char)(0xf0 | value >> 18);
+        buffer[length++] = (unsigned char)(0x80 | (value >> 12 & 0x3f));
+        buffer[length++] = (unsigned char)(0x80 | (value >> 6 & 0x3f));
+        buffer[length++] = (unsigned char)(0x80 | (value & 0x3f));
+      }
+
+      utf32[count++] = value;
+      units += value > 0xffff ? 2 : 1;
+    }
+
+    failures += rsv_utf8_validate((const char*)buffer, length) != 1;
+    failures += rsv_utf8_count((const char*)buffer, length) != count;
+    failures += rsv_utf8_utf16_length((const char*)buffer, length) != units;
+
+    {
+      uint32_t decoded[64];
+      uint16_t encoded[64];
+      size_t j;
+      size_t k = 0;
+
+      failures += rsv_utf8_to_utf32((const char*)buffer, length, decoded, 64,
+                                    &written) != 0;
+      failures += written != count;
+      failures += memcmp(decoded, utf32, count * sizeof(uint32_t)) != 0;
+      failures += rsv_utf8_to_utf16((const char*)buffer, length, encoded, 64,
+                                    &written) != 0;
+      failures += written != units;
+
+      for (j = 0; j < count; j++) {
+        if (utf32[j] > 0xffff) {
+          failures += encoded[k] != 0xd800 + ((utf32[j] - 0x10000) >> 10);
+          failures += encoded[k + 1] != 0xdc00 + (utf32[j] & 0x3ff);
+          k += 2;
+        } else {
+          failures += encoded[k++] != utf32[j];
+        }
+      }
+    }
+
+    seed = seed * 1103515245u + 12345u;
+    buffer[(seed >> 8) % length] ^= (unsigned char)(1u << (seed >> 4) % 8);
+    failures += rsv_utf8_validate((const char*)buffer, length) !=
+                test_utf8_reference_validate(buffer, length);
+  }
+
+  TEST(failures == 0);
+
+  /* Test: Transcoding ASCII blocks and reporting errors */
+  memset(buffer, 'x', sizeof(buffer));
+  TEST(rsv_utf8_to_utf32((const char*)buffer, 40, utf32, 64, &written) == 0);
+  TEST(written == 40 && utf32[0] == 'x' && utf32[39] == 'x');
+  TEST(rsv_utf8_to_utf16((const char*)buffer, 40, utf16, 64, &written) == 0);
+  TEST(written == 40 && utf16[0] == 'x' && utf16[39] == 'x');
+  TEST(rsv_utf8_to_utf32((const char*)buffer, 40, utf32, 20, &written) ==
+       ERANGE);
+  TEST(written == 20);
+  buffer[30] = 0xff;
+  TEST(rsv_utf8_to_utf32((const char*)buffer, 40, utf32, 64, &written) ==
+       EILSEQ);
+  TEST(written == 30);
+  TEST(rsv_utf8_to_utf16((const char*)buffer, 40, utf16, 64, NULL) == EILSEQ);
+  TEST(rsv_utf8_to_utf16(mixed, strlen(mixed), utf16, 4, &written) == ERANGE);
+  TEST(written == 3);
+  TEST(rsv_utf8_to_utf16(mixed, strlen(mixed), utf16, 6, &written) == 0);
+  TEST(utf16[3] == 0xd83d && utf16[4] == 0xde00 && utf16[5] == 'z');
+
+  return 0;
+}
+
+#endif /* TEST_UTF8_H */